@@ -204,6 +204,15 @@ license you like.
 # define JSONCPP_OVERRIDE
 #endif
 
+// Storage class for the per-thread state of Arena::Scope.
+#if __cplusplus >= 201103L
+# define JSONCPP_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+# define JSONCPP_THREAD_LOCAL __declspec(thread)
+#else
+# define JSONCPP_THREAD_LOCAL __thread
+#endif
+
 #ifndef JSON_HAS_RVALUE_REFERENCES
 
 #if defined(_MSC_VER) && _MSC_VER >= 1600 // MSVC >= 2010
@@ -441,6 +450,8 @@ namespace Json {
 #include <string>
 #include <vector>
 #include <exception>
+#include <new>
+#include <utility>
 
 #ifndef JSON_USE_CPPTL_SMALLMAP
 #include <map>
@@ -567,6 +578,132 @@ namespace Json {
          const char* c_str_;
    };
 
+   /** \brief Bump-pointer memory pool for the object maps and strings of Values.
+    *
+    * While an Arena::Scope is alive, every Value created on the same thread,
+    * including the ones built by Reader and CharReader, takes its object maps
+    * and strings from the arena and releasing them costs nothing. reset()
+    * recycles all the memory at once. Values created inside a scope must be
+    * destroyed before the scope ends and must not be assigned to Values that
+    * outlive it.
+    *
+    * Example of usage:
+    * \code
+    * Json::Arena arena;
+    * while (nextDocument(&document)) {
+    *    {
+    *       Json::Arena::Scope scope(arena);
+    *       Json::Value root;
+    *       reader.parse(document, root);
+    *       validator.validate(&root);
+    *    }
+    *    arena.reset();
+    * }
+    * \endcode
+    */
+   class JSON_API Arena {
+      public:
+         /// Routes the allocations of the calling thread to an arena.
+         class JSON_API Scope {
+            public:
+               explicit Scope(Arena& arena);
+               ~Scope();
+
+            private:
+               Scope(Scope const&);
+               Scope& operator=(Scope const&);
+
+               Arena* previous_;
+         };
+
+         explicit Arena(size_t blockSize = 64 * 1024);
+         ~Arena();
+
+         void* allocate(size_t size);
+
+         /// Returns true if p was handed out by this arena.
+         bool owns(const void* p) const;
+
+         /** Releases everything allocated so far. The blocks are merged into
+          * a single one, so a steady workload ends up bumping through one
+          * contiguous block per document.
+          */
+         void reset();
+
+         /// Bytes handed out since the last reset().
+         size_t used() const { return used_; }
+
+         /// Bytes held in blocks.
+         size_t reserved() const { return reserved_; }
+
+         /// Arena of the innermost Scope on the calling thread, or NULL.
+         static Arena* current();
+
+         /// Allocates from the current arena, or from the heap without one.
+         static void* allocateCurrent(size_t size);
+
+         /// Releases memory returned by allocateCurrent().
+         static void releaseCurrent(void* p);
+
+      private:
+         Arena(Arena const&);
+         Arena& operator=(Arena const&);
+
+         struct Block {
+            Block* next_;
+            size_t size_;
+         };
+
+         void addBlock(size_t minimum);
+
+         Block* blocks_;
+         char*  cursor_;
+         char*  limit_;
+         size_t blockSize_;
+         size_t used_;
+         size_t reserved_;
+   };
+
+   /// STL allocator for the Value object maps, backed by the current Arena.
+   template <typename T>
+   class ArenaAllocator {
+      public:
+         typedef T              value_type;
+         typedef T*             pointer;
+         typedef const T*       const_pointer;
+         typedef T&             reference;
+         typedef const T&       const_reference;
+         typedef size_t         size_type;
+         typedef ptrdiff_t      difference_type;
+
+         template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+         ArenaAllocator() {}
+         template <typename U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+         pointer allocate(size_type n, const void* = 0) {
+            return static_cast<pointer>(Arena::allocateCurrent(n * sizeof(T)));
+         }
+         void deallocate(pointer p, size_type) { Arena::releaseCurrent(p); }
+
+         pointer address(reference x) const { return &x; }
+         const_pointer address(const_reference x) const { return &x; }
+         size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+         void construct(pointer p, const T& value) { new (p) T(value); }
+#if JSON_HAS_RVALUE_REFERENCES
+         template <typename U, typename... Args>
+         void construct(U* p, Args&&... args) {
+            new (p) U(std::forward<Args>(args)...);
+         }
+#endif
+         void destroy(pointer p) { p->~T(); }
+         template <typename U> void destroy(U* p) { p->~U(); }
+
+         bool operator==(const ArenaAllocator&) const { return true; }
+         bool operator!=(const ArenaAllocator&) const { return false; }
+   };
+
    /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
     *
     * This class is a discriminated union wrapper that can represents a:
@@ -684,7 +821,8 @@ namespace Json {
 
       public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-      typedef std::map<CZString, Value> ObjectValues;
+      typedef std::map<CZString, Value, std::less<CZString>,
+              ArenaAllocator<std::pair<const CZString, Value> > > ObjectValues;
 #else
       typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
@@ -1333,6 +1471,15 @@ namespace std {
 
 namespace Json {
 
+   /** \brief Converts the JSON number in [begin, end) to the nearest double.
+    *
+    * The conversion is exact, does not allocate in the common case and does
+    * not depend on the process locale; it is the one used by Reader and
+    * CharReader.
+    * \return false if the text does not follow the JSON number grammar.
+    */
+   bool JSON_API decodeDecimal(const char* begin, const char* end, double& result);
+
    /** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
     *Value.
     *
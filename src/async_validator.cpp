@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string>
+#include <vector>
+#include <list>
+#include <regex>
+#include <future>
+#include <memory>
+#include <json.h>
+#include <tape.h>
+#include <primitive_base.h>
+#include <validator.h>
+#include <worker_pool.h>
+#include <async_validator.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static inline uint64_t elapsedNs(Clock::time_point from, Clock::time_point to)
+{
+   return static_cast<uint64_t>(
+         std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+/**
+ * @brief Pool task validating one document
+ */
+template <typename T>
+class ValidationTask
+{
+   public:
+      ValidationTask(JsonValidator *validator, const T *document,
+            const JsonAsyncValidator::Callback &done) :
+         m_validator(validator), m_document(document), m_done(done),
+         m_submitted(Clock::now()) {}
+
+      void operator()() {
+         JsonAsyncResult result;
+         Clock::time_point start = Clock::now();
+         result.result = m_validator->validate(m_document);
+         result.queueWaitNs = elapsedNs(m_submitted, start);
+         result.executionNs = elapsedNs(start, Clock::now());
+         m_done(result);
+      }
+
+   private:
+      JsonValidator                 *m_validator;
+      const T                       *m_document;
+      JsonAsyncValidator::Callback  m_done;
+      Clock::time_point             m_submitted;
+};
+
+/**
+ * @brief Completion callback fulfilling a promise
+ */
+class PromiseCallback
+{
+   public:
+      PromiseCallback(
+            const std::shared_ptr<std::promise<JsonAsyncResult> > &promise) :
+         m_promise(promise) {}
+
+      void operator()(const JsonAsyncResult &result) {
+         m_promise->set_value(result);
+      }
+
+   private:
+      std::shared_ptr<std::promise<JsonAsyncResult> > m_promise;
+};
+
+JsonAsyncValidator::JsonAsyncValidator(JsonValidator *validator,
+      unsigned int threads, size_t queueDepth) :
+   m_validator(validator), m_pool(threads, queueDepth)
+{
+}
+
+template <typename T>
+bool JsonAsyncValidator::enqueue(const T *document, const Callback &done)
+{
+   return m_pool.trySubmit(ValidationTask<T>(m_validator, document, done));
+}
+
+template <typename T>
+std::future<JsonAsyncResult> JsonAsyncValidator::enqueue(const T *document)
+{
+   std::shared_ptr<std::promise<JsonAsyncResult> > promise(
+         new std::promise<JsonAsyncResult>());
+   std::future<JsonAsyncResult> future = promise->get_future();
+
+   if (!enqueue(document, PromiseCallback(promise))) {
+      return std::future<JsonAsyncResult>();
+   }
+
+   return future;
+}
+
+bool JsonAsyncValidator::submit(const Json::Value *document,
+      const Callback &done)
+{
+   return enqueue(document, done);
+}
+
+bool JsonAsyncValidator::submit(const JsonTape *document, const Callback &done)
+{
+   return enqueue(document, done);
+}
+
+std::future<JsonAsyncResult> JsonAsyncValidator::submit(
+      const Json::Value *document)
+{
+   return enqueue(document);
+}
+
+std::future<JsonAsyncResult> JsonAsyncValidator::submit(
+      const JsonTape *document)
+{
+   return enqueue(document);
+}
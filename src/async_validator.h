@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __ASYNC_VALIDATOR_H__
+#define __ASYNC_VALIDATOR_H__
+
+#include <future>
+#include <memory>
+#include <worker_pool.h>
+
+class JsonValidator;
+class JsonTape;
+
+/**
+ * @brief Outcome of one asynchronous validation
+ */
+struct JsonAsyncResult
+{
+   int      result;        // same codes as JsonValidator::validate()
+   uint64_t queueWaitNs;   // from submission to the start of the validation
+   uint64_t executionNs;
+};
+
+/**
+ * @brief Runs JsonValidator::validate() on a pool of worker threads so that
+ * an event loop can hand over large documents without blocking. Submissions
+ * go through a bounded queue and are refused when it is full; the number of
+ * validations in flight is then threads + queueDepth, whatever the number of
+ * clients.
+ *
+ * Completion callbacks run on a worker thread and must not throw; they should
+ * hand the result over to the caller's loop. A submitted document must stay
+ * alive and unmodified until its validation completes. The validator is only
+ * read by the workers and may be shared by several JsonAsyncValidator.
+ */
+class JsonAsyncValidator
+{
+   public:
+      typedef std::function<void(const JsonAsyncResult &)> Callback;
+
+      /**
+       * @param validator with its schema loaded, outlives this object
+       * @param threads number of worker threads
+       * @param queueDepth maximum number of documents waiting for a worker
+       */
+      JsonAsyncValidator(JsonValidator *validator, unsigned int threads,
+            size_t queueDepth);
+
+      /**
+       * @brief Completes the validations already accepted
+       */
+      ~JsonAsyncValidator() {}
+
+      /**
+       * @brief Queues a document, done is called with the result
+       *
+       * @return false if the queue is full and the document was not queued
+       */
+      bool submit(const Json::Value *document, const Callback &done);
+
+      bool submit(const JsonTape *document, const Callback &done);
+
+      /**
+       * @brief Queues a document, the future gets the result
+       *
+       * @return a future for which valid() is false if the queue is full
+       */
+      std::future<JsonAsyncResult> submit(const Json::Value *document);
+
+      std::future<JsonAsyncResult> submit(const JsonTape *document);
+
+      /**
+       * @brief Waits for every accepted validation to complete
+       */
+      void drain() {m_pool.drain();}
+
+      /**
+       * @brief Counters and times of the pool, rejected submissions included
+       */
+      JsonWorkerPool::Metrics metrics() const {return m_pool.metrics();}
+
+   private:
+      JsonAsyncValidator(const JsonAsyncValidator &);
+      JsonAsyncValidator &operator=(const JsonAsyncValidator &);
+
+      template <typename T>
+      bool enqueue(const T *document, const Callback &done);
+
+      template <typename T>
+      std::future<JsonAsyncResult> enqueue(const T *document);
+
+      JsonValidator  *m_validator;
+      JsonWorkerPool m_pool;
+};
+
+#endif
@@ -0,0 +1,612 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <tape.h>
+
+// same limit as the JSON text parser
+static const int BINARY_MAX_DEPTH = 1000;
+
+/**
+ * @brief Common state of the MessagePack and CBOR readers. Both walk the
+ * buffer once and write straight into the tape: strings are referenced in
+ * place and numbers are decoded into tape words, no Json::Value is built.
+ */
+class JsonBinaryParser
+{
+   public:
+      JsonBinaryParser(JsonTape *tape, const char *begin, const char *end) :
+         m_tape(tape), m_begin(begin), m_cur(begin), m_end(end) {}
+
+   protected:
+      bool error(const char *message);
+
+      size_t remaining() const {
+         return static_cast<size_t>(m_end - m_cur);
+      }
+
+      /**
+       * @brief Reads a big endian unsigned integer of bytes bytes
+       */
+      bool readUInt(size_t bytes, uint64_t &value);
+
+      /**
+       * @brief Appends a non negative integer with the classification of
+       * Json::Reader, so that a value validates the same whatever its
+       * encoding
+       */
+      void appendUnsigned(uint64_t value);
+
+      bool appendBytes(uint64_t length);
+
+      JsonTape    *m_tape;
+      const char  *m_begin;
+      const char  *m_cur;
+      const char  *m_end;
+};
+
+bool JsonBinaryParser::error(const char *message)
+{
+   char offset[32];
+   snprintf(offset, sizeof(offset), "%lu",
+         static_cast<unsigned long>(m_cur - m_begin));
+   m_tape->m_error = std::string(message) + " at offset " + offset;
+   return false;
+}
+
+bool JsonBinaryParser::readUInt(size_t bytes, uint64_t &value)
+{
+   if (remaining() < bytes) {
+      return error("Unexpected end of document");
+   }
+
+   const unsigned char *p = reinterpret_cast<const unsigned char *>(m_cur);
+   value = 0;
+   for (size_t i = 0; i < bytes; i++) {
+      value = (value << 8) | p[i];
+   }
+   m_cur += bytes;
+   return true;
+}
+
+void JsonBinaryParser::appendUnsigned(uint64_t value)
+{
+   if (value <= static_cast<uint64_t>(Json::Value::maxInt)) {
+      m_tape->appendInt(static_cast<int64_t>(value));
+   } else {
+      m_tape->appendUInt(value);
+   }
+}
+
+bool JsonBinaryParser::appendBytes(uint64_t length)
+{
+   if (remaining() < length) {
+      return error("Unexpected end of document");
+   }
+
+   m_tape->appendSourceString(m_cur, m_cur + length);
+   m_cur += length;
+   return true;
+}
+
+static double floatFromBits(uint64_t bits)
+{
+   uint32_t word = static_cast<uint32_t>(bits);
+   float f;
+   memcpy(&f, &word, sizeof(f));
+   return f;
+}
+
+static double doubleFromBits(uint64_t bits)
+{
+   double d;
+   memcpy(&d, &bits, sizeof(d));
+   return d;
+}
+
+/**
+ * @brief IEEE 754 half precision, only found in CBOR
+ */
+static double halfFromBits(uint64_t bits)
+{
+   int exponent = static_cast<int>((bits >> 10) & 0x1F);
+   double mantissa = static_cast<double>(bits & 0x3FF);
+   double value;
+   if (exponent == 0) {
+      value = ldexp(mantissa, -24);
+   } else if (exponent != 31) {
+      value = ldexp(mantissa + 1024, exponent - 25);
+   } else {
+      value = mantissa == 0 ? HUGE_VAL : NAN;
+   }
+   return (bits & 0x8000) ? -value : value;
+}
+
+/**
+ * @brief MessagePack reader. bin and ext values have no JSON equivalent and
+ * are refused, map keys must be strings.
+ */
+class JsonMessagePackParser : public JsonBinaryParser
+{
+   public:
+      JsonMessagePackParser(JsonTape *tape, const char *begin, const char *end) :
+         JsonBinaryParser(tape, begin, end) {}
+
+      bool parse();
+
+   private:
+      bool parseValue(int depth);
+      bool parseKey();
+      bool parseArray(uint64_t count, int depth);
+      bool parseMap(uint64_t count, int depth);
+};
+
+bool JsonMessagePackParser::parse()
+{
+   if (!parseValue(0)) {
+      return false;
+   }
+
+   if (m_cur != m_end) {
+      return error("Extra bytes after the document");
+   }
+
+   return true;
+}
+
+bool JsonMessagePackParser::parseKey()
+{
+   if (m_cur == m_end) {
+      return error("Unexpected end of document");
+   }
+
+   unsigned char type = static_cast<unsigned char>(*m_cur);
+   uint64_t length = 0;
+   if (type >= 0xA0 && type <= 0xBF) {
+      m_cur++;
+      length = type & 0x1F;
+   } else if (type >= 0xD9 && type <= 0xDB) {
+      m_cur++;
+      if (!readUInt(size_t(1) << (type - 0xD9), length)) {
+         return false;
+      }
+   } else {
+      return error("Object member name must be a string");
+   }
+
+   return appendBytes(length);
+}
+
+bool JsonMessagePackParser::parseArray(uint64_t count, int depth)
+{
+   // every item takes at least one byte
+   if (count > remaining()) {
+      return error("Unexpected end of document");
+   }
+
+   size_t open = m_tape->openContainer('[');
+   for (uint64_t i = 0; i < count; i++) {
+      if (!parseValue(depth + 1)) {
+         return false;
+      }
+   }
+   m_tape->closeContainer(open, count);
+   return true;
+}
+
+bool JsonMessagePackParser::parseMap(uint64_t count, int depth)
+{
+   if (count > remaining() / 2) {
+      return error("Unexpected end of document");
+   }
+
+   size_t open = m_tape->openContainer('{');
+   for (uint64_t i = 0; i < count; i++) {
+      if (!parseKey() || !parseValue(depth + 1)) {
+         return false;
+      }
+   }
+   m_tape->closeContainer(open, count);
+   return true;
+}
+
+bool JsonMessagePackParser::parseValue(int depth)
+{
+   if (depth > BINARY_MAX_DEPTH) {
+      return error("Exceeded stack limit");
+   }
+
+   if (m_cur == m_end) {
+      return error("Unexpected end of document");
+   }
+
+   unsigned char type = static_cast<unsigned char>(*m_cur);
+   if (type <= 0x7F) {
+      m_cur++;
+      m_tape->appendInt(type);
+      return true;
+   }
+   if (type >= 0xE0) {
+      m_cur++;
+      m_tape->appendInt(static_cast<int8_t>(type));
+      return true;
+   }
+   if (type <= 0x8F) {
+      m_cur++;
+      return parseMap(type & 0x0F, depth);
+   }
+   if (type <= 0x9F) {
+      m_cur++;
+      return parseArray(type & 0x0F, depth);
+   }
+   if (type <= 0xBF) {
+      m_cur++;
+      return appendBytes(type & 0x1F);
+   }
+
+   const char *start = m_cur++;
+   uint64_t value = 0;
+   switch (type) {
+      case 0xC0:
+         m_tape->appendNull();
+         return true;
+
+      case 0xC2:
+      case 0xC3:
+         m_tape->appendBool(type == 0xC3);
+         return true;
+
+      case 0xCA:
+         if (!readUInt(4, value)) {
+            return false;
+         }
+         m_tape->appendDouble(floatFromBits(value));
+         return true;
+
+      case 0xCB:
+         if (!readUInt(8, value)) {
+            return false;
+         }
+         m_tape->appendDouble(doubleFromBits(value));
+         return true;
+
+      case 0xCC:
+      case 0xCD:
+      case 0xCE:
+      case 0xCF:
+         if (!readUInt(size_t(1) << (type - 0xCC), value)) {
+            return false;
+         }
+         appendUnsigned(value);
+         return true;
+
+      case 0xD0:
+      case 0xD1:
+      case 0xD2:
+      case 0xD3: {
+         size_t bytes = size_t(1) << (type - 0xD0);
+         if (!readUInt(bytes, value)) {
+            return false;
+         }
+         // sign extend
+         unsigned int shift = static_cast<unsigned int>(64 - 8 * bytes);
+         int64_t i = static_cast<int64_t>(value << shift) >> shift;
+         if (i >= 0) {
+            appendUnsigned(static_cast<uint64_t>(i));
+         } else {
+            m_tape->appendInt(i);
+         }
+         return true;
+      }
+
+      case 0xD9:
+      case 0xDA:
+      case 0xDB:
+         if (!readUInt(size_t(1) << (type - 0xD9), value)) {
+            return false;
+         }
+         return appendBytes(value);
+
+      case 0xDC:
+      case 0xDD:
+         if (!readUInt(type == 0xDC ? 2 : 4, value)) {
+            return false;
+         }
+         return parseArray(value, depth);
+
+      case 0xDE:
+      case 0xDF:
+         if (!readUInt(type == 0xDE ? 2 : 4, value)) {
+            return false;
+         }
+         return parseMap(value, depth);
+
+      default:
+         // 0xC1 is never used, bin and ext have no JSON equivalent
+         m_cur = start;
+         return error("Unsupported MessagePack type");
+   }
+}
+
+/**
+ * @brief CBOR (RFC 7049) reader. Tags are skipped, byte strings and simple
+ * values other than false, true and null are refused, map keys must be text
+ * strings. Chunked text strings are the only values copied into the tape.
+ */
+class JsonCborParser : public JsonBinaryParser
+{
+   public:
+      JsonCborParser(JsonTape *tape, const char *begin, const char *end) :
+         JsonBinaryParser(tape, begin, end) {}
+
+      bool parse();
+
+   private:
+      bool parseValue(int depth);
+      bool parseText(unsigned int info);
+      bool parseContainer(char tag, unsigned int info, int depth);
+      bool readArgument(unsigned int info, uint64_t &value);
+      bool atBreak();
+
+      std::string m_scratch;
+};
+
+bool JsonCborParser::parse()
+{
+   if (!parseValue(0)) {
+      return false;
+   }
+
+   if (m_cur != m_end) {
+      return error("Extra bytes after the document");
+   }
+
+   return true;
+}
+
+bool JsonCborParser::readArgument(unsigned int info, uint64_t &value)
+{
+   if (info < 24) {
+      value = info;
+      return true;
+   }
+   if (info <= 27) {
+      return readUInt(size_t(1) << (info - 24), value);
+   }
+
+   m_cur--;
+   return error("Invalid CBOR additional information");
+}
+
+bool JsonCborParser::atBreak()
+{
+   if (m_cur < m_end && static_cast<unsigned char>(*m_cur) == 0xFF) {
+      m_cur++;
+      return true;
+   }
+
+   return false;
+}
+
+bool JsonCborParser::parseText(unsigned int info)
+{
+   uint64_t length = 0;
+   if (info != 31) {
+      return readArgument(info, length) && appendBytes(length);
+   }
+
+   // indefinite length, a sequence of definite text chunks
+   m_scratch.clear();
+   while (!atBreak()) {
+      if (m_cur == m_end) {
+         return error("Unexpected end of document");
+      }
+      unsigned char type = static_cast<unsigned char>(*m_cur);
+      if ((type >> 5) != 3 || (type & 0x1F) == 31) {
+         return error("Invalid chunk in text string");
+      }
+      m_cur++;
+      if (!readArgument(type & 0x1F, length)) {
+         return false;
+      }
+      if (remaining() < length) {
+         return error("Unexpected end of document");
+      }
+      m_scratch.append(m_cur, static_cast<size_t>(length));
+      m_cur += length;
+   }
+
+   m_tape->appendString(m_scratch.data(), m_scratch.data() + m_scratch.size());
+   return true;
+}
+
+bool JsonCborParser::parseContainer(char tag, unsigned int info, int depth)
+{
+   bool object = (tag == '{');
+   bool indefinite = (info == 31);
+   uint64_t count = 0;
+   if (!indefinite) {
+      if (!readArgument(info, count)) {
+         return false;
+      }
+      if (count > (object ? remaining() / 2 : remaining())) {
+         return error("Unexpected end of document");
+      }
+   }
+
+   size_t open = m_tape->openContainer(tag);
+   uint64_t items = 0;
+   while (indefinite ? !atBreak() : items < count) {
+      if (object) {
+         if (m_cur == m_end) {
+            return error("Unexpected end of document");
+         }
+         unsigned char type = static_cast<unsigned char>(*m_cur);
+         if ((type >> 5) != 3) {
+            return error("Object member name must be a text string");
+         }
+         m_cur++;
+         if (!parseText(type & 0x1F)) {
+            return false;
+         }
+      }
+      if (!parseValue(depth + 1)) {
+         return false;
+      }
+      items++;
+   }
+
+   m_tape->closeContainer(open, items);
+   return true;
+}
+
+bool JsonCborParser::parseValue(int depth)
+{
+   if (depth > BINARY_MAX_DEPTH) {
+      return error("Exceeded stack limit");
+   }
+
+   if (m_cur == m_end) {
+      return error("Unexpected end of document");
+   }
+
+   const char *start = m_cur;
+   unsigned char type = static_cast<unsigned char>(*m_cur++);
+   unsigned int major = type >> 5;
+   unsigned int info = type & 0x1F;
+   uint64_t value = 0;
+
+   switch (major) {
+      case 0:
+         if (!readArgument(info, value)) {
+            return false;
+         }
+         appendUnsigned(value);
+         return true;
+
+      case 1:
+         if (!readArgument(info, value)) {
+            return false;
+         }
+         // -1 - value, past int64 it overflows to a double like the JSON
+         // reader does
+         if (value <= static_cast<uint64_t>(Json::Value::maxInt64)) {
+            m_tape->appendInt(-1 - static_cast<int64_t>(value));
+         } else {
+            m_tape->appendDouble(-1.0 - static_cast<double>(value));
+         }
+         return true;
+
+      case 3:
+         return parseText(info);
+
+      case 4:
+         return parseContainer('[', info, depth);
+
+      case 5:
+         return parseContainer('{', info, depth);
+
+      case 6:
+         // tagged value, the tag carries no meaning for JSON
+         if (!readArgument(info, value)) {
+            return false;
+         }
+         return parseValue(depth + 1);
+
+      case 7:
+         switch (info) {
+            case 20:
+            case 21:
+               m_tape->appendBool(info == 21);
+               return true;
+            case 22:
+               m_tape->appendNull();
+               return true;
+            case 25:
+               if (!readUInt(2, value)) {
+                  return false;
+               }
+               m_tape->appendDouble(halfFromBits(value));
+               return true;
+            case 26:
+               if (!readUInt(4, value)) {
+                  return false;
+               }
+               m_tape->appendDouble(floatFromBits(value));
+               return true;
+            case 27:
+               if (!readUInt(8, value)) {
+                  return false;
+               }
+               m_tape->appendDouble(doubleFromBits(value));
+               return true;
+            default:
+               m_cur = start;
+               return error("Unsupported CBOR simple value");
+         }
+
+      default:
+         m_cur = start;
+         return error("Unsupported CBOR byte string");
+   }
+}
+
+bool JsonTape::parseMessagePack(const char *begin, const char *end)
+{
+   clear();
+   setSource(begin);
+
+   // a scalar takes two words for as little as one byte, the text parser's
+   // estimate is kept as a compromise between reallocations and memory
+   m_tape.reserve(static_cast<size_t>(end - begin) / 3 + 2);
+
+   JsonMessagePackParser parser(this, begin, end);
+   if (!parser.parse()) {
+      m_tape.clear();
+      m_strings.clear();
+      return false;
+   }
+
+   return true;
+}
+
+bool JsonTape::parseCbor(const char *begin, const char *end)
+{
+   clear();
+   setSource(begin);
+   m_tape.reserve(static_cast<size_t>(end - begin) / 3 + 2);
+
+   JsonCborParser parser(this, begin, end);
+   if (!parser.parse()) {
+      m_tape.clear();
+      m_strings.clear();
+      return false;
+   }
+
+   return true;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <json.h>
+#include <budget.h>
+
+static JSONCPP_THREAD_LOCAL JsonBudget *currentBudget = NULL;
+
+JsonBudget::Scope::Scope(JsonBudget &budget)
+{
+   m_previous = currentBudget;
+   currentBudget = &budget;
+}
+
+JsonBudget::Scope::~Scope()
+{
+   currentBudget = m_previous;
+}
+
+JsonBudget::JsonBudget()
+{
+   m_remaining = SIZE_MAX;
+   m_used = 0;
+   m_untilPoll = JVAL_BUDGET_POLL_STEPS;
+   m_exceeded = false;
+   m_hasDeadline = false;
+   m_cancel = NULL;
+}
+
+JsonBudget *JsonBudget::current()
+{
+   return currentBudget;
+}
+
+bool JsonBudget::poll()
+{
+   m_untilPoll = JVAL_BUDGET_POLL_STEPS;
+
+   if (NULL != m_cancel && m_cancel->load(std::memory_order_relaxed)) {
+      m_exceeded = true;
+   } else if (m_hasDeadline && Clock::now() >= m_deadline) {
+      m_exceeded = true;
+   }
+
+   return !m_exceeded;
+}
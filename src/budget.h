@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __BUDGET_H__
+#define __BUDGET_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+// steps between two looks at the clock and the cancellation flag
+#define JVAL_BUDGET_POLL_STEPS   64
+
+/**
+ * @brief Bounds the work of a validation: a number of steps, a deadline and a
+ * cancellation flag, any of which may be left unset. A step is one item or
+ * member visited by items, properties or uniqueItems, so the loops over large
+ * arrays and objects stop soon after the budget runs out and the validation
+ * returns JVAL_ERR_BUDGET_EXCEEDED.
+ *
+ * A budget is consulted while a JsonBudget::Scope is active on the thread.
+ * It is spent by one validation at a time.
+ */
+class JsonBudget
+{
+   public:
+      typedef std::chrono::steady_clock Clock;
+
+      /**
+       * @brief Makes a budget the one spent by the calling thread for the
+       * lifetime of the scope
+       */
+      class Scope
+      {
+         public:
+            explicit Scope(JsonBudget &budget);
+            ~Scope();
+
+         private:
+            Scope(const Scope &);
+            Scope &operator=(const Scope &);
+
+            JsonBudget *m_previous;
+      };
+
+      // unlimited until set otherwise
+      JsonBudget();
+
+      ~JsonBudget() {}
+
+      void setSteps(size_t steps) {m_remaining = steps;}
+
+      void setDeadline(Clock::time_point deadline) {
+         m_deadline = deadline;
+         m_hasDeadline = true;
+      }
+
+      /**
+       * @brief Stops the validation once cancel becomes true; the flag has to
+       * outlive the validations spending the budget
+       */
+      void setCancel(const std::atomic<bool> *cancel) {m_cancel = cancel;}
+
+      /**
+       * @brief Spends one step
+       *
+       * @return false if the budget is exceeded
+       */
+      bool step() {
+         if (m_exceeded) {
+            return false;
+         }
+
+         if (0 == m_remaining) {
+            m_exceeded = true;
+            return false;
+         }
+
+         m_remaining--;
+         m_used++;
+         if (0 == --m_untilPoll) {
+            return poll();
+         }
+
+         return true;
+      }
+
+      /**
+       * @brief Spends one step of budget, if there is one, as the loops over
+       * items and members do
+       *
+       * @return false if the budget is exceeded
+       */
+      static bool spend(JsonBudget *budget) {
+         return NULL == budget || budget->step();
+      }
+
+      bool exceeded() const {return m_exceeded;}
+
+      size_t used() const {return m_used;}
+
+      /**
+       * @brief Budget of the innermost Scope on the calling thread, or NULL
+       */
+      static JsonBudget *current();
+
+   private:
+      JsonBudget(const JsonBudget &);
+      JsonBudget &operator=(const JsonBudget &);
+
+      // looks at the deadline and the cancellation flag
+      bool poll();
+
+      size_t                     m_remaining;
+      size_t                     m_used;
+      unsigned                   m_untilPoll;
+      bool                       m_exceeded;
+      bool                       m_hasDeadline;
+      Clock::time_point          m_deadline;
+      const std::atomic<bool>    *m_cancel;
+};
+
+#endif
@@ -0,0 +1,668 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <sstream>
+#include <ostream>
+#include <map>
+#include <vector>
+#include <regex>
+#include <algorithm>
+#include <stdint.h>
+#include <json.h>
+#include <number.h>
+#include <format.h>
+#include <primitive_base.h>
+#include <schema_cache.h>
+#include <keyword_validator.h>
+#include <codegen.h>
+
+static std::string nodeName(int node)
+{
+   std::ostringstream name;
+   name << "jval_node_" << node;
+   return name.str();
+}
+
+/**
+ * @brief C++ string literal for arbitrary bytes. '?' is escaped too since
+ * --std=c++0x enables trigraphs
+ */
+static std::string stringLiteral(const std::string &str)
+{
+   std::string literal = "\"";
+   for (size_t i = 0; i < str.size(); i++) {
+      unsigned char c = static_cast<unsigned char>(str[i]);
+      if (c == '"' || c == '\\' || c == '?') {
+         literal += '\\';
+         literal += static_cast<char>(c);
+      } else if (c < 0x20 || c >= 0x7f) {
+         char octal[8];
+         snprintf(octal, sizeof(octal), "\\%03o", c);
+         literal += octal;
+      } else {
+         literal += static_cast<char>(c);
+      }
+   }
+
+   return literal + "\"";
+}
+
+static std::string uintLiteral(unsigned int value)
+{
+   std::ostringstream literal;
+   literal << value << "U";
+   return literal.str();
+}
+
+static std::string doubleLiteral(double value)
+{
+   if (std::isnan(value)) {
+      return "std::numeric_limits<double>::quiet_NaN()";
+   }
+
+   if (std::isinf(value)) {
+      return value > 0 ? "std::numeric_limits<double>::infinity()" : \
+         "-std::numeric_limits<double>::infinity()";
+   }
+
+   // %.17g reads back to the same double
+   char literal[40];
+   snprintf(literal, sizeof(literal), "%.17g", value);
+
+   std::string str(literal);
+   if (str.find_first_of(".en") == std::string::npos) {
+      str += ".0";
+   }
+   return str;
+}
+
+static bool exclusive(Json::Value *schema, const char *keyword)
+{
+   if (schema->isMember(keyword)) {
+      Json::Value v = schema->get(keyword, v);
+      return v.asBool();
+   }
+
+   return false;
+}
+
+// inline function of a built-in format checker, NULL for custom ones
+static const char *formatFunction(JsonFormat::Checker checker)
+{
+   if (checker == &JsonFormat::dateTime) {
+      return "JsonFormat::dateTime";
+   } else if (checker == &JsonFormat::email) {
+      return "JsonFormat::email";
+   } else if (checker == &JsonFormat::hostname) {
+      return "JsonFormat::hostname";
+   } else if (checker == &JsonFormat::ipv4) {
+      return "JsonFormat::ipv4";
+   } else if (checker == &JsonFormat::ipv6) {
+      return "JsonFormat::ipv6";
+   } else if (checker == &JsonFormat::uri) {
+      return "JsonFormat::uri";
+   }
+
+   return NULL;
+}
+
+void JsonCodeGenerator::generate(Json::Value *schema,
+      const std::string &function, std::ostream &out)
+{
+   // the schemas JsonValidator rejects, e.g. for a keyword of the wrong
+   // type, are rejected before any of their keywords is converted
+   JsonSchemaCache cache;
+   JsonSchemaCache::Scope scope(cache);
+   JsonPrimitive::release(JsonPrimitive::createPrimitive(schema));
+   if (cache.failed()) {
+      throw Exception(cache.error());
+   }
+
+   m_nodes = 0;
+   m_declarations.str("");
+   m_definitions.str("");
+
+   int root = emitNode(schema);
+
+   out << "// Generated by jval-codegen. Do not edit.\n"
+      "\n"
+      "#include <string.h>\n"
+      "#include <stdint.h>\n"
+      "#include <cmath>\n"
+      "#include <limits>\n"
+      "#include <algorithm>\n"
+      "#include <set>\n"
+      "#include <string>\n"
+      "#include <regex>\n"
+      "#include <json.h>\n"
+      "#include <number.h>\n"
+      "#include <format.h>\n"
+      "#include <primitive_base.h>\n"
+      "\n"
+      "int " << function << "(const Json::Value *value);\n"
+      "\n"
+      << m_declarations.str() << "\n" << m_definitions.str() <<
+      "int " << function << "(const Json::Value *value)\n"
+      "{\n"
+      "   return " << nodeName(root) << "(*value);\n"
+      "}\n";
+}
+
+int JsonCodeGenerator::emitNode(Json::Value *schema)
+{
+   int node = m_nodes++;
+   std::ostringstream body;
+
+   switch (JsonPrimitive::getPrimitveType(schema)) {
+      case JSON_TYPE_INTEGER:
+         emitInteger(schema, body);
+         break;
+      case JSON_TYPE_NUMBER:
+         emitNumber(schema, body);
+         break;
+      case JSON_TYPE_STRING:
+         emitString(schema, body);
+         break;
+      case JSON_TYPE_OBJECT:
+         emitObject(schema, body);
+         emitDependencies(schema, body);
+         break;
+      case JSON_TYPE_ARRAY:
+         emitArray(schema, body);
+         break;
+      case JSON_TYPE_BOOLEAN:
+      case JSON_TYPE_NULL:
+         body << "   (void)value;\n";
+         break;
+      default:
+         throw Exception("Invalid Schema");
+   }
+
+   m_declarations << "static int " << nodeName(node) << \
+      "(const Json::Value &value);\n";
+   m_definitions << "static int " << nodeName(node) << \
+      "(const Json::Value &value)\n{\n" << body.str() << \
+      "   return JVAL_ROK;\n}\n\n";
+
+   return node;
+}
+
+static std::string numberLiteral(const JsonNumberValue &number)
+{
+   std::ostringstream literal;
+   literal << "{JsonNumberValue::";
+   switch (number.kind) {
+      case JsonNumberValue::INTEGER:
+         if (number.i == std::numeric_limits<int64_t>::min()) {
+            literal << "INTEGER, (" << number.i + 1 << "LL - 1)";
+         } else {
+            literal << "INTEGER, " << number.i << "LL";
+         }
+         literal << ", 0ULL, 0.0}";
+         break;
+      case JsonNumberValue::UNSIGNED:
+         literal << "UNSIGNED, 0LL, " << number.u << "ULL, 0.0}";
+         break;
+      default:
+         literal << "REAL, 0LL, 0ULL, " << doubleLiteral(number.d) << "}";
+         break;
+   }
+   return literal.str();
+}
+
+// mirrors NumberRange
+void JsonCodeGenerator::emitNumberRange(Json::Value *schema, std::ostream &out)
+{
+   // rejects the schemas NumberRange rejects
+   NumberRange range(schema);
+   if (range.empty()) {
+      return;
+   }
+
+   out << "   const JsonNumberValue number = JsonNumberValue::of(value);\n";
+
+   if (schema->isMember("minimum")) {
+      Json::Value min = schema->get("minimum", min);
+      out << "   {\n"
+         "      const JsonNumberValue minimum = " << \
+         numberLiteral(JsonNumberValue::of(min)) << ";\n"
+         "      int c = JsonNumberValue::compare(number, minimum);\n"
+         "      if (c < 0" << \
+         (exclusive(schema, "exclusiveMinimum") ? " || c == 0" : "") << \
+         ") {\n"
+         "         return JVAL_ERR_INVALID_MINIMUM;\n"
+         "      }\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("maximum")) {
+      Json::Value max = schema->get("maximum", max);
+      out << "   {\n"
+         "      const JsonNumberValue maximum = " << \
+         numberLiteral(JsonNumberValue::of(max)) << ";\n"
+         "      int c = JsonNumberValue::compare(number, maximum);\n"
+         "      if ((c > 0 && c != JSON_NUMBER_UNORDERED)" << \
+         (exclusive(schema, "exclusiveMaximum") ? " || c == 0" : "") << \
+         ") {\n"
+         "         return JVAL_ERR_INVALID_MAXIMUM;\n"
+         "      }\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("multipleOf")) {
+      Json::Value divisor = schema->get("multipleOf", divisor);
+      JsonMultipleOf multipleOf = JsonMultipleOf::of(
+            JsonNumberValue::of(divisor));
+      out << "   {\n"
+         "      static const JsonMultipleOf multipleOf = {" << \
+         numberLiteral(multipleOf.divisor) << ", " << \
+         (multipleOf.decimal ? "true" : "false") << ", " << \
+         multipleOf.units << "ULL, " << multipleOf.scale << "U, " << \
+         multipleOf.step << "ULL};\n"
+         "      if (!multipleOf.check(number)) {\n"
+         "         return JVAL_ERR_NOT_A_MULTIPLE;\n"
+         "      }\n"
+         "   }\n";
+   }
+}
+
+// mirrors the keywords set up by JsonInteger
+void JsonCodeGenerator::emitInteger(Json::Value *schema, std::ostream &out)
+{
+   out << "   if (!value.isInt()) {\n"
+      "      return JVAL_ERR_NOT_AN_INTEGER;\n"
+      "   }\n";
+
+   emitNumberRange(schema, out);
+}
+
+// mirrors the keywords set up by JsonNumber
+void JsonCodeGenerator::emitNumber(Json::Value *schema, std::ostream &out)
+{
+   out << "   if (!value.isNumeric()) {\n"
+      "      return JVAL_ERR_NOT_A_NUMBER;\n"
+      "   }\n";
+
+   emitNumberRange(schema, out);
+}
+
+// mirrors the keywords set up by JsonString
+void JsonCodeGenerator::emitString(Json::Value *schema, std::ostream &out)
+{
+   out << "   if (!value.isString()) {\n"
+      "      return JVAL_ERR_NOT_A_STRING;\n"
+      "   }\n";
+
+   bool minLength = schema->isMember("minLength");
+   bool maxLength = schema->isMember("maxLength");
+   bool pattern = schema->isMember("pattern");
+   JsonFormat::Checker checker = Format::lookup(schema);
+   if (!minLength && !maxLength && !pattern && NULL == checker) {
+      return;
+   }
+
+   out << "   const char *begin = NULL;\n"
+      "   const char *end = NULL;\n"
+      "   value.getString(&begin, &end);\n";
+
+   if (minLength) {
+      Json::Value min = schema->get("minLength", min);
+      out << "   if (static_cast<size_t>(end - begin) < " << \
+         uintLiteral(min.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MIN_LENGTH;\n"
+         "   }\n";
+   }
+
+   if (maxLength) {
+      Json::Value max = schema->get("maxLength", max);
+      out << "   if (static_cast<size_t>(end - begin) > " << \
+         uintLiteral(max.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MAX_LENGTH;\n"
+         "   }\n";
+   }
+
+   if (pattern) {
+      Json::Value p = schema->get("pattern", p);
+
+      // reject the patterns the interpreter fails to compile
+      std::regex check(p.asString());
+      (void)check;
+
+      out << "   static const std::regex pattern(" << \
+         stringLiteral(p.asString()) << ");\n"
+         "   if (!std::regex_match(begin, end, pattern)) {\n"
+         "      return JVAL_ERR_PATTERN_MISMATCH;\n"
+         "   }\n";
+   }
+
+   if (NULL != checker) {
+      const char *function = formatFunction(checker);
+      if (NULL != function) {
+         out << "   if (!" << function << "(begin, end)) {\n";
+      } else {
+         // looked up when first used, in the program running the code
+         Json::Value format = schema->get("format", format);
+         out << "   static const JsonFormat::Checker format = " \
+            "JsonFormat::find(" << stringLiteral(format.asString()) << ");\n"
+            "   if (NULL != format && !format(begin, end)) {\n";
+      }
+      out << "      return JVAL_ERR_INVALID_FORMAT;\n"
+         "   }\n";
+   }
+}
+
+// mirrors the keywords set up by JsonArray
+void JsonCodeGenerator::emitArray(Json::Value *schema, std::ostream &out)
+{
+   out << "   if (!value.isArray()) {\n"
+      "      return JVAL_ERR_NOT_AN_ARRAY;\n"
+      "   }\n";
+
+   if (schema->isMember("minItems")) {
+      Json::Value min = schema->get("minItems", min);
+      out << "   if (value.size() < " << uintLiteral(min.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MIN_ITEMS;\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("maxItems")) {
+      Json::Value max = schema->get("maxItems", max);
+      out << "   if (value.size() > " << uintLiteral(max.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MAX_ITEMS;\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("uniqueItems")) {
+      Json::Value unique = schema->get("uniqueItems", unique);
+      if (unique.asBool()) {
+         out << "   {\n"
+            "      std::set<Json::Value> seen;\n"
+            "      for (Json::ArrayIndex i = 0; i < value.size(); i++) {\n"
+            "         if (!seen.insert(value[i]).second) {\n"
+            "            return JVAL_ERR_DUPLICATE_ITEMS;\n"
+            "         }\n"
+            "      }\n"
+            "   }\n";
+      }
+   }
+
+   if (!schema->isMember("items")) {
+      return;
+   }
+
+   Json::Value items = schema->get("items", items);
+   if (items.isArray()) {
+      if (schema->isMember("additionalItems")) {
+         Json::Value ai = schema->get("additionalItems", ai);
+         if (ai.type() == Json::booleanValue && ai.asBool() == false) {
+            out << "   if (value.size() > " << uintLiteral(items.size()) << \
+               ") {\n"
+               "      return JVAL_ERR_ADDITIONAL_ITEMS;\n"
+               "   }\n";
+         }
+      }
+
+      // the children are generated first so their numbers are known
+      std::vector<int> nodes;
+      for (Json::ArrayIndex i = 0; i < items.size(); i++) {
+         nodes.push_back(emitNode(&items[i]));
+      }
+
+      for (Json::ArrayIndex i = 0; i < items.size(); i++) {
+         out << "   if (value.size() > " << uintLiteral(i) << " && \\\n"
+            "         JVAL_ROK != " << nodeName(nodes[i]) << "(value[" << \
+            uintLiteral(i) << "])) {\n"
+            "      return JVAL_ERR_INVALID_ARRAY_ITEM;\n"
+            "   }\n";
+      }
+   } else if (items.isObject()) {
+      int node = emitNode(&items);
+      out << "   for (Json::ValueConstIterator itr = value.begin();\n"
+         "         itr != value.end();\n"
+         "         ++itr) {\n"
+         "      if (JVAL_ROK != " << nodeName(node) << "(*itr)) {\n"
+         "         return JVAL_ERR_INVALID_ARRAY_ITEM;\n"
+         "      }\n"
+         "   }\n";
+   }
+}
+
+// mirrors the keywords set up by JsonObject
+void JsonCodeGenerator::emitObject(Json::Value *schema, std::ostream &out)
+{
+   out << "   if (!value.isObject()) {\n"
+      "      return JVAL_ERR_NOT_AN_OBJECT;\n"
+      "   }\n";
+
+   if (schema->isMember("minProperties")) {
+      Json::Value min = schema->get("minProperties", min);
+      out << "   if (value.size() < " << uintLiteral(min.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MIN_PROPERTIES;\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("maxProperties")) {
+      Json::Value max = schema->get("maxProperties", max);
+      out << "   if (value.size() > " << uintLiteral(max.asUInt()) << ") {\n"
+         "      return JVAL_ERR_INVALID_MAX_PROPERTIES;\n"
+         "   }\n";
+   }
+
+   if (schema->isMember("required")) {
+      Json::Value req = schema->get("required", req);
+      for (Json::ArrayIndex i = 0; i < req.size(); i++) {
+         std::string name = req[i].asString();
+         out << "   if (NULL == value.find(" << stringLiteral(name) << \
+            ", " << stringLiteral(name) << " + " << name.size() << ")) {\n"
+            "      return JVAL_ERR_REQUIRED_ITEM_MISSING;\n"
+            "   }\n";
+      }
+   }
+
+   Json::Value patterns = schema->get("patternProperties", Json::nullValue);
+   if (!patterns.isNull() && !patterns.isObject()) {
+      throw Exception("Invalid Schema");
+   }
+
+   // a missing additionalProperties allows the undeclared members, as
+   // JsonObject does
+   Json::Value additional = schema->get("additionalProperties",
+         Json::nullValue);
+   bool allowed = true;
+   if (additional.isBool()) {
+      allowed = additional.asBool();
+   } else if (!additional.isNull() && !additional.isObject()) {
+      throw Exception("Invalid Schema");
+   }
+
+   Json::Value properties = schema->get("properties", Json::nullValue);
+   if (allowed && !additional.isObject() && properties.empty() && \
+         patterns.empty()) {
+      return;
+   }
+
+   // member names grouped by length for the switch
+   std::map<size_t, std::vector<std::pair<std::string, int> > > names;
+   for (Json::ValueIterator itr = properties.begin();
+         itr != properties.end();
+         itr++) {
+      Json::Value property = properties.get(itr.name(), property);
+      std::string name = itr.name();
+      names[name.size()].push_back(std::make_pair(name, emitNode(&property)));
+   }
+
+   // the patterns in the order Properties tries them
+   std::vector<std::pair<std::string, int> > searched;
+   for (Json::ValueIterator itr = patterns.begin();
+         itr != patterns.end();
+         itr++) {
+      Json::Value property = patterns.get(itr.name(), property);
+      std::string pattern = itr.name();
+
+      // reject the patterns the interpreter fails to compile
+      std::regex check(pattern);
+      (void)check;
+
+      searched.push_back(std::make_pair(pattern, emitNode(&property)));
+   }
+
+   int node = additional.isObject() ? emitNode(&additional) : -1;
+
+   // the members neither the switch nor a pattern covers are additional;
+   // without patterns the switch deals with them at once, with them a flag
+   // tells whether one was found
+   bool flagged = !searched.empty() && (!allowed || node >= 0);
+   std::string unknown;
+   if (flagged) {
+      unknown = "matched = false;";
+   } else if (!allowed) {
+      unknown = "return JVAL_ERR_UNKNOWN_PROPERTY;";
+   } else if (node >= 0 && searched.empty()) {
+      unknown = "ret = " + nodeName(node) + "(*itr);";
+   }
+
+   out << "   for (Json::ValueConstIterator itr = value.begin();\n"
+      "         itr != value.end();\n"
+      "         ++itr) {\n"
+      "      const char *end = NULL;\n"
+      "      const char *name = itr.memberName(&end);\n";
+
+   if (flagged) {
+      out << "      bool matched = " << (names.empty() ? "false" : "true") << \
+         ";\n";
+   }
+
+   if (!names.empty() || searched.empty()) {
+      out << "      int ret = JVAL_ROK;\n"
+         "      switch (end - name) {\n";
+
+      for (std::map<size_t, std::vector<std::pair<std::string, int> > >::
+            iterator length = names.begin();
+            length != names.end();
+            length++) {
+         out << "         case " << length->first << ":\n";
+         for (size_t i = 0; i < length->second.size(); i++) {
+            const std::pair<std::string, int> &member = length->second[i];
+            out << "            " << (i > 0 ? "} else " : "") << \
+               "if (0 == memcmp(name, " << stringLiteral(member.first) << \
+               ", " << length->first << ")) {\n"
+               "               ret = " << nodeName(member.second) << \
+               "(*itr);\n";
+         }
+         if (!unknown.empty()) {
+            out << "            } else {\n"
+               "               " << unknown << "\n";
+         }
+         out << "            }\n"
+            "            break;\n";
+      }
+
+      out << "         default:\n"
+         "            " << (unknown.empty() ? "break;" : unknown) << "\n"
+         "      }\n"
+         "      if (JVAL_ROK != ret) {\n"
+         "         return JVAL_ERR_INVALID_PROPERTY;\n"
+         "      }\n";
+   }
+
+   for (size_t i = 0; i < searched.size(); i++) {
+      out << "      {\n"
+         "         static const std::regex pattern(" << \
+         stringLiteral(searched[i].first) << ");\n"
+         "         if (std::regex_search(name, end, pattern)) {\n" << \
+         (flagged ? "            matched = true;\n" : "") << \
+         "            if (JVAL_ROK != " << nodeName(searched[i].second) << \
+         "(*itr)) {\n"
+         "               return JVAL_ERR_INVALID_PROPERTY;\n"
+         "            }\n"
+         "         }\n"
+         "      }\n";
+   }
+
+   if (flagged && !allowed) {
+      out << "      if (!matched) {\n"
+         "         return JVAL_ERR_UNKNOWN_PROPERTY;\n"
+         "      }\n";
+   } else if (flagged) {
+      out << "      if (!matched && JVAL_ROK != " << nodeName(node) << \
+         "(*itr)) {\n"
+         "         return JVAL_ERR_INVALID_PROPERTY;\n"
+         "      }\n";
+   }
+
+   out << "   }\n";
+}
+
+// mirrors Dependencies, which runs after the keywords of emitObject
+void JsonCodeGenerator::emitDependencies(Json::Value *schema,
+      std::ostream &out)
+{
+   if (!schema->isMember("dependencies")) {
+      return;
+   }
+
+   Json::Value dependencies = schema->get("dependencies", dependencies);
+   if (!dependencies.isObject()) {
+      throw Exception("Invalid Schema");
+   }
+
+   for (Json::ValueIterator itr = dependencies.begin();
+         itr != dependencies.end();
+         itr++) {
+      Json::Value dependency = dependencies.get(itr.name(), dependency);
+      std::string name = itr.name();
+      std::string present = "NULL != value.find(" + stringLiteral(name) + \
+         ", " + stringLiteral(name) + " + " + std::to_string(name.size()) + \
+         ")";
+
+      if (dependency.isObject()) {
+         int node = emitNode(&dependency);
+         out << "   if (" << present << " && \\\n"
+            "         JVAL_ROK != " << nodeName(node) << "(value)) {\n"
+            "      return JVAL_ERR_INVALID_DEPENDENCY;\n"
+            "   }\n";
+         continue;
+      }
+
+      if (!dependency.isArray()) {
+         throw Exception("Invalid Schema");
+      }
+
+      out << "   if (" << present << ") {\n";
+      for (Json::ArrayIndex i = 0; i < dependency.size(); i++) {
+         if (!dependency[i].isString()) {
+            throw Exception("Invalid Schema");
+         }
+         std::string required = dependency[i].asString();
+         out << "      if (NULL == value.find(" << stringLiteral(required) << \
+            ", " << stringLiteral(required) << " + " << required.size() << \
+            ")) {\n"
+            "         return JVAL_ERR_DEPENDENCY_MISSING;\n"
+            "      }\n";
+      }
+      out << "   }\n";
+   }
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __CODEGEN_H__
+#define __CODEGEN_H__
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Translates a schema into a self-contained C++ source file with one
+ * straight-line function per subschema. The generated entry point
+ *
+ *    int <function>(const Json::Value *value);
+ *
+ * returns the same JVAL_* codes as JsonValidator::validate() does for the
+ * same schema: the keywords are checked in the same order and with the same
+ * Json::Value calls, but the constants are inlined, properties are
+ * dispatched by a generated switch and no virtual call is left. Custom
+ * formats are looked up by name with JsonFormat::find() and so need format.o
+ * and the same JsonFormat::define() calls in the program using the code.
+ */
+class JsonCodeGenerator
+{
+   public:
+      JsonCodeGenerator() : m_nodes(0) {}
+
+      ~JsonCodeGenerator() {}
+
+      /**
+       * @brief Writes the source of a validator for schema
+       *
+       * @param schema
+       * @param function name of the generated entry point
+       * @param out
+       *
+       * Throws Exception for the schemas JsonValidator rejects.
+       */
+      void generate(Json::Value *schema, const std::string &function,
+            std::ostream &out);
+
+   private:
+      JsonCodeGenerator(const JsonCodeGenerator &);
+      JsonCodeGenerator &operator=(const JsonCodeGenerator &);
+
+      int emitNode(Json::Value *schema);
+      void emitNumberRange(Json::Value *schema, std::ostream &out);
+      void emitInteger(Json::Value *schema, std::ostream &out);
+      void emitNumber(Json::Value *schema, std::ostream &out);
+      void emitString(Json::Value *schema, std::ostream &out);
+      void emitArray(Json::Value *schema, std::ostream &out);
+      void emitObject(Json::Value *schema, std::ostream &out);
+      void emitDependencies(Json::Value *schema, std::ostream &out);
+
+      int                  m_nodes;
+      std::ostringstream   m_declarations;
+      std::ostringstream   m_definitions;
+};
+
+#endif
@@ -0,0 +1,516 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <dirent.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <exception>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <regex>
+#include <thread>
+#include <json.h>
+#include <tape.h>
+#include <primitive_base.h>
+#include <validator.h>
+#include <daemon.h>
+
+// answers to requests already buffered are written together
+#define JVALD_READ_SIZE    (64U << 10)
+#define JVALD_SEND_BUFFER  (64U << 10)
+
+static inline uint32_t decodeLength(const char *p)
+{
+   const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+   return (static_cast<uint32_t>(b[0]) << 24) | \
+      (static_cast<uint32_t>(b[1]) << 16) | \
+      (static_cast<uint32_t>(b[2]) << 8) | static_cast<uint32_t>(b[3]);
+}
+
+static inline void appendLength(std::vector<char> &out, uint32_t length)
+{
+   out.push_back(static_cast<char>(length >> 24));
+   out.push_back(static_cast<char>(length >> 16));
+   out.push_back(static_cast<char>(length >> 8));
+   out.push_back(static_cast<char>(length));
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+   while (size > 0) {
+      ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+      if (n < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         return false;
+      }
+      data += n;
+      size -= static_cast<size_t>(n);
+   }
+
+   return true;
+}
+
+static ssize_t readSome(int fd, char *data, size_t size)
+{
+   for (;;) {
+      ssize_t n = ::read(fd, data, size);
+      if (n >= 0 || errno != EINTR) {
+         return n;
+      }
+   }
+}
+
+static bool socketAddress(const char *path, struct sockaddr_un &address)
+{
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   if (strlen(path) >= sizeof(address.sun_path)) {
+      return false;
+   }
+
+   strcpy(address.sun_path, path);
+   return true;
+}
+
+JsonDaemon::JsonDaemon()
+{
+   m_listener = -1;
+   m_wakeup[0] = -1;
+   m_wakeup[1] = -1;
+}
+
+JsonDaemon::~JsonDaemon()
+{
+   if (m_listener >= 0) {
+      ::close(m_listener);
+      unlink(m_path.c_str());
+   }
+
+   if (m_wakeup[0] >= 0) {
+      ::close(m_wakeup[0]);
+      ::close(m_wakeup[1]);
+   }
+
+   for (Validators::iterator itr = m_validators.begin(); \
+         itr != m_validators.end(); itr++) {
+      delete itr->second;
+   }
+}
+
+size_t JsonDaemon::loadSchemas(const char *directory)
+{
+   DIR *dir = opendir(directory);
+   if (NULL == dir) {
+      throw Exception(std::string(directory) + ": " + strerror(errno));
+   }
+
+   size_t count = 0;
+   struct dirent *entry;
+   while (NULL != (entry = readdir(dir))) {
+      std::string file = entry->d_name;
+      if (file.size() <= 5 || file.compare(file.size() - 5, 5, ".json") != 0) {
+         continue;
+      }
+
+      std::string path = std::string(directory) + "/" + file;
+      std::ifstream t(path.c_str());
+      std::string str((std::istreambuf_iterator<char>(t)),
+            std::istreambuf_iterator<char>());
+
+      std::string error;
+      try {
+         JsonValidator *validator = new JsonValidator(str);
+         error = validator->getError();
+         if (error.empty()) {
+            std::string name = file.substr(0, file.size() - 5);
+            delete m_validators[name];
+            m_validators[name] = validator;
+            count++;
+         } else {
+            delete validator;
+         }
+      } catch (Exception &e) {
+         error = e.what();
+      } catch (std::exception &e) {
+         // such as std::regex_error for a pattern
+         error = e.what();
+      }
+
+      if (!error.empty()) {
+         closedir(dir);
+         throw Exception(path + ": " + error);
+      }
+   }
+
+   closedir(dir);
+   return count;
+}
+
+void JsonDaemon::addSchema(const std::string &name, Json::Value *schema)
+{
+   JsonValidator *validator = new JsonValidator(schema);
+   if (!validator->getError().empty()) {
+      // built without exceptions
+      std::string error = validator->getError();
+      delete validator;
+      throw Exception(error);
+   }
+
+   delete m_validators[name];
+   m_validators[name] = validator;
+}
+
+void JsonDaemon::listen(const char *path)
+{
+   struct sockaddr_un address;
+   if (!socketAddress(path, address)) {
+      throw Exception(std::string(path) + ": socket path too long");
+   }
+
+   if (pipe(m_wakeup) != 0) {
+      throw Exception(std::string("pipe: ") + strerror(errno));
+   }
+
+   m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (m_listener < 0) {
+      throw Exception(std::string("socket: ") + strerror(errno));
+   }
+
+   unlink(path);
+   if (bind(m_listener, reinterpret_cast<struct sockaddr *>(&address),
+            sizeof(address)) != 0 || ::listen(m_listener, SOMAXCONN) != 0) {
+      std::string error = std::string(path) + ": " + strerror(errno);
+      ::close(m_listener);
+      m_listener = -1;
+      throw Exception(error);
+   }
+
+   m_path = path;
+}
+
+void JsonDaemon::run()
+{
+   struct pollfd fds[2];
+   fds[0].fd = m_listener;
+   fds[0].events = POLLIN;
+   fds[1].fd = m_wakeup[0];
+   fds[1].events = POLLIN;
+
+   for (;;) {
+      fds[0].revents = 0;
+      fds[1].revents = 0;
+      if (poll(fds, 2, -1) < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         break;
+      }
+
+      if (fds[1].revents != 0) {
+         break;
+      }
+
+      if (fds[0].revents != 0) {
+         int fd = accept(m_listener, NULL, NULL);
+         if (fd < 0) {
+            continue;
+         }
+
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_connections.insert(fd);
+         std::thread(&JsonDaemon::serve, this, fd).detach();
+      }
+   }
+
+   // wake up the connections blocked in read and wait for them to close
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for (std::set<int>::iterator itr = m_connections.begin(); \
+         itr != m_connections.end(); itr++) {
+      shutdown(*itr, SHUT_RDWR);
+   }
+
+   while (!m_connections.empty()) {
+      m_closed.wait(lock);
+   }
+}
+
+void JsonDaemon::stop()
+{
+   char byte = 0;
+   ssize_t n = write(m_wakeup[1], &byte, 1);
+   (void)n;
+}
+
+int JsonDaemon::validate(const char *begin, const char *end,
+      JsonTape &tape) const
+{
+   const char *name = begin;
+   const char *separator = static_cast<const char *>(
+         memchr(begin, '\0', static_cast<size_t>(end - begin)));
+   if (NULL == separator) {
+      return JVALD_ERR_BAD_REQUEST;
+   }
+
+   Validators::const_iterator itr = m_validators.find(
+         std::string(name, separator));
+   if (itr == m_validators.end()) {
+      return JVALD_ERR_UNKNOWN_SCHEMA;
+   }
+
+   // the frame outlives the validation, vendor data the schema never looks
+   // into stays unparsed in it
+   if (!tape.parse(separator + 1, end, itr->second->skipPlan())) {
+      return JVALD_ERR_INVALID_JSON;
+   }
+
+   return itr->second->validate(&tape);
+}
+
+void JsonDaemon::serve(int fd)
+{
+   std::vector<char> in(JVALD_READ_SIZE);
+   std::vector<char> out;
+   size_t begin = 0;
+   size_t end = 0;
+   JsonTape tape;
+   bool open = true;
+
+   while (open) {
+      // answer every request already complete in the buffer
+      size_t need = JVALD_FRAME_HEADER;
+      while (end - begin >= JVALD_FRAME_HEADER) {
+         uint32_t length = decodeLength(&in[begin]);
+         if (length > JVALD_MAX_FRAME) {
+            // answered, then the connection is closed
+            appendLength(out, 4);
+            appendLength(out, static_cast<uint32_t>(JVALD_ERR_BAD_REQUEST));
+            open = false;
+            break;
+         }
+
+         need = JVALD_FRAME_HEADER + length;
+         if (end - begin < need) {
+            break;
+         }
+
+         const char *frame = &in[begin] + JVALD_FRAME_HEADER;
+         int result = validate(frame, frame + length, tape);
+         appendLength(out, 4);
+         appendLength(out, static_cast<uint32_t>(result));
+         begin += need;
+         need = JVALD_FRAME_HEADER;
+      }
+
+      if (!out.empty()) {
+         if (!writeAll(fd, &out[0], out.size())) {
+            break;
+         }
+         out.clear();
+      }
+
+      if (!open) {
+         break;
+      }
+
+      if (begin == end) {
+         begin = 0;
+         end = 0;
+      } else if (begin > 0) {
+         memmove(&in[0], &in[begin], end - begin);
+         end -= begin;
+         begin = 0;
+      }
+
+      // the buffer grows with the data actually received, doubling up to
+      // the frame, and not with the length a header merely declares
+      if (end == in.size() && in.size() < need) {
+         in.resize(std::min(need, 2 * in.size()));
+      }
+
+      ssize_t n = readSome(fd, &in[end], in.size() - end);
+      if (n <= 0) {
+         break;
+      }
+      end += static_cast<size_t>(n);
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   ::close(fd);
+   m_connections.erase(fd);
+   m_closed.notify_all();
+}
+
+JsonDaemonClient::JsonDaemonClient()
+{
+   m_fd = -1;
+   m_inBegin = 0;
+   m_inEnd = 0;
+}
+
+JsonDaemonClient::~JsonDaemonClient()
+{
+   close();
+}
+
+bool JsonDaemonClient::fail(const char *what)
+{
+   m_error = std::string(what) + ": " + strerror(errno);
+   close();
+   return false;
+}
+
+bool JsonDaemonClient::connect(const char *path)
+{
+   close();
+
+   struct sockaddr_un address;
+   if (!socketAddress(path, address)) {
+      m_error = std::string(path) + ": socket path too long";
+      return false;
+   }
+
+   m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (m_fd < 0) {
+      return fail("socket");
+   }
+
+   if (::connect(m_fd, reinterpret_cast<struct sockaddr *>(&address),
+            sizeof(address)) != 0) {
+      return fail(path);
+   }
+
+   m_in.resize(JVALD_READ_SIZE);
+   return true;
+}
+
+void JsonDaemonClient::close()
+{
+   if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+   }
+   m_out.clear();
+   m_inBegin = 0;
+   m_inEnd = 0;
+}
+
+bool JsonDaemonClient::send(const std::string &schema, const char *begin,
+      const char *end)
+{
+   if (m_fd < 0) {
+      m_error = "not connected";
+      return false;
+   }
+
+   size_t length = schema.size() + 1 + static_cast<size_t>(end - begin);
+   if (length > JVALD_MAX_FRAME) {
+      m_error = "document too large";
+      return false;
+   }
+
+   appendLength(m_out, static_cast<uint32_t>(length));
+   m_out.insert(m_out.end(), schema.begin(), schema.end());
+   m_out.push_back('\0');
+   m_out.insert(m_out.end(), begin, end);
+
+   if (m_out.size() >= JVALD_SEND_BUFFER) {
+      return flush();
+   }
+
+   return true;
+}
+
+bool JsonDaemonClient::flush()
+{
+   if (m_out.empty()) {
+      return true;
+   }
+
+   if (m_fd < 0 || !writeAll(m_fd, &m_out[0], m_out.size())) {
+      return fail("send");
+   }
+
+   m_out.clear();
+   return true;
+}
+
+bool JsonDaemonClient::receive(int &result)
+{
+   if (!flush()) {
+      return false;
+   }
+
+   if (m_fd < 0) {
+      m_error = "not connected";
+      return false;
+   }
+
+   while (m_inEnd - m_inBegin < JVALD_FRAME_HEADER + 4) {
+      if (m_inBegin > 0) {
+         memmove(&m_in[0], &m_in[m_inBegin], m_inEnd - m_inBegin);
+         m_inEnd -= m_inBegin;
+         m_inBegin = 0;
+      }
+
+      ssize_t n = readSome(m_fd, &m_in[m_inEnd], m_in.size() - m_inEnd);
+      if (n == 0) {
+         m_error = "connection closed by the daemon";
+         close();
+         return false;
+      } else if (n < 0) {
+         return fail("read");
+      }
+      m_inEnd += static_cast<size_t>(n);
+   }
+
+   if (decodeLength(&m_in[m_inBegin]) != 4) {
+      m_error = "unexpected answer";
+      close();
+      return false;
+   }
+
+   result = static_cast<int32_t>(decodeLength(&m_in[m_inBegin + 4]));
+   m_inBegin += JVALD_FRAME_HEADER + 4;
+   return true;
+}
+
+int JsonDaemonClient::validate(const std::string &schema,
+      const std::string &document)
+{
+   int result = JVALD_ERR_IO;
+   if (!send(schema, document.data(), document.data() + document.size()) || \
+         !receive(result)) {
+      return JVALD_ERR_IO;
+   }
+
+   return result;
+}
@@ -0,0 +1,164 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __DAEMON_H__
+#define __DAEMON_H__
+
+#include <stdint.h>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Protocol of jvald, the validation daemon, over a Unix stream socket.
+ *
+ * A request is a frame: a 4-byte big-endian length followed by that many
+ * bytes, the schema name, a NUL byte, then the JSON document. The answer to
+ * every request is a frame holding a 4-byte big-endian signed result: a
+ * JsonValidator::validate() code, or one of the JVALD_ERR codes below.
+ * Requests can be pipelined; answers come back in the order of the requests.
+ */
+#define JVALD_FRAME_HEADER          4
+#define JVALD_MAX_FRAME             (256U << 20)
+
+#define JVALD_ERR_IO                -1
+#define JVALD_ERR_BAD_REQUEST       -2
+#define JVALD_ERR_UNKNOWN_SCHEMA    -3
+#define JVALD_ERR_INVALID_JSON      -4
+
+class JsonValidator;
+class JsonTape;
+
+/**
+ * @brief Serves validation requests against schemas compiled once at
+ * startup. Each connection is served by its own thread, whose buffer grows
+ * with the bytes received rather than with the declared frame length.
+ */
+class JsonDaemon
+{
+   public:
+      JsonDaemon();
+
+      ~JsonDaemon();
+
+      /**
+       * @brief Compiles every .json file of a directory, each one named after
+       * its file name without the extension
+       *
+       * @return number of schemas loaded; throws Exception on a bad schema
+       */
+      size_t loadSchemas(const char *directory);
+
+      void addSchema(const std::string &name, Json::Value *schema);
+
+      /**
+       * @brief Binds the socket, replacing a stale socket file; throws
+       * Exception on failure
+       */
+      void listen(const char *path);
+
+      /**
+       * @brief Accepts connections until stop(), then waits for the open
+       * connections to close
+       */
+      void run();
+
+      /**
+       * @brief Makes run() return; safe from a signal handler
+       */
+      void stop();
+
+   private:
+      JsonDaemon(const JsonDaemon &);
+      JsonDaemon &operator=(const JsonDaemon &);
+
+      void serve(int fd);
+
+      int validate(const char *begin, const char *end, JsonTape &tape) const;
+
+      typedef std::map<std::string, JsonValidator *> Validators;
+
+      Validators              m_validators;
+      std::string             m_path;
+      int                     m_listener;
+      int                     m_wakeup[2];
+      std::mutex              m_mutex;
+      std::condition_variable m_closed;
+      std::set<int>           m_connections;
+};
+
+/**
+ * @brief Connection to jvald. Requests are buffered by send() and written
+ * when receive() needs an answer, when flush() is called or when the buffer
+ * grows large; keep the number of unanswered requests bounded (a few
+ * thousand) so that neither side blocks writing.
+ */
+class JsonDaemonClient
+{
+   public:
+      JsonDaemonClient();
+
+      ~JsonDaemonClient();
+
+      bool connect(const char *path);
+
+      void close();
+
+      /**
+       * @brief Sends one request and waits for its answer
+       *
+       * @return the result, JVALD_ERR_IO if the connection failed
+       */
+      int validate(const std::string &schema, const std::string &document);
+
+      /**
+       * @brief Queues a request without waiting for the answer
+       */
+      bool send(const std::string &schema, const char *begin, const char *end);
+
+      bool flush();
+
+      /**
+       * @brief Answer to the oldest request not received yet
+       */
+      bool receive(int &result);
+
+      const std::string &getError() const {return m_error;}
+
+   private:
+      JsonDaemonClient(const JsonDaemonClient &);
+      JsonDaemonClient &operator=(const JsonDaemonClient &);
+
+      bool fail(const char *what);
+
+      int               m_fd;
+      std::vector<char> m_out;
+      std::vector<char> m_in;
+      size_t            m_inBegin;
+      size_t            m_inEnd;
+      std::string       m_error;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <format.h>
+
+typedef std::map<std::string, JsonFormat::Checker> Formats;
+
+static std::mutex formatsMutex;
+
+// the formats known to schemas, with the built-in ones to begin with; called
+// with formatsMutex held
+static Formats &formats()
+{
+   static Formats known;
+   static bool builtIn = false;
+   if (!builtIn) {
+      builtIn = true;
+      known["date-time"] = &JsonFormat::dateTime;
+      known["email"] = &JsonFormat::email;
+      known["hostname"] = &JsonFormat::hostname;
+      known["ipv4"] = &JsonFormat::ipv4;
+      known["ipv6"] = &JsonFormat::ipv6;
+      known["uri"] = &JsonFormat::uri;
+   }
+   return known;
+}
+
+void JsonFormat::define(const std::string &name, Checker checker)
+{
+   std::lock_guard<std::mutex> lock(formatsMutex);
+   if (NULL == checker) {
+      formats().erase(name);
+   } else {
+      formats()[name] = checker;
+   }
+}
+
+JsonFormat::Checker JsonFormat::find(const std::string &name)
+{
+   std::lock_guard<std::mutex> lock(formatsMutex);
+   Formats::const_iterator itr = formats().find(name);
+   return itr == formats().end() ? NULL : itr->second;
+}
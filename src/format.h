@@ -0,0 +1,344 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __FORMAT_H__
+#define __FORMAT_H__
+
+#include <string>
+
+/**
+ * @brief Checkers of the Draft 4 "format" keyword, each one a single pass over
+ * the string without allocating, and the registry of the named formats a
+ * schema may use. The built-in checkers are inline so that generated
+ * validators call them without the library.
+ *
+ * Unknown formats are ignored, as Draft 4 allows. Custom formats are defined
+ * by name before the schemas using them are compiled; a compiled schema keeps
+ * the checker it was compiled with.
+ */
+class JsonFormat
+{
+   public:
+      /**
+       * @return true if [begin, end) is in the format
+       */
+      typedef bool (*Checker)(const char *begin, const char *end);
+
+      /**
+       * @brief Adds a format, or replaces the checker of a known one; a NULL
+       * checker forgets the format. Thread safe, and so is find().
+       */
+      static void define(const std::string &name, Checker checker);
+
+      /**
+       * @brief Checker of a format, NULL if it is unknown
+       */
+      static Checker find(const std::string &name);
+
+      // RFC 3339 date-time: 1985-04-12T23:20:50.52Z, 1996-12-19T16:39:57-08:00
+      static bool dateTime(const char *begin, const char *end) {
+         const char *p = begin;
+         unsigned int year, month, day, hour, minute, second;
+         if (!digits(p, end, 4, year) || !expect(p, end, '-') ||
+               !digits(p, end, 2, month) || !expect(p, end, '-') ||
+               !digits(p, end, 2, day) ||
+               !(expect(p, end, 'T') || expect(p, end, 't')) ||
+               !digits(p, end, 2, hour) || !expect(p, end, ':') ||
+               !digits(p, end, 2, minute) || !expect(p, end, ':') ||
+               !digits(p, end, 2, second)) {
+            return false;
+         }
+
+         // a leap second is allowed in any minute, the offset may move it
+         if (month < 1 || month > 12 || day < 1 ||
+               day > daysInMonth(year, month) || hour > 23 || minute > 59 ||
+               second > 60) {
+            return false;
+         }
+
+         if (expect(p, end, '.')) {
+            const char *fraction = p;
+            while (p < end && isDigit(*p)) {
+               p++;
+            }
+            if (p == fraction) {
+               return false;
+            }
+         }
+
+         if (expect(p, end, 'Z') || expect(p, end, 'z')) {
+            return p == end;
+         }
+
+         unsigned int offsetHour, offsetMinute;
+         if (!(expect(p, end, '+') || expect(p, end, '-')) ||
+               !digits(p, end, 2, offsetHour) || !expect(p, end, ':') ||
+               !digits(p, end, 2, offsetMinute)) {
+            return false;
+         }
+
+         return p == end && offsetHour <= 23 && offsetMinute <= 59;
+      }
+
+      // RFC 5322 addr-spec with a dot-atom local part and a hostname domain
+      static bool email(const char *begin, const char *end) {
+         const char *at = begin;
+         while (at < end && *at != '@') {
+            at++;
+         }
+
+         if (at == begin || at == end || at - begin > 64) {
+            return false;
+         }
+
+         bool dot = true;
+         for (const char *p = begin; p < at; p++) {
+            if (*p == '.') {
+               if (dot) {
+                  return false;
+               }
+               dot = true;
+            } else if (isAtext(*p)) {
+               dot = false;
+            } else {
+               return false;
+            }
+         }
+
+         return !dot && hostname(at + 1, end);
+      }
+
+      // RFC 1034 host name: dot separated labels of letters, digits and
+      // inner hyphens, 63 characters at most each and 253 in all
+      static bool hostname(const char *begin, const char *end) {
+         if (begin == end || end - begin > 253) {
+            return false;
+         }
+
+         const char *label = begin;
+         for (const char *p = begin; p <= end; p++) {
+            if (p == end || *p == '.') {
+               if (p == label || p - label > 63 || p[-1] == '-') {
+                  return false;
+               }
+               label = p + 1;
+            } else if (*p == '-') {
+               if (p == label) {
+                  return false;
+               }
+            } else if (!isAlnum(*p)) {
+               return false;
+            }
+         }
+
+         return true;
+      }
+
+      // dotted quad, without the leading zeros some parsers read as octal
+      static bool ipv4(const char *begin, const char *end) {
+         const char *p = begin;
+         for (int i = 0; i < 4; i++) {
+            if (i > 0 && !expect(p, end, '.')) {
+               return false;
+            }
+
+            const char *octet = p;
+            unsigned int value = 0;
+            while (p < end && isDigit(*p) && p - octet < 3) {
+               value = value * 10 + static_cast<unsigned int>(*p - '0');
+               p++;
+            }
+
+            if (p == octet || value > 255 || (*octet == '0' && p - octet > 1)) {
+               return false;
+            }
+         }
+
+         return p == end;
+      }
+
+      // RFC 4291 text form: eight groups of up to four hex digits, one run
+      // of groups compressed to "::", the last two as a dotted quad
+      static bool ipv6(const char *begin, const char *end) {
+         const char *p = begin;
+         unsigned int groups = 0;
+         bool compressed = false;
+
+         if (end - p >= 2 && p[0] == ':' && p[1] == ':') {
+            compressed = true;
+            p += 2;
+         }
+
+         while (p < end) {
+            const char *group = p;
+            while (p < end && isHex(*p) && p - group < 5) {
+               p++;
+            }
+
+            if (p < end && *p == '.') {
+               if (!ipv4(group, end)) {
+                  return false;
+               }
+               groups += 2;
+               p = end;
+               break;
+            }
+
+            if (p == group || p - group > 4) {
+               return false;
+            }
+            groups++;
+
+            if (p == end) {
+               break;
+            }
+
+            if (!expect(p, end, ':') || p == end) {
+               return false;
+            }
+
+            if (*p == ':') {
+               if (compressed) {
+                  return false;
+               }
+               compressed = true;
+               p++;
+            }
+         }
+
+         return compressed ? groups <= 7 : groups == 8;
+      }
+
+      // RFC 3986 URI: a scheme, then characters allowed in a URI with
+      // well-formed percent-encodings and at most one fragment
+      static bool uri(const char *begin, const char *end) {
+         const char *p = begin;
+         if (p == end || !isAlpha(*p)) {
+            return false;
+         }
+
+         while (p < end && (isAlnum(*p) || *p == '+' || *p == '-' ||
+                  *p == '.')) {
+            p++;
+         }
+
+         if (!expect(p, end, ':')) {
+            return false;
+         }
+
+         bool fragment = false;
+         while (p < end) {
+            char c = *p++;
+            if (c == '%') {
+               if (end - p < 2 || !isHex(p[0]) || !isHex(p[1])) {
+                  return false;
+               }
+               p += 2;
+            } else if (c == '#') {
+               if (fragment) {
+                  return false;
+               }
+               fragment = true;
+            } else if (!isUric(c)) {
+               return false;
+            }
+         }
+
+         return true;
+      }
+
+   private:
+      static bool isDigit(char c) {return c >= '0' && c <= '9';}
+
+      static bool isAlpha(char c) {
+         return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+      }
+
+      static bool isAlnum(char c) {return isDigit(c) || isAlpha(c);}
+
+      static bool isHex(char c) {
+         return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+      }
+
+      // atext of RFC 5322
+      static bool isAtext(char c) {
+         switch (c) {
+            case '!': case '#': case '$': case '%': case '&': case '\'':
+            case '*': case '+': case '-': case '/': case '=': case '?':
+            case '^': case '_': case '`': case '{': case '|': case '}':
+            case '~':
+               return true;
+            default:
+               return isAlnum(c);
+         }
+      }
+
+      // unreserved, gen-delims but '#', and sub-delims of RFC 3986
+      static bool isUric(char c) {
+         switch (c) {
+            case '-': case '.': case '_': case '~': case ':': case '/':
+            case '?': case '[': case ']': case '@': case '!': case '$':
+            case '&': case '\'': case '(': case ')': case '*': case '+':
+            case ',': case ';': case '=':
+               return true;
+            default:
+               return isAlnum(c);
+         }
+      }
+
+      static bool expect(const char *&p, const char *end, char c) {
+         if (p < end && *p == c) {
+            p++;
+            return true;
+         }
+         return false;
+      }
+
+      // exactly count decimal digits
+      static bool digits(const char *&p, const char *end, int count,
+            unsigned int &value) {
+         if (end - p < count) {
+            return false;
+         }
+
+         value = 0;
+         for (int i = 0; i < count; i++, p++) {
+            if (!isDigit(*p)) {
+               return false;
+            }
+            value = value * 10 + static_cast<unsigned int>(*p - '0');
+         }
+         return true;
+      }
+
+      static unsigned int daysInMonth(unsigned int year, unsigned int month) {
+         static const unsigned int days[] = {31, 28, 31, 30, 31, 30, 31, 31,
+            30, 31, 30, 31};
+         if (month == 2 && year % 4 == 0 &&
+               (year % 100 != 0 || year % 400 == 0)) {
+            return 29;
+         }
+         return days[month - 1];
+      }
+};
+
+#endif
@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <json_pointer.h>
+
+bool parseJsonPointer(const std::string &pointer,
+      std::vector<std::string> &tokens)
+{
+   tokens.clear();
+   if (pointer.empty()) {
+      return true;
+   }
+
+   if (pointer[0] != '/') {
+      return false;
+   }
+
+   std::string token;
+   for (size_t i = 1; i <= pointer.size(); i++) {
+      if (i == pointer.size() || pointer[i] == '/') {
+         tokens.push_back(token);
+         token.clear();
+      } else if (pointer[i] == '~') {
+         if (i + 1 == pointer.size()) {
+            return false;
+         }
+         if (pointer[i + 1] == '0') {
+            token += '~';
+         } else if (pointer[i + 1] == '1') {
+            token += '/';
+         } else {
+            return false;
+         }
+         i++;
+      } else {
+         token += pointer[i];
+      }
+   }
+
+   return true;
+}
+
+JsonPointerNode::JsonPointerNode() : m_full(false)
+{
+}
+
+JsonPointerNode::~JsonPointerNode()
+{
+   for (Children::iterator itr = m_children.begin();
+         itr != m_children.end();
+         itr++) {
+      delete itr->second;
+   }
+}
+
+bool JsonPointerNode::add(const std::string &pointer)
+{
+   std::vector<std::string> tokens;
+   if (!parseJsonPointer(pointer, tokens)) {
+      return false;
+   }
+
+   JsonPointerNode *node = this;
+   for (size_t i = 0; i < tokens.size() && !node->m_full; i++) {
+      Children::iterator itr = node->m_children.find(tokens[i]);
+      if (itr == node->m_children.end()) {
+         itr = node->m_children.insert(
+               std::make_pair(tokens[i], new JsonPointerNode)).first;
+      }
+      node = itr->second;
+   }
+
+   node->m_full = true;
+   return true;
+}
+
+const JsonPointerNode *JsonPointerNode::find(const std::string &token) const
+{
+   Children::const_iterator itr = m_children.find(token);
+   if (itr == m_children.end()) {
+      return NULL;
+   }
+
+   return itr->second;
+}
+
+bool JsonPointerNode::toIndex(const std::string &token, unsigned int size,
+      unsigned int &index)
+{
+   if (token == "-") {
+      if (size == 0) {
+         return false;
+      }
+      index = size - 1;
+      return true;
+   }
+
+   if (token.empty() || token.size() > 10 || \
+         (token.size() > 1 && token[0] == '0')) {
+      return false;
+   }
+
+   unsigned long value = 0;
+   for (size_t i = 0; i < token.size(); i++) {
+      if (token[i] < '0' || token[i] > '9') {
+         return false;
+      }
+      value = value * 10 + static_cast<unsigned long>(token[i] - '0');
+   }
+
+   if (value > 0xFFFFFFFFUL) {
+      return false;
+   }
+
+   index = static_cast<unsigned int>(value);
+   return true;
+}
+
+bool JsonPointerNode::minIndex(unsigned int size, unsigned int &index) const
+{
+   bool found = false;
+   for (Children::const_iterator itr = m_children.begin();
+         itr != m_children.end();
+         itr++) {
+      unsigned int i = 0;
+      if (toIndex(itr->first, size, i) && (!found || i < index)) {
+         index = i;
+         found = true;
+      }
+   }
+
+   return found;
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __JSON_POINTER_H__
+#define __JSON_POINTER_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Splits a JSON Pointer (RFC 6901) into its reference tokens,
+ * decoding the "~1" and "~0" escapes. "" designates the whole document.
+ *
+ * @param pointer
+ * @param tokens
+ *
+ * @return false if the pointer is malformed
+ */
+bool parseJsonPointer(const std::string &pointer,
+      std::vector<std::string> &tokens);
+
+/**
+ * @brief Prefix tree of JSON Pointers. A node is "full" when the pointer
+ * ending at it was added; its whole subtree is then selected and the
+ * deeper pointers are irrelevant.
+ */
+class JsonPointerNode
+{
+   public:
+      typedef std::map<std::string, JsonPointerNode*> Children;
+
+      JsonPointerNode();
+
+      ~JsonPointerNode();
+
+      /**
+       * @brief Adds a pointer below this node
+       *
+       * @return false if the pointer is malformed
+       */
+      bool add(const std::string &pointer);
+
+      bool isFull() const {return m_full;}
+
+      const Children &children() const {return m_children;}
+
+      const JsonPointerNode *find(const std::string &token) const;
+
+      /**
+       * @brief Smallest array index among the children, ignoring the tokens
+       * that are not indices. "-" stands for the last item of an array of
+       * the given size.
+       *
+       * @return false if no child is an index
+       */
+      bool minIndex(unsigned int size, unsigned int &index) const;
+
+      /**
+       * @brief Converts a reference token to an index in an array of the
+       * given size, "-" being its last item
+       *
+       * @return false if the token is not an index
+       */
+      static bool toIndex(const std::string &token, unsigned int size,
+            unsigned int &index);
+
+   private:
+      JsonPointerNode(const JsonPointerNode &);
+      JsonPointerNode &operator=(const JsonPointerNode &);
+
+      bool     m_full;
+      Children m_children;
+};
+
+#endif
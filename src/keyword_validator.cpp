@@ -27,155 +27,389 @@
 #include <list>
 #include <vector>
 #include <map>
+#include <set>
 #include <algorithm>
 #include <regex>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
 #include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <json_pointer.h>
+#include <memo.h>
+#include <budget.h>
+#include <parallel.h>
+#include <pattern_set.h>
+#include <regex_compile.h>
+#include <memory_usage.h>
 #include <primitive_base.h>
 #include <keyword_validator.h>
 
-inline bool almostEqual(double a, double b, double errorFactor = 2.0)
+// Hands a child instance to a compiled subschema, whatever its representation
+static inline int validateChild(JsonPrimitive *primitive,
+      const Json::Value &value)
 {
-   return (a == b) || std::abs(a - b) < std::abs(std::min(a, b)) * \
-             std::numeric_limits<double>::epsilon() * errorFactor;
+   return primitive->validate(&value);
 }
 
-int IntValid::validate(const Json::Value *value)
+static inline int validateChild(JsonPrimitive *primitive,
+      const JsonTapeValue &value)
 {
-   if (!value->isInt()) {
-      return JVAL_ERR_NOT_AN_INTEGER;
+   return primitive->validate(value);
+}
+
+// Same as validateChild() but answers from the thread's JsonMemo, if any, for
+// containers identical to ones seen before. Scalars are cheaper to validate
+// than to look up.
+static int validateMemoizedChild(JsonPrimitive *primitive,
+      const Json::Value &value)
+{
+   JsonMemo *memo = JsonMemo::current();
+   if (NULL == memo || !(value.isObject() || value.isArray())) {
+      return primitive->validate(&value);
    }
 
-   return JVAL_ROK;
+   size_t hash = JsonMemo::hash(value);
+   int ret = JVAL_ROK;
+   if (memo->find(primitive, value, hash, ret)) {
+      return ret;
+   }
+
+   ret = primitive->validate(&value);
+
+   // a validation cut short proves nothing about the subtree
+   JsonBudget *budget = JsonBudget::current();
+   if (NULL == budget || !budget->exceeded()) {
+      memo->insert(primitive, value, hash, ret);
+   }
+   return ret;
 }
 
-IntMaximum::IntMaximum(int maximum, bool exclusiveMaximum = false)
+static inline int validateMemoizedChild(JsonPrimitive *primitive,
+      const JsonTapeValue &value)
 {
-   m_maximum = maximum;
-   m_exclusiveMaximum = exclusiveMaximum;
+   return primitive->validate(value);
 }
 
-int IntMaximum::validate(const Json::Value *value)
+// Iterators to the first item or member of each of chunks slices of a
+// container, followed by its end
+template <typename T>
+static void chunkBounds(const T &value, size_t chunks,
+      std::vector<typename T::const_iterator> &bounds)
 {
-   Json::Int val = value->asInt();   
-   if (val > m_maximum) {
-      return JVAL_ERR_INVALID_MAXIMUM;
+   size_t size = value.size();
+   size_t slice = (size + chunks - 1) / chunks;
+   size_t i = 0;
+   for (typename T::const_iterator itr = value.begin();
+         itr != value.end();
+         ++itr, ++i) {
+      if (0 == i % slice) {
+         bounds.push_back(itr);
+      }
    }
+   bounds.push_back(value.end());
+}
+
+/**
+ * @brief Items of a slice of a large array, validated by ItemsList on the
+ * threads of a JsonParallel
+ */
+template <typename T>
+class ItemsChunk : public JsonParallel::Work
+{
+   public:
+      ItemsChunk(JsonPrimitive *primitive,
+            const std::vector<typename T::const_iterator> &bounds) :
+         m_primitive(primitive), m_bounds(bounds) {}
+
+      int chunk(size_t index, const std::atomic<size_t> &failed) {
+         for (typename T::const_iterator itr = m_bounds[index];
+               itr != m_bounds[index + 1];
+               ++itr) {
+            if (failed.load(std::memory_order_relaxed) < index) {
+               break;
+            }
+
+            if (JVAL_ROK != validateMemoizedChild(m_primitive, *itr)) {
+               return JVAL_ERR_INVALID_ARRAY_ITEM;
+            }
+         }
+
+         return JVAL_ROK;
+      }
+
+   private:
+      JsonPrimitive                                   *m_primitive;
+      const std::vector<typename T::const_iterator>   &m_bounds;
+};
+
+/**
+ * @brief Room for a set of bits, such as the match set of a JsonPatternSet,
+ * on the stack for up to 256 bits
+ */
+class MatchSet
+{
+   public:
+      explicit MatchSet(size_t words) {
+         init(words);
+      }
+
+      explicit MatchSet(const JsonPatternSet *patterns) {
+         init(NULL == patterns ? 0 : patterns->words());
+      }
+
+      uint64_t *words() {return m_words;}
+
+   private:
+      MatchSet(const MatchSet &);
+      MatchSet &operator=(const MatchSet &);
+
+      void init(size_t words) {
+         m_words = m_local;
+         if (words > 4) {
+            m_heap.resize(words);
+            m_words = &m_heap[0];
+         }
+      }
+
+      uint64_t                m_local[4];
+      std::vector<uint64_t>   m_heap;
+      uint64_t                *m_words;
+};
+
+/**
+ * @brief Members of a slice of a large object, validated by Properties on the
+ * threads of a JsonParallel
+ */
+template <typename T>
+class PropertiesChunk : public JsonParallel::Work
+{
+   public:
+      PropertiesChunk(Properties &properties,
+            const std::vector<typename T::const_iterator> &bounds) :
+         m_properties(properties), m_bounds(bounds) {}
+
+      int chunk(size_t index, const std::atomic<size_t> &failed) {
+         MatchSet matches(m_properties.m_patterns);
+         for (typename T::const_iterator itr = m_bounds[index];
+               itr != m_bounds[index + 1];
+               ++itr) {
+            if (failed.load(std::memory_order_relaxed) < index) {
+               break;
+            }
+
+            const char *end = NULL;
+            const char *name = itr.memberName(&end);
+            int ret = m_properties.checkMember(name, end, *itr,
+                  matches.words());
+            if (JVAL_ROK != ret) {
+               return ret;
+            }
+         }
+
+         return JVAL_ROK;
+      }
+
+   private:
+      Properties                                      &m_properties;
+      const std::vector<typename T::const_iterator>   &m_bounds;
+};
 
-   if (val == m_maximum && m_exclusiveMaximum == true) {
-      return JVAL_ERR_INVALID_MAXIMUM;
+template <typename T>
+int IntValid::check(const T &value)
+{
+   if (!value.isInt()) {
+      return JVAL_ERR_NOT_AN_INTEGER;
    }
 
    return JVAL_ROK;
 }
 
-IntMinimum::IntMinimum(int minimum, bool exclusiveMinimum = false)
+int IntValid::validate(const Json::Value *value)
 {
-   m_minimum = minimum;
-   m_exclusiveMinimum = exclusiveMinimum;
+   return check(*value);
 }
 
-int IntMinimum::validate(const Json::Value *value)
+int IntValid::validate(const JsonTapeValue &value)
 {
-   Json::Int val = value->asInt();   
-   if (val < m_minimum) {
-      return JVAL_ERR_INVALID_MINIMUM;
-   }
-
-   if (val == m_minimum && m_exclusiveMinimum == true) {
-      return JVAL_ERR_INVALID_MINIMUM;
-   }
+   return check(value);
+}
 
-   return JVAL_ROK;
+void IntValid::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("IntValid", path, sizeof(*this));
 }
 
-int NumberValid::validate(const Json::Value *value)
+template <typename T>
+int NumberValid::check(const T &value)
 {
-   if (!value->isNumeric()) {
+   if (!value.isNumeric()) {
       return JVAL_ERR_NOT_A_NUMBER;
    }
  
    return JVAL_ROK;
 }
 
-NumberMaximum::NumberMaximum(double maximum, bool exclusiveMaximum = false)
+int NumberValid::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int NumberValid::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void NumberValid::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
 {
-   m_maximum = maximum;
-   m_exclusiveMaximum = exclusiveMaximum;
+   usage.add("NumberValid", path, sizeof(*this));
 }
 
-int NumberMaximum::validate(const Json::Value *value)
+/**
+ * @brief Reads a numeric bound of the schema
+ */
+static bool numberKeyword(Json::Value *schema, const char *keyword,
+      JsonNumberValue &number)
 {
-   double val = value->asDouble();   
-   if (val > m_maximum) {
-      return JVAL_ERR_INVALID_MAXIMUM;
+   if (!schema->isMember(keyword)) {
+      return false;
    }
 
-   if (val == m_maximum && m_exclusiveMaximum == true) {
-      return JVAL_ERR_INVALID_MAXIMUM;
+   Json::Value v = schema->get(keyword, Json::nullValue);
+   if (!v.isNumeric()) {
+      JVAL_SCHEMA_ERROR(std::string("\"") + keyword + "\" is not a number");
+      return false;
    }
 
-   return JVAL_ROK;
+   number = JsonNumberValue::of(v);
+   return true;
 }
 
-NumberMinimum::NumberMinimum(double minimum, bool exclusiveMinimum = false)
+bool countKeyword(Json::Value *schema, const char *keyword, size_t &count)
 {
-   m_minimum = minimum;
-   m_exclusiveMinimum = exclusiveMinimum;
+   if (!schema->isMember(keyword)) {
+      return false;
+   }
+
+   Json::Value v = schema->get(keyword, Json::nullValue);
+   if (!v.isUInt64()) {
+      JVAL_SCHEMA_ERROR(std::string("\"") + keyword + \
+            "\" is not a non-negative integer");
+      return false;
+   }
+
+   // the keywords keep their count in an unsigned int
+   if (!v.isUInt()) {
+      JVAL_SCHEMA_ERROR(std::string("\"") + keyword + "\" is too large");
+      return false;
+   }
+
+   count = v.asUInt();
+   return true;
 }
 
-int NumberMinimum::validate(const Json::Value *value)
+bool boolKeyword(Json::Value *schema, const char *keyword, bool &flag)
 {
-   double val = value->asDouble();   
-   if (val < m_minimum) {
-      return JVAL_ERR_INVALID_MINIMUM;
+   if (!schema->isMember(keyword)) {
+      return false;
    }
 
-   if (val == m_minimum && m_exclusiveMinimum == true) {
-      return JVAL_ERR_INVALID_MINIMUM;
+   Json::Value v = schema->get(keyword, Json::nullValue);
+   if (!v.isBool()) {
+      JVAL_SCHEMA_ERROR(std::string("\"") + keyword + "\" is not a boolean");
+      return false;
    }
 
-   return JVAL_ROK;
+   flag = v.asBool();
+   return true;
 }
 
-IntMultipleOf::IntMultipleOf(int multipleOf = 1) 
+bool stringKeyword(Json::Value *schema, const char *keyword,
+      std::string &text)
 {
-   m_multipleOf = multipleOf;
+   if (!schema->isMember(keyword)) {
+      return false;
+   }
+
+   Json::Value v = schema->get(keyword, Json::nullValue);
+   if (!v.isString()) {
+      JVAL_SCHEMA_ERROR(std::string("\"") + keyword + "\" is not a string");
+      return false;
+   }
+
+   text = v.asString();
+   return true;
 }
 
-int IntMultipleOf::validate(const Json::Value *value)
+NumberRange::NumberRange(Json::Value *schema)
 {
-   int val = value->asInt();   
-   if ((val % m_multipleOf) != 0) {
-      return JVAL_ERR_NOT_A_MULTIPLE;
+   bool exclusive = false;
+   m_hasMinimum = numberKeyword(schema, "minimum", m_minimum);
+   m_exclusiveMinimum = m_hasMinimum && \
+                        boolKeyword(schema, "exclusiveMinimum", exclusive) && \
+                        exclusive;
+
+   exclusive = false;
+   m_hasMaximum = numberKeyword(schema, "maximum", m_maximum);
+   m_exclusiveMaximum = m_hasMaximum && \
+                        boolKeyword(schema, "exclusiveMaximum", exclusive) && \
+                        exclusive;
+
+   JsonNumberValue divisor;
+   m_hasMultipleOf = numberKeyword(schema, "multipleOf", divisor);
+   if (m_hasMultipleOf && !divisor.isPositive()) {
+      JVAL_SCHEMA_ERROR("\"multipleOf\" must be greater than 0");
+      m_hasMultipleOf = false;
+   }
+   if (m_hasMultipleOf) {
+      m_multipleOf = JsonMultipleOf::of(divisor);
    }
+}
 
-   return JVAL_ROK;
+int NumberRange::validate(const Json::Value *value)
+{
+   return check(*value);
 }
 
-NumberMultipleOf::NumberMultipleOf(double multipleOf) 
+int NumberRange::validate(const JsonTapeValue &value)
 {
-   m_multipleOf = multipleOf;
+   return check(value);
 }
 
-int NumberMultipleOf::validate(const Json::Value *value)
+void NumberRange::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
 {
-   double val = value->asDouble();
-   double remainder = fmod(val, m_multipleOf);
+   usage.add("NumberRange", path, sizeof(*this));
+}
 
-   if (almostEqual(remainder, 0.0) || almostEqual(remainder, m_multipleOf)) {
-      return JVAL_ROK;
+template <typename T>
+int StringValid::check(const T &value)
+{
+   if (!value.isString()) {
+      return JVAL_ERR_NOT_A_STRING;
    }
 
-   return JVAL_ERR_NOT_A_MULTIPLE;
+   return JVAL_ROK;
 }
 
 int StringValid::validate(const Json::Value *value)
 {
-   if (!value->isString()) {
-      return JVAL_ERR_NOT_A_STRING;
-   }
+   return check(*value);
+}
 
-   return JVAL_ROK;
+int StringValid::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void StringValid::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("StringValid", path, sizeof(*this));
 }
 
 MinLength::MinLength(int minLength = 0)
@@ -183,51 +417,184 @@ MinLength::MinLength(int minLength = 0)
    m_minLength = minLength;
 }
 
-int MinLength::validate(const Json::Value *value)
+template <typename T>
+int MinLength::check(const T &value)
 {
-   if (value->asString().size() < m_minLength) {
+   const char *begin = NULL;
+   const char *end = NULL;
+   value.getString(&begin, &end);
+   if (static_cast<size_t>(end - begin) < m_minLength) {
       return JVAL_ERR_INVALID_MIN_LENGTH;
    }
 
    return JVAL_ROK;
 }
 
+int MinLength::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int MinLength::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MinLength::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MinLength", path, sizeof(*this));
+}
+
 MaxLength::MaxLength(int maxLength = 0) 
 {
    m_maxLength = maxLength;
 }
 
-int MaxLength::validate(const Json::Value *value)
+template <typename T>
+int MaxLength::check(const T &value)
 {
-   if (value->asString().size() > m_maxLength) {
+   const char *begin = NULL;
+   const char *end = NULL;
+   value.getString(&begin, &end);
+   if (static_cast<size_t>(end - begin) > m_maxLength) {
       return JVAL_ERR_INVALID_MAX_LENGTH;
    }
 
    return JVAL_ROK;
 }
 
-Pattern::Pattern(JSONCPP_STRING pattern = ".*") : m_pattern(pattern)
+int MaxLength::validate(const Json::Value *value)
 {
+   return check(*value);
 }
 
-int Pattern::validate(const Json::Value *value)
+int MaxLength::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MaxLength::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MaxLength", path, sizeof(*this));
+}
+
+Pattern::Pattern(JSONCPP_STRING pattern = ".*") :
+   m_patternLength(pattern.size())
 {
-   if (!std::regex_match(value->asString(), m_pattern)) {
+   if (!compileRegex(pattern, m_pattern)) {
+      JVAL_SCHEMA_ERROR("pattern is not a valid regular expression: " + \
+            pattern);
+   }
+}
+
+template <typename T>
+int Pattern::check(const T &value)
+{
+   const char *begin = NULL;
+   const char *end = NULL;
+   value.getString(&begin, &end);
+   if (!std::regex_match(begin, end, m_pattern)) {
       return JVAL_ERR_PATTERN_MISMATCH;
    }
 
    return JVAL_ROK;
 }
 
-int ArrayValid::validate(const Json::Value *value)
+int Pattern::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int Pattern::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void Pattern::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("Pattern", path, sizeof(*this));
+   usage.add("std::regex", path, JsonMemoryUsage::regexBytes(m_patternLength));
+}
+
+Format::Format(const std::string &name, JsonFormat::Checker checker) :
+   m_name(name), m_checker(checker)
+{
+}
+
+JsonFormat::Checker Format::lookup(Json::Value *schema)
+{
+   if (!schema->isMember("format")) {
+      return NULL;
+   }
+
+   Json::Value format = schema->get("format", format);
+   if (!format.isString()) {
+      JVAL_SCHEMA_ERROR("format is not a string");
+      return NULL;
+   }
+
+   return JsonFormat::find(format.asString());
+}
+
+template <typename T>
+int Format::check(const T &value)
+{
+   const char *begin = NULL;
+   const char *end = NULL;
+   value.getString(&begin, &end);
+   if (!m_checker(begin, end)) {
+      return JVAL_ERR_INVALID_FORMAT;
+   }
+
+   return JVAL_ROK;
+}
+
+int Format::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int Format::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void Format::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("Format", path,
+         sizeof(*this) + JsonMemoryUsage::stringBytes(m_name));
+}
+
+template <typename T>
+int ArrayValid::check(const T &value)
 {
-   if (!value->isArray()) {
+   if (!value.isArray()) {
       return JVAL_ERR_NOT_AN_ARRAY;
    }
 
    return JVAL_ROK;
 }
 
+int ArrayValid::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int ArrayValid::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void ArrayValid::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("ArrayValid", path, sizeof(*this));
+}
+
 /**
  * @brief Array validation keyword. Constructor
  */
@@ -245,15 +612,32 @@ MinItems::MinItems(unsigned int minItems = 0)
  *
  * @return 
  */
-int MinItems::validate(const Json::Value *value)
+template <typename T>
+int MinItems::check(const T &value)
 {
-   if (value->size() < m_minItems) {
+   if (value.size() < m_minItems) {
       return JVAL_ERR_INVALID_MIN_ITEMS;
    }
 
    return JVAL_ROK;
 }
 
+int MinItems::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int MinItems::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MinItems::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MinItems", path, sizeof(*this));
+}
+
 /**
  * @brief Array validation keyword. Constructor
  */
@@ -271,15 +655,32 @@ MaxItems::MaxItems(unsigned int maxItems = 0)
  *
  * @return 
  */
-int MaxItems::validate(const Json::Value *value)
+template <typename T>
+int MaxItems::check(const T &value)
 {
-   if (value->size() > m_maxItems) {
+   if (value.size() > m_maxItems) {
       return JVAL_ERR_INVALID_MAX_ITEMS;
    }
 
    return JVAL_ROK;
 }
 
+int MaxItems::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int MaxItems::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MaxItems::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MaxItems", path, sizeof(*this));
+}
+
 ItemsTuple::ItemsTuple(Json::Value items)
 {
    m_items = items;
@@ -292,14 +693,23 @@ ItemsTuple::ItemsTuple(Json::Value items)
 ItemsTuple::~ItemsTuple()
 {
    for (unsigned int i = 0; i < m_primitives.size(); i++) {
-      delete m_primitives[i];
+      JsonPrimitive::release(m_primitives[i]);
    }
 }
 
-int ItemsTuple::validate(const Json::Value *value)
+template <typename T>
+int ItemsTuple::check(const T &value)
 {
-   for (std::size_t i = 0; i < value->size() && i < m_primitives.size(); i++) {
-      int ret = m_primitives[i]->validate(&((*value)[i]));
+   JsonBudget *budget = JsonBudget::current();
+   size_t i = 0;
+   for (typename T::const_iterator itr = value.begin();
+         itr != value.end() && i < m_primitives.size();
+         ++itr, i++) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      int ret = validateChild(m_primitives[i], *itr);
       if (JVAL_ROK != ret) {
          return JVAL_ERR_INVALID_ARRAY_ITEM;
       }
@@ -308,128 +718,429 @@ int ItemsTuple::validate(const Json::Value *value)
    return JVAL_ROK;
 }
 
-ItemsList::ItemsList(Json::Value items)
+int ItemsTuple::validate(const Json::Value *value)
 {
-   m_items = items;
-   m_primitive = JsonPrimitive::createPrimitive(&items);
+   return check(*value);
 }
 
-ItemsList::~ItemsList()
+int ItemsTuple::validate(const JsonTapeValue &value)
 {
-   delete m_primitive;
+   return check(value);
 }
 
-int ItemsList::validate(const Json::Value *value)
+void ItemsTuple::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
 {
-   for (std::size_t i = 0; i < value->size(); i++) {
-      int ret = m_primitive->validate(&((*value)[i]));
-      if (JVAL_ROK != ret) {
-         return JVAL_ERR_INVALID_ARRAY_ITEM;
+   usage.add("ItemsTuple", path, sizeof(*this) + \
+         m_primitives.capacity() * sizeof(JsonPrimitive *));
+   usage.add("Json::Value", path, JsonMemoryUsage::valueBytes(m_items));
+
+   for (unsigned int i = 0; i < m_primitives.size(); i++) {
+      std::ostringstream item;
+      item << path << "/items/" << i;
+      if (usage.visit(m_primitives[i])) {
+         m_primitives[i]->memoryUsage(usage, item.str());
       }
    }
-
-   return JVAL_ROK;
 }
 
 /**
- * @brief Array Validation keyword. Constructor
+ * @brief Array validation keyword. An insertion or removal shifts every item
+ * after it to another position of the tuple, so all the items from the first
+ * changed index onwards are validated again
  */
-UniqueItems::UniqueItems(bool uniqueItems = false)
+int ItemsTuple::validatePaths(const Json::Value *value,
+      const JsonPointerNode *paths)
 {
-   m_uniqueItems = uniqueItems;
-}
+   unsigned int first = 0;
+   if (!paths->minIndex(value->size(), first)) {
+      return JVAL_ROK;
+   }
 
-/**
- * @brief Array Validation keyword.
- *    Validates uniquieness in the list items
- *
- * @param schema
- * @param value
- *
- * @return 
- */
-int UniqueItems::validate(const Json::Value *value)
-{
-   std::set<Json::Value> valueSet;
+   JsonBudget *budget = JsonBudget::current();
+   for (Json::ArrayIndex i = first;
+         i < value->size() && i < m_primitives.size();
+         i++) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
 
-   if (m_uniqueItems) {
-      for (std::size_t i = 0; i < value->size(); i++) {
-        std::pair<std::set<Json::Value>::iterator, bool> ret = \
-            valueSet.insert((*value)[i]);
-        if (false == ret.second) {
-            return JVAL_ERR_DUPLICATE_ITEMS;
-        }
+      if (JVAL_ROK != m_primitives[i]->validate(&(*value)[i])) {
+         return JVAL_ERR_INVALID_ARRAY_ITEM;
       }
    }
 
    return JVAL_ROK;
 }
 
-/**
- * @brief Array Validation keyword. Constructor
- */
-AdditionalItems::AdditionalItems(unsigned int itemsSize)
-{
-   m_itemsSize = itemsSize;
-}
-
-/**
- * @brief Array Validation keyword. Validates additional items in a tuple.
- *
- * @param schema
- * @param value
- *
- * @return 
- */
-int AdditionalItems::validate(const Json::Value *value)
+int ItemsTuple::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
 {
-   // An empty array is always valid
-   if (0 == value->size()) {
-      return JVAL_ROK;
-   }
-
-   if (value->size() > m_itemsSize) {
-      return JVAL_ERR_ADDITIONAL_ITEMS;
+   unsigned int index = 0;
+   if (JsonPointerNode::toIndex(token, 0, index) && \
+         index < m_primitives.size()) {
+      schemas.push_back(m_primitives[index]);
    }
 
    return JVAL_ROK;
 }
 
-/**
- * @brief Object validation keyword. Constructor
- */
-MaxProperties::MaxProperties(unsigned int maxProperties)
+ItemsList::ItemsList(Json::Value items)
 {
-   m_maxProperties = maxProperties;
+   m_items = items;
+   m_primitive = JsonPrimitive::createPrimitive(&items);
 }
 
-int ObjectValid::validate(const Json::Value *value)
+ItemsList::~ItemsList()
 {
-   if (!value->isObject()) {
-      return JVAL_ERR_NOT_AN_OBJECT;
-   }
-
-   return JVAL_ROK;
+   JsonPrimitive::release(m_primitive);
 }
 
-/**
- * @brief Object validation keyword. Validates maximum number of properties of
- * an object
+template <typename T>
+int ItemsList::check(const T &value)
+{
+   JsonParallel *parallel = JsonParallel::current();
+   if (NULL != parallel) {
+      size_t chunks = parallel->chunks(value.size());
+      if (chunks > 0) {
+         std::vector<typename T::const_iterator> bounds;
+         chunkBounds(value, chunks, bounds);
+         ItemsChunk<T> work(m_primitive, bounds);
+         return parallel->run(bounds.size() - 1, work);
+      }
+   }
+
+   JsonBudget *budget = JsonBudget::current();
+   for (typename T::const_iterator itr = value.begin();
+         itr != value.end();
+         ++itr) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      int ret = validateMemoizedChild(m_primitive, *itr);
+      if (JVAL_ROK != ret) {
+         return JVAL_ERR_INVALID_ARRAY_ITEM;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+int ItemsList::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int ItemsList::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void ItemsList::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("ItemsList", path, sizeof(*this));
+   usage.add("Json::Value", path, JsonMemoryUsage::valueBytes(m_items));
+   if (usage.visit(m_primitive)) {
+      m_primitive->memoryUsage(usage, path + "/items");
+   }
+}
+
+/**
+ * @brief Array validation keyword. All the items share one subschema, so a
+ * single changed index is all that needs validating again. Several indices
+ * may come from insertions and removals which moved the items edited by the
+ * other operations, so then every item from the first one onwards is checked.
+ */
+int ItemsList::validatePaths(const Json::Value *value,
+      const JsonPointerNode *paths)
+{
+   const JsonPointerNode *changed = NULL;
+   unsigned int first = 0;
+   unsigned int count = 0;
+
+   for (JsonPointerNode::Children::const_iterator itr = \
+         paths->children().begin();
+         itr != paths->children().end();
+         itr++) {
+
+      unsigned int index = 0;
+      if (!JsonPointerNode::toIndex(itr->first, value->size(), index)) {
+         continue;
+      }
+
+      if (0 == count || index < first) {
+         first = index;
+      }
+
+      changed = itr->second;
+      count++;
+   }
+
+   if (0 == count || first >= value->size()) {
+      return JVAL_ROK;
+   }
+
+   if (1 == count) {
+      if (JVAL_ROK != m_primitive->validatePaths(&(*value)[first], changed)) {
+         return JVAL_ERR_INVALID_ARRAY_ITEM;
+      }
+
+      return JVAL_ROK;
+   }
+
+   JsonBudget *budget = JsonBudget::current();
+   for (Json::ArrayIndex i = first; i < value->size(); i++) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      if (JVAL_ROK != m_primitive->validate(&(*value)[i])) {
+         return JVAL_ERR_INVALID_ARRAY_ITEM;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+int ItemsList::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
+{
+   unsigned int index = 0;
+   if (JsonPointerNode::toIndex(token, 0, index)) {
+      schemas.push_back(m_primitive);
+   }
+
+   return JVAL_ROK;
+}
+
+/**
+ * @brief Array Validation keyword. Constructor
+ */
+UniqueItems::UniqueItems(bool uniqueItems = false)
+{
+   m_uniqueItems = uniqueItems;
+}
+
+/**
+ * @brief Array Validation keyword.
+ *    Validates uniquieness in the list items
  *
  * @param schema
  * @param value
  *
  * @return 
  */
-int MaxProperties::validate(const Json::Value *value)
+int UniqueItems::validate(const Json::Value *value)
 {
-   if (value->size() > m_maxProperties) {
+   std::set<Json::Value> valueSet;
+
+   if (m_uniqueItems) {
+      JsonBudget *budget = JsonBudget::current();
+      for (Json::ArrayIndex i = 0; i < value->size(); i++) {
+        if (!JsonBudget::spend(budget)) {
+            return JVAL_ERR_BUDGET_EXCEEDED;
+        }
+
+        std::pair<std::set<Json::Value>::iterator, bool> ret = \
+            valueSet.insert((*value)[i]);
+        if (false == ret.second) {
+            return JVAL_ERR_DUPLICATE_ITEMS;
+        }
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+static bool hashLess(const std::pair<size_t, JsonTapeValue> &a,
+      const std::pair<size_t, JsonTapeValue> &b)
+{
+   return a.first < b.first;
+}
+
+/**
+ * @brief Array Validation keyword. Validates uniqueness of the items of a
+ * tape array: items are sorted by structural hash and only the ones sharing
+ * a hash are compared.
+ */
+int UniqueItems::validate(const JsonTapeValue &value)
+{
+   if (!m_uniqueItems) {
+      return JVAL_ROK;
+   }
+
+   JsonBudget *budget = JsonBudget::current();
+   std::vector<std::pair<size_t, JsonTapeValue> > items;
+   items.reserve(value.size());
+   for (JsonTapeValue::const_iterator itr = value.begin();
+         itr != value.end();
+         ++itr) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      JsonTapeValue item = *itr;
+      items.push_back(std::make_pair(item.hash(), item));
+   }
+
+   std::sort(items.begin(), items.end(), hashLess);
+   for (size_t i = 0; i < items.size(); i++) {
+      for (size_t j = i + 1; j < items.size() && \
+            items[j].first == items[i].first; j++) {
+         if (!JsonBudget::spend(budget)) {
+            return JVAL_ERR_BUDGET_EXCEEDED;
+         }
+
+         if (items[i].second == items[j].second) {
+            return JVAL_ERR_DUPLICATE_ITEMS;
+         }
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+void UniqueItems::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("UniqueItems", path, sizeof(*this));
+}
+
+/**
+ * @brief Array Validation keyword. Constructor
+ */
+AdditionalItems::AdditionalItems(unsigned int itemsSize)
+{
+   m_itemsSize = itemsSize;
+}
+
+/**
+ * @brief Array Validation keyword. Validates additional items in a tuple.
+ *
+ * @param schema
+ * @param value
+ *
+ * @return 
+ */
+template <typename T>
+int AdditionalItems::check(const T &value)
+{
+   // An empty array is always valid
+   if (0 == value.size()) {
+      return JVAL_ROK;
+   }
+
+   if (value.size() > m_itemsSize) {
+      return JVAL_ERR_ADDITIONAL_ITEMS;
+   }
+
+   return JVAL_ROK;
+}
+
+int AdditionalItems::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int AdditionalItems::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void AdditionalItems::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("AdditionalItems", path, sizeof(*this));
+}
+
+/**
+ * @brief Array validation keyword. An array holding an item past the tuple
+ * is refused whatever the item.
+ */
+int AdditionalItems::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
+{
+   (void)schemas;
+
+   unsigned int index = 0;
+   if (JsonPointerNode::toIndex(token, 0, index) && index >= m_itemsSize) {
+      return JVAL_ERR_ADDITIONAL_ITEMS;
+   }
+
+   return JVAL_ROK;
+}
+
+/**
+ * @brief Object validation keyword. Constructor
+ */
+MaxProperties::MaxProperties(unsigned int maxProperties)
+{
+   m_maxProperties = maxProperties;
+}
+
+template <typename T>
+int ObjectValid::check(const T &value)
+{
+   if (!value.isObject()) {
+      return JVAL_ERR_NOT_AN_OBJECT;
+   }
+
+   return JVAL_ROK;
+}
+
+int ObjectValid::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int ObjectValid::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void ObjectValid::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("ObjectValid", path, sizeof(*this));
+}
+
+/**
+ * @brief Object validation keyword. Validates maximum number of properties of
+ * an object
+ *
+ * @param schema
+ * @param value
+ *
+ * @return 
+ */
+template <typename T>
+int MaxProperties::check(const T &value)
+{
+   if (value.size() > m_maxProperties) {
       return JVAL_ERR_INVALID_MAX_PROPERTIES;
    }
 
    return JVAL_ROK;
 }
 
+int MaxProperties::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int MaxProperties::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MaxProperties::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MaxProperties", path, sizeof(*this));
+}
+
 /**
  * @brief Object validation keyword. Constructor
  */
@@ -447,18 +1158,44 @@ MinProperties::MinProperties(unsigned int minProperties = 0)
  *
  * @return 
  */
-int MinProperties::validate(const Json::Value *value)
+template <typename T>
+int MinProperties::check(const T &value)
 {
-   if (value->size() < m_minProperties) {
+   if (value.size() < m_minProperties) {
       return JVAL_ERR_INVALID_MIN_PROPERTIES;
    }
 
    return JVAL_ROK;
 }
 
+int MinProperties::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int MinProperties::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void MinProperties::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("MinProperties", path, sizeof(*this));
+}
+
 Required::Required(Json::Value required)
 {
+   if (!required.isArray()) {
+      JVAL_SCHEMA_ERROR("required is not an array");
+      return;
+   }
+
    for (unsigned int i = 0; i < required.size(); i++) {
+      if (!required[i].isString()) {
+         JVAL_SCHEMA_ERROR("required has a name which is not a string");
+         return;
+      }
       m_required.push_back(required[i].asString());
    }
 }
@@ -472,10 +1209,11 @@ Required::Required(Json::Value required)
  *
  * @return
  */
-int Required::validate(const Json::Value *value)
+template <typename T>
+int Required::check(const T &value)
 {
    for (size_t i = 0; i < m_required.size(); i++) {
-      if (!value->isMember(m_required[i])) {
+      if (!value.isMember(m_required[i])) {
          return JVAL_ERR_REQUIRED_ITEM_MISSING;
       }
    }
@@ -483,10 +1221,117 @@ int Required::validate(const Json::Value *value)
    return JVAL_ROK;
 }
 
-Properties::Properties(Json::Value properties, bool additionalProperties = true)
+int Required::validate(const Json::Value *value)
+{
+   return check(*value);
+}
+
+int Required::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void Required::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   size_t bytes = sizeof(*this) + m_required.capacity() * sizeof(std::string);
+   for (unsigned int i = 0; i < m_required.size(); i++) {
+      bytes += JsonMemoryUsage::stringBytes(m_required[i]);
+   }
+   usage.add("Required", path, bytes);
+}
+
+static inline size_t hashName(const char *begin, const char *end)
+{
+   size_t hash = 14695981039346656037ULL;
+   for (; begin != end; begin++) {
+      hash = (hash ^ static_cast<unsigned char>(*begin)) * 1099511628211ULL;
+   }
+
+   return hash;
+}
+
+void NameIndex::add(const std::string &name)
+{
+   m_names.push_back(name);
+
+   // open addressing, at most half full
+   if (2 * m_names.size() > m_slots.size()) {
+      rehash(m_slots.empty() ? 4 : 2 * m_slots.size());
+      return;
+   }
+
+   size_t slot = hashName(name.data(), name.data() + name.size()) & m_mask;
+   while (0 != m_slots[slot]) {
+      slot = (slot + 1) & m_mask;
+   }
+   m_slots[slot] = static_cast<uint32_t>(m_names.size());
+}
+
+void NameIndex::rehash(size_t slots)
+{
+   m_slots.assign(slots, 0);
+   m_mask = slots - 1;
+   for (size_t i = 0; i < m_names.size(); i++) {
+      const std::string &name = m_names[i];
+      size_t slot = hashName(name.data(), name.data() + name.size()) & m_mask;
+      while (0 != m_slots[slot]) {
+         slot = (slot + 1) & m_mask;
+      }
+      m_slots[slot] = static_cast<uint32_t>(i + 1);
+   }
+}
+
+int NameIndex::find(const char *name, const char *end) const
+{
+   if (m_names.empty()) {
+      return -1;
+   }
+
+   size_t length = end - name;
+   size_t slot = hashName(name, end) & m_mask;
+   for (; 0 != m_slots[slot]; slot = (slot + 1) & m_mask) {
+      const std::string &candidate = m_names[m_slots[slot] - 1];
+      if (candidate.size() == length && \
+            0 == memcmp(candidate.data(), name, length)) {
+         return static_cast<int>(m_slots[slot] - 1);
+      }
+   }
+
+   return -1;
+}
+
+size_t NameIndex::bytes() const
+{
+   size_t bytes = m_names.capacity() * sizeof(std::string) + \
+      m_slots.capacity() * sizeof(uint32_t);
+   for (size_t i = 0; i < m_names.size(); i++) {
+      bytes += JsonMemoryUsage::stringBytes(m_names[i]);
+   }
+
+   return bytes;
+}
+
+Properties::Properties(Json::Value properties, Json::Value patternProperties,
+      Json::Value additionalProperties)
 {
    m_properties = properties;
-   m_additionalProperties = additionalProperties;
+   m_patternProperties = patternProperties;
+   m_additionalSchema = additionalProperties;
+   m_additionalProperties = true;
+   m_patterns = NULL;
+   m_additional = NULL;
+
+   if (!additionalProperties.isNull() && !additionalProperties.isBool() && \
+         !additionalProperties.isObject()) {
+      JVAL_SCHEMA_ERROR("additionalProperties is not a boolean or an object");
+      return;
+   }
+
+   if (!properties.isNull() && !properties.isObject()) {
+      JVAL_SCHEMA_ERROR("properties is not an object");
+      return;
+   }
 
    for (Json::ValueIterator itr = properties.begin();\
          itr != properties.end();\
@@ -494,18 +1339,105 @@ Properties::Properties(Json::Value properties, bool additionalProperties = true)
 
       Json::Value property = properties.get(itr.name(), property);
       JsonPrimitive *primitive = JsonPrimitive::createPrimitive(&property);
-      m_primitives[itr.name()] = primitive;
+      m_names.add(itr.name());
+      m_primitives.push_back(primitive);
+   }
+
+   if (additionalProperties.isObject()) {
+      m_additionalProperties = true;
+      m_additional = JsonPrimitive::createPrimitive(&additionalProperties);
+   } else if (additionalProperties.isBool()) {
+      m_additionalProperties = additionalProperties.asBool();
+   }
+
+   if (patternProperties.isNull() || patternProperties.empty()) {
+      return;
    }
+
+   if (!patternProperties.isObject()) {
+      JVAL_SCHEMA_ERROR("patternProperties is not an object");
+      return;
+   }
+
+   // the patterns of the names, all searched at once
+   m_patterns = new JsonPatternSet;
+   for (Json::ValueIterator itr = patternProperties.begin();
+         itr != patternProperties.end();
+         itr++) {
+      Json::Value property = patternProperties.get(itr.name(), property);
+      m_patterns->add(itr.name());
+      m_patternPrimitives.push_back(JsonPrimitive::createPrimitive(&property));
+   }
+   m_patterns->compile();
 }
 
 Properties::~Properties()
 {
-   for (std::map<std::string, JsonPrimitive*>::iterator itr = \
-         m_primitives.begin(); itr != m_primitives.end();
-         itr++)
-   {
-      delete itr->second;
+   for (size_t i = 0; i < m_primitives.size(); i++) {
+      JsonPrimitive::release(m_primitives[i]);
+   }
+
+   for (size_t i = 0; i < m_patternPrimitives.size(); i++) {
+      JsonPrimitive::release(m_patternPrimitives[i]);
    }
+   delete m_patterns;
+
+   if (NULL != m_additional) {
+      JsonPrimitive::release(m_additional);
+   }
+}
+
+JsonPrimitive *Properties::declared(const char *name, const char *end) const
+{
+   int position = m_names.find(name, end);
+   return position < 0 ? NULL : m_primitives[position];
+}
+
+/**
+ * @brief Validates a member against the subschemas of its name and of the
+ * patterns found in it, or else against additionalProperties
+ */
+template <typename V>
+int Properties::checkMember(const char *name, const char *end,
+      const V &value, uint64_t *matches)
+{
+   bool covered = false;
+   JsonPrimitive *primitive = declared(name, end);
+   if (NULL != primitive) {
+      covered = true;
+      if (JVAL_ROK != validateMemoizedChild(primitive, value)) {
+         return JVAL_ERR_INVALID_PROPERTY;
+      }
+   }
+
+   if (NULL != m_patterns) {
+      m_patterns->match(name, end, matches);
+      for (size_t i = 0; i < m_patternPrimitives.size(); i++) {
+         if (0 == (matches[i / 64] & (static_cast<uint64_t>(1) << (i % 64)))) {
+            continue;
+         }
+
+         covered = true;
+         if (JVAL_ROK != validateMemoizedChild(m_patternPrimitives[i], value)) {
+            return JVAL_ERR_INVALID_PROPERTY;
+         }
+      }
+   }
+
+   if (covered) {
+      return JVAL_ROK;
+   }
+
+   if (!m_additionalProperties) {
+      return JVAL_ERR_UNKNOWN_PROPERTY;
+   }
+
+   if (NULL != m_additional && \
+         JVAL_ROK != validateMemoizedChild(m_additional, value)) {
+      return JVAL_ERR_INVALID_PROPERTY;
+   }
+
+   return JVAL_ROK;
 }
 
 /**
@@ -516,19 +1448,155 @@ Properties::~Properties()
  *
  * @return 
  */
+template <typename T>
+int Properties::check(const T &value)
+{
+   JsonParallel *parallel = JsonParallel::current();
+   if (NULL != parallel) {
+      size_t chunks = parallel->chunks(value.size());
+      if (chunks > 0) {
+         std::vector<typename T::const_iterator> bounds;
+         chunkBounds(value, chunks, bounds);
+         PropertiesChunk<T> work(*this, bounds);
+         return parallel->run(bounds.size() - 1, work);
+      }
+   }
+
+   MatchSet matches(m_patterns);
+   JsonBudget *budget = JsonBudget::current();
+   for (typename T::const_iterator itr = value.begin();\
+         itr != value.end();\
+         ++itr) {
+
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      const char *end = NULL;
+      const char *name = itr.memberName(&end);
+      int ret = checkMember(name, end, *itr, matches.words());
+      if (JVAL_ROK != ret) {
+         return ret;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
 int Properties::validate(const Json::Value *value)
 {
-   if (m_additionalProperties) {
-      return JVAL_ROK;
+   return check(*value);
+}
+
+int Properties::validate(const JsonTapeValue &value)
+{
+   return check(value);
+}
+
+void Properties::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   size_t bytes = sizeof(*this);
+   usage.add("Json::Value", path, JsonMemoryUsage::valueBytes(m_properties));
+
+   bytes += m_names.bytes() + m_primitives.capacity() * sizeof(JsonPrimitive*);
+   for (size_t i = 0; i < m_primitives.size(); i++) {
+      if (usage.visit(m_primitives[i])) {
+         m_primitives[i]->memoryUsage(usage, path + "/properties/" + \
+               JsonMemoryUsage::pointerToken(m_names.name(i)));
+      }
    }
 
-   for (Json::ValueConstIterator itr = value->begin();\
-         itr != value->end();\
+   if (NULL != m_patterns) {
+      usage.add("Json::Value", path,
+            JsonMemoryUsage::valueBytes(m_patternProperties));
+      m_patterns->memoryUsage(usage, path);
+      bytes += m_patternPrimitives.capacity() * sizeof(JsonPrimitive*);
+
+      Json::Value::Members names = m_patternProperties.getMemberNames();
+      for (size_t i = 0; i < m_patternPrimitives.size(); i++) {
+         if (usage.visit(m_patternPrimitives[i])) {
+            m_patternPrimitives[i]->memoryUsage(usage,
+                  path + "/patternProperties/" + \
+                  JsonMemoryUsage::pointerToken(names[i]));
+         }
+      }
+   }
+
+   if (NULL != m_additional) {
+      usage.add("Json::Value", path,
+            JsonMemoryUsage::valueBytes(m_additionalSchema));
+      if (usage.visit(m_additional)) {
+         m_additional->memoryUsage(usage, path + "/additionalProperties");
+      }
+   }
+   usage.add("Properties", path, bytes);
+}
+
+/**
+ * @brief Object validation keyword. Validates the changed members only; the
+ * pointer tree keeps them in the member order of Json::Value so the first
+ * failure is the same one check() would report
+ */
+int Properties::validatePaths(const Json::Value *value,
+      const JsonPointerNode *paths)
+{
+   MatchSet matches(m_patterns);
+   JsonBudget *budget = JsonBudget::current();
+   for (JsonPointerNode::Children::const_iterator itr = \
+         paths->children().begin();
+         itr != paths->children().end();
          itr++) {
 
-      JsonPrimitive *primitive = m_primitives[itr.name()];
-      Json::Value property = *itr;
-      if (JVAL_ROK != primitive->validate(&property)) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      const std::string &name = itr->first;
+      const Json::Value *member = value->find(name.data(),
+            name.data() + name.size());
+      if (NULL == member) {
+         // removed members are left to the required keyword
+         continue;
+      }
+
+      bool covered = false;
+      JsonPrimitive *primitive = declared(name.data(),
+            name.data() + name.size());
+      if (NULL != primitive) {
+         covered = true;
+         if (JVAL_ROK != primitive->validatePaths(member, itr->second)) {
+            return JVAL_ERR_INVALID_PROPERTY;
+         }
+      }
+
+      if (NULL != m_patterns) {
+         m_patterns->match(name.data(), name.data() + name.size(),
+               matches.words());
+         for (size_t i = 0; i < m_patternPrimitives.size(); i++) {
+            if (0 == (matches.words()[i / 64] & \
+                     (static_cast<uint64_t>(1) << (i % 64)))) {
+               continue;
+            }
+
+            covered = true;
+            if (JVAL_ROK != m_patternPrimitives[i]->validatePaths(member,
+                     itr->second)) {
+               return JVAL_ERR_INVALID_PROPERTY;
+            }
+         }
+      }
+
+      if (covered) {
+         continue;
+      }
+
+      if (!m_additionalProperties) {
+         return JVAL_ERR_UNKNOWN_PROPERTY;
+      }
+
+      if (NULL != m_additional && \
+            JVAL_ROK != m_additional->validatePaths(member, itr->second)) {
          return JVAL_ERR_INVALID_PROPERTY;
       }
    }
@@ -536,28 +1604,196 @@ int Properties::validate(const Json::Value *value)
    return JVAL_ROK;
 }
 
-AdditionalProperties::AdditionalProperties()
+/**
+ * @brief Object validation keyword. Same lookup as checkMember(); a member
+ * no subschema covers is refused if additional properties are not allowed.
+ */
+int Properties::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
+{
+   const char *name = token.data();
+   const char *end = token.data() + token.size();
+
+   bool covered = false;
+   JsonPrimitive *primitive = declared(name, end);
+   if (NULL != primitive) {
+      covered = true;
+      schemas.push_back(primitive);
+   }
+
+   if (NULL != m_patterns) {
+      MatchSet matches(m_patterns);
+      m_patterns->match(name, end, matches.words());
+      for (size_t i = 0; i < m_patternPrimitives.size(); i++) {
+         if (0 == (matches.words()[i / 64] & \
+                  (static_cast<uint64_t>(1) << (i % 64)))) {
+            continue;
+         }
+
+         covered = true;
+         schemas.push_back(m_patternPrimitives[i]);
+      }
+   }
+
+   if (covered) {
+      return JVAL_ROK;
+   }
+
+   if (!m_additionalProperties) {
+      return JVAL_ERR_UNKNOWN_PROPERTY;
+   }
+
+   if (NULL != m_additional) {
+      schemas.push_back(m_additional);
+   }
+
+   return JVAL_ROK;
+}
+
+Dependencies::Dependencies(Json::Value dependencies)
+{
+   m_dependencies = dependencies;
+   m_words = 0;
+
+   if (!dependencies.isObject()) {
+      JVAL_SCHEMA_ERROR("dependencies is not an object");
+      return;
+   }
+
+   // the bits first, the masks are as wide as their count
+   for (Json::ValueIterator itr = dependencies.begin();
+         itr != dependencies.end();
+         itr++) {
+      Json::Value dependency = dependencies.get(itr.name(), dependency);
+      if (dependency.isArray()) {
+         for (Json::ArrayIndex i = 0; i < dependency.size(); i++) {
+            if (!dependency[i].isString()) {
+               JVAL_SCHEMA_ERROR("dependency \"" + itr.name() + \
+                     "\" has a name which is not a string");
+               return;
+            }
+            bit(dependency[i].asString());
+         }
+      } else if (!dependency.isObject()) {
+         JVAL_SCHEMA_ERROR("dependency \"" + itr.name() + \
+               "\" is neither an array nor an object");
+         return;
+      }
+      m_rules.push_back(bit(itr.name()));
+   }
+
+   m_words = (m_names.size() + 63) / 64;
+   m_masks.assign(m_rules.size() * m_words, 0);
+
+   size_t rule = 0;
+   for (Json::ValueIterator itr = dependencies.begin();
+         itr != dependencies.end();
+         itr++, rule++) {
+      Json::Value dependency = dependencies.get(itr.name(), dependency);
+      if (dependency.isObject()) {
+         m_schemas.push_back(JsonPrimitive::createPrimitive(&dependency));
+         continue;
+      }
+
+      m_schemas.push_back(NULL);
+      uint64_t *mask = &m_masks[rule * m_words];
+      for (Json::ArrayIndex i = 0; i < dependency.size(); i++) {
+         size_t b = bit(dependency[i].asString());
+         mask[b / 64] |= static_cast<uint64_t>(1) << (b % 64);
+      }
+   }
+}
+
+Dependencies::~Dependencies()
+{
+   for (size_t i = 0; i < m_schemas.size(); i++) {
+      if (NULL != m_schemas[i]) {
+         JsonPrimitive::release(m_schemas[i]);
+      }
+   }
+}
+
+size_t Dependencies::bit(const std::string &name)
+{
+   int position = m_names.find(name.data(), name.data() + name.size());
+   if (position >= 0) {
+      return position;
+   }
+
+   m_names.add(name);
+   return m_names.size() - 1;
+}
+
+/**
+ * @brief Object validation keyword. Checks the rules of the names present,
+ * in the member order of the dependencies
+ */
+template <typename T>
+int Dependencies::check(const T &value)
+{
+   MatchSet present(m_words);
+   uint64_t *words = present.words();
+   memset(words, 0, m_words * sizeof(uint64_t));
+
+   for (typename T::const_iterator itr = value.begin();
+         itr != value.end();
+         ++itr) {
+      const char *end = NULL;
+      const char *name = itr.memberName(&end);
+      int b = m_names.find(name, end);
+      if (b >= 0) {
+         words[b / 64] |= static_cast<uint64_t>(1) << (b % 64);
+      }
+   }
+
+   for (size_t rule = 0; rule < m_rules.size(); rule++) {
+      size_t b = m_rules[rule];
+      if (0 == (words[b / 64] & (static_cast<uint64_t>(1) << (b % 64)))) {
+         continue;
+      }
+
+      if (NULL != m_schemas[rule]) {
+         if (JVAL_ROK != validateMemoizedChild(m_schemas[rule], value)) {
+            return JVAL_ERR_INVALID_DEPENDENCY;
+         }
+         continue;
+      }
+
+      const uint64_t *mask = &m_masks[rule * m_words];
+      for (size_t i = 0; i < m_words; i++) {
+         if ((words[i] & mask[i]) != mask[i]) {
+            return JVAL_ERR_DEPENDENCY_MISSING;
+         }
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+int Dependencies::validate(const Json::Value *value)
 {
-    m_additionalProperties = true;
+   return check(*value);
 }
 
-int AdditionalProperties::validate(const Json::Value *value)
+int Dependencies::validate(const JsonTapeValue &value)
 {
-   (void)value;
-#if 0
-    Json::Value additionalProps = schema->get("additionalProperties",
-            additionalProps);
-    if (additionalProps.isBool()) {
-        m_additionalProperties = additionalProps.asBool();
-        if (true == m_additionalProperties) {
-            return JVAL_ROK;
-        }
-    } else if (additionalProps.isObject()) {
-        return JVAL_ROK;
-    } else {
-        return JVAL_ERR_INVALID_SCHEMA;
-    }
-#endif
-
-    return JVAL_ROK;
+   return check(value);
+}
+
+void Dependencies::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   size_t bytes = sizeof(*this) + m_names.bytes() + \
+      m_rules.capacity() * sizeof(size_t) + \
+      m_schemas.capacity() * sizeof(JsonPrimitive*) + \
+      m_masks.capacity() * sizeof(uint64_t);
+   usage.add("Json::Value", path, JsonMemoryUsage::valueBytes(m_dependencies));
+
+   for (size_t rule = 0; rule < m_rules.size(); rule++) {
+      if (NULL != m_schemas[rule] && usage.visit(m_schemas[rule])) {
+         m_schemas[rule]->memoryUsage(usage, path + "/dependencies/" + \
+               JsonMemoryUsage::pointerToken(m_names.name(m_rules[rule])));
+      }
+   }
+   usage.add("Dependencies", path, bytes);
 }
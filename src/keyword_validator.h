@@ -23,11 +23,52 @@
 #ifndef __KEYWORD_VALIDATOR_H__
 #define __KEYWORD_VALIDATOR_H__
 
+class JsonTapeValue;
+class JsonPointerNode;
+class JsonMemoryUsage;
+class JsonPatternSet;
+
+/**
+ * Keyword values of a schema, checked before they are converted. A keyword
+ * of the wrong type, or a count which is negative or does not fit an unsigned
+ * int, is a schema error (see JVAL_SCHEMA_ERROR) and false is returned for it
+ * as for a missing one.
+ */
+bool countKeyword(Json::Value *schema, const char *keyword, size_t &count);
+bool boolKeyword(Json::Value *schema, const char *keyword, bool &flag);
+bool stringKeyword(Json::Value *schema, const char *keyword,
+      std::string &text);
+
 class KeywordValidator
 {
    public:
       virtual ~KeywordValidator() {};
       virtual int validate(const Json::Value *value) = 0;
+      virtual int validate(const JsonTapeValue &value) = 0;
+
+      /**
+       * @brief Adds the bytes held by the keyword and its subschemas
+       *
+       * @param path JSON Pointer of the schema the keyword belongs to
+       */
+      virtual void memoryUsage(JsonMemoryUsage &usage,
+            const std::string &path) const = 0;
+
+      // keywords which do not descend into subschemas are re-run as is
+      virtual int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths) {
+         (void)paths;
+         return validate(value);
+      }
+
+      // only the keywords which descend into subschemas have any for a
+      // member or item; see JsonPrimitive::subschemas()
+      virtual int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const {
+         (void)token;
+         (void)schemas;
+         return JVAL_ROK;
+      }
 };
 
 class IntValid : public KeywordValidator
@@ -36,30 +77,11 @@ class IntValid : public KeywordValidator
       IntValid() {};
       ~IntValid() {};
       int validate(const Json::Value *value);
-};
-
-class IntMaximum : public KeywordValidator
-{
-   public:
-      IntMaximum(int, bool);
-      ~IntMaximum() {};
-      int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
-      int  m_maximum;
-      bool m_exclusiveMaximum;
-};
-
-class IntMinimum : public KeywordValidator
-{
-   public:
-      IntMinimum(int, bool);
-      ~IntMinimum() {};
-      int validate(const Json::Value *value);
-
-   private:
-      bool m_exclusiveMinimum;
-      int  m_minimum;
+      template <typename T> int check(const T &value);
 };
 
 class NumberValid : public KeywordValidator
@@ -68,52 +90,66 @@ class NumberValid : public KeywordValidator
       NumberValid() {};
       ~NumberValid() {};
       int validate(const Json::Value *value);
-};
-
-class NumberMaximum : public KeywordValidator
-{
-   public:
-      NumberMaximum(double, bool);
-      ~NumberMaximum() {};
-      int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
-      double   m_maximum;
-      bool     m_exclusiveMaximum;
+      template <typename T> int check(const T &value);
 };
 
-class NumberMinimum : public KeywordValidator
+/**
+ * @brief minimum, maximum, their exclusive flags and multipleOf folded into
+ * one keyword: the instance is read once and compared exactly against the
+ * bounds, as 64-bit integers when both sides are integral
+ */
+class NumberRange : public KeywordValidator
 {
    public:
-      NumberMinimum(double, bool);
-      ~NumberMinimum() {};
+      NumberRange(Json::Value *schema);
+      ~NumberRange() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+      // true if the schema has none of the keywords
+      bool empty() const {
+         return !m_hasMinimum && !m_hasMaximum && !m_hasMultipleOf;
+      }
+
+      template <typename T> int check(const T &value) const {
+         JsonNumberValue number = JsonNumberValue::of(value);
+
+         if (m_hasMinimum) {
+            int c = JsonNumberValue::compare(number, m_minimum);
+            if (c < 0 || (c == 0 && m_exclusiveMinimum)) {
+               return JVAL_ERR_INVALID_MINIMUM;
+            }
+         }
+
+         if (m_hasMaximum) {
+            int c = JsonNumberValue::compare(number, m_maximum);
+            if ((c > 0 && c != JSON_NUMBER_UNORDERED) || \
+                  (c == 0 && m_exclusiveMaximum)) {
+               return JVAL_ERR_INVALID_MAXIMUM;
+            }
+         }
+
+         if (m_hasMultipleOf && !m_multipleOf.check(number)) {
+            return JVAL_ERR_NOT_A_MULTIPLE;
+         }
+
+         return JVAL_ROK;
+      }
 
    private:
-      double   m_minimum;
-      bool     m_exclusiveMinimum;
-};
-
-class IntMultipleOf : public KeywordValidator
-{
-   public:
-      IntMultipleOf(int);
-      ~IntMultipleOf() {}
-      int validate(const Json::Value *value);
-
-   private:
-      int m_multipleOf;
-};
-
-class NumberMultipleOf : public KeywordValidator
-{
-   public:
-      NumberMultipleOf(double);
-      ~NumberMultipleOf() {}
-      int validate(const Json::Value *value);
-
-   private:
-      double m_multipleOf;
+      bool              m_hasMinimum;
+      bool              m_exclusiveMinimum;
+      JsonNumberValue   m_minimum;
+      bool              m_hasMaximum;
+      bool              m_exclusiveMaximum;
+      JsonNumberValue   m_maximum;
+      bool              m_hasMultipleOf;
+      JsonMultipleOf    m_multipleOf;
 };
 
 class StringValid : public KeywordValidator
@@ -122,6 +158,11 @@ class StringValid : public KeywordValidator
       StringValid() {};
       ~StringValid() {};
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+   private:
+      template <typename T> int check(const T &value);
 };
 
 class MinLength : public KeywordValidator
@@ -130,8 +171,12 @@ class MinLength : public KeywordValidator
       MinLength(int);
       ~MinLength() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_minLength;
 };
 
@@ -141,8 +186,12 @@ class MaxLength : public KeywordValidator
       MaxLength(int);
       ~MaxLength() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_maxLength;
 };
 
@@ -152,9 +201,36 @@ class Pattern : public KeywordValidator
       Pattern(JSONCPP_STRING);
       ~Pattern() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+   private:
+      template <typename T> int check(const T &value);
+
+      std::regex     m_pattern;
+      size_t         m_patternLength;
+};
+
+class Format : public KeywordValidator
+{
+   public:
+      Format(const std::string &name, JsonFormat::Checker checker);
+      ~Format() {}
+      int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+      /**
+       * @brief Checker of the format keyword of a schema, NULL if there is
+       * none or the format is unknown
+       */
+      static JsonFormat::Checker lookup(Json::Value *schema);
 
    private:
-      std::regex m_pattern;
+      template <typename T> int check(const T &value);
+
+      std::string          m_name;
+      JsonFormat::Checker  m_checker;
 };
 
 class ArrayValid : public KeywordValidator
@@ -163,6 +239,11 @@ class ArrayValid : public KeywordValidator
       ArrayValid() {};
       ~ArrayValid() {};
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+   private:
+      template <typename T> int check(const T &value);
 };
 
 class MinItems : public KeywordValidator
@@ -171,8 +252,12 @@ class MinItems : public KeywordValidator
       MinItems(unsigned int);
       ~MinItems() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_minItems;
 };
 
@@ -182,8 +267,12 @@ class MaxItems : public KeywordValidator
       MaxItems(unsigned int);
       ~MaxItems() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_maxItems;
 };
 
@@ -193,8 +282,16 @@ class ItemsTuple : public KeywordValidator
       ItemsTuple(Json::Value);
       ~ItemsTuple();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths);
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       Json::Value                   m_items;
       std::vector<JsonPrimitive*>   m_primitives;
 };
@@ -205,8 +302,16 @@ class ItemsList : public KeywordValidator
       ItemsList(Json::Value items);
       ~ItemsList();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths);
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       Json::Value    m_items;
       JsonPrimitive  *m_primitive;
 };
@@ -217,6 +322,8 @@ class UniqueItems : public KeywordValidator
       UniqueItems(bool);
       ~UniqueItems() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
       bool m_uniqueItems;
@@ -228,9 +335,15 @@ class AdditionalItems : public KeywordValidator
       AdditionalItems(unsigned int);
       ~AdditionalItems() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
 
    private:
-      bool m_itemsSize;
+      template <typename T> int check(const T &value);
+
+      unsigned int m_itemsSize;
 };
 
 class ObjectValid : public KeywordValidator
@@ -239,6 +352,11 @@ class ObjectValid : public KeywordValidator
       ObjectValid() {};
       ~ObjectValid() {};
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+   private:
+      template <typename T> int check(const T &value);
 };
 
 class MaxProperties : public KeywordValidator
@@ -247,8 +365,12 @@ class MaxProperties : public KeywordValidator
       MaxProperties(unsigned int);
       ~MaxProperties() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_maxProperties;
 };
 
@@ -258,8 +380,12 @@ class MinProperties : public KeywordValidator
       MinProperties(unsigned int);
       ~MinProperties() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       unsigned int m_minProperties;
 };
 
@@ -269,34 +395,117 @@ class Required : public KeywordValidator
       Required(Json::Value);
       ~Required() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
+      template <typename T> int check(const T &value);
+
       std::vector<std::string> m_required;
 };
 
+/**
+ * @brief Member names of the object keywords, each found at its position by
+ * a hash of the name without copying it
+ */
+class NameIndex
+{
+   public:
+      NameIndex() : m_mask(0) {}
+
+      // the position of a name is the number of names added before it
+      void add(const std::string &name);
+
+      // position of [name, end) among the names, -1 if it is not one of them
+      int find(const char *name, const char *end) const;
+
+      size_t size() const {return m_names.size();}
+      const std::string &name(size_t position) const {return m_names[position];}
+      size_t bytes() const;
+
+   private:
+      void rehash(size_t slots);
+
+      std::vector<std::string>   m_names;
+      std::vector<uint32_t>      m_slots;
+      size_t                     m_mask;
+};
+
+/**
+ * @brief Object validation keyword for properties, patternProperties and
+ * additionalProperties. In one pass over the members each name is looked up
+ * among the declared properties and searched for all the patterns at once; a
+ * member neither covers is additional: allowed when additionalProperties is
+ * missing or true, refused when it is false, or else validated against its
+ * subschema.
+ */
 class Properties : public KeywordValidator
 {
    public:
-      Properties(Json::Value, bool);
+      Properties(Json::Value properties, Json::Value patternProperties,
+            Json::Value additionalProperties);
       ~Properties();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths);
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
 
    private:
+      template <typename T> friend class PropertiesChunk;
+
+      template <typename T> int check(const T &value);
+
+      // matches holds the words of a JsonPatternSet match set
+      template <typename V> int checkMember(const char *name, const char *end,
+            const V &value, uint64_t *matches);
+
+      JsonPrimitive *declared(const char *name, const char *end) const;
+
       Json::Value                            m_properties;
+      Json::Value                            m_patternProperties;
+      Json::Value                            m_additionalSchema;
       bool                                   m_additionalProperties;
-      std::map<std::string, JsonPrimitive*>  m_primitives;
+      NameIndex                              m_names;
+      std::vector<JsonPrimitive*>            m_primitives;
+      JsonPatternSet                         *m_patterns;
+      std::vector<JsonPrimitive*>            m_patternPrimitives;
+      JsonPrimitive                          *m_additional;
 };
 
-class AdditionalProperties
+/**
+ * @brief Object validation keyword for dependencies. Every name the rules
+ * mention has a bit and every property dependency is a mask of those bits;
+ * one pass over the members collects the bits of the names present, then a
+ * rule whose name is present holds if its mask is all set, or if the object
+ * is valid against its schema dependency.
+ */
+class Dependencies : public KeywordValidator
 {
    public:
-      AdditionalProperties();
-      ~AdditionalProperties() {}
+      Dependencies(Json::Value dependencies);
+      ~Dependencies();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
-      bool m_additionalProperties;
+      template <typename T> int check(const T &value);
+
+      // bit of name, added if no rule mentioned it yet
+      size_t bit(const std::string &name);
+
+      Json::Value                   m_dependencies;
+      NameIndex                     m_names;
+      size_t                        m_words;
 
+      // per rule, the bit of its name and a schema or else a mask of
+      // m_words words in m_masks
+      std::vector<size_t>           m_rules;
+      std::vector<JsonPrimitive*>   m_schemas;
+      std::vector<uint64_t>         m_masks;
 };
 
 #endif
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string.h>
+#include <unordered_map>
+#include <json.h>
+#include <memo.h>
+
+static JSONCPP_THREAD_LOCAL JsonMemo *currentMemo = NULL;
+
+static inline size_t combine(size_t seed, size_t hash)
+{
+   return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+static inline size_t hashBytes(const char *begin, const char *end)
+{
+   size_t hash = 14695981039346656037ULL;
+   for (; begin != end; begin++) {
+      hash = (hash ^ static_cast<unsigned char>(*begin)) * 1099511628211ULL;
+   }
+
+   return hash;
+}
+
+JsonMemo::Scope::Scope(JsonMemo &memo)
+{
+   m_previous = currentMemo;
+   currentMemo = &memo;
+}
+
+JsonMemo::Scope::~Scope()
+{
+   currentMemo = m_previous;
+}
+
+JsonMemo::JsonMemo(size_t capacity, bool copyValues)
+{
+   m_capacity = capacity;
+   m_copyValues = copyValues;
+   m_hits = 0;
+   m_misses = 0;
+}
+
+JsonMemo *JsonMemo::current()
+{
+   return currentMemo;
+}
+
+bool JsonMemo::find(const JsonPrimitive *primitive, const Json::Value &value,
+      size_t hash, int &result)
+{
+   std::pair<Entries::iterator, Entries::iterator> range = \
+      m_entries.equal_range(hash);
+
+   for (Entries::iterator itr = range.first; itr != range.second; itr++) {
+      if (itr->second.primitive == primitive && *itr->second.value == value) {
+         result = itr->second.result;
+         m_hits++;
+         return true;
+      }
+   }
+
+   m_misses++;
+   return false;
+}
+
+void JsonMemo::insert(const JsonPrimitive *primitive, const Json::Value &value,
+      size_t hash, int result)
+{
+   if (0 == m_capacity || (m_copyValues && NULL != Json::Arena::current())) {
+      return;
+   }
+
+   if (m_entries.size() >= m_capacity) {
+      m_entries.clear();
+   }
+
+   Entries::iterator itr = m_entries.insert(std::make_pair(hash, Entry()));
+   itr->second.primitive = primitive;
+   itr->second.result = result;
+   if (m_copyValues) {
+      itr->second.copy = value;
+      itr->second.value = &itr->second.copy;
+   } else {
+      itr->second.value = &value;
+   }
+}
+
+void JsonMemo::clear()
+{
+   m_entries.clear();
+   m_hits = 0;
+   m_misses = 0;
+}
+
+size_t JsonMemo::hash(const Json::Value &value)
+{
+   size_t hash = static_cast<size_t>(value.type());
+
+   switch (value.type()) {
+      case Json::intValue:
+         return combine(hash, static_cast<size_t>(value.asLargestInt()));
+      case Json::uintValue:
+         return combine(hash, static_cast<size_t>(value.asLargestUInt()));
+      case Json::realValue: {
+         // -0.0 == 0.0
+         double d = value.asDouble() == 0.0 ? 0.0 : value.asDouble();
+         size_t bits = 0;
+         memcpy(&bits, &d, sizeof(d) < sizeof(bits) ? sizeof(d) : sizeof(bits));
+         return combine(hash, bits);
+      }
+      case Json::booleanValue:
+         return combine(hash, value.asBool() ? 1 : 0);
+      case Json::stringValue: {
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         return combine(hash, hashBytes(begin, end));
+      }
+      case Json::arrayValue:
+         for (Json::ArrayIndex i = 0; i < value.size(); i++) {
+            hash = combine(hash, JsonMemo::hash(value[i]));
+         }
+         return hash;
+      case Json::objectValue:
+         for (Json::ValueConstIterator itr = value.begin();
+               itr != value.end();
+               ++itr) {
+            const char *end = NULL;
+            const char *name = itr.memberName(&end);
+            hash = combine(hash, hashBytes(name, end));
+            hash = combine(hash, JsonMemo::hash(*itr));
+         }
+         return hash;
+      default:
+         return hash;
+   }
+}
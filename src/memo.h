@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __MEMO_H__
+#define __MEMO_H__
+
+#include <stddef.h>
+#include <unordered_map>
+
+class JsonPrimitive;
+
+/**
+ * @brief Bounded cache of subschema results keyed by the compiled schema node
+ * and the structure of the instance subtree. Lets items and properties skip
+ * subtrees identical to ones already validated against the same subschema.
+ *
+ * A memo is consulted while a JsonMemo::Scope is active on the thread. A memo
+ * scoped to one validate() call may refer to the document itself; one kept
+ * across calls has to copy the subtrees it remembers (copyValues), and then
+ * does not remember anything while a Json::Arena::Scope is active since the
+ * copies would live in the arena.
+ */
+class JsonMemo
+{
+   public:
+      /**
+       * @brief Makes a memo the one used by the calling thread for the
+       * lifetime of the scope
+       */
+      class Scope
+      {
+         public:
+            explicit Scope(JsonMemo &memo);
+            ~Scope();
+
+         private:
+            Scope(const Scope &);
+            Scope &operator=(const Scope &);
+
+            JsonMemo *m_previous;
+      };
+
+      /**
+       * @param capacity maximum number of results kept; the memo starts over
+       * when it is full
+       * @param copyValues true if the memo outlives the validated documents
+       */
+      JsonMemo(size_t capacity, bool copyValues);
+
+      ~JsonMemo() {}
+
+      /**
+       * @brief Looks up the result of a subschema for a subtree
+       *
+       * @return false if it is not known
+       */
+      bool find(const JsonPrimitive *primitive, const Json::Value &value,
+            size_t hash, int &result);
+
+      void insert(const JsonPrimitive *primitive, const Json::Value &value,
+            size_t hash, int result);
+
+      void clear();
+
+      size_t size() const {return m_entries.size();}
+
+      size_t hits() const {return m_hits;}
+
+      size_t misses() const {return m_misses;}
+
+      /**
+       * @brief Memo of the innermost Scope on the calling thread, or NULL
+       */
+      static JsonMemo *current();
+
+      /**
+       * @brief Structural hash, equal for values that compare equal
+       */
+      static size_t hash(const Json::Value &value);
+
+   private:
+      JsonMemo(const JsonMemo &);
+      JsonMemo &operator=(const JsonMemo &);
+
+      struct Entry
+      {
+         const JsonPrimitive  *primitive;
+         const Json::Value    *value;
+         Json::Value          copy;
+         int                  result;
+      };
+
+      typedef std::unordered_multimap<size_t, Entry> Entries;
+
+      Entries  m_entries;
+      size_t   m_capacity;
+      bool     m_copyValues;
+      size_t   m_hits;
+      size_t   m_misses;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <json.h>
+#include <memory_usage.h>
+
+// retained by libstdc++ for a pattern: a fixed part plus a few automaton
+// states per pattern character, as measured for typical schema patterns
+#define JVAL_REGEX_BASE_BYTES       384
+#define JVAL_REGEX_BYTES_PER_CHAR   96
+
+void JsonMemoryUsage::add(const char *kind, const std::string &path,
+      size_t bytes)
+{
+   m_total += bytes;
+   m_byKind[kind] += bytes;
+   m_byPath[path] += bytes;
+}
+
+void JsonMemoryUsage::clear()
+{
+   m_total = 0;
+   m_byKind.clear();
+   m_byPath.clear();
+   m_visited.clear();
+}
+
+size_t JsonMemoryUsage::valueBytes(const Json::Value &value)
+{
+   switch (value.type()) {
+      case Json::stringValue: {
+         // a length prefix, the bytes and a terminating NUL
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         return sizeof(unsigned) + static_cast<size_t>(end - begin) + 1;
+      }
+      case Json::arrayValue:
+      case Json::objectValue: {
+         size_t bytes = sizeof(Json::Value::ObjectValues);
+         size_t node = treeNodeBytes<Json::Value::ObjectValues::value_type>();
+         for (Json::Value::const_iterator itr = value.begin(); \
+               itr != value.end(); itr++) {
+            bytes += node + valueBytes(*itr);
+            if (value.isObject()) {
+               const char *end = NULL;
+               const char *name = itr.memberName(&end);
+               bytes += static_cast<size_t>(end - name) + 1;
+            }
+         }
+         return bytes;
+      }
+      default:
+         return 0;
+   }
+}
+
+size_t JsonMemoryUsage::stringBytes(const std::string &value)
+{
+   static const size_t inlineCapacity = std::string().capacity();
+   return value.capacity() > inlineCapacity ? value.capacity() + 1 : 0;
+}
+
+size_t JsonMemoryUsage::regexBytes(size_t length)
+{
+   return JVAL_REGEX_BASE_BYTES + JVAL_REGEX_BYTES_PER_CHAR * length;
+}
+
+std::string JsonMemoryUsage::pointerToken(const std::string &name)
+{
+   std::string token;
+   for (size_t i = 0; i < name.size(); i++) {
+      if (name[i] == '~') {
+         token += "~0";
+      } else if (name[i] == '/') {
+         token += "~1";
+      } else {
+         token += name[i];
+      }
+   }
+   return token;
+}
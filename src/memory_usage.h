@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __MEMORY_USAGE_H__
+#define __MEMORY_USAGE_H__
+
+#include <stddef.h>
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * @brief Bytes held by a compiled schema, broken down by kind of node and by
+ * schema location. Node kinds are the class names (JsonObject, Properties,
+ * Pattern, ...), the schema copies kept by some keywords are counted as
+ * "Json::Value" and the compiled patterns as "std::regex". Locations are JSON
+ * Pointers into the schema, "" being the root.
+ *
+ * The numbers are estimates: container nodes are counted with the usual
+ * node layouts and the allocator overhead is left out. A primitive shared by
+ * identical subschemas is counted once, at the first location visited.
+ */
+class JsonMemoryUsage
+{
+   public:
+      JsonMemoryUsage() : m_total(0) {}
+
+      ~JsonMemoryUsage() {}
+
+      void add(const char *kind, const std::string &path, size_t bytes);
+
+      void clear();
+
+      /**
+       * @brief Records that the bytes of a shared node are being added
+       *
+       * @return false if they were already
+       */
+      bool visit(const void *node) {return m_visited.insert(node).second;}
+
+      size_t total() const {return m_total;}
+
+      const std::map<std::string, size_t> &byKind() const {return m_byKind;}
+
+      const std::map<std::string, size_t> &byPath() const {return m_byPath;}
+
+      /**
+       * @brief Heap bytes of a Json::Value tree, the Value itself excluded
+       */
+      static size_t valueBytes(const Json::Value &value);
+
+      /**
+       * @brief Heap bytes of a string, none while it fits the inline buffer
+       */
+      static size_t stringBytes(const std::string &value);
+
+      /**
+       * @brief Heap bytes of a std::regex compiled from a pattern of length
+       * characters, the std::regex itself excluded
+       */
+      static size_t regexBytes(size_t length);
+
+      /**
+       * @brief Bytes of one node of a std::map or std::set of value_type
+       */
+      template <typename T> static size_t treeNodeBytes() {
+         return 4 * sizeof(void *) + sizeof(T);
+      }
+
+      /**
+       * @brief Member name as a JSON Pointer token, ~ and / escaped
+       */
+      static std::string pointerToken(const std::string &name);
+
+   private:
+      size_t                           m_total;
+      std::map<std::string, size_t>    m_byKind;
+      std::map<std::string, size_t>    m_byPath;
+      std::set<const void *>           m_visited;
+};
+
+#endif
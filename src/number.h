@@ -0,0 +1,290 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __NUMBER_H__
+#define __NUMBER_H__
+
+#define JSON_NUMBER_UNORDERED 2
+
+/**
+ * @brief A JSON number as the reader classified it: a signed or unsigned
+ * 64-bit integer when it is integral and fits, a double otherwise. Two
+ * numbers compare exactly, a double against a 64-bit integer included,
+ * instead of going through a lossy conversion.
+ */
+struct JsonNumberValue
+{
+   enum Kind {INTEGER, UNSIGNED, REAL};
+
+   Kind     kind;
+   int64_t  i;
+   uint64_t u;
+   double   d;
+
+   // value is a Json::Value or a JsonTapeValue holding a number; the
+   // storage type decides, a double stays a double
+   template <typename T>
+   static JsonNumberValue of(const T &value) {
+      JsonNumberValue number;
+      number.i = 0;
+      number.u = 0;
+      number.d = 0;
+      switch (value.type()) {
+         case Json::intValue:
+            number.kind = INTEGER;
+            number.i = value.asInt64();
+            break;
+         case Json::uintValue:
+            number.kind = UNSIGNED;
+            number.u = value.asUInt64();
+            break;
+         default:
+            number.kind = REAL;
+            number.d = value.asDouble();
+            break;
+      }
+      return number;
+   }
+
+   bool isIntegral() const {return kind != REAL;}
+
+   bool isPositive() const {
+      return (kind == INTEGER && i > 0) || (kind == UNSIGNED && u > 0) || \
+         (kind == REAL && d > 0);
+   }
+
+   double toDouble() const {
+      if (kind == REAL) {
+         return d;
+      }
+      return kind == INTEGER ? static_cast<double>(i) : static_cast<double>(u);
+   }
+
+   // magnitude of an integral number
+   uint64_t magnitude() const {
+      if (kind == UNSIGNED) {
+         return u;
+      }
+      return i < 0 ? 0 - static_cast<uint64_t>(i) : static_cast<uint64_t>(i);
+   }
+
+   /**
+    * @brief Three-way comparison
+    *
+    * @return -1, 0, 1, or JSON_NUMBER_UNORDERED if either one is NaN
+    */
+   static int compare(const JsonNumberValue &a, const JsonNumberValue &b) {
+      if (a.kind == REAL && b.kind == REAL) {
+         if (a.d < b.d) {
+            return -1;
+         }
+         return a.d > b.d ? 1 : (a.d == b.d ? 0 : JSON_NUMBER_UNORDERED);
+      }
+
+      if (a.kind == REAL) {
+         return b.kind == INTEGER ? compareReal(a.d, b.i) : \
+            compareReal(a.d, b.u);
+      }
+
+      if (b.kind == REAL) {
+         int c = a.kind == INTEGER ? compareReal(b.d, a.i) : \
+            compareReal(b.d, a.u);
+         return c == JSON_NUMBER_UNORDERED ? c : -c;
+      }
+
+      if (a.kind == INTEGER && b.kind == INTEGER) {
+         return a.i < b.i ? -1 : (a.i > b.i ? 1 : 0);
+      }
+
+      if (a.kind == INTEGER && a.i < 0) {
+         return -1;
+      }
+
+      if (b.kind == INTEGER && b.i < 0) {
+         return 1;
+      }
+
+      uint64_t x = a.kind == INTEGER ? static_cast<uint64_t>(a.i) : a.u;
+      uint64_t y = b.kind == INTEGER ? static_cast<uint64_t>(b.i) : b.u;
+      return x < y ? -1 : (x > y ? 1 : 0);
+   }
+
+   /**
+    * @brief multipleOf: exact for integers, within a few ulps for doubles.
+    * JsonMultipleOf is exact for decimal divisors as well and falls back to
+    * this one for the others.
+    *
+    * @param divisor positive
+    */
+   static bool isMultipleOf(const JsonNumberValue &number,
+         const JsonNumberValue &divisor) {
+      if (number.isIntegral() && divisor.isIntegral()) {
+         return number.magnitude() % divisor.magnitude() == 0;
+      }
+
+      double m = divisor.toDouble();
+      double remainder = fmod(number.toDouble(), m);
+      return almostEqual(remainder, 0.0) || almostEqual(remainder, m);
+   }
+
+   private:
+      static bool almostEqual(double a, double b) {
+         return (a == b) || std::abs(a - b) < std::abs(std::min(a, b)) * \
+            std::numeric_limits<double>::epsilon() * 2.0;
+      }
+
+      // d against an integer: the integral part of d is exact as an integer
+      // and decides unless it is equal, in which case the fraction does
+      static int compareReal(double d, int64_t n) {
+         if (d != d) {
+            return JSON_NUMBER_UNORDERED;
+         }
+         if (d < -9223372036854775808.0) {
+            return -1;
+         }
+         if (d >= 9223372036854775808.0) {
+            return 1;
+         }
+         int64_t t = static_cast<int64_t>(d);
+         if (t != n) {
+            return t < n ? -1 : 1;
+         }
+         double whole = static_cast<double>(t);
+         return d < whole ? -1 : (d > whole ? 1 : 0);
+      }
+
+      static int compareReal(double d, uint64_t n) {
+         if (d != d) {
+            return JSON_NUMBER_UNORDERED;
+         }
+         if (d < 0) {
+            return -1;
+         }
+         if (d >= 18446744073709551616.0) {
+            return 1;
+         }
+         uint64_t t = static_cast<uint64_t>(d);
+         if (t != n) {
+            return t < n ? -1 : 1;
+         }
+         double whole = static_cast<double>(t);
+         return d > whole ? 1 : 0;
+      }
+};
+
+/**
+ * @brief A multipleOf divisor, precomputed when the schema is loaded. When
+ * the divisor is a decimal of at most 18 fractional digits (0.01 is 1 / 10^2)
+ * an instance is tested with integer arithmetic on its own decimal digits:
+ * the double d is the decimal n / 10^scale exactly when n / 10^scale rounds
+ * back to d, which holds for n below 2^52, and then d is a multiple if and
+ * only if n % units == 0. An integral instance is a multiple when it is
+ * divisible by units / gcd(units, 10^scale).
+ */
+struct JsonMultipleOf
+{
+   JsonNumberValue divisor;
+   bool            decimal;   // divisor == units / 10^scale
+   uint64_t        units;
+   unsigned int    scale;
+   uint64_t        step;      // multiple of the divisor among the integers
+
+   // divisor positive
+   static JsonMultipleOf of(const JsonNumberValue &divisor) {
+      JsonMultipleOf multipleOf;
+      multipleOf.divisor = divisor;
+      multipleOf.decimal = false;
+      multipleOf.units = 0;
+      multipleOf.scale = 0;
+      multipleOf.step = 0;
+
+      if (divisor.isIntegral()) {
+         multipleOf.decimal = true;
+         multipleOf.units = divisor.magnitude();
+         multipleOf.step = multipleOf.units;
+         return multipleOf;
+      }
+
+      // shortest scale at which the divisor is a whole number of units
+      for (unsigned int scale = 0; scale <= 18; scale++) {
+         double x = divisor.d * powerOfTen(scale);
+         if (!(x < 4503599627370496.0)) {
+            break;
+         }
+
+         uint64_t n = static_cast<uint64_t>(x + 0.5);
+         if (n != 0 && static_cast<double>(n) / powerOfTen(scale) == divisor.d) {
+            uint64_t tens = static_cast<uint64_t>(powerOfTen(scale));
+            multipleOf.decimal = true;
+            multipleOf.units = n;
+            multipleOf.scale = scale;
+            multipleOf.step = n / gcd(n, tens);
+            break;
+         }
+      }
+      return multipleOf;
+   }
+
+   bool check(const JsonNumberValue &number) const {
+      if (!decimal) {
+         return JsonNumberValue::isMultipleOf(number, divisor);
+      }
+
+      if (number.isIntegral()) {
+         return number.magnitude() % step == 0;
+      }
+
+      double a = std::abs(number.d);
+      double x = a * powerOfTen(scale);
+      if (x < 4503599627370496.0) {
+         uint64_t n = static_cast<uint64_t>(x + 0.5);
+         return static_cast<double>(n) / powerOfTen(scale) == a && \
+            n % units == 0;
+      }
+
+      // beyond 2^52 units: a whole double is still exact through fmod
+      if (a == std::floor(a) && step < 9007199254740992ULL) {
+         return std::fmod(a, static_cast<double>(step)) == 0;
+      }
+
+      return JsonNumberValue::isMultipleOf(number, divisor);
+   }
+
+   private:
+      static double powerOfTen(unsigned int n) {
+         static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+            1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+            1e18};
+         return powers[n];
+      }
+
+      static uint64_t gcd(uint64_t a, uint64_t b) {
+         while (b != 0) {
+            uint64_t r = a % b;
+            a = b;
+            b = r;
+         }
+         return a;
+      }
+};
+
+#endif
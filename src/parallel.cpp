@@ -0,0 +1,164 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <json.h>
+#include <budget.h>
+#include <primitive_base.h>
+#include <worker_pool.h>
+#include <parallel.h>
+
+static JSONCPP_THREAD_LOCAL JsonParallel *currentParallel = NULL;
+
+/**
+ * @brief State of one split shared by the threads taking its chunks. Workers
+ * reaching a helper task after every chunk was taken only look at next, so
+ * the state outlives the run() which created it while the Work does not.
+ */
+class JsonParallelJoin
+{
+   public:
+      JsonParallelJoin(size_t chunks, JsonParallel::Work *work) :
+         m_next(0), m_failed(chunks), m_chunks(chunks), m_done(0),
+         m_results(chunks, JVAL_ROK), m_work(work) {}
+
+      // takes chunks until there are none left
+      void help() {
+         for (;;) {
+            size_t index = m_next.fetch_add(1);
+            if (index >= m_chunks) {
+               return;
+            }
+
+            int ret = JVAL_ROK;
+            if (index < m_failed.load(std::memory_order_relaxed)) {
+               ret = m_work->chunk(index, m_failed);
+            }
+
+            if (JVAL_ROK != ret) {
+               m_results[index] = ret;
+               size_t failed = m_failed.load();
+               while (index < failed &&
+                     !m_failed.compare_exchange_weak(failed, index)) {
+               }
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (++m_done == m_chunks) {
+               m_finished.notify_all();
+            }
+         }
+      }
+
+      // waits for the chunks taken by the other threads
+      int wait() {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         while (m_done < m_chunks) {
+            m_finished.wait(lock);
+         }
+
+         size_t failed = m_failed.load();
+         return failed < m_chunks ? m_results[failed] : JVAL_ROK;
+      }
+
+   private:
+      std::atomic<size_t>        m_next;
+      std::atomic<size_t>        m_failed;
+      size_t                     m_chunks;
+      size_t                     m_done;
+      std::vector<int>           m_results;
+      JsonParallel::Work         *m_work;
+      std::mutex                 m_mutex;
+      std::condition_variable    m_finished;
+};
+
+// Task of a worker helping with a split
+class JsonParallelHelper
+{
+   public:
+      JsonParallelHelper(const std::shared_ptr<JsonParallelJoin> &join) :
+         m_join(join) {}
+
+      void operator()() {m_join->help();}
+
+   private:
+      std::shared_ptr<JsonParallelJoin> m_join;
+};
+
+JsonParallel::Scope::Scope(JsonParallel &parallel)
+{
+   m_previous = currentParallel;
+   currentParallel = &parallel;
+}
+
+JsonParallel::Scope::~Scope()
+{
+   currentParallel = m_previous;
+}
+
+JsonParallel::JsonParallel(JsonWorkerPool *pool, size_t threshold)
+{
+   m_pool = pool;
+   m_threshold = std::max(threshold, static_cast<size_t>(2));
+}
+
+JsonParallel *JsonParallel::current()
+{
+   return currentParallel;
+}
+
+size_t JsonParallel::chunks(size_t size) const
+{
+   if (size < m_threshold || NULL != JsonBudget::current()) {
+      return 0;
+   }
+
+   size_t chunks = (size + JVAL_PARALLEL_MIN_CHUNK - 1) / \
+                   JVAL_PARALLEL_MIN_CHUNK;
+   chunks = std::min(chunks,
+         static_cast<size_t>(JVAL_PARALLEL_CHUNKS * (m_pool->threads() + 1)));
+   return chunks > 1 ? chunks : 0;
+}
+
+int JsonParallel::run(size_t chunks, Work &work)
+{
+   std::shared_ptr<JsonParallelJoin> join(new JsonParallelJoin(chunks, &work));
+
+   // the calling thread takes chunks too, so one worker fewer will do
+   size_t helpers = std::min(chunks - 1,
+         static_cast<size_t>(m_pool->threads()));
+   for (size_t i = 0; i < helpers; i++) {
+      if (!m_pool->trySubmit(JsonParallelHelper(join))) {
+         break;
+      }
+   }
+
+   join->help();
+   return join->wait();
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+class JsonWorkerPool;
+
+// fewest items or members given to a chunk
+#define JVAL_PARALLEL_MIN_CHUNK     256
+
+// chunks per thread, the calling one included, so that uneven chunks even out
+#define JVAL_PARALLEL_CHUNKS        4
+
+/**
+ * @brief Splits the items of large arrays and the members of large objects
+ * into chunks validated side by side by the workers of a JsonWorkerPool and
+ * by the calling thread. A container is split when it has at least threshold
+ * items or members; the result is the failure of the first failing chunk in
+ * document order, which is the one a validation on a single thread reports.
+ *
+ * A split is made while a JsonParallel::Scope is active on the thread and no
+ * JsonBudget is, since a budget is spent by one thread at a time. The chunks
+ * run on the workers without the memo of the calling thread and are never
+ * split again there.
+ *
+ * The calling thread takes chunks too, so that a validation started on a
+ * worker of the same pool completes even when every worker is busy.
+ */
+class JsonParallel
+{
+   public:
+      /**
+       * @brief Makes a JsonParallel the one splitting the validations of the
+       * calling thread for the lifetime of the scope
+       */
+      class Scope
+      {
+         public:
+            explicit Scope(JsonParallel &parallel);
+            ~Scope();
+
+         private:
+            Scope(const Scope &);
+            Scope &operator=(const Scope &);
+
+            JsonParallel *m_previous;
+      };
+
+      /**
+       * @brief Validation of the chunks of one split container
+       */
+      class Work
+      {
+         public:
+            virtual ~Work() {}
+
+            /**
+             * @brief Validates the chunk with the given index. May give up
+             * and return anything once failed, the index of the first chunk
+             * known to fail, is below index.
+             *
+             * @return JVAL_ROK or the code of the failure
+             */
+            virtual int chunk(size_t index,
+                  const std::atomic<size_t> &failed) = 0;
+      };
+
+      /**
+       * @param pool workers, outlives this object
+       * @param threshold fewest items or members of a container to split
+       */
+      JsonParallel(JsonWorkerPool *pool, size_t threshold);
+
+      ~JsonParallel() {}
+
+      /**
+       * @brief Number of chunks to split a container of size items or
+       * members into, 0 if it is validated on the calling thread
+       */
+      size_t chunks(size_t size) const;
+
+      /**
+       * @brief Runs the chunks of work and waits for them
+       *
+       * @return JVAL_ROK or the result of the first failing chunk
+       */
+      int run(size_t chunks, Work &work);
+
+      size_t threshold() const {return m_threshold;}
+
+      /**
+       * @brief Splits of the innermost Scope on the calling thread, or NULL
+       */
+      static JsonParallel *current();
+
+   private:
+      JsonParallel(const JsonParallel &);
+      JsonParallel &operator=(const JsonParallel &);
+
+      JsonWorkerPool *m_pool;
+      size_t         m_threshold;
+};
+
+#endif
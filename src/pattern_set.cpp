@@ -0,0 +1,883 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <string>
+#include <vector>
+#include <regex>
+#include <json.h>
+#include <memory_usage.h>
+#include <primitive_base.h>
+#include <regex_compile.h>
+#include <pattern_set.h>
+
+typedef std::bitset<256> ByteSet;
+
+/**
+ * @brief Node of the syntax tree of a pattern
+ */
+struct PatternNode
+{
+   enum Kind {BYTES, BEGIN, END, CONCAT, ALTERNATE, REPEAT};
+
+   Kind              kind;
+   size_t            bytes;      // BYTES: index of its ByteSet
+   unsigned int      min;        // REPEAT
+   unsigned int      max;        // REPEAT, UINT32_MAX if unbounded
+   std::vector<int>  children;
+};
+
+/**
+ * @brief Parses the part of the ECMAScript syntax the automaton handles. Any
+ * other construct makes parse() fail and the pattern goes to std::regex,
+ * which then decides what it means.
+ */
+class PatternParser
+{
+   public:
+      PatternParser(const std::string &pattern, std::vector<ByteSet> &sets,
+            std::vector<PatternNode> &nodes) :
+         m_p(pattern.data()), m_end(pattern.data() + pattern.size()),
+         m_sets(sets), m_nodes(nodes) {}
+
+      bool parse(int &root) {
+         return alternation(root) && m_p == m_end;
+      }
+
+   private:
+      int node(PatternNode::Kind kind) {
+         PatternNode n;
+         n.kind = kind;
+         n.bytes = 0;
+         n.min = 0;
+         n.max = 0;
+         m_nodes.push_back(n);
+         return static_cast<int>(m_nodes.size() - 1);
+      }
+
+      int bytes(const ByteSet &set) {
+         int n = node(PatternNode::BYTES);
+         m_nodes[n].bytes = m_sets.size();
+         m_sets.push_back(set);
+         return n;
+      }
+
+      bool alternation(int &result) {
+         int first = 0;
+         if (!concatenation(first)) {
+            return false;
+         }
+
+         if (m_p == m_end || *m_p != '|') {
+            result = first;
+            return true;
+         }
+
+         result = node(PatternNode::ALTERNATE);
+         m_nodes[result].children.push_back(first);
+         while (m_p < m_end && *m_p == '|') {
+            m_p++;
+            int next = 0;
+            if (!concatenation(next)) {
+               return false;
+            }
+            m_nodes[result].children.push_back(next);
+         }
+         return true;
+      }
+
+      bool concatenation(int &result) {
+         result = node(PatternNode::CONCAT);
+         while (m_p < m_end && *m_p != '|' && *m_p != ')') {
+            int next = 0;
+            if (!repetition(next)) {
+               return false;
+            }
+            m_nodes[result].children.push_back(next);
+         }
+         return true;
+      }
+
+      bool repetition(int &result) {
+         bool assertion = m_p < m_end && (*m_p == '^' || *m_p == '$');
+         if (!atom(result)) {
+            return false;
+         }
+
+         unsigned int min = 0;
+         unsigned int max = 0;
+         if (!quantifier(min, max)) {
+            return true;
+         }
+
+         if (assertion || min > max) {
+            return false;
+         }
+
+         // a lazy quantifier finds the same strings
+         if (m_p < m_end && *m_p == '?') {
+            m_p++;
+         }
+
+         if (m_p < m_end && isQuantifier(*m_p)) {
+            return false;
+         }
+
+         int repeat = node(PatternNode::REPEAT);
+         m_nodes[repeat].min = min;
+         m_nodes[repeat].max = max;
+         m_nodes[repeat].children.push_back(result);
+         result = repeat;
+         return true;
+      }
+
+      static bool isQuantifier(char c) {
+         return c == '*' || c == '+' || c == '?' || c == '{';
+      }
+
+      bool quantifier(unsigned int &min, unsigned int &max) {
+         if (m_p == m_end) {
+            return false;
+         }
+
+         switch (*m_p) {
+            case '*':
+               m_p++;
+               min = 0;
+               max = UINT32_MAX;
+               return true;
+            case '+':
+               m_p++;
+               min = 1;
+               max = UINT32_MAX;
+               return true;
+            case '?':
+               m_p++;
+               min = 0;
+               max = 1;
+               return true;
+            case '{':
+               break;
+            default:
+               return false;
+         }
+
+         // {n}, {n,} or {n,m}; an invalid one makes min greater than max
+         const char *start = m_p++;
+         if (!number(min)) {
+            m_p = start;
+            min = 1;
+            return true;
+         }
+
+         max = min;
+         if (m_p < m_end && *m_p == ',') {
+            m_p++;
+            max = UINT32_MAX;
+            if (m_p < m_end && *m_p != '}' && !number(max)) {
+               min = 1;
+               max = 0;
+               return true;
+            }
+         }
+
+         if (m_p == m_end || *m_p != '}') {
+            min = 1;
+            max = 0;
+            return true;
+         }
+         m_p++;
+         return true;
+      }
+
+      // up to 1000, so that counted repeats stay small
+      bool number(unsigned int &value) {
+         const char *start = m_p;
+         value = 0;
+         while (m_p < m_end && *m_p >= '0' && *m_p <= '9') {
+            value = value * 10 + static_cast<unsigned int>(*m_p - '0');
+            if (value > 1000) {
+               return false;
+            }
+            m_p++;
+         }
+         return m_p > start;
+      }
+
+      bool atom(int &result) {
+         char c = *m_p++;
+         ByteSet set;
+         switch (c) {
+            case '(':
+               if (m_p < m_end && *m_p == '?') {
+                  if (m_end - m_p < 2 || m_p[1] != ':') {
+                     return false;
+                  }
+                  m_p += 2;
+               }
+               if (!alternation(result) || m_p == m_end || *m_p != ')') {
+                  return false;
+               }
+               m_p++;
+               return true;
+            case '[':
+               if (!byteClass(set)) {
+                  return false;
+               }
+               result = bytes(set);
+               return true;
+            case '.':
+               set.set();
+               set.reset('\n');
+               set.reset('\r');
+               result = bytes(set);
+               return true;
+            case '^':
+               result = node(PatternNode::BEGIN);
+               return true;
+            case '$':
+               result = node(PatternNode::END);
+               return true;
+            case '\\':
+               if (!escape(set)) {
+                  return false;
+               }
+               result = bytes(set);
+               return true;
+            case '*': case '+': case '?': case '{': case '}': case ']':
+               return false;
+            default:
+               set.set(static_cast<unsigned char>(c));
+               result = bytes(set);
+               return true;
+         }
+      }
+
+      static int hex(char c) {
+         if (c >= '0' && c <= '9') {
+            return c - '0';
+         } else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+         } else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+         }
+         return -1;
+      }
+
+      // \xHH, or \uHHHH of an ASCII character
+      bool hexEscape(int digits, ByteSet &set) {
+         if (m_end - m_p < digits) {
+            return false;
+         }
+
+         int value = 0;
+         for (int i = 0; i < digits; i++) {
+            int h = hex(*m_p++);
+            if (h < 0) {
+               return false;
+            }
+            value = value * 16 + h;
+         }
+
+         if (value > (digits == 2 ? 0xff : 0x7f)) {
+            return false;
+         }
+         set.set(static_cast<size_t>(value));
+         return true;
+      }
+
+      // the bytes of the escape after a backslash
+      bool escape(ByteSet &set) {
+         if (m_p == m_end) {
+            return false;
+         }
+
+         char c = *m_p++;
+         ByteSet shorthand;
+         switch (c) {
+            case 'd': case 'D':
+               for (char d = '0'; d <= '9'; d++) {
+                  shorthand.set(static_cast<unsigned char>(d));
+               }
+               break;
+            case 'w': case 'W':
+               for (int b = 0; b < 256; b++) {
+                  if ((b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z') ||
+                        (b >= '0' && b <= '9') || b == '_') {
+                     shorthand.set(b);
+                  }
+               }
+               break;
+            case 's': case 'S':
+               shorthand.set(' ');
+               shorthand.set('\t');
+               shorthand.set('\n');
+               shorthand.set('\v');
+               shorthand.set('\f');
+               shorthand.set('\r');
+               break;
+            case 't': set.set('\t'); return true;
+            case 'n': set.set('\n'); return true;
+            case 'v': set.set('\v'); return true;
+            case 'f': set.set('\f'); return true;
+            case 'r': set.set('\r'); return true;
+            case '0':
+               if (m_p < m_end && *m_p >= '0' && *m_p <= '9') {
+                  return false;
+               }
+               set.set(0);
+               return true;
+            case 'x':
+               return hexEscape(2, set);
+            case 'u':
+               return hexEscape(4, set);
+            default:
+               // identity escapes of punctuation; letters and digits have
+               // meanings of their own (\b, \1, \c...)
+               if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                     (c >= '0' && c <= '9') ||
+                     static_cast<unsigned char>(c) >= 0x80) {
+                  return false;
+               }
+               set.set(static_cast<unsigned char>(c));
+               return true;
+         }
+
+         if (c == 'D' || c == 'W' || c == 'S') {
+            shorthand.flip();
+         }
+         set |= shorthand;
+         return true;
+      }
+
+      // one byte of a class, false for the shorthand classes
+      bool classByte(unsigned char &byte, ByteSet &set, bool &single) {
+         ByteSet one;
+         if (*m_p == '\\') {
+            m_p++;
+            if (!escape(one)) {
+               return false;
+            }
+         } else {
+            one.set(static_cast<unsigned char>(*m_p++));
+         }
+
+         single = one.count() == 1;
+         if (single) {
+            for (int b = 0; b < 256; b++) {
+               if (one.test(b)) {
+                  byte = static_cast<unsigned char>(b);
+               }
+            }
+         }
+         set |= one;
+         return true;
+      }
+
+      // after the opening bracket
+      bool byteClass(ByteSet &set) {
+         bool negated = m_p < m_end && *m_p == '^';
+         if (negated) {
+            m_p++;
+         }
+
+         // [] and [^] mean nothing and anything in ECMAScript only
+         if (m_p == m_end || *m_p == ']') {
+            return false;
+         }
+
+         while (m_p < m_end && *m_p != ']') {
+            unsigned char low = 0;
+            bool single = false;
+            ByteSet item;
+            if (!classByte(low, item, single)) {
+               return false;
+            }
+
+            if (m_end - m_p >= 2 && m_p[0] == '-' && m_p[1] != ']') {
+               m_p++;
+               unsigned char high = 0;
+               bool highSingle = false;
+               ByteSet end;
+               if (!single || !classByte(high, end, highSingle) ||
+                     !highSingle || low > high || high >= 0x80) {
+                  return false;
+               }
+               for (unsigned int b = low; b <= high; b++) {
+                  item.set(b);
+               }
+            }
+            set |= item;
+         }
+
+         if (m_p == m_end) {
+            return false;
+         }
+         m_p++;
+
+         if (negated) {
+            set.flip();
+         }
+         return true;
+      }
+
+      const char                 *m_p;
+      const char                 *m_end;
+      std::vector<ByteSet>       &m_sets;
+      std::vector<PatternNode>   &m_nodes;
+};
+
+/**
+ * @brief Nondeterministic automaton of the patterns: a state moves on the
+ * bytes of a set to next, or on nothing to the states in epsilon, or to next
+ * at the beginning (BEGIN) or at the end (END) of the string only
+ */
+class PatternNfa
+{
+   public:
+      enum Kind {PLAIN, BEGIN, END};
+
+      struct State
+      {
+         Kind              kind;
+         int               bytes;      // index of a ByteSet, -1 if none
+         int               next;
+         int               accept;     // pattern found, -1 if none
+         std::vector<int>  epsilon;
+      };
+
+      PatternNfa(const std::vector<PatternNode> &nodes) : m_nodes(nodes) {}
+
+      // adds the states of a pattern; false if there would be too many
+      bool add(int root, size_t pattern) {
+         size_t size = m_states.size();
+         int start = 0;
+         int end = 0;
+         if (!fragment(root, start, end)) {
+            m_states.resize(size);
+            return false;
+         }
+
+         m_states[end].accept = static_cast<int>(pattern);
+         m_starts.push_back(start);
+         return true;
+      }
+
+      const std::vector<State> &states() const {return m_states;}
+
+      const std::vector<int> &starts() const {return m_starts;}
+
+   private:
+      int state() {
+         State s;
+         s.kind = PLAIN;
+         s.bytes = -1;
+         s.next = -1;
+         s.accept = -1;
+         m_states.push_back(s);
+         return static_cast<int>(m_states.size() - 1);
+      }
+
+      void link(int from, int to) {m_states[from].epsilon.push_back(to);}
+
+      // states from start to end matching the node
+      bool fragment(int n, int &start, int &end) {
+         if (m_states.size() >= JVAL_PATTERN_MAX_NFA) {
+            return false;
+         }
+
+         const PatternNode &node = m_nodes[n];
+         start = state();
+         end = state();
+         switch (node.kind) {
+            case PatternNode::BYTES:
+               m_states[start].bytes = static_cast<int>(node.bytes);
+               m_states[start].next = end;
+               return true;
+            case PatternNode::BEGIN:
+            case PatternNode::END:
+               m_states[start].kind = node.kind == PatternNode::BEGIN ? \
+                                      BEGIN : END;
+               m_states[start].next = end;
+               return true;
+            case PatternNode::CONCAT: {
+               int last = start;
+               for (size_t i = 0; i < node.children.size(); i++) {
+                  int s = 0;
+                  int e = 0;
+                  if (!fragment(node.children[i], s, e)) {
+                     return false;
+                  }
+                  link(last, s);
+                  last = e;
+               }
+               link(last, end);
+               return true;
+            }
+            case PatternNode::ALTERNATE:
+               for (size_t i = 0; i < node.children.size(); i++) {
+                  int s = 0;
+                  int e = 0;
+                  if (!fragment(node.children[i], s, e)) {
+                     return false;
+                  }
+                  link(start, s);
+                  link(e, end);
+               }
+               return true;
+            case PatternNode::REPEAT: {
+               int last = start;
+               for (unsigned int i = 0; i < node.min; i++) {
+                  int s = 0;
+                  int e = 0;
+                  if (!fragment(node.children[0], s, e)) {
+                     return false;
+                  }
+                  link(last, s);
+                  last = e;
+               }
+
+               if (node.max == UINT32_MAX) {
+                  int s = 0;
+                  int e = 0;
+                  if (!fragment(node.children[0], s, e)) {
+                     return false;
+                  }
+                  link(last, s);
+                  link(e, s);
+                  link(e, end);
+                  link(last, end);
+                  return true;
+               }
+
+               // each optional repeat may end the node
+               for (unsigned int i = node.min; i < node.max; i++) {
+                  int s = 0;
+                  int e = 0;
+                  if (!fragment(node.children[0], s, e)) {
+                     return false;
+                  }
+                  link(last, end);
+                  link(last, s);
+                  last = e;
+               }
+               link(last, end);
+               return true;
+            }
+         }
+         return false;
+      }
+
+      const std::vector<PatternNode>   &m_nodes;
+      std::vector<State>               m_states;
+      std::vector<int>                 m_starts;
+};
+
+/**
+ * @brief Sets of NFA states reachable without reading a byte; only the
+ * states which read a byte, find a pattern or wait for the end are kept, the
+ * others being the same as the states they lead to
+ */
+class PatternClosure
+{
+   public:
+      PatternClosure(const PatternNfa &nfa) :
+         m_states(nfa.states()), m_marks(nfa.states().size(), 0),
+         m_generation(0) {}
+
+      void compute(const std::vector<int> &seeds, bool begin, bool end,
+            std::vector<int> &result) {
+         m_generation++;
+         result.clear();
+         m_stack.assign(seeds.begin(), seeds.end());
+         while (!m_stack.empty()) {
+            int s = m_stack.back();
+            m_stack.pop_back();
+            if (m_marks[s] == m_generation) {
+               continue;
+            }
+            m_marks[s] = m_generation;
+
+            const PatternNfa::State &state = m_states[s];
+            if (state.bytes >= 0 || state.accept >= 0 ||
+                  state.kind == PatternNfa::END) {
+               result.push_back(s);
+            }
+
+            if ((state.kind == PatternNfa::BEGIN && begin) ||
+                  (state.kind == PatternNfa::END && end)) {
+               m_stack.push_back(state.next);
+            }
+            m_stack.insert(m_stack.end(), state.epsilon.begin(),
+                  state.epsilon.end());
+         }
+         std::sort(result.begin(), result.end());
+      }
+
+   private:
+      const std::vector<PatternNfa::State>   &m_states;
+      std::vector<unsigned int>              m_marks;
+      unsigned int                           m_generation;
+      std::vector<int>                       m_stack;
+};
+
+void JsonPatternSet::add(const std::string &pattern)
+{
+   // rejects what std::regex rejects, as the pattern keyword does
+   std::regex check;
+   if (!compileRegex(pattern, check)) {
+      JVAL_SCHEMA_ERROR("patternProperties name is not a valid regular "
+            "expression: " + pattern);
+   }
+   m_patterns.push_back(pattern);
+}
+
+void JsonPatternSet::addRegex(size_t pattern)
+{
+   // a pattern add() refused without exceptions is left empty; it never
+   // matches and the schema is thrown away anyway
+   std::regex regex;
+   compileRegex(m_patterns[pattern], regex);
+   m_regexes.push_back(regex);
+   m_regexPatterns.push_back(pattern);
+}
+
+void JsonPatternSet::compile()
+{
+   std::vector<size_t> compiled;
+   for (size_t i = 0; i < m_patterns.size(); i++) {
+      std::vector<ByteSet> sets;
+      std::vector<PatternNode> nodes;
+      PatternParser parser(m_patterns[i], sets, nodes);
+      int root = 0;
+      if (parser.parse(root)) {
+         compiled.push_back(i);
+      } else {
+         addRegex(i);
+      }
+   }
+
+   if (!compiled.empty()) {
+      group(compiled);
+   }
+}
+
+void JsonPatternSet::group(const std::vector<size_t> &patterns)
+{
+   Automaton automaton;
+   if (build(patterns, automaton)) {
+      m_automata.push_back(automaton);
+   } else if (patterns.size() == 1) {
+      addRegex(patterns[0]);
+   } else {
+      size_t half = patterns.size() / 2;
+      group(std::vector<size_t>(patterns.begin(), patterns.begin() + half));
+      group(std::vector<size_t>(patterns.begin() + half, patterns.end()));
+   }
+}
+
+bool JsonPatternSet::build(const std::vector<size_t> &patterns,
+      Automaton &automaton)
+{
+   std::vector<ByteSet> sets;
+   std::vector<PatternNode> nodes;
+   std::vector<int> roots;
+   for (size_t i = 0; i < patterns.size(); i++) {
+      PatternParser parser(m_patterns[patterns[i]], sets, nodes);
+      int root = 0;
+      parser.parse(root);
+      roots.push_back(root);
+   }
+
+   PatternNfa nfa(nodes);
+   for (size_t i = 0; i < patterns.size(); i++) {
+      if (!nfa.add(roots[i], patterns[i])) {
+         return false;
+      }
+   }
+
+   // bytes no set tells apart share a class
+   std::vector<int> classes(256, 0);
+   size_t count = 1;
+   for (size_t i = 0; i < sets.size(); i++) {
+      std::map<std::pair<int, bool>, int> split;
+      for (int b = 0; b < 256; b++) {
+         std::pair<int, bool> key(classes[b], sets[i].test(b));
+         std::map<std::pair<int, bool>, int>::iterator itr = split.find(key);
+         if (itr == split.end()) {
+            itr = split.insert(std::make_pair(key,
+                     static_cast<int>(split.size()))).first;
+         }
+         classes[b] = itr->second;
+      }
+      count = split.size();
+   }
+
+   std::vector<int> representative(count, -1);
+   for (int b = 0; b < 256; b++) {
+      automaton.classes[b] = static_cast<unsigned char>(classes[b]);
+      if (representative[classes[b]] < 0) {
+         representative[classes[b]] = b;
+      }
+   }
+   automaton.classCount = count;
+
+   // subset construction; a search may start after every byte, so the
+   // states of the patterns which do not begin with ^ join every move
+   const std::vector<PatternNfa::State> &states = nfa.states();
+   PatternClosure closure(nfa);
+   std::vector<int> initial;
+   std::vector<int> restart;
+   closure.compute(nfa.starts(), true, false, initial);
+   closure.compute(nfa.starts(), false, false, restart);
+
+   // the first state is only entered at the beginning, which the END
+   // states of its closure still need when the string is empty
+   initial.insert(initial.begin(), -1);
+
+   std::map<std::vector<int>, uint32_t> ids;
+   std::vector<std::vector<int> > subsets;
+   ids[initial] = 0;
+   subsets.push_back(initial);
+
+   size_t words = this->words();
+   std::vector<int> seeds;
+   std::vector<int> target;
+   for (size_t i = 0; i < subsets.size(); i++) {
+      std::vector<int> current = subsets[i];
+      if (!current.empty() && current[0] < 0) {
+         current.erase(current.begin());
+      }
+
+      automaton.accept.resize(automaton.accept.size() + words, 0);
+      automaton.acceptEnd.resize(automaton.acceptEnd.size() + words, 0);
+      uint64_t *accept = &automaton.accept[i * words];
+      uint64_t *acceptEnd = &automaton.acceptEnd[i * words];
+      for (size_t j = 0; j < current.size(); j++) {
+         int pattern = states[current[j]].accept;
+         if (pattern >= 0) {
+            accept[pattern / 64] |= static_cast<uint64_t>(1) << (pattern % 64);
+         }
+      }
+
+      closure.compute(current, i == 0, true, target);
+      for (size_t j = 0; j < target.size(); j++) {
+         int pattern = states[target[j]].accept;
+         if (pattern >= 0) {
+            acceptEnd[pattern / 64] |= \
+               static_cast<uint64_t>(1) << (pattern % 64);
+         }
+      }
+
+      for (size_t c = 0; c < count; c++) {
+         seeds = restart;
+         for (size_t j = 0; j < current.size(); j++) {
+            const PatternNfa::State &state = states[current[j]];
+            if (state.bytes >= 0 && sets[state.bytes].test(representative[c])) {
+               seeds.push_back(state.next);
+            }
+         }
+         closure.compute(seeds, false, false, target);
+
+         std::map<std::vector<int>, uint32_t>::iterator itr = ids.find(target);
+         if (itr == ids.end()) {
+            if (subsets.size() >= JVAL_PATTERN_MAX_DFA) {
+               return false;
+            }
+            itr = ids.insert(std::make_pair(target,
+                     static_cast<uint32_t>(subsets.size()))).first;
+            subsets.push_back(target);
+         }
+         automaton.next.push_back(itr->second);
+      }
+   }
+
+   // nothing is found any more once no state is left
+   std::map<std::vector<int>, uint32_t>::iterator dead = \
+      ids.find(std::vector<int>());
+   automaton.dead = dead == ids.end() ? UINT32_MAX : dead->second;
+   return true;
+}
+
+void JsonPatternSet::match(const char *begin, const char *end,
+      uint64_t *matches) const
+{
+   size_t words = this->words();
+   for (size_t i = 0; i < words; i++) {
+      matches[i] = 0;
+   }
+
+   for (size_t a = 0; a < m_automata.size(); a++) {
+      const Automaton &automaton = m_automata[a];
+      uint32_t state = 0;
+      for (size_t i = 0; i < words; i++) {
+         matches[i] |= automaton.accept[i];
+      }
+
+      for (const char *p = begin; p < end && state != automaton.dead; p++) {
+         state = automaton.next[state * automaton.classCount + \
+            automaton.classes[static_cast<unsigned char>(*p)]];
+         const uint64_t *accept = &automaton.accept[state * words];
+         for (size_t i = 0; i < words; i++) {
+            matches[i] |= accept[i];
+         }
+      }
+
+      const uint64_t *acceptEnd = &automaton.acceptEnd[state * words];
+      for (size_t i = 0; i < words; i++) {
+         matches[i] |= acceptEnd[i];
+      }
+   }
+
+   for (size_t i = 0; i < m_regexes.size(); i++) {
+      if (std::regex_search(begin, end, m_regexes[i])) {
+         size_t pattern = m_regexPatterns[i];
+         matches[pattern / 64] |= static_cast<uint64_t>(1) << (pattern % 64);
+      }
+   }
+}
+
+void JsonPatternSet::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   size_t bytes = sizeof(*this) + \
+      m_patterns.capacity() * sizeof(std::string) + \
+      m_automata.capacity() * sizeof(Automaton) + \
+      m_regexPatterns.capacity() * sizeof(size_t);
+   for (size_t i = 0; i < m_patterns.size(); i++) {
+      bytes += JsonMemoryUsage::stringBytes(m_patterns[i]);
+   }
+   for (size_t i = 0; i < m_automata.size(); i++) {
+      bytes += m_automata[i].next.capacity() * sizeof(uint32_t) + \
+         (m_automata[i].accept.capacity() + \
+          m_automata[i].acceptEnd.capacity()) * sizeof(uint64_t);
+   }
+   usage.add("JsonPatternSet", path, bytes);
+
+   for (size_t i = 0; i < m_regexPatterns.size(); i++) {
+      usage.add("std::regex", path, JsonMemoryUsage::regexBytes(
+               m_patterns[m_regexPatterns[i]].size()));
+   }
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __PATTERN_SET_H__
+#define __PATTERN_SET_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <regex>
+
+class JsonMemoryUsage;
+
+// most automaton states built for the patterns of one schema
+#define JVAL_PATTERN_MAX_NFA     16384
+#define JVAL_PATTERN_MAX_DFA     1024
+
+/**
+ * @brief A set of ECMAScript patterns searched in a string all at once, the
+ * way std::regex_search() searches each of them. The patterns are compiled
+ * together into one deterministic automaton over classes of bytes, so a
+ * single scan of the string with one table lookup per byte tells which of
+ * the patterns are found, however many there are.
+ *
+ * Literals, classes, escapes such as \d, groups, alternations, quantifiers and
+ * the ^ and $ anchors are compiled. A pattern using anything else, such as a
+ * backreference, a lookahead or \b, is searched with its own std::regex.
+ * Patterns whose automaton would grow too large together are split among
+ * several automata, each scanning the string once.
+ *
+ * A compiled set is only read by match() and may be shared by threads.
+ */
+class JsonPatternSet
+{
+   public:
+      JsonPatternSet() {}
+
+      ~JsonPatternSet() {}
+
+      /**
+       * @brief Adds a pattern; the index of its bit in the match sets is the
+       * number of patterns added before. A pattern std::regex rejects is a
+       * schema error, see JVAL_SCHEMA_ERROR.
+       */
+      void add(const std::string &pattern);
+
+      /**
+       * @brief Builds the automaton, after the last add()
+       */
+      void compile();
+
+      size_t size() const {return m_patterns.size();}
+
+      /**
+       * @brief Number of 64-bit words of a match set
+       */
+      size_t words() const {return (m_patterns.size() + 63) / 64;}
+
+      /**
+       * @brief Sets the bit of every pattern found in [begin, end) and clears
+       * the others
+       *
+       * @param matches words() words
+       */
+      void match(const char *begin, const char *end, uint64_t *matches) const;
+
+      /**
+       * @brief Number of the patterns searched with std::regex
+       */
+      size_t fallbacks() const {return m_regexes.size();}
+
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+
+   private:
+      /**
+       * @brief Deterministic automaton of some of the patterns: states of
+       * classCount transitions, with the patterns found on entering a state
+       * and those found if the string ends there
+       */
+      struct Automaton
+      {
+         unsigned char           classes[256];
+         size_t                  classCount;
+         std::vector<uint32_t>   next;
+         std::vector<uint64_t>   accept;
+         std::vector<uint64_t>   acceptEnd;
+         uint32_t                dead;
+      };
+
+      // builds the automata of the patterns with an index in patterns,
+      // splitting them among several automata when one gets too large
+      void group(const std::vector<size_t> &patterns);
+
+      // false if the automaton gets too large
+      bool build(const std::vector<size_t> &patterns, Automaton &automaton);
+
+      void addRegex(size_t pattern);
+
+      std::vector<std::string>   m_patterns;
+      std::vector<Automaton>     m_automata;
+      std::vector<std::regex>    m_regexes;
+      std::vector<size_t>        m_regexPatterns;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string>
+#include <list>
+#include <vector>
+#include <regex>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdint.h>
+#include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <memory_usage.h>
+#include <regex_compile.h>
+#include <primitive_base.h>
+#include <keyword_validator.h>
+#include <policy_primitive.h>
+
+PatternPolicy::PatternPolicy(const std::string &pattern) :
+   m_patternLength(pattern.size())
+{
+   if (!compileRegex(pattern, m_pattern)) {
+      JVAL_SCHEMA_ERROR("pattern is not a valid regular expression: " + \
+            pattern);
+   }
+}
+
+static JsonPrimitive *createInteger(Json::Value *schema)
+{
+   NumberRange range(schema);
+   if (range.empty()) {
+      return new JsonPolicyPrimitive<IntValidPolicy>(schema);
+   }
+
+   return new JsonPolicyPrimitive<IntValidPolicy, NumberRange>(schema, range);
+}
+
+static JsonPrimitive *createNumber(Json::Value *schema)
+{
+   NumberRange range(schema);
+   if (range.empty()) {
+      return new JsonPolicyPrimitive<NumberValidPolicy>(schema);
+   }
+
+   return new JsonPolicyPrimitive<NumberValidPolicy, NumberRange>(schema,
+         range);
+}
+
+static JsonPrimitive *createString(Json::Value *schema)
+{
+   size_t minLength = 0;
+   size_t maxLength = 0;
+   std::string p;
+   bool min = countKeyword(schema, "minLength", minLength);
+   bool max = countKeyword(schema, "maxLength", maxLength);
+   bool pattern = stringKeyword(schema, "pattern", p);
+   JsonFormat::Checker checker = Format::lookup(schema);
+
+   if (NULL != checker) {
+      if (!min && !max && !pattern) {
+         return new JsonPolicyPrimitive<StringValidPolicy, FormatPolicy>(
+               schema, FormatPolicy(checker));
+      }
+      return NULL;
+   }
+
+   if (!min && !max && !pattern) {
+      return new JsonPolicyPrimitive<StringValidPolicy>(schema);
+   }
+
+   if (!min && max && !pattern) {
+      return new JsonPolicyPrimitive<StringValidPolicy, MaxLengthPolicy>(
+            schema, MaxLengthPolicy(maxLength));
+   }
+
+   if (min && max && pattern) {
+      return new JsonPolicyPrimitive<StringValidPolicy, MinLengthPolicy,
+             MaxLengthPolicy, PatternPolicy>(schema,
+                   MinLengthPolicy(minLength),
+                   MaxLengthPolicy(maxLength),
+                   PatternPolicy(p));
+   }
+
+   return NULL;
+}
+
+JsonPrimitive *createPolicyPrimitive(Json::Value *schema,
+      JsonPrimitiveType type)
+{
+   switch (type) {
+      case JSON_TYPE_INTEGER:
+         return createInteger(schema);
+      case JSON_TYPE_NUMBER:
+         return createNumber(schema);
+      case JSON_TYPE_STRING:
+         return createString(schema);
+      default:
+         return NULL;
+   }
+}
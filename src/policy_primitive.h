@@ -0,0 +1,221 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __POLICY_PRIMITIVE_H__
+#define __POLICY_PRIMITIVE_H__
+
+/**
+ * Keyword policies: the checks of the keyword validators as plain classes
+ * with an inline check(), for either a Json::Value or a JsonTapeValue. They
+ * give the same results as the KeywordValidator they are named after.
+ */
+
+struct NoPolicy
+{
+   template <typename T> int check(const T &) const {return JVAL_ROK;}
+};
+
+struct IntValidPolicy
+{
+   template <typename T> int check(const T &value) const {
+      return value.isInt() ? JVAL_ROK : JVAL_ERR_NOT_AN_INTEGER;
+   }
+};
+
+struct NumberValidPolicy
+{
+   template <typename T> int check(const T &value) const {
+      return value.isNumeric() ? JVAL_ROK : JVAL_ERR_NOT_A_NUMBER;
+   }
+};
+
+struct StringValidPolicy
+{
+   template <typename T> int check(const T &value) const {
+      return value.isString() ? JVAL_ROK : JVAL_ERR_NOT_A_STRING;
+   }
+};
+
+// MinLength
+class MinLengthPolicy
+{
+   public:
+      explicit MinLengthPolicy(unsigned int minLength) :
+         m_minLength(minLength) {}
+
+      template <typename T> int check(const T &value) const {
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         if (static_cast<size_t>(end - begin) < m_minLength) {
+            return JVAL_ERR_INVALID_MIN_LENGTH;
+         }
+         return JVAL_ROK;
+      }
+
+   private:
+      unsigned int m_minLength;
+};
+
+// MaxLength
+class MaxLengthPolicy
+{
+   public:
+      explicit MaxLengthPolicy(unsigned int maxLength) :
+         m_maxLength(maxLength) {}
+
+      template <typename T> int check(const T &value) const {
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         if (static_cast<size_t>(end - begin) > m_maxLength) {
+            return JVAL_ERR_INVALID_MAX_LENGTH;
+         }
+         return JVAL_ROK;
+      }
+
+   private:
+      unsigned int m_maxLength;
+};
+
+// Pattern
+class PatternPolicy
+{
+   public:
+      explicit PatternPolicy(const std::string &pattern);
+
+      template <typename T> int check(const T &value) const {
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         if (!std::regex_match(begin, end, m_pattern)) {
+            return JVAL_ERR_PATTERN_MISMATCH;
+         }
+         return JVAL_ROK;
+      }
+
+      size_t patternLength() const {return m_patternLength;}
+
+   private:
+      std::regex  m_pattern;
+      size_t      m_patternLength;
+};
+
+// Format
+class FormatPolicy
+{
+   public:
+      explicit FormatPolicy(JsonFormat::Checker checker) :
+         m_checker(checker) {}
+
+      template <typename T> int check(const T &value) const {
+         const char *begin = NULL;
+         const char *end = NULL;
+         value.getString(&begin, &end);
+         if (!m_checker(begin, end)) {
+            return JVAL_ERR_INVALID_FORMAT;
+         }
+         return JVAL_ROK;
+      }
+
+   private:
+      JsonFormat::Checker m_checker;
+};
+
+// memory a policy holds outside of its own bytes: only the compiled patterns
+template <typename P>
+inline void policyMemoryUsage(const P &, JsonMemoryUsage &,
+      const std::string &)
+{
+}
+
+inline void policyMemoryUsage(const PatternPolicy &policy,
+      JsonMemoryUsage &usage, const std::string &path)
+{
+   usage.add("std::regex", path,
+         JsonMemoryUsage::regexBytes(policy.patternLength()));
+}
+
+/**
+ * @brief Scalar primitive whose keywords are fixed at compile time: a type
+ * check followed by up to three keyword policies, run in order and inlined
+ * into a single validate() per representation
+ */
+template <typename Valid, typename P1 = NoPolicy, typename P2 = NoPolicy,
+         typename P3 = NoPolicy>
+class JsonPolicyPrimitive : public JsonPrimitive
+{
+   public:
+      JsonPolicyPrimitive(Json::Value *schema, const P1 &p1 = P1(),
+            const P2 &p2 = P2(), const P3 &p3 = P3()) :
+         JsonPrimitive(schema), m_p1(p1), m_p2(p2), m_p3(p3) {}
+
+      ~JsonPolicyPrimitive() {}
+
+      int validate(const Json::Value *value) {return check(*value);}
+
+      int validate(const JsonTapeValue &value) {return check(value);}
+
+      void memoryUsage(JsonMemoryUsage &usage,
+            const std::string &path) const {
+         usage.add("JsonPolicyPrimitive", path, sizeof(*this));
+         policyMemoryUsage(m_p1, usage, path);
+         policyMemoryUsage(m_p2, usage, path);
+         policyMemoryUsage(m_p3, usage, path);
+      }
+
+   private:
+      template <typename T> int check(const T &value) const {
+         int ret = m_valid.check(value);
+         if (JVAL_ROK == ret) {
+            ret = m_p1.check(value);
+         }
+         if (JVAL_ROK == ret) {
+            ret = m_p2.check(value);
+         }
+         if (JVAL_ROK == ret) {
+            ret = m_p3.check(value);
+         }
+         return ret;
+      }
+
+      Valid m_valid;
+      P1    m_p1;
+      P2    m_p2;
+      P3    m_p3;
+};
+
+/**
+ * @brief Builds a JsonPolicyPrimitive for the integer and number schemas,
+ * with their numeric keywords fused in a NumberRange, and for the string
+ * schemas of a common shape: type only, maxLength only, format only, or
+ * minLength, maxLength and pattern
+ *
+ * @param schema
+ * @param type
+ *
+ * @return NULL if the schema needs the generic primitive
+ */
+JsonPrimitive *createPolicyPrimitive(Json::Value *schema,
+      JsonPrimitiveType type);
+
+#endif
@@ -30,11 +30,113 @@
 #include <stdexcept>
 #include <algorithm>
 #include <regex>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
 #include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <json_pointer.h>
+#include <memory_usage.h>
 #include <primitive_base.h>
 #include <keyword_validator.h>
 #include <primitive.h>
 
+/**
+ * @brief Runs the keyword validators of a primitive in order and stops at the
+ * first failure
+ *
+ * @param validators
+ * @param value either a const Json::Value * or a JsonTapeValue
+ *
+ * @return 
+ */
+template <typename T>
+static int validateKeywords(std::list<KeywordValidator*> &validators,
+      const T &value)
+{
+   for (std::list<KeywordValidator*>::iterator b = validators.begin();
+         b != validators.end();
+         b++) {
+
+      int ret = (*b)->validate(value);
+      if (JVAL_ROK != ret) {
+         return ret;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+/**
+ * @brief Adds a primitive, its list of keyword validators and the validators
+ *
+ * @param kind class name of the primitive
+ * @param bytes size of the primitive
+ */
+static void validatorsMemoryUsage(const char *kind, size_t bytes,
+      const std::list<KeywordValidator*> &validators, JsonMemoryUsage &usage,
+      const std::string &path)
+{
+   // a list node holds two links and the pointer
+   usage.add(kind, path, bytes + validators.size() * \
+         (2 * sizeof(void *) + sizeof(KeywordValidator *)));
+
+   for (std::list<KeywordValidator*>::const_iterator b = validators.begin();
+         b != validators.end();
+         b++) {
+      (*b)->memoryUsage(usage, path);
+   }
+}
+
+/**
+ * @brief Same as validateKeywords() for an instance of which only the
+ * locations in paths changed since it was last found valid
+ *
+ * @param validators
+ * @param value
+ * @param paths
+ *
+ * @return 
+ */
+static int validateKeywordPaths(std::list<KeywordValidator*> &validators,
+      const Json::Value *value, const JsonPointerNode *paths)
+{
+   if (paths->isFull()) {
+      return validateKeywords(validators, value);
+   }
+
+   for (std::list<KeywordValidator*>::iterator b = validators.begin();
+         b != validators.end();
+         b++) {
+
+      int ret = (*b)->validatePaths(value, paths);
+      if (JVAL_ROK != ret) {
+         return ret;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+// Subschemas of all the keywords for a member or item, or the first refusal
+static int keywordSubschemas(const std::list<KeywordValidator*> &validators,
+      const std::string &token, std::vector<JsonPrimitive*> &schemas)
+{
+   for (std::list<KeywordValidator*>::const_iterator b = validators.begin();
+         b != validators.end();
+         b++) {
+
+      int ret = (*b)->subschemas(token, schemas);
+      if (JVAL_ROK != ret) {
+         return ret;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
 JsonBoolean::JsonBoolean(Json::Value *element) : JsonPrimitive(element)
 {
 }
@@ -45,6 +147,18 @@ int JsonBoolean::validate(const Json::Value *value)
    return JVAL_ROK;
 }
 
+int JsonBoolean::validate(const JsonTapeValue &value)
+{
+   (void)value;
+   return JVAL_ROK;
+}
+
+void JsonBoolean::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("JsonBoolean", path, sizeof(*this));
+}
+
 JsonNull::JsonNull(Json::Value *element) : JsonPrimitive(element)
 {
 }
@@ -55,43 +169,29 @@ int JsonNull::validate(const Json::Value *value)
    return JVAL_ROK;
 }
 
+int JsonNull::validate(const JsonTapeValue &value)
+{
+   (void)value;
+   return JVAL_ROK;
+}
+
+void JsonNull::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   usage.add("JsonNull", path, sizeof(*this));
+}
+
 JsonInteger::JsonInteger(Json::Value *schema) : JsonPrimitive(schema)
 {
    // validator for integer type
    m_validators.push_back(new IntValid);
 
-   // validator for minimum check
-   if (schema->isMember("minimum")) {
-      Json::Value min = schema->get("minimum", min);
-
-      bool exclusiveMin = false;
-      if (schema->isMember("exclusiveMinimum")) {
-         Json::Value eMin = schema->get("exclusiveMinimum", eMin);
-         exclusiveMin = eMin.asBool();
-      }
-
-      IntMinimum *minimum = new IntMinimum(min.asInt(), exclusiveMin);
-      m_validators.push_back(minimum);
-   }
-
-   // validator for maximum check
-   if (schema->isMember("maximum")) {
-      Json::Value max = schema->get("maximum", max);
-
-      bool exclusiveMax = false;
-      if (schema->isMember("exclusiveMaximum")) {
-         Json::Value eMax = schema->get("exclusiveMaximum", eMax);
-         exclusiveMax = eMax.asBool();
-      }
-
-      NumberMaximum *maximum = new NumberMaximum(max.asInt(), exclusiveMax);
-      m_validators.push_back(maximum);
-   }
-
-   // validator for multipleOf
-   if (schema->isMember("multipleOf")) {
-      Json::Value multipleOf = schema->get("multipleOf", multipleOf);
-      m_validators.push_back(new IntMultipleOf(multipleOf.asInt()));
+   // minimum, maximum and multipleOf
+   NumberRange *range = new NumberRange(schema);
+   if (range->empty()) {
+      delete range;
+   } else {
+      m_validators.push_back(range);
    }
 }
 
@@ -107,56 +207,31 @@ JsonInteger::~JsonInteger()
 
 int JsonInteger::validate(const Json::Value *value)
 {
-   for (std::list<KeywordValidator*>::iterator b = m_validators.begin();
-         b != m_validators.end();
-         b++) {
+   return validateKeywords(m_validators, value);
+}
 
-      int ret = (*b)->validate(value);
-      if (JVAL_ROK != ret) {
-         return ret;
-      }
-   }
+int JsonInteger::validate(const JsonTapeValue &value)
+{
+   return validateKeywords(m_validators, value);
+}
 
-   return JVAL_ROK;
+void JsonInteger::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   validatorsMemoryUsage("JsonInteger", sizeof(*this), m_validators, usage, path);
 }
 
 JsonNumber::JsonNumber(Json::Value *schema) : JsonPrimitive(schema)
 {
-   // validator for integer type
+   // validator for number type
    m_validators.push_back(new NumberValid);
 
-   // validator for minimum check
-   if (schema->isMember("minimum")) {
-      Json::Value min = schema->get("minimum", min);
-
-      bool exclusiveMin = false;
-      if (schema->isMember("exclusiveMinimum")) {
-         Json::Value eMin = schema->get("exclusiveMinimum", eMin);
-         exclusiveMin = eMin.asBool();
-      }
-
-      NumberMinimum *minimum = new NumberMinimum(min.asInt(), exclusiveMin);
-      m_validators.push_back(minimum);
-   }
-
-   // validator for maximum check
-   if (schema->isMember("maximum")) {
-      Json::Value max = schema->get("maximum", max);
-
-      bool exclusiveMax = false;
-      if (schema->isMember("exclusiveMaximum")) {
-         Json::Value eMax = schema->get("exclusiveMaximum", eMax);
-         exclusiveMax = eMax.asBool();
-      }
-
-      IntMaximum *maximum = new IntMaximum(max.asInt(), exclusiveMax);
-      m_validators.push_back(maximum);
-   }
-
-   // validator for multipleOf
-   if (schema->isMember("multipleOf")) {
-      Json::Value multipleOf = schema->get("multipleOf", multipleOf);
-      m_validators.push_back(new NumberMultipleOf(multipleOf.asDouble()));
+   // minimum, maximum and multipleOf
+   NumberRange *range = new NumberRange(schema);
+   if (range->empty()) {
+      delete range;
+   } else {
+      m_validators.push_back(range);
    }
 }
 
@@ -172,17 +247,18 @@ JsonNumber::~JsonNumber()
 
 int JsonNumber::validate(const Json::Value *value)
 {
-   for (std::list<KeywordValidator*>::iterator b = m_validators.begin();
-         b != m_validators.end();
-         b++) {
+   return validateKeywords(m_validators, value);
+}
 
-      int ret = (*b)->validate(value);
-      if (JVAL_ROK != ret) {
-         return ret;
-      }
-   }
+int JsonNumber::validate(const JsonTapeValue &value)
+{
+   return validateKeywords(m_validators, value);
+}
 
-   return JVAL_ROK;
+void JsonNumber::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   validatorsMemoryUsage("JsonNumber", sizeof(*this), m_validators, usage, path);
 }
 
 JsonString::JsonString(Json::Value *schema) : JsonPrimitive(schema)
@@ -190,22 +266,26 @@ JsonString::JsonString(Json::Value *schema) : JsonPrimitive(schema)
    m_validators.push_back(new StringValid);
 
    // checking length constraints
-   if (schema->isMember("minLength")) {
-      Json::Value min = schema->get("minLength", min);
-      size_t length = min.asUInt();
+   size_t length = 0;
+   if (countKeyword(schema, "minLength", length)) {
       m_validators.push_back(new MinLength(length));
    }
 
-   if (schema->isMember("maxLength")) {
-      Json::Value max = schema->get("maxLength", max);
-      size_t length = max.asUInt();
+   if (countKeyword(schema, "maxLength", length)) {
       m_validators.push_back(new MaxLength(length));
    }
 
    // string pattern
-   if (schema->isMember("pattern")) {
-      Json::Value pattern = schema->get("pattern", pattern);
-      m_validators.push_back(new Pattern(pattern.asString()));
+   std::string pattern;
+   if (stringKeyword(schema, "pattern", pattern)) {
+      m_validators.push_back(new Pattern(pattern));
+   }
+
+   // string format, unknown ones are ignored
+   JsonFormat::Checker checker = Format::lookup(schema);
+   if (NULL != checker) {
+      Json::Value format = schema->get("format", format);
+      m_validators.push_back(new Format(format.asString(), checker));
    }
 }
 
@@ -221,17 +301,18 @@ JsonString::~JsonString()
 
 int JsonString::validate(const Json::Value *value)
 {
-   for (std::list<KeywordValidator*>::iterator b = m_validators.begin();
-         b != m_validators.end();
-         b++) {
+   return validateKeywords(m_validators, value);
+}
 
-      int ret = (*b)->validate(value);
-      if (JVAL_ROK != ret) {
-         return ret;
-      }
-   }
+int JsonString::validate(const JsonTapeValue &value)
+{
+   return validateKeywords(m_validators, value);
+}
 
-   return JVAL_ROK;
+void JsonString::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   validatorsMemoryUsage("JsonString", sizeof(*this), m_validators, usage, path);
 }
 
 JsonArray::JsonArray(Json::Value *schema) : JsonPrimitive(schema)
@@ -239,21 +320,20 @@ JsonArray::JsonArray(Json::Value *schema) : JsonPrimitive(schema)
    m_validators.push_back(new ArrayValid);
 
    // checking minimum number of items constraint
-   if (schema->isMember("minItems")) {
-      Json::Value min = schema->get("minItems", min);
-      m_validators.push_back(new MinItems(min.asUInt()));
+   size_t count = 0;
+   if (countKeyword(schema, "minItems", count)) {
+      m_validators.push_back(new MinItems(count));
    }
 
    // checking maximum number of items constraint
-   if (schema->isMember("maxItems")) {
-      Json::Value max = schema->get("maxItems", max);
-      m_validators.push_back(new MaxItems(max.asUInt()));
+   if (countKeyword(schema, "maxItems", count)) {
+      m_validators.push_back(new MaxItems(count));
    }
 
    // checking maximum number of items constraint
-   if (schema->isMember("uniqueItems")) {
-      Json::Value unique = schema->get("uniqueItems", unique);
-      m_validators.push_back(new UniqueItems(unique.asBool()));
+   bool unique = false;
+   if (boolKeyword(schema, "uniqueItems", unique)) {
+      m_validators.push_back(new UniqueItems(unique));
    }
 
    // items
@@ -298,17 +378,36 @@ JsonArray::~JsonArray()
 
 int JsonArray::validate(const Json::Value *value)
 {
-   for (std::list<KeywordValidator*>::iterator b = m_validators.begin();
-         b != m_validators.end();
-         b++) {
+   return validateKeywords(m_validators, value);
+}
 
-      int ret = (*b)->validate(value);
-      if (JVAL_ROK != ret) {
-         return ret;
-      }
-   }
+int JsonArray::validate(const JsonTapeValue &value)
+{
+   return validateKeywords(m_validators, value);
+}
 
-   return JVAL_ROK;
+void JsonArray::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   validatorsMemoryUsage("JsonArray", sizeof(*this), m_validators, usage, path);
+}
+
+int JsonArray::validatePaths(const Json::Value *value,
+      const JsonPointerNode *paths)
+{
+   return validateKeywordPaths(m_validators, value, paths);
+}
+
+int JsonArray::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
+{
+   return keywordSubschemas(m_validators, token, schemas);
+}
+
+// the first keyword checks the type
+int JsonArray::validateType(const Json::Value *value)
+{
+   return m_validators.front()->validate(value);
 }
 
 JsonObject::JsonObject(Json::Value *schema) : JsonPrimitive(schema)
@@ -316,15 +415,14 @@ JsonObject::JsonObject(Json::Value *schema) : JsonPrimitive(schema)
    m_validators.push_back(new ObjectValid);
 
    // checking minimum number of properties constraint
-   if (schema->isMember("minProperties")) {
-      Json::Value min = schema->get("minProperties", min);
-      m_validators.push_back(new MinProperties(min.asUInt()));
+   size_t count = 0;
+   if (countKeyword(schema, "minProperties", count)) {
+      m_validators.push_back(new MinProperties(count));
    }
 
    // checking maximum number of properties constraint
-   if (schema->isMember("maxProperties")) {
-      Json::Value max = schema->get("maxProperties", max);
-      m_validators.push_back(new MaxProperties(max.asUInt()));
+   if (countKeyword(schema, "maxProperties", count)) {
+      m_validators.push_back(new MaxProperties(count));
    }
 
    // required properties
@@ -333,17 +431,26 @@ JsonObject::JsonObject(Json::Value *schema) : JsonPrimitive(schema)
       m_validators.push_back(new Required(req));
    }
 
-   // properties
-   if (schema->isMember("properties")) {
-      Json::Value properties = schema->get("properties", properties);
-
-      bool additionalProperties = false;
-      if (schema->isMember("additionalProperties")) {
-         Json::Value v = schema->get("additionalProperties", v);
-         additionalProperties = v.asBool(); 
-      }
+   // properties, patternProperties and additionalProperties, checked in one
+   // pass; a missing additionalProperties allows the undeclared members
+   Json::Value additional = schema->get("additionalProperties",
+         Json::nullValue);
+   if (schema->isMember("properties") || \
+         schema->isMember("patternProperties") || \
+         !(additional.isNull() || \
+            (additional.isBool() && additional.asBool()))) {
+      Json::Value properties = schema->get("properties", Json::nullValue);
+      Json::Value patterns = schema->get("patternProperties",
+            Json::nullValue);
+
+      m_validators.push_back(new Properties(properties, patterns,
+               additional));
+   }
 
-      m_validators.push_back(new Properties(properties, additionalProperties));
+   // property and schema dependencies
+   if (schema->isMember("dependencies")) {
+      Json::Value dependencies = schema->get("dependencies", dependencies);
+      m_validators.push_back(new Dependencies(dependencies));
    }
 }
 
@@ -359,17 +466,36 @@ JsonObject::~JsonObject()
 
 int JsonObject::validate(const Json::Value *value)
 {
-   for (std::list<KeywordValidator*>::iterator b = m_validators.begin();
-         b != m_validators.end();
-         b++) {
+   return validateKeywords(m_validators, value);
+}
 
-      int ret = (*b)->validate(value);
-      if (JVAL_ROK != ret) {
-         return ret;
-      }
-   }
+int JsonObject::validate(const JsonTapeValue &value)
+{
+   return validateKeywords(m_validators, value);
+}
 
-   return JVAL_ROK;
+void JsonObject::memoryUsage(JsonMemoryUsage &usage,
+      const std::string &path) const
+{
+   validatorsMemoryUsage("JsonObject", sizeof(*this), m_validators, usage, path);
+}
+
+int JsonObject::validatePaths(const Json::Value *value,
+      const JsonPointerNode *paths)
+{
+   return validateKeywordPaths(m_validators, value, paths);
+}
+
+int JsonObject::subschemas(const std::string &token,
+      std::vector<JsonPrimitive*> &schemas) const
+{
+   return keywordSubschemas(m_validators, token, schemas);
+}
+
+// the first keyword checks the type
+int JsonObject::validateType(const Json::Value *value)
+{
+   return m_validators.front()->validate(value);
 }
 
 
@@ -29,6 +29,8 @@ class JsonInteger : public JsonPrimitive
       JsonInteger(Json::Value *schema);
       ~JsonInteger();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
       std::list<KeywordValidator*> m_validators; 
@@ -40,6 +42,8 @@ class JsonNumber : public JsonPrimitive
       JsonNumber(Json::Value *schema);
       ~JsonNumber();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
       std::list<KeywordValidator*> m_validators; 
@@ -51,6 +55,8 @@ class JsonString : public JsonPrimitive
       JsonString(Json::Value *schema);
       ~JsonString();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
       std::list<KeywordValidator*> m_validators; 
@@ -62,6 +68,13 @@ class JsonObject : public JsonPrimitive
       JsonObject(Json::Value *element);
       ~JsonObject();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths);
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
+      int validateType(const Json::Value *value);
    
    private:
       std::list<KeywordValidator*> m_validators; 
@@ -74,6 +87,8 @@ class JsonEnum : public JsonPrimitive
       JsonEnum(Json::Value *element);
       ~JsonEnum() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 
    private:
       void getOptions(std::vector<std::string> &options);
@@ -85,6 +100,8 @@ class JsonBoolean : public JsonPrimitive
       JsonBoolean(Json::Value *element);
       ~JsonBoolean() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 };
 
 class JsonNull : public JsonPrimitive
@@ -93,6 +110,8 @@ class JsonNull : public JsonPrimitive
       JsonNull(Json::Value *element);
       ~JsonNull() {}
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
 };
 
 class JsonArray : public JsonPrimitive
@@ -101,6 +120,13 @@ class JsonArray : public JsonPrimitive
       JsonArray(Json::Value *schema);
       ~JsonArray();
       int validate(const Json::Value *value);
+      int validate(const JsonTapeValue &value);
+      void memoryUsage(JsonMemoryUsage &usage, const std::string &path) const;
+      int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths);
+      int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const;
+      int validateType(const Json::Value *value);
 
    private:
       std::list<KeywordValidator*> m_validators; 
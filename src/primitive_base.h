@@ -37,6 +37,7 @@
 #define JVAL_ERR_INVALID_MIN_PROPERTIES     11
 #define JVAL_ERR_REQUIRED_ITEM_MISSING      12
 #define JVAL_ERR_INVALID_ARRAY_ITEM         13
+#define JVAL_ERR_BUDGET_EXCEEDED            14
 #define JVAL_ERR_UNKNOWN_PROPERTY           15
 #define JVAL_ERR_INVALID_SCHEMA             16
 #define JVAL_ERR_NOT_AN_INTEGER             17
@@ -46,6 +47,10 @@
 #define JVAL_ERR_NOT_AN_OBJECT              21
 #define JVAL_ERR_INVALID_PROPERTY           22
 #define JVAL_ERR_ADDITIONAL_ITEMS           23
+#define JVAL_ERR_INVALID_JSON               24
+#define JVAL_ERR_INVALID_FORMAT             25
+#define JVAL_ERR_DEPENDENCY_MISSING         26
+#define JVAL_ERR_INVALID_DEPENDENCY         27
 
 typedef enum
 {
@@ -78,10 +83,27 @@ class Exception
       std::string m_msg;
 };
 
+/**
+ * Schema errors throw Exception. Built with JVAL_NO_EXCEPTIONS (and
+ * -fno-exceptions) they are recorded by the JsonSchemaCache of the thread
+ * instead, the compilation carries on with a placeholder and its result is
+ * thrown away; JsonValidator::getError() tells what went wrong.
+ */
+#ifdef JVAL_NO_EXCEPTIONS
+#define JVAL_SCHEMA_ERROR(message) JsonPrimitive::schemaError(message)
+#else
+#define JVAL_SCHEMA_ERROR(message) throw Exception(message)
+#endif
+
+class JsonTapeValue;
+class JsonPointerNode;
+class JsonMemoryUsage;
+
 class JsonPrimitive
 {
    private:
       JsonPrimitiveType   m_type;
+      size_t              m_references;
 
    protected:
       JsonPrimitiveType type() {return m_type;}
@@ -89,15 +111,80 @@ class JsonPrimitive
    public:
       JsonPrimitive(Json::Value *element) {
          m_type = getPrimitveType(element);
+         m_references = 1;
       }
 
       virtual ~JsonPrimitive() {}
 
+      /**
+       * @brief Takes one more reference to a primitive shared by identical
+       * subschemas
+       */
+      void retain() {m_references++;}
+
+      /**
+       * @brief Drops a reference, deleting the primitive with the last one
+       */
+      static void release(JsonPrimitive *primitive) {
+         if (NULL != primitive && 0 == --primitive->m_references) {
+            delete primitive;
+         }
+      }
+
       virtual int validate(const Json::Value *value) = 0;
 
+      virtual int validate(const JsonTapeValue &value) = 0;
+
+      /**
+       * @brief Re-validates a previously valid instance of which only the
+       * locations in paths changed. Scalars have nothing to narrow down.
+       */
+      virtual int validatePaths(const Json::Value *value,
+            const JsonPointerNode *paths) {
+         (void)paths;
+         return validate(value);
+      }
+
+      /**
+       * @brief Adds the subschemas which validate the member or item token
+       * of an instance, for JsonProjection. Scalars have none.
+       *
+       * @return JVAL_ROK, or the error of an instance holding such a member
+       * or item whatever its value
+       */
+      virtual int subschemas(const std::string &token,
+            std::vector<JsonPrimitive*> &schemas) const {
+         (void)token;
+         (void)schemas;
+         return JVAL_ROK;
+      }
+
+      /**
+       * @brief Checks the type of an instance alone, without its members or
+       * items. All there is to check for scalars.
+       */
+      virtual int validateType(const Json::Value *value) {
+         return validate(value);
+      }
+
+      /**
+       * @brief Adds the bytes held by this node and its subschemas
+       *
+       * @param path JSON Pointer of the subschema
+       */
+      virtual void memoryUsage(JsonMemoryUsage &usage,
+            const std::string &path) const = 0;
+
       static JsonPrimitiveType getPrimitveType(Json::Value *value);
 
-      // factory method for creating type specific element validator
+      /**
+       * @brief Records an error of the schema being compiled on the thread
+       */
+      static void schemaError(const std::string &message);
+
+      // factory method for creating type specific element validator; the
+      // subschemas of elment identical to one another share a primitive.
+      // NULL on schema errors without exceptions.
       static JsonPrimitive *createPrimitive(Json::Value *elment);
 };
 
@@ -0,0 +1,255 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string>
+#include <list>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <json.h>
+#include <json_pointer.h>
+#include <budget.h>
+#include <primitive_base.h>
+#include <projection.h>
+
+struct JsonProjection::Node
+{
+   // the location is validated in full, not only along the children
+   bool                                      full;
+
+   // error of any parent holding this location, whatever its value
+   int                                       refused;
+
+   // every subschema the location has to satisfy
+   std::vector<JsonPrimitive*>               schemas;
+
+   // reference tokens and nodes of the locations below
+   std::vector<std::pair<std::string, int> > children;
+};
+
+JsonProjection::JsonProjection(JsonPrimitive *schema,
+      const std::vector<std::string> &pointers)
+{
+   m_valid = true;
+
+   JsonPointerNode paths;
+   for (size_t i = 0; i < pointers.size(); i++) {
+      if (!paths.add(pointers[i])) {
+         m_valid = false;
+         return;
+      }
+   }
+
+   std::vector<JsonPrimitive*> schemas(1, schema);
+   build(schemas, &paths);
+}
+
+JsonProjection::~JsonProjection()
+{
+   for (size_t i = 0; i < m_nodes.size(); i++) {
+      delete m_nodes[i];
+   }
+}
+
+/**
+ * @brief Adds the node of a location and, unless it is validated in full,
+ * those of the locations below it which have a subschema or are refused.
+ * The others have nothing to validate.
+ */
+int JsonProjection::build(const std::vector<JsonPrimitive*> &schemas,
+      const JsonPointerNode *paths)
+{
+   int index = static_cast<int>(m_nodes.size());
+   Node *node = new Node;
+   node->full = paths->isFull();
+   node->refused = JVAL_ROK;
+   node->schemas = schemas;
+   m_nodes.push_back(node);
+
+   if (node->full) {
+      return index;
+   }
+
+   for (JsonPointerNode::Children::const_iterator itr = \
+         paths->children().begin();
+         itr != paths->children().end();
+         itr++) {
+
+      std::vector<JsonPrimitive*> below;
+      int refused = JVAL_ROK;
+      for (size_t i = 0; i < schemas.size() && JVAL_ROK == refused; i++) {
+         refused = schemas[i]->subschemas(itr->first, below);
+      }
+
+      int child = 0;
+      if (JVAL_ROK != refused) {
+         child = static_cast<int>(m_nodes.size());
+         Node *leaf = new Node;
+         leaf->full = false;
+         leaf->refused = refused;
+         m_nodes.push_back(leaf);
+      } else if (below.empty()) {
+         continue;
+      } else {
+         child = build(below, itr->second);
+      }
+
+      node->children.push_back(std::make_pair(itr->first, child));
+   }
+
+   return index;
+}
+
+int JsonProjection::validate(const Json::Value *value) const
+{
+   if (!m_valid || m_nodes.empty()) {
+      return JVAL_ROK;
+   }
+
+   return validateNode(0, value);
+}
+
+int JsonProjection::validateNode(int node, const Json::Value *value) const
+{
+   const Node *n = m_nodes[node];
+
+   if (n->full) {
+      for (size_t i = 0; i < n->schemas.size(); i++) {
+         int ret = n->schemas[i]->validate(value);
+         if (JVAL_ROK != ret) {
+            return ret;
+         }
+      }
+
+      return JVAL_ROK;
+   }
+
+   for (size_t i = 0; i < n->schemas.size(); i++) {
+      int ret = n->schemas[i]->validateType(value);
+      if (JVAL_ROK != ret) {
+         return ret;
+      }
+   }
+
+   bool object = value->isObject();
+   if (!object && !value->isArray()) {
+      return JVAL_ROK;
+   }
+
+   JsonBudget *budget = JsonBudget::current();
+   for (size_t i = 0; i < n->children.size(); i++) {
+      if (!JsonBudget::spend(budget)) {
+         return JVAL_ERR_BUDGET_EXCEEDED;
+      }
+
+      const std::string &token = n->children[i].first;
+      const Json::Value *child = NULL;
+      unsigned int index = 0;
+      if (object) {
+         child = value->find(token.data(), token.data() + token.size());
+      } else if (token != "-" && \
+            JsonPointerNode::toIndex(token, value->size(), index) && \
+            index < value->size()) {
+         child = &(*value)[index];
+      }
+
+      if (NULL == child) {
+         // locations the instance does not have are left to the keywords
+         // of their parent
+         continue;
+      }
+
+      const Node *c = m_nodes[n->children[i].second];
+      if (JVAL_ROK != c->refused) {
+         return c->refused;
+      }
+
+      int ret = validateNode(n->children[i].second, child);
+      if (JVAL_ERR_BUDGET_EXCEEDED == ret) {
+         return ret;
+      }
+
+      if (JVAL_ROK != ret) {
+         return object ? JVAL_ERR_INVALID_PROPERTY : \
+            JVAL_ERR_INVALID_ARRAY_ITEM;
+      }
+   }
+
+   return JVAL_ROK;
+}
+
+JsonProjectionCache::JsonProjectionCache(size_t capacity)
+{
+   m_capacity = capacity;
+}
+
+std::shared_ptr<const JsonProjection> JsonProjectionCache::find(
+      JsonPrimitive *schema, const std::vector<std::string> &pointers)
+{
+   // lengths keep pointers apart whatever they contain
+   std::string key;
+   for (size_t i = 0; i < pointers.size(); i++) {
+      key += std::to_string(pointers[i].size());
+      key += ':';
+      key += pointers[i];
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      Entries::iterator itr = m_entries.find(key);
+      if (itr != m_entries.end()) {
+         return itr->second;
+      }
+   }
+
+   // built outside the lock, a thread which raced us may have added one
+   std::shared_ptr<const JsonProjection> projection(
+         new JsonProjection(schema, pointers));
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (0 == m_capacity) {
+      return projection;
+   }
+
+   if (m_entries.size() >= m_capacity) {
+      m_entries.clear();
+   }
+
+   std::pair<Entries::iterator, bool> inserted = \
+      m_entries.insert(std::make_pair(key, projection));
+   return inserted.first->second;
+}
+
+void JsonProjectionCache::clear()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_entries.clear();
+}
+
+size_t JsonProjectionCache::size() const
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_entries.size();
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __PROJECTION_H__
+#define __PROJECTION_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+class JsonPrimitive;
+class JsonPointerNode;
+
+/**
+ * @brief Compiled schema pruned to a set of instance locations given as JSON
+ * Pointers (RFC 6901). Only the subschemas along the pointers run: the
+ * ancestors of a location check their type and refuse it if their keywords
+ * do (additionalProperties, additionalItems), the location itself is
+ * validated in full, and every other member and item is left alone.
+ *
+ * A location the instance does not have is skipped. The projection refers to
+ * the primitives of the schema without holding them, so it must not outlive
+ * the JsonValidator which compiled them.
+ */
+class JsonProjection
+{
+   public:
+      JsonProjection(JsonPrimitive *schema,
+            const std::vector<std::string> &pointers);
+
+      ~JsonProjection();
+
+      /**
+       * @brief false if one of the pointers is malformed
+       */
+      bool isValid() const {return m_valid;}
+
+      /**
+       * @return JVAL_ROK, or the JVAL_ERR_* code of the first failure along
+       * the pointers
+       */
+      int validate(const Json::Value *value) const;
+
+      /**
+       * @brief Nodes of the pruned schema, for the tests
+       */
+      size_t size() const {return m_nodes.size();}
+
+   private:
+      JsonProjection(const JsonProjection &);
+      JsonProjection &operator=(const JsonProjection &);
+
+      struct Node;
+
+      int build(const std::vector<JsonPrimitive*> &schemas,
+            const JsonPointerNode *paths);
+
+      int validateNode(int node, const Json::Value *value) const;
+
+      std::vector<Node*>   m_nodes;
+      bool                 m_valid;
+};
+
+/**
+ * @brief Projections of one compiled schema keyed by their pointers, shared
+ * by the threads validating with it. Starts over when it is full.
+ */
+class JsonProjectionCache
+{
+   public:
+      explicit JsonProjectionCache(size_t capacity);
+
+      ~JsonProjectionCache() {}
+
+      /**
+       * @brief Projection of schema to pointers, built on the first request
+       */
+      std::shared_ptr<const JsonProjection> find(JsonPrimitive *schema,
+            const std::vector<std::string> &pointers);
+
+      void clear();
+
+      size_t size() const;
+
+   private:
+      JsonProjectionCache(const JsonProjectionCache &);
+      JsonProjectionCache &operator=(const JsonProjectionCache &);
+
+      typedef std::map<std::string,
+              std::shared_ptr<const JsonProjection> > Entries;
+
+      Entries              m_entries;
+      size_t               m_capacity;
+      mutable std::mutex   m_mutex;
+};
+
+#endif
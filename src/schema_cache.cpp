@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#include <string>
+#include <unordered_map>
+#include <json.h>
+#include <primitive_base.h>
+#include <schema_cache.h>
+
+static JSONCPP_THREAD_LOCAL JsonSchemaCache *currentCache = NULL;
+
+// keywords which only annotate a schema
+static const char *annotations[] = {
+   "title",
+   "description",
+   "default",
+   "examples",
+   "$comment"
+};
+
+JsonSchemaCache::Scope::Scope(JsonSchemaCache &cache)
+{
+   m_previous = currentCache;
+   currentCache = &cache;
+}
+
+JsonSchemaCache::Scope::~Scope()
+{
+   currentCache = m_previous;
+}
+
+JsonSchemaCache::JsonSchemaCache()
+{
+   m_hits = 0;
+   m_failed = false;
+}
+
+JsonSchemaCache::~JsonSchemaCache()
+{
+   for (Entries::iterator itr = m_entries.begin();
+         itr != m_entries.end();
+         itr++) {
+      JsonPrimitive::release(itr->second.primitive);
+   }
+}
+
+JsonSchemaCache *JsonSchemaCache::current()
+{
+   return currentCache;
+}
+
+JsonPrimitive *JsonSchemaCache::find(const Json::Value &canonical,
+      size_t hash)
+{
+   std::pair<Entries::iterator, Entries::iterator> range = \
+      m_entries.equal_range(hash);
+
+   for (Entries::iterator itr = range.first; itr != range.second; itr++) {
+      if (itr->second.schema == canonical) {
+         m_hits++;
+         itr->second.primitive->retain();
+         return itr->second.primitive;
+      }
+   }
+
+   return NULL;
+}
+
+void JsonSchemaCache::insert(const Json::Value &canonical, size_t hash,
+      JsonPrimitive *primitive)
+{
+   if (NULL == primitive) {
+      return;
+   }
+
+   Entries::iterator itr = m_entries.insert(std::make_pair(hash, Entry()));
+   itr->second.schema = canonical;
+   itr->second.primitive = primitive;
+   primitive->retain();
+}
+
+void JsonSchemaCache::fail(const std::string &message)
+{
+   if (!m_failed) {
+      m_failed = true;
+      m_error = message;
+   }
+}
+
+void JsonPrimitive::schemaError(const std::string &message)
+{
+   JsonSchemaCache *cache = JsonSchemaCache::current();
+   if (NULL != cache) {
+      cache->fail(message);
+   }
+}
+
+Json::Value JsonSchemaCache::canonical(const Json::Value &schema)
+{
+   if (!schema.isObject()) {
+      return schema;
+   }
+
+   Json::Value result = schema;
+   for (size_t i = 0; i < sizeof(annotations) / sizeof(annotations[0]); i++) {
+      result.removeMember(annotations[i]);
+   }
+
+   // the subschemas this validator compiles
+   const char *members[] = {"properties", "patternProperties",
+      "dependencies"};
+   for (size_t i = 0; i < sizeof(members) / sizeof(members[0]); i++) {
+      if (result.isMember(members[i]) && result[members[i]].isObject()) {
+         Json::Value &properties = result[members[i]];
+         for (Json::ValueIterator itr = properties.begin();
+               itr != properties.end();
+               itr++) {
+            *itr = canonical(*itr);
+         }
+      }
+   }
+
+   if (result.isMember("additionalProperties")) {
+      Json::Value &additional = result["additionalProperties"];
+      additional = canonical(additional);
+   }
+
+   if (result.isMember("items")) {
+      Json::Value &items = result["items"];
+      if (items.isArray()) {
+         for (Json::ArrayIndex i = 0; i < items.size(); i++) {
+            items[i] = canonical(items[i]);
+         }
+      } else {
+         items = canonical(items);
+      }
+   }
+
+   return result;
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __SCHEMA_CACHE_H__
+#define __SCHEMA_CACHE_H__
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+
+class JsonPrimitive;
+
+/**
+ * @brief Compiled subschemas of one schema keyed by their structure, so that
+ * identical subschemas share a single JsonPrimitive. Subschemas are compared
+ * in canonical form: annotations (title, description, ...) do not take part,
+ * and member order never did since Json::Value keeps objects sorted.
+ *
+ * JsonPrimitive::createPrimitive consults the cache of the innermost Scope on
+ * the calling thread, and opens one for the schema it compiles when there is
+ * none. The cache holds a reference to each primitive until it goes away.
+ * Without exceptions it also keeps the first error of the schema.
+ */
+class JsonSchemaCache
+{
+   public:
+      /**
+       * @brief Makes a cache the one used by the calling thread for the
+       * lifetime of the scope
+       */
+      class Scope
+      {
+         public:
+            explicit Scope(JsonSchemaCache &cache);
+            ~Scope();
+
+         private:
+            Scope(const Scope &);
+            Scope &operator=(const Scope &);
+
+            JsonSchemaCache *m_previous;
+      };
+
+      JsonSchemaCache();
+
+      ~JsonSchemaCache();
+
+      /**
+       * @brief Looks up the primitive compiled for a canonical subschema
+       *
+       * @return a new reference to it, or NULL
+       */
+      JsonPrimitive *find(const Json::Value &canonical, size_t hash);
+
+      void insert(const Json::Value &canonical, size_t hash,
+            JsonPrimitive *primitive);
+
+      size_t size() const {return m_entries.size();}
+
+      size_t hits() const {return m_hits;}
+
+      /**
+       * @brief Records an error of the schema, the first one is kept
+       */
+      void fail(const std::string &message);
+
+      bool failed() const {return m_failed;}
+
+      const std::string &error() const {return m_error;}
+
+      /**
+       * @brief Cache of the innermost Scope on the calling thread, or NULL
+       */
+      static JsonSchemaCache *current();
+
+      /**
+       * @brief Copy of schema without the keywords that do not affect
+       * validation, in it and in the subschemas it contains
+       */
+      static Json::Value canonical(const Json::Value &schema);
+
+   private:
+      JsonSchemaCache(const JsonSchemaCache &);
+      JsonSchemaCache &operator=(const JsonSchemaCache &);
+
+      struct Entry
+      {
+         Json::Value    schema;
+         JsonPrimitive  *primitive;
+      };
+
+      typedef std::unordered_multimap<size_t, Entry> Entries;
+
+      Entries     m_entries;
+      size_t      m_hits;
+      bool        m_failed;
+      std::string m_error;
+};
+
+#endif
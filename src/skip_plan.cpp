@@ -0,0 +1,203 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string>
+#include <list>
+#include <vector>
+#include <regex>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <string.h>
+#include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <json_pointer.h>
+#include <pattern_set.h>
+#include <primitive_base.h>
+#include <keyword_validator.h>
+#include <skip_plan.h>
+
+struct JsonSkipPlan::Node
+{
+   // declared member names and their nodes
+   NameIndex         names;
+   std::vector<int>  members;
+
+   // tuple items
+   std::vector<int>  items;
+
+   // any other member or item
+   int               rest;
+};
+
+const int JsonSkipPlan::FULL;
+const int JsonSkipPlan::SKIPPED;
+
+JsonSkipPlan::JsonSkipPlan(const Json::Value &schema)
+{
+   m_root = build(schema);
+}
+
+JsonSkipPlan::~JsonSkipPlan()
+{
+   for (size_t i = 0; i < m_nodes.size(); i++) {
+      delete m_nodes[i];
+   }
+}
+
+int JsonSkipPlan::member(int node, const char *name, const char *end) const
+{
+   if (node < 0) {
+      return node;
+   }
+
+   const Node *n = m_nodes[node];
+   int position = n->names.find(name, end);
+   return position < 0 ? n->rest : n->members[position];
+}
+
+int JsonSkipPlan::item(int node, size_t index) const
+{
+   if (node < 0) {
+      return node;
+   }
+
+   const Node *n = m_nodes[node];
+   return index < n->items.size() ? n->items[index] : n->rest;
+}
+
+int JsonSkipPlan::build(const Json::Value &schema)
+{
+   if (!schema.isObject()) {
+      return FULL;
+   }
+
+   Json::Value type = schema.get("type", Json::nullValue);
+   if (!type.isString()) {
+      return FULL;
+   }
+
+   if (type.asString() == "object") {
+      return objectNode(schema);
+   } else if (type.asString() == "array") {
+      return arrayNode(schema);
+   }
+
+   // scalars cost little more to parse than to skip
+   return FULL;
+}
+
+/**
+ * @brief Member values are only looked at by properties, additionalProperties
+ * subschemas and schema dependencies. Required, minProperties,
+ * maxProperties and property dependencies need the names alone.
+ */
+int JsonSkipPlan::objectNode(const Json::Value &schema)
+{
+   Json::Value dependencies = schema.get("dependencies", Json::nullValue);
+   if (dependencies.isObject()) {
+      for (Json::ValueConstIterator itr = dependencies.begin();
+            itr != dependencies.end();
+            itr++) {
+         // validates the whole object
+         if (itr->isObject()) {
+            return FULL;
+         }
+      }
+   }
+
+   Json::Value patterns = schema.get("patternProperties", Json::nullValue);
+   if (!patterns.isNull()) {
+      return FULL;
+   }
+
+   Json::Value properties = schema.get("properties", Json::nullValue);
+   if (!(properties.isNull() || properties.isObject())) {
+      return FULL;
+   }
+
+   // an undeclared member is either refused, allowed as it is or validated
+   // against the additionalProperties subschema
+   Json::Value additional = schema.get("additionalProperties",
+         Json::nullValue);
+
+   Node *node = new Node;
+   node->rest = additional.isObject() ? build(additional) : SKIPPED;
+
+   bool full = (FULL == node->rest);
+   for (Json::ValueConstIterator itr = properties.begin();
+         itr != properties.end();
+         itr++) {
+      int child = build(*itr);
+      node->names.add(itr.name());
+      node->members.push_back(child);
+      full = full && FULL == child;
+   }
+
+   if (full) {
+      delete node;
+      return FULL;
+   }
+
+   return add(node);
+}
+
+/**
+ * @brief Items are only looked at by items subschemas and uniqueItems;
+ * additionalItems is checked as a count of items
+ */
+int JsonSkipPlan::arrayNode(const Json::Value &schema)
+{
+   Json::Value unique = schema.get("uniqueItems", Json::nullValue);
+   if (unique.isBool() && unique.asBool()) {
+      return FULL;
+   }
+
+   Json::Value items = schema.get("items", Json::nullValue);
+
+   Node *node = new Node;
+   node->rest = items.isObject() ? build(items) : SKIPPED;
+
+   bool full = (FULL == node->rest);
+   if (items.isArray()) {
+      for (Json::ArrayIndex i = 0; i < items.size(); i++) {
+         int child = build(items[i]);
+         node->items.push_back(child);
+         full = full && FULL == child;
+      }
+   }
+
+   if (full) {
+      delete node;
+      return FULL;
+   }
+
+   return add(node);
+}
+
+int JsonSkipPlan::add(Node *node)
+{
+   m_nodes.push_back(node);
+   return static_cast<int>(m_nodes.size() - 1);
+}
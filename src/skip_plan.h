@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __SKIP_PLAN_H__
+#define __SKIP_PLAN_H__
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @brief Instance locations a schema can look into, derived from the rules
+ * the object and array keywords are compiled with. JsonTape::parse() keeps
+ * the values no keyword inspects as raw text instead of parsing them, only
+ * checking their syntax.
+ *
+ * Every object or array schema with such values is a node, numbered from 0;
+ * FULL and SKIPPED stand for whole subtrees. Anything the plan cannot prove
+ * unused, such as the members of an object with patternProperties or the
+ * items of one with uniqueItems, is parsed in full.
+ */
+class JsonSkipPlan
+{
+   public:
+      // the subtree is parsed completely
+      static const int FULL = -1;
+
+      // no keyword looks into the subtree
+      static const int SKIPPED = -2;
+
+      explicit JsonSkipPlan(const Json::Value &schema);
+
+      ~JsonSkipPlan();
+
+      /**
+       * @brief Node of the document, FULL if the schema inspects everything
+       */
+      int root() const {return m_root;}
+
+      /**
+       * @brief Node of the member [name, end) of the object at node
+       */
+      int member(int node, const char *name, const char *end) const;
+
+      /**
+       * @brief Node of the item at index of the array at node
+       */
+      int item(int node, size_t index) const;
+
+   private:
+      JsonSkipPlan(const JsonSkipPlan &);
+      JsonSkipPlan &operator=(const JsonSkipPlan &);
+
+      struct Node;
+
+      int build(const Json::Value &schema);
+
+      int objectNode(const Json::Value &schema);
+
+      int arrayNode(const Json::Value &schema);
+
+      int add(Node *node);
+
+      std::vector<Node*>   m_nodes;
+      int                  m_root;
+};
+
+#endif
@@ -0,0 +1,385 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <string>
+#include <istream>
+#include <vector>
+#include <unordered_set>
+#include <regex>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <budget.h>
+#include <primitive_base.h>
+#include <keyword_validator.h>
+#include <schema_cache.h>
+#include <stream_validator.h>
+
+static inline bool isSpace(char c)
+{
+   return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
+
+JsonStreamValidator::JsonStreamValidator(Json::Value *schema)
+{
+   // the same keywords as JsonArray, compiled one subschema at a time
+   JsonSchemaCache cache;
+   JsonSchemaCache::Scope scope(cache);
+
+   if (JSON_TYPE_ARRAY != JsonPrimitive::getPrimitveType(schema)) {
+      JVAL_SCHEMA_ERROR("Streaming needs a schema of type \"array\"");
+   }
+
+   m_items = NULL;
+   m_hasMinItems = false;
+   m_minItems = 0;
+   m_hasMaxItems = false;
+   m_maxItems = 0;
+   m_uniqueItems = false;
+   m_additionalItems = true;
+
+   m_hasMinItems = countKeyword(schema, "minItems", m_minItems);
+   m_hasMaxItems = countKeyword(schema, "maxItems", m_maxItems);
+   boolKeyword(schema, "uniqueItems", m_uniqueItems);
+
+   if (schema->isMember("items")) {
+      Json::Value items = schema->get("items", items);
+      if (items.isArray()) {
+         if (schema->isMember("additionalItems")) {
+            Json::Value ai = schema->get("additionalItems", ai);
+            m_additionalItems = !(ai.type() == Json::booleanValue && \
+                  ai.asBool() == false);
+         }
+
+         for (Json::ArrayIndex i = 0; i < items.size(); i++) {
+            m_tuple.push_back(JsonPrimitive::createPrimitive(&items[i]));
+         }
+      } else if (items.isObject()) {
+         m_items = JsonPrimitive::createPrimitive(&items);
+      }
+   }
+
+   m_schemaError = cache.error();
+   reset();
+}
+
+JsonStreamValidator::~JsonStreamValidator()
+{
+   for (size_t i = 0; i < m_tuple.size(); i++) {
+      JsonPrimitive::release(m_tuple[i]);
+   }
+
+   JsonPrimitive::release(m_items);
+}
+
+void JsonStreamValidator::reset()
+{
+   m_state = STREAM_START;
+   m_stopped = JVAL_ROK;
+   m_item.clear();
+   m_depth = 0;
+   m_inString = false;
+   m_escape = false;
+   m_hashes.clear();
+   m_count = 0;
+   m_failedItem = 0;
+   m_duplicate = false;
+   m_error.clear();
+
+   if (!m_schemaError.empty()) {
+      m_state = STREAM_STOPPED;
+      m_stopped = JVAL_ERR_INVALID_SCHEMA;
+      m_error = m_schemaError;
+   }
+}
+
+bool JsonStreamValidator::done() const
+{
+   return STREAM_STOPPED == m_state;
+}
+
+size_t JsonStreamValidator::bufferBytes() const
+{
+   return m_item.capacity() + m_tape.memoryUsage();
+}
+
+void JsonStreamValidator::feed(const char *data, size_t length)
+{
+   // start of the item in data, if any
+   size_t item = 0;
+   size_t i = 0;
+
+   while (i < length && STREAM_STOPPED != m_state) {
+      char c = data[i];
+      // false to look at c again in the new state
+      bool consumed = true;
+
+      switch (m_state) {
+         case STREAM_START:
+            if ('[' == c) {
+               m_state = STREAM_FIRST;
+            } else if (!isSpace(c)) {
+               // not an array, whatever follows
+               m_state = STREAM_STOPPED;
+               m_stopped = JVAL_ERR_NOT_AN_ARRAY;
+            }
+            break;
+
+         case STREAM_FIRST:
+         case STREAM_NEXT:
+            if (isSpace(c)) {
+               break;
+            }
+
+            if (']' == c && STREAM_FIRST == m_state) {
+               m_state = STREAM_END;
+               break;
+            }
+
+            if (']' == c || ',' == c) {
+               syntaxError("Missing array item");
+               break;
+            }
+
+            m_state = STREAM_ITEM;
+            item = i;
+            consumed = false;
+            break;
+
+         case STREAM_ITEM: {
+            // the item ends past c, or before c
+            bool after = false;
+            bool before = false;
+
+            if (m_inString) {
+               if (m_escape) {
+                  m_escape = false;
+               } else if ('\\' == c) {
+                  m_escape = true;
+               } else if ('"' == c) {
+                  m_inString = false;
+                  after = (0 == m_depth);
+               }
+            } else if ('"' == c) {
+               m_inString = true;
+            } else if ('[' == c || '{' == c) {
+               m_depth++;
+            } else if (']' == c || '}' == c) {
+               if (0 == m_depth) {
+                  before = true;
+               } else {
+                  m_depth--;
+                  after = (0 == m_depth);
+               }
+            } else if (0 == m_depth && (',' == c || isSpace(c))) {
+               before = true;
+            }
+
+            if (after || before) {
+               m_item.append(data + item, data + (after ? i + 1 : i));
+               m_state = STREAM_SEPARATOR;
+               consumed = after;
+               addItem();
+            }
+            break;
+         }
+
+         case STREAM_SEPARATOR:
+            if (',' == c) {
+               m_state = STREAM_NEXT;
+            } else if (']' == c) {
+               m_state = STREAM_END;
+            } else if (!isSpace(c)) {
+               syntaxError("Missing comma between array items");
+            }
+            break;
+
+         case STREAM_END:
+            if (!isSpace(c)) {
+               syntaxError("Data after the end of the array");
+            }
+            break;
+
+         default:
+            break;
+      }
+
+      if (consumed) {
+         i++;
+      }
+   }
+
+   if (STREAM_ITEM == m_state) {
+      m_item.append(data + item, data + length);
+   }
+}
+
+void JsonStreamValidator::syntaxError(const std::string &message)
+{
+   m_state = STREAM_STOPPED;
+   m_stopped = JVAL_ERR_INVALID_JSON;
+   m_error = message;
+}
+
+void JsonStreamValidator::addItem()
+{
+   if (!m_tape.parse(m_item)) {
+      syntaxError("Invalid array item: " + m_tape.getError());
+      return;
+   }
+   m_item.clear();
+
+   JsonBudget *budget = JsonBudget::current();
+   if (!JsonBudget::spend(budget)) {
+      m_state = STREAM_STOPPED;
+      m_stopped = JVAL_ERR_BUDGET_EXCEEDED;
+      return;
+   }
+
+   size_t index = m_count++;
+   JsonTapeValue value = m_tape.root();
+
+   if (m_uniqueItems && !m_hashes.insert(value.hash()).second) {
+      m_duplicate = true;
+   }
+
+   if (m_failedItem < index) {
+      // an item failed already
+      return;
+   }
+
+   JsonPrimitive *primitive = m_items;
+   if (index < m_tuple.size()) {
+      primitive = m_tuple[index];
+   }
+
+   int ret = JVAL_ROK;
+   if (NULL != primitive) {
+      ret = primitive->validate(value);
+   }
+
+   if (NULL != budget && budget->exceeded()) {
+      m_state = STREAM_STOPPED;
+      m_stopped = JVAL_ERR_BUDGET_EXCEEDED;
+      return;
+   }
+
+   if (JVAL_ROK == ret) {
+      m_failedItem = m_count;
+      return;
+   }
+
+   // no keyword on the whole array may fail before items
+   if (!m_hasMinItems && !m_hasMaxItems && !m_uniqueItems && \
+         m_additionalItems) {
+      m_state = STREAM_STOPPED;
+      m_stopped = JVAL_ERR_INVALID_ARRAY_ITEM;
+   }
+}
+
+/**
+ * @brief Result of a complete array, the keywords in the order JsonArray runs
+ * them
+ */
+int JsonStreamValidator::result() const
+{
+   if (m_hasMinItems && m_count < m_minItems) {
+      return JVAL_ERR_INVALID_MIN_ITEMS;
+   }
+
+   if (m_hasMaxItems && m_count > m_maxItems) {
+      return JVAL_ERR_INVALID_MAX_ITEMS;
+   }
+
+   if (m_duplicate) {
+      return JVAL_ERR_DUPLICATE_ITEMS;
+   }
+
+   if (!m_additionalItems && m_count > m_tuple.size()) {
+      return JVAL_ERR_ADDITIONAL_ITEMS;
+   }
+
+   if (m_failedItem < m_count) {
+      return JVAL_ERR_INVALID_ARRAY_ITEM;
+   }
+
+   return JVAL_ROK;
+}
+
+int JsonStreamValidator::finish()
+{
+   switch (m_state) {
+      case STREAM_STOPPED:
+         return m_stopped;
+      case STREAM_END:
+         return result();
+      case STREAM_ITEM:
+         // a number or literal may end with the input, but not the array
+      default:
+         syntaxError("Unexpected end of the document");
+         return m_stopped;
+   }
+}
+
+int JsonStreamValidator::validate(std::istream &in)
+{
+   std::vector<char> chunk(JVAL_STREAM_CHUNK);
+
+   reset();
+   while (!done() && in.read(&chunk[0], chunk.size()).gcount() > 0) {
+      feed(&chunk[0], static_cast<size_t>(in.gcount()));
+   }
+
+   return finish();
+}
+
+int JsonStreamValidator::validate(int fd)
+{
+   std::vector<char> chunk(JVAL_STREAM_CHUNK);
+
+   reset();
+   while (!done()) {
+      ssize_t n = read(fd, &chunk[0], chunk.size());
+      if (n < 0 && EINTR == errno) {
+         continue;
+      }
+
+      if (n < 0) {
+         syntaxError(std::string("read: ") + strerror(errno));
+         break;
+      }
+
+      if (0 == n) {
+         break;
+      }
+
+      feed(&chunk[0], static_cast<size_t>(n));
+   }
+
+   return finish();
+}
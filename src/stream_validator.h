@@ -0,0 +1,163 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __STREAM_VALIDATOR_H__
+#define __STREAM_VALIDATOR_H__
+
+#include <stddef.h>
+#include <istream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// bytes read from an input at once
+#define JVAL_STREAM_CHUNK  (64U * 1024U)
+
+/**
+ * @brief Validates a document which is one large array, one item at a time,
+ * against a schema of type "array". The input arrives in chunks of any size;
+ * each item is parsed into a JsonTape once complete, validated against its
+ * items subschema and dropped, so memory stays bounded by the largest item.
+ *
+ * minItems, maxItems, additionalItems and uniqueItems are enforced on the
+ * whole array, and the result is the one JsonValidator gives for the parsed
+ * document. uniqueItems remembers a 64-bit structural hash per item instead of
+ * the items, so two distinct items sharing a hash would be reported as
+ * duplicates. Items count as steps of the thread's JsonBudget, if any.
+ *
+ * Once the result is known, e.g. an item failed and no keyword on the array
+ * as a whole can come before it, the rest of the input is not looked at.
+ * Malformed input ends the validation with JVAL_ERR_INVALID_JSON.
+ */
+class JsonStreamValidator
+{
+   public:
+      /**
+       * @brief Throws Exception if schema is not of type "array" or has
+       * errors; without exceptions the validation returns
+       * JVAL_ERR_INVALID_SCHEMA
+       */
+      JsonStreamValidator(Json::Value *schema);
+
+      ~JsonStreamValidator();
+
+      /**
+       * @brief Starts over with a new document
+       */
+      void reset();
+
+      /**
+       * @brief Takes the next chunk of the document
+       */
+      void feed(const char *data, size_t length);
+
+      /**
+       * @brief Ends the document
+       *
+       * @return same codes as JsonValidator::validate(), or
+       * JVAL_ERR_INVALID_JSON if the document is malformed, incomplete or
+       * could not be read
+       */
+      int finish();
+
+      /**
+       * @brief Whether the result is known and feed() ignores its input
+       */
+      bool done() const;
+
+      /**
+       * @brief Reads and validates a whole document
+       */
+      int validate(std::istream &in);
+
+      int validate(int fd);
+
+      /**
+       * @brief Items of the array seen so far
+       */
+      size_t items() const {return m_count;}
+
+      /**
+       * @brief Index of the first item found invalid, items() if none
+       */
+      size_t failedItem() const {return m_failedItem;}
+
+      /**
+       * @brief Bytes of the buffers holding an item, which grow to the size
+       * of the largest one
+       */
+      size_t bufferBytes() const;
+
+      /**
+       * @brief What was wrong with the schema or the document, if anything
+       */
+      const std::string &getError() const {return m_error;}
+
+   private:
+      JsonStreamValidator(const JsonStreamValidator &);
+      JsonStreamValidator &operator=(const JsonStreamValidator &);
+
+      typedef enum
+      {
+         STREAM_START,        // before the opening bracket
+         STREAM_FIRST,        // after it, an item or the closing bracket
+         STREAM_ITEM,         // inside an item
+         STREAM_SEPARATOR,    // after an item, a comma or the closing bracket
+         STREAM_NEXT,         // after a comma, an item
+         STREAM_END,          // after the closing bracket
+         STREAM_STOPPED       // the result is known
+
+      } State;
+
+      void addItem();
+
+      void syntaxError(const std::string &message);
+
+      int result() const;
+
+      // the subschemas
+      std::vector<JsonPrimitive*>   m_tuple;
+      JsonPrimitive                 *m_items;
+      bool                          m_hasMinItems;
+      size_t                        m_minItems;
+      bool                          m_hasMaxItems;
+      size_t                        m_maxItems;
+      bool                          m_uniqueItems;
+      bool                          m_additionalItems;
+      std::string                   m_schemaError;
+
+      // the document
+      State                         m_state;
+      int                           m_stopped;
+      std::string                   m_item;
+      unsigned int                  m_depth;
+      bool                          m_inString;
+      bool                          m_escape;
+      JsonTape                      m_tape;
+      std::unordered_set<size_t>    m_hashes;
+      size_t                        m_count;
+      size_t                        m_failedItem;
+      bool                          m_duplicate;
+      std::string                   m_error;
+};
+
+#endif
@@ -0,0 +1,1325 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <tape.h>
+#include <skip_plan.h>
+
+static const uint64_t TAPE_PAYLOAD_MASK = 0x00FFFFFFFFFFFFFFULL;
+
+// Json::Reader gives up beyond this depth as well
+static const int TAPE_MAX_DEPTH = 1000;
+
+static inline uint64_t tapeWord(char tag, uint64_t payload)
+{
+   return (static_cast<uint64_t>(static_cast<unsigned char>(tag)) << 56) | \
+      (payload & TAPE_PAYLOAD_MASK);
+}
+
+static inline char tapeTag(uint64_t word)
+{
+   return static_cast<char>(word >> 56);
+}
+
+/**
+ * @brief Returns the index of the word following the value at index
+ */
+static inline size_t tapeSkip(const std::vector<uint64_t> &tape, size_t index)
+{
+   switch (tapeTag(tape[index])) {
+      case '[':
+      case '{':
+         return static_cast<size_t>(tape[index + 1]);
+      case 'l':
+      case 'u':
+      case 'd':
+      case 's':
+      case 'S':
+      case 'r':
+         return index + 2;
+      default:
+         return index + 1;
+   }
+}
+
+static inline bool isIntegralDouble(double d)
+{
+   double integral_part;
+   return modf(d, &integral_part) == 0.0;
+}
+
+/**
+ * @brief Single pass recursive descent parser producing a JsonTape. With a
+ * JsonSkipPlan the values no keyword inspects are only scanned, and the
+ * strings without escapes are left in the source buffer.
+ */
+class JsonTapeParser
+{
+   public:
+      JsonTapeParser(JsonTape *tape, const char *begin, const char *end,
+            const JsonSkipPlan *plan) :
+         m_tape(tape), m_begin(begin), m_cur(begin), m_end(end),
+         m_plan(plan) {}
+
+      bool parse();
+
+   private:
+      bool parseValue(int depth, int node);
+      bool parseString();
+      bool parseNumber();
+      bool parseLiteral(const char *literal, size_t length);
+      bool parseHex4(unsigned int &cp);
+      bool parseUnicodeEscape(unsigned int &cp);
+      bool skipValue(int depth);
+      bool scanValue(int depth);
+      bool scanString();
+      bool scanNumber();
+      int memberNode(int node) const;
+      void skipWhitespace();
+      bool error(const char *message);
+
+      JsonTape             *m_tape;
+      const char           *m_begin;
+      const char           *m_cur;
+      const char           *m_end;
+      const JsonSkipPlan   *m_plan;
+      std::string          m_scratch;
+};
+
+bool JsonTapeParser::error(const char *message)
+{
+   char offset[32];
+   snprintf(offset, sizeof(offset), "%lu",
+         static_cast<unsigned long>(m_cur - m_begin));
+   m_tape->m_error = std::string(message) + " at offset " + offset;
+   return false;
+}
+
+void JsonTapeParser::skipWhitespace()
+{
+   while (m_cur < m_end && \
+         (*m_cur == ' ' || *m_cur == '\n' || *m_cur == '\r' || *m_cur == '\t')) {
+      m_cur++;
+   }
+}
+
+bool JsonTapeParser::parse()
+{
+   skipWhitespace();
+   if (!parseValue(0, NULL == m_plan ? JsonSkipPlan::FULL : m_plan->root())) {
+      return false;
+   }
+
+   skipWhitespace();
+   if (m_cur != m_end) {
+      return error("Extra characters after the document");
+   }
+
+   return true;
+}
+
+/**
+ * @param node of the value in m_plan
+ */
+bool JsonTapeParser::parseValue(int depth, int node)
+{
+   if (depth > TAPE_MAX_DEPTH) {
+      return error("Exceeded stack limit");
+   }
+
+   if (m_cur == m_end) {
+      return error("Unexpected end of document");
+   }
+
+   if (JsonSkipPlan::SKIPPED == node) {
+      return skipValue(depth);
+   }
+
+   switch (*m_cur) {
+      case '{': {
+         size_t open = m_tape->openContainer('{');
+         uint64_t count = 0;
+         m_cur++;
+         skipWhitespace();
+         if (m_cur < m_end && *m_cur == '}') {
+            m_cur++;
+            m_tape->closeContainer(open, count);
+            return true;
+         }
+
+         while (true) {
+            skipWhitespace();
+            if (m_cur == m_end || *m_cur != '"') {
+               return error("Missing '}' or object member name");
+            }
+            if (!parseString()) {
+               return false;
+            }
+            skipWhitespace();
+            if (m_cur == m_end || *m_cur != ':') {
+               return error("Missing ':' after object member name");
+            }
+            m_cur++;
+            skipWhitespace();
+            if (!parseValue(depth + 1, memberNode(node))) {
+               return false;
+            }
+            count++;
+            skipWhitespace();
+            if (m_cur < m_end && *m_cur == ',') {
+               m_cur++;
+               continue;
+            }
+            if (m_cur < m_end && *m_cur == '}') {
+               m_cur++;
+               break;
+            }
+            return error("Missing ',' or '}' in object declaration");
+         }
+
+         m_tape->closeContainer(open, count);
+         return true;
+      }
+
+      case '[': {
+         size_t open = m_tape->openContainer('[');
+         uint64_t count = 0;
+         m_cur++;
+         skipWhitespace();
+         if (m_cur < m_end && *m_cur == ']') {
+            m_cur++;
+            m_tape->closeContainer(open, count);
+            return true;
+         }
+
+         while (true) {
+            skipWhitespace();
+            int item = node < 0 ? node : m_plan->item(node, count);
+            if (!parseValue(depth + 1, item)) {
+               return false;
+            }
+            count++;
+            skipWhitespace();
+            if (m_cur < m_end && *m_cur == ',') {
+               m_cur++;
+               continue;
+            }
+            if (m_cur < m_end && *m_cur == ']') {
+               m_cur++;
+               break;
+            }
+            return error("Missing ',' or ']' in array declaration");
+         }
+
+         m_tape->closeContainer(open, count);
+         return true;
+      }
+
+      case '"':
+         return parseString();
+
+      case 't':
+         if (!parseLiteral("true", 4)) {
+            return false;
+         }
+         m_tape->appendBool(true);
+         return true;
+
+      case 'f':
+         if (!parseLiteral("false", 5)) {
+            return false;
+         }
+         m_tape->appendBool(false);
+         return true;
+
+      case 'n':
+         if (!parseLiteral("null", 4)) {
+            return false;
+         }
+         m_tape->appendNull();
+         return true;
+
+      default:
+         if (*m_cur == '-' || (*m_cur >= '0' && *m_cur <= '9')) {
+            return parseNumber();
+         }
+         return error("Syntax error: value, object or array expected");
+   }
+}
+
+bool JsonTapeParser::parseLiteral(const char *literal, size_t length)
+{
+   if (static_cast<size_t>(m_end - m_cur) < length || \
+         memcmp(m_cur, literal, length) != 0) {
+      return error("Syntax error: value, object or array expected");
+   }
+
+   m_cur += length;
+   return true;
+}
+
+bool JsonTapeParser::parseNumber()
+{
+   const char *start = m_cur;
+   const char *p = m_cur;
+   bool isNegative = (*p == '-');
+   if (isNegative) {
+      p++;
+   }
+
+   // same token shape as Json::Reader::readNumber
+   bool integral = true;
+   while (p < m_end && *p >= '0' && *p <= '9') {
+      p++;
+   }
+   if (p < m_end && *p == '.') {
+      integral = false;
+      p++;
+      while (p < m_end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+   }
+   if (p < m_end && (*p == 'e' || *p == 'E')) {
+      integral = false;
+      p++;
+      if (p < m_end && (*p == '+' || *p == '-')) {
+         p++;
+      }
+      while (p < m_end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+   }
+   m_cur = p;
+
+   const char *digits = start + (isNegative ? 1 : 0);
+   if (integral && p > digits) {
+      // Json::Reader stores negative integers and the ones up to
+      // Value::maxInt as intValue, larger ones as uintValue, and whatever
+      // overflows 64 bits as a double
+      uint64_t maxValue = isNegative ? (uint64_t(1) << 63) : ~uint64_t(0);
+      uint64_t value = 0;
+      bool overflow = false;
+      for (const char *c = digits; c < p; c++) {
+         unsigned int digit = static_cast<unsigned int>(*c - '0');
+         if (value > (maxValue - digit) / 10) {
+            overflow = true;
+            break;
+         }
+         value = value * 10 + digit;
+      }
+
+      if (!overflow) {
+         if (isNegative) {
+            m_tape->appendInt(static_cast<int64_t>(0 - value));
+         } else if (value <= static_cast<uint64_t>(Json::Value::maxInt)) {
+            m_tape->appendInt(static_cast<int64_t>(value));
+         } else {
+            m_tape->appendUInt(value);
+         }
+         return true;
+      }
+   }
+
+   double d = 0;
+   if (!Json::decodeDecimal(start, p, d)) {
+      m_cur = start;
+      return error("Invalid number");
+   }
+
+   m_tape->appendDouble(d);
+   return true;
+}
+
+bool JsonTapeParser::parseHex4(unsigned int &cp)
+{
+   if (m_end - m_cur < 4) {
+      return error("Bad unicode escape sequence in string");
+   }
+
+   cp = 0;
+   for (int i = 0; i < 4; i++) {
+      char c = *m_cur++;
+      cp <<= 4;
+      if (c >= '0' && c <= '9') {
+         cp += static_cast<unsigned int>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+         cp += static_cast<unsigned int>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+         cp += static_cast<unsigned int>(c - 'A' + 10);
+      } else {
+         return error("Bad unicode escape sequence in string");
+      }
+   }
+
+   return true;
+}
+
+/**
+ * @brief Reads the digits of a \\u escape, and of the second half of a
+ * surrogate pair
+ */
+bool JsonTapeParser::parseUnicodeEscape(unsigned int &cp)
+{
+   if (!parseHex4(cp)) {
+      return false;
+   }
+
+   if (cp >= 0xD800 && cp <= 0xDBFF) {
+      unsigned int low = 0;
+      if (m_end - m_cur < 2 || m_cur[0] != '\\' || m_cur[1] != 'u') {
+         return error("Expecting another \\u token to begin the "
+               "second half of a unicode surrogate pair");
+      }
+      m_cur += 2;
+      if (!parseHex4(low)) {
+         return false;
+      }
+      if (low < 0xDC00 || low > 0xDFFF) {
+         return error("Expecting another \\u token to begin the "
+               "second half of a unicode surrogate pair");
+      }
+      cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+   }
+
+   return true;
+}
+
+static void appendUtf8(std::string &out, unsigned int cp)
+{
+   if (cp <= 0x7F) {
+      out += static_cast<char>(cp);
+   } else if (cp <= 0x7FF) {
+      out += static_cast<char>(0xC0 | (cp >> 6));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+   } else if (cp <= 0xFFFF) {
+      out += static_cast<char>(0xE0 | (cp >> 12));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+   } else {
+      out += static_cast<char>(0xF0 | (cp >> 18));
+      out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+   }
+}
+
+bool JsonTapeParser::parseString()
+{
+   const char *start = ++m_cur;
+
+   // fast path, no escape sequence
+   while (m_cur < m_end && *m_cur != '"' && *m_cur != '\\') {
+      m_cur++;
+   }
+   if (m_cur == m_end) {
+      return error("Missing '\"' at the end of string");
+   }
+   if (*m_cur == '"') {
+      if (NULL != m_plan) {
+         m_tape->appendSourceString(start, m_cur);
+      } else {
+         m_tape->appendString(start, m_cur);
+      }
+      m_cur++;
+      return true;
+   }
+
+   m_scratch.assign(start, m_cur);
+   while (m_cur < m_end && *m_cur != '"') {
+      char c = *m_cur++;
+      if (c != '\\') {
+         m_scratch += c;
+         continue;
+      }
+
+      if (m_cur == m_end) {
+         return error("Empty escape sequence in string");
+      }
+
+      char escape = *m_cur++;
+      switch (escape) {
+         case '"': m_scratch += '"'; break;
+         case '/': m_scratch += '/'; break;
+         case '\\': m_scratch += '\\'; break;
+         case 'b': m_scratch += '\b'; break;
+         case 'f': m_scratch += '\f'; break;
+         case 'n': m_scratch += '\n'; break;
+         case 'r': m_scratch += '\r'; break;
+         case 't': m_scratch += '\t'; break;
+         case 'u': {
+            unsigned int cp = 0;
+            if (!parseUnicodeEscape(cp)) {
+               return false;
+            }
+            appendUtf8(m_scratch, cp);
+            break;
+         }
+         default:
+            return error("Bad escape sequence in string");
+      }
+   }
+
+   if (m_cur == m_end) {
+      return error("Missing '\"' at the end of string");
+   }
+   m_cur++;
+
+   m_tape->appendString(m_scratch.data(), m_scratch.data() + m_scratch.size());
+   return true;
+}
+
+/**
+ * @brief Node in m_plan of the value of the member whose name was appended
+ * last
+ */
+int JsonTapeParser::memberNode(int node) const
+{
+   if (node < 0) {
+      return node;
+   }
+
+   const std::vector<uint64_t> &words = m_tape->m_tape;
+   uint64_t word = words[words.size() - 2];
+   const char *name = m_tape->stringData(tapeTag(word), words.back());
+   return m_plan->member(node, name, name + (word & TAPE_PAYLOAD_MASK));
+}
+
+/**
+ * @brief Checks the syntax of a value like parseValue() does and appends its
+ * text as a raw value
+ */
+bool JsonTapeParser::skipValue(int depth)
+{
+   const char *start = m_cur;
+   if (!scanValue(depth)) {
+      return false;
+   }
+
+   m_tape->appendRaw(start, m_cur);
+   return true;
+}
+
+bool JsonTapeParser::scanValue(int depth)
+{
+   if (depth > TAPE_MAX_DEPTH) {
+      return error("Exceeded stack limit");
+   }
+
+   if (m_cur == m_end) {
+      return error("Unexpected end of document");
+   }
+
+   switch (*m_cur) {
+      case '{':
+         m_cur++;
+         skipWhitespace();
+         if (m_cur < m_end && *m_cur == '}') {
+            m_cur++;
+            return true;
+         }
+
+         while (true) {
+            skipWhitespace();
+            if (m_cur == m_end || *m_cur != '"') {
+               return error("Missing '}' or object member name");
+            }
+            if (!scanString()) {
+               return false;
+            }
+            skipWhitespace();
+            if (m_cur == m_end || *m_cur != ':') {
+               return error("Missing ':' after object member name");
+            }
+            m_cur++;
+            skipWhitespace();
+            if (!scanValue(depth + 1)) {
+               return false;
+            }
+            skipWhitespace();
+            if (m_cur < m_end && *m_cur == ',') {
+               m_cur++;
+               continue;
+            }
+            if (m_cur < m_end && *m_cur == '}') {
+               m_cur++;
+               return true;
+            }
+            return error("Missing ',' or '}' in object declaration");
+         }
+
+      case '[':
+         m_cur++;
+         skipWhitespace();
+         if (m_cur < m_end && *m_cur == ']') {
+            m_cur++;
+            return true;
+         }
+
+         while (true) {
+            skipWhitespace();
+            if (!scanValue(depth + 1)) {
+               return false;
+            }
+            skipWhitespace();
+            if (m_cur < m_end && *m_cur == ',') {
+               m_cur++;
+               continue;
+            }
+            if (m_cur < m_end && *m_cur == ']') {
+               m_cur++;
+               return true;
+            }
+            return error("Missing ',' or ']' in array declaration");
+         }
+
+      case '"':
+         return scanString();
+
+      case 't':
+         return parseLiteral("true", 4);
+
+      case 'f':
+         return parseLiteral("false", 5);
+
+      case 'n':
+         return parseLiteral("null", 4);
+
+      default:
+         if (*m_cur == '-' || (*m_cur >= '0' && *m_cur <= '9')) {
+            return scanNumber();
+         }
+         return error("Syntax error: value, object or array expected");
+   }
+}
+
+bool JsonTapeParser::scanString()
+{
+   m_cur++;
+
+   while (true) {
+      while (m_cur < m_end && *m_cur != '"' && *m_cur != '\\') {
+         m_cur++;
+      }
+      if (m_cur == m_end) {
+         return error("Missing '\"' at the end of string");
+      }
+      if (*m_cur++ == '"') {
+         return true;
+      }
+
+      if (m_cur == m_end) {
+         return error("Empty escape sequence in string");
+      }
+
+      unsigned int cp = 0;
+      switch (*m_cur++) {
+         case '"':
+         case '/':
+         case '\\':
+         case 'b':
+         case 'f':
+         case 'n':
+         case 'r':
+         case 't':
+            break;
+         case 'u':
+            if (!parseUnicodeEscape(cp)) {
+               return false;
+            }
+            break;
+         default:
+            return error("Bad escape sequence in string");
+      }
+   }
+}
+
+/**
+ * @brief Checks a number token against the grammar parseNumber() and
+ * Json::decodeDecimal() accept, without converting it
+ */
+bool JsonTapeParser::scanNumber()
+{
+   const char *p = m_cur;
+   if (*p == '-') {
+      p++;
+   }
+
+   const char *digits = p;
+   while (p < m_end && *p >= '0' && *p <= '9') {
+      p++;
+   }
+   bool valid = p > digits;
+
+   if (valid && p < m_end && *p == '.') {
+      const char *fraction = ++p;
+      while (p < m_end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+      valid = p > fraction;
+   }
+
+   if (valid && p < m_end && (*p == 'e' || *p == 'E')) {
+      p++;
+      if (p < m_end && (*p == '+' || *p == '-')) {
+         p++;
+      }
+      const char *exponent = p;
+      while (p < m_end && *p >= '0' && *p <= '9') {
+         p++;
+      }
+      valid = p > exponent;
+   }
+
+   if (!valid) {
+      return error("Invalid number");
+   }
+
+   m_cur = p;
+   return true;
+}
+
+JsonTape::JsonTape() : m_source(NULL)
+{
+}
+
+void JsonTape::clear()
+{
+   m_tape.clear();
+   m_strings.clear();
+   m_error.clear();
+}
+
+bool JsonTape::parse(const char *begin, const char *end)
+{
+   clear();
+
+   // a scalar takes two words for a few bytes of text, reserving up front
+   // avoids most of the reallocations on large documents
+   m_tape.reserve(static_cast<size_t>(end - begin) / 3 + 2);
+   m_strings.reserve(static_cast<size_t>(end - begin) / 2);
+
+   JsonTapeParser parser(this, begin, end, NULL);
+   if (!parser.parse()) {
+      m_tape.clear();
+      m_strings.clear();
+      return false;
+   }
+
+   return true;
+}
+
+bool JsonTape::parse(const std::string &document)
+{
+   return parse(document.data(), document.data() + document.size());
+}
+
+bool JsonTape::parse(const char *begin, const char *end,
+      const JsonSkipPlan *plan)
+{
+   if (NULL == plan) {
+      return parse(begin, end);
+   }
+
+   clear();
+   setSource(begin);
+   m_tape.reserve(static_cast<size_t>(end - begin) / 3 + 2);
+
+   JsonTapeParser parser(this, begin, end, plan);
+   if (!parser.parse()) {
+      m_tape.clear();
+      m_strings.clear();
+      return false;
+   }
+
+   return true;
+}
+
+JsonTapeValue JsonTape::root() const
+{
+   if (m_tape.empty()) {
+      return JsonTapeValue();
+   }
+
+   return JsonTapeValue(this, 0);
+}
+
+size_t JsonTape::memoryUsage() const
+{
+   return m_tape.capacity() * sizeof(uint64_t) + m_strings.capacity();
+}
+
+void JsonTape::appendNull()
+{
+   m_tape.push_back(tapeWord('n', 0));
+}
+
+void JsonTape::appendBool(bool value)
+{
+   m_tape.push_back(tapeWord(value ? 't' : 'f', 0));
+}
+
+void JsonTape::appendInt(int64_t value)
+{
+   m_tape.push_back(tapeWord('l', 0));
+   m_tape.push_back(static_cast<uint64_t>(value));
+}
+
+void JsonTape::appendUInt(uint64_t value)
+{
+   m_tape.push_back(tapeWord('u', 0));
+   m_tape.push_back(value);
+}
+
+void JsonTape::appendDouble(double value)
+{
+   uint64_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   m_tape.push_back(tapeWord('d', 0));
+   m_tape.push_back(bits);
+}
+
+void JsonTape::appendString(const char *begin, const char *end)
+{
+   m_tape.push_back(tapeWord('s', static_cast<uint64_t>(end - begin)));
+   m_tape.push_back(m_strings.size());
+   m_strings.insert(m_strings.end(), begin, end);
+   m_strings.push_back('\0');
+}
+
+void JsonTape::appendSourceString(const char *begin, const char *end)
+{
+   m_tape.push_back(tapeWord('S', static_cast<uint64_t>(end - begin)));
+   m_tape.push_back(static_cast<uint64_t>(begin - m_source));
+}
+
+void JsonTape::appendRaw(const char *begin, const char *end)
+{
+   m_tape.push_back(tapeWord('r', static_cast<uint64_t>(end - begin)));
+   m_tape.push_back(static_cast<uint64_t>(begin - m_source));
+}
+
+size_t JsonTape::openContainer(char tag)
+{
+   size_t open = m_tape.size();
+   m_tape.push_back(tapeWord(tag, 0));
+   m_tape.push_back(0);
+   return open;
+}
+
+void JsonTape::closeContainer(size_t open, uint64_t count)
+{
+   m_tape[open] = tapeWord(tapeTag(m_tape[open]), count);
+   m_tape[open + 1] = m_tape.size();
+}
+
+const char *JsonTape::stringData(char tag, uint64_t offset) const
+{
+   if (tag == 'S') {
+      return m_source + offset;
+   }
+
+   return &m_strings[static_cast<size_t>(offset)];
+}
+
+JsonTapeValue JsonTapeValue::const_iterator::operator*() const
+{
+   return JsonTapeValue(m_tape, m_object ? m_index + 2 : m_index);
+}
+
+JsonTapeValue::const_iterator &JsonTapeValue::const_iterator::operator++()
+{
+   const std::vector<uint64_t> &words = m_tape->words();
+   m_index = tapeSkip(words, m_object ? m_index + 2 : m_index);
+   return *this;
+}
+
+const char *JsonTapeValue::const_iterator::memberName(const char **end) const
+{
+   const std::vector<uint64_t> &words = m_tape->words();
+   uint64_t word = words[m_index];
+   const char *name = m_tape->stringData(tapeTag(word), words[m_index + 1]);
+   *end = name + (word & TAPE_PAYLOAD_MASK);
+   return name;
+}
+
+char JsonTapeValue::tag() const
+{
+   return tapeTag(m_tape->words()[m_index]);
+}
+
+Json::ValueType JsonTapeValue::type() const
+{
+   switch (tag()) {
+      case 'n': return Json::nullValue;
+      case 'l': return Json::intValue;
+      case 'u': return Json::uintValue;
+      case 'd': return Json::realValue;
+      case 't':
+      case 'f': return Json::booleanValue;
+      case '[': return Json::arrayValue;
+      case '{': return Json::objectValue;
+      case 'r': return Json::nullValue;
+      default: return Json::stringValue;
+   }
+}
+
+uint64_t JsonTapeValue::payload() const
+{
+   return m_tape->words()[m_index] & TAPE_PAYLOAD_MASK;
+}
+
+bool JsonTapeValue::isNull() const
+{
+   return tag() == 'n';
+}
+
+bool JsonTapeValue::isBool() const
+{
+   char t = tag();
+   return t == 't' || t == 'f';
+}
+
+bool JsonTapeValue::isInt() const
+{
+   switch (tag()) {
+      case 'l': {
+         int64_t v = asInt64();
+         return v >= Json::Value::minInt && v <= Json::Value::maxInt;
+      }
+      case 'u':
+         return asUInt64() <= static_cast<uint64_t>(Json::Value::maxInt);
+      case 'd': {
+         double d = asDouble();
+         return d >= Json::Value::minInt && d <= Json::Value::maxInt && \
+            isIntegralDouble(d);
+      }
+      default:
+         return false;
+   }
+}
+
+bool JsonTapeValue::isInt64() const
+{
+   switch (tag()) {
+      case 'l':
+         return true;
+      case 'u':
+         return asUInt64() <= static_cast<uint64_t>(Json::Value::maxInt64);
+      case 'd': {
+         double d = asDouble();
+         return d >= double(Json::Value::minInt64) && \
+            d < double(Json::Value::maxInt64) && isIntegralDouble(d);
+      }
+      default:
+         return false;
+   }
+}
+
+bool JsonTapeValue::isUInt() const
+{
+   switch (tag()) {
+      case 'l': {
+         int64_t v = asInt64();
+         return v >= 0 && static_cast<uint64_t>(v) <= Json::Value::maxUInt;
+      }
+      case 'u':
+         return asUInt64() <= Json::Value::maxUInt;
+      case 'd': {
+         double d = asDouble();
+         return d >= 0 && d <= Json::Value::maxUInt && isIntegralDouble(d);
+      }
+      default:
+         return false;
+   }
+}
+
+bool JsonTapeValue::isUInt64() const
+{
+   switch (tag()) {
+      case 'l':
+         return asInt64() >= 0;
+      case 'u':
+         return true;
+      case 'd': {
+         double d = asDouble();
+         return d >= 0 && d < 18446744073709551616.0 && isIntegralDouble(d);
+      }
+      default:
+         return false;
+   }
+}
+
+bool JsonTapeValue::isIntegral() const
+{
+   return isInt64() || isUInt64();
+}
+
+bool JsonTapeValue::isDouble() const
+{
+   return tag() == 'd' || isIntegral();
+}
+
+bool JsonTapeValue::isNumeric() const
+{
+   return isDouble();
+}
+
+bool JsonTapeValue::isString() const
+{
+   char t = tag();
+   return t == 's' || t == 'S';
+}
+
+bool JsonTapeValue::isSkipped() const
+{
+   return tag() == 'r';
+}
+
+bool JsonTapeValue::isArray() const
+{
+   return tag() == '[';
+}
+
+bool JsonTapeValue::isObject() const
+{
+   return tag() == '{';
+}
+
+bool JsonTapeValue::asBool() const
+{
+   switch (tag()) {
+      case 't':
+         return true;
+      case 'l':
+      case 'u':
+         return m_tape->words()[m_index + 1] != 0;
+      case 'd':
+         return asDouble() != 0.0;
+      default:
+         return false;
+   }
+}
+
+int JsonTapeValue::asInt() const
+{
+   switch (tag()) {
+      case 'l':
+      case 'u':
+         if (!isInt()) {
+            Json::throwLogicError("LargestInt out of Int range");
+         }
+         return static_cast<int>(asInt64());
+      case 'd': {
+         double d = asDouble();
+         if (!(d >= Json::Value::minInt && d <= Json::Value::maxInt)) {
+            Json::throwLogicError("double out of Int range");
+         }
+         return static_cast<int>(d);
+      }
+      case 't':
+         return 1;
+      case 'f':
+      case 'n':
+         return 0;
+      default:
+         Json::throwLogicError("Value is not convertible to Int.");
+   }
+}
+
+int64_t JsonTapeValue::asInt64() const
+{
+   switch (tag()) {
+      case 'l':
+      case 'u':
+         return static_cast<int64_t>(m_tape->words()[m_index + 1]);
+      case 'd':
+         return static_cast<int64_t>(asDouble());
+      case 't':
+         return 1;
+      default:
+         return 0;
+   }
+}
+
+uint64_t JsonTapeValue::asUInt64() const
+{
+   switch (tag()) {
+      case 'l':
+      case 'u':
+         return m_tape->words()[m_index + 1];
+      case 'd':
+         return static_cast<uint64_t>(asDouble());
+      case 't':
+         return 1;
+      default:
+         return 0;
+   }
+}
+
+double JsonTapeValue::asDouble() const
+{
+   uint64_t bits;
+   switch (tag()) {
+      case 'l':
+         return static_cast<double>(asInt64());
+      case 'u':
+         return static_cast<double>(asUInt64());
+      case 'd':
+         bits = m_tape->words()[m_index + 1];
+         double d;
+         memcpy(&d, &bits, sizeof(d));
+         return d;
+      case 't':
+         return 1.0;
+      default:
+         return 0.0;
+   }
+}
+
+std::string JsonTapeValue::asString() const
+{
+   const char *begin = NULL;
+   const char *end = NULL;
+   if (!getString(&begin, &end)) {
+      return std::string();
+   }
+
+   return std::string(begin, end);
+}
+
+bool JsonTapeValue::getString(const char **begin, const char **end) const
+{
+   char t = tag();
+   if (t != 's' && t != 'S') {
+      return false;
+   }
+
+   *begin = m_tape->stringData(t, m_tape->words()[m_index + 1]);
+   *end = *begin + payload();
+   return true;
+}
+
+bool JsonTapeValue::getRaw(const char **begin, const char **end) const
+{
+   if (tag() != 'r') {
+      return false;
+   }
+
+   *begin = m_tape->stringData('S', m_tape->words()[m_index + 1]);
+   *end = *begin + payload();
+   return true;
+}
+
+unsigned int JsonTapeValue::size() const
+{
+   char t = tag();
+   if (t != '[' && t != '{') {
+      return 0;
+   }
+
+   return static_cast<unsigned int>(payload());
+}
+
+bool JsonTapeValue::isMember(const std::string &name) const
+{
+   return find(name.data(), name.data() + name.size()).isValid();
+}
+
+bool JsonTapeValue::isMember(const char *begin, const char *end) const
+{
+   return find(begin, end).isValid();
+}
+
+JsonTapeValue JsonTapeValue::find(const char *begin, const char *end) const
+{
+   if (tag() != '{') {
+      return JsonTapeValue();
+   }
+
+   size_t length = static_cast<size_t>(end - begin);
+   for (const_iterator itr = this->begin(); itr != this->end(); ++itr) {
+      const char *nameEnd = NULL;
+      const char *name = itr.memberName(&nameEnd);
+      if (static_cast<size_t>(nameEnd - name) == length && \
+            memcmp(name, begin, length) == 0) {
+         return *itr;
+      }
+   }
+
+   return JsonTapeValue();
+}
+
+JsonTapeValue::const_iterator JsonTapeValue::begin() const
+{
+   char t = tag();
+   if (t != '[' && t != '{') {
+      return const_iterator(m_tape, 0, false);
+   }
+
+   return const_iterator(m_tape, m_index + 2, t == '{');
+}
+
+JsonTapeValue::const_iterator JsonTapeValue::end() const
+{
+   char t = tag();
+   if (t != '[' && t != '{') {
+      return const_iterator(m_tape, 0, false);
+   }
+
+   return const_iterator(m_tape, tapeSkip(m_tape->words(), m_index), t == '{');
+}
+
+bool JsonTapeValue::operator==(const JsonTapeValue &other) const
+{
+   char a = tag();
+   char b = other.tag();
+   if (a == 'S') {
+      a = 's';
+   }
+   if (b == 'S') {
+      b = 's';
+   }
+   if (a != b) {
+      return false;
+   }
+
+   switch (a) {
+      case 'l':
+      case 'u':
+         return asUInt64() == other.asUInt64();
+      case 'd':
+         return asDouble() == other.asDouble();
+      case 's': {
+         const char *b1, *e1, *b2, *e2;
+         getString(&b1, &e1);
+         other.getString(&b2, &e2);
+         return (e1 - b1) == (e2 - b2) && \
+            memcmp(b1, b2, static_cast<size_t>(e1 - b1)) == 0;
+      }
+      case 'r': {
+         // the same text, only known equal without parsing it
+         const char *b1 = NULL, *e1 = NULL, *b2 = NULL, *e2 = NULL;
+         getRaw(&b1, &e1);
+         other.getRaw(&b2, &e2);
+         return (e1 - b1) == (e2 - b2) && \
+            memcmp(b1, b2, static_cast<size_t>(e1 - b1)) == 0;
+      }
+      case '[': {
+         if (size() != other.size()) {
+            return false;
+         }
+         const_iterator j = other.begin();
+         for (const_iterator i = begin(); i != end(); ++i, ++j) {
+            if (*i != *j) {
+               return false;
+            }
+         }
+         return true;
+      }
+      case '{': {
+         if (size() != other.size()) {
+            return false;
+         }
+         for (const_iterator i = begin(); i != end(); ++i) {
+            const char *nameEnd = NULL;
+            const char *name = i.memberName(&nameEnd);
+            JsonTapeValue member = other.find(name, nameEnd);
+            if (!member.isValid() || *i != member) {
+               return false;
+            }
+         }
+         return true;
+      }
+      default:
+         return true;
+   }
+}
+
+static inline size_t hashBytes(const char *begin, const char *end)
+{
+   // FNV-1a
+   uint64_t h = 14695981039346656037ULL;
+   for (const char *c = begin; c < end; c++) {
+      h ^= static_cast<unsigned char>(*c);
+      h *= 1099511628211ULL;
+   }
+   return static_cast<size_t>(h);
+}
+
+static inline size_t hashMix(size_t seed, size_t value)
+{
+   return seed ^ (value + static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2));
+}
+
+size_t JsonTapeValue::hash() const
+{
+   char t = tag();
+   switch (t) {
+      case 'l':
+      case 'u':
+         return hashMix(static_cast<size_t>(t), static_cast<size_t>(asUInt64()));
+      case 'd': {
+         double d = asDouble();
+         uint64_t bits = 0;
+         if (d != 0.0) {
+            memcpy(&bits, &d, sizeof(bits));
+         }
+         return hashMix('d', static_cast<size_t>(bits));
+      }
+      case 's':
+      case 'S': {
+         const char *begin, *end;
+         getString(&begin, &end);
+         return hashMix('s', hashBytes(begin, end));
+      }
+      case 'r': {
+         const char *begin, *end;
+         getRaw(&begin, &end);
+         return hashMix('r', hashBytes(begin, end));
+      }
+      case '[': {
+         size_t h = '[';
+         for (const_iterator i = this->begin(); i != this->end(); ++i) {
+            h = hashMix(h, (*i).hash());
+         }
+         return h;
+      }
+      case '{': {
+         // members are combined regardless of their order
+         size_t h = 0;
+         for (const_iterator i = this->begin(); i != this->end(); ++i) {
+            const char *nameEnd = NULL;
+            const char *name = i.memberName(&nameEnd);
+            h += hashMix(hashBytes(name, nameEnd), (*i).hash());
+         }
+         return hashMix('{', h);
+      }
+      default:
+         return static_cast<size_t>(t);
+   }
+}
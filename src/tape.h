@@ -0,0 +1,289 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __TAPE_H__
+#define __TAPE_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class JsonTape;
+class JsonSkipPlan;
+
+/**
+ * @brief Read-only view of one value on a JsonTape. The accessors follow the
+ * semantics of the Json::Value methods of the same name, so that keyword
+ * validators can be written once for both representations.
+ */
+class JsonTapeValue
+{
+   public:
+      class const_iterator
+      {
+         public:
+            const_iterator() : m_tape(NULL), m_index(0), m_object(false) {}
+
+            const_iterator(const JsonTape *tape, size_t index, bool object) :
+               m_tape(tape), m_index(index), m_object(object) {}
+
+            JsonTapeValue operator*() const;
+
+            const_iterator &operator++();
+
+            bool operator==(const const_iterator &other) const {
+               return m_index == other.m_index;
+            }
+
+            bool operator!=(const const_iterator &other) const {
+               return m_index != other.m_index;
+            }
+
+            /**
+             * @brief Name of the current member when iterating an object
+             *
+             * @param end receives the end of the name
+             *
+             * @return start of the name, not null terminated
+             */
+            const char *memberName(const char **end) const;
+
+         private:
+            const JsonTape *m_tape;
+            size_t         m_index;
+            bool           m_object;
+      };
+
+      JsonTapeValue() : m_tape(NULL), m_index(0) {}
+
+      JsonTapeValue(const JsonTape *tape, size_t index) :
+         m_tape(tape), m_index(index) {}
+
+      bool isNull() const;
+      bool isBool() const;
+      bool isInt() const;
+      bool isInt64() const;
+      bool isUInt() const;
+      bool isUInt64() const;
+      bool isIntegral() const;
+      bool isDouble() const;
+      bool isNumeric() const;
+      bool isString() const;
+      bool isArray() const;
+      bool isObject() const;
+
+      /**
+       * @brief true for a value left unparsed by a JsonSkipPlan, which reads
+       * as null; getRaw() gives its text
+       */
+      bool isSkipped() const;
+
+      bool           asBool() const;
+      int            asInt() const;
+      int64_t        asInt64() const;
+      uint64_t       asUInt64() const;
+      double         asDouble() const;
+      std::string    asString() const;
+
+      /**
+       * @brief Gives access to the bytes of a string value without copying
+       *
+       * @return false if the value is not a string
+       */
+      bool getString(const char **begin, const char **end) const;
+
+      /**
+       * @brief Gives access to the JSON text of a skipped value
+       *
+       * @return false if the value was parsed
+       */
+      bool getRaw(const char **begin, const char **end) const;
+
+      /**
+       * @brief Number of items of an array or members of an object
+       */
+      unsigned int size() const;
+
+      bool isMember(const std::string &name) const;
+
+      bool isMember(const char *begin, const char *end) const;
+
+      /**
+       * @brief Looks up an object member by name
+       *
+       * @return the member, or a value for which isValid() is false
+       */
+      JsonTapeValue find(const char *begin, const char *end) const;
+
+      const_iterator begin() const;
+
+      const_iterator end() const;
+
+      bool isValid() const {return m_tape != NULL;}
+
+      /**
+       * @brief Storage type, with the same classification as Json::Value
+       */
+      Json::ValueType type() const;
+
+      /**
+       * @brief Structural equality with the Json::Value::operator== rules:
+       * numbers of different storage types differ and object members are
+       * compared regardless of their order.
+       */
+      bool operator==(const JsonTapeValue &other) const;
+
+      bool operator!=(const JsonTapeValue &other) const {
+         return !(*this == other);
+      }
+
+      /**
+       * @brief Hash consistent with operator==
+       */
+      size_t hash() const;
+
+      const JsonTape *tape() const {return m_tape;}
+
+      size_t index() const {return m_index;}
+
+   private:
+      char tag() const;
+
+      uint64_t payload() const;
+
+      const JsonTape *m_tape;
+      size_t         m_index;
+};
+
+/**
+ * @brief Flat representation of a JSON document, built in a single pass.
+ *
+ * Every value is stored as one or two 64-bit words. The top byte of the first
+ * word is a tag and the remaining 56 bits a payload:
+ *
+ *    'n' 't' 'f'    null, true, false
+ *    'l' 'u' 'd'    int64, uint64, double; the bits follow in the next word
+ *    's'            string of payload bytes; the next word is its offset in
+ *                   the string buffer
+ *    'S'            same as 's' with the offset taken in the source buffer
+ *    'r'            JSON text of payload bytes left unparsed, at the offset
+ *                   of the next word in the source buffer
+ *    '[' '{'        array or object of payload items or members, the next
+ *                   word is the index of the word following the container
+ *
+ * Object members are stored as a key string followed by the value. Skipping
+ * any subtree is a single jump, and the tape takes two words per scalar.
+ * Numbers are classified into int64, uint64 and double exactly like
+ * Json::Reader does it.
+ */
+class JsonTape
+{
+   public:
+      JsonTape();
+
+      /**
+       * @brief Parses a document, replacing the previous content
+       *
+       * @return false on syntax error, see getError()
+       */
+      bool parse(const char *begin, const char *end);
+
+      bool parse(const std::string &document);
+
+      /**
+       * @brief Parses a document, keeping the values plan says no keyword
+       * looks into as raw text in the buffer, which must then outlive the
+       * tape. Their syntax is checked all the same.
+       *
+       * @param plan JsonValidator::skipPlan() of the schema the document is
+       * validated against, or NULL to parse everything
+       */
+      bool parse(const char *begin, const char *end, const JsonSkipPlan *plan);
+
+      /**
+       * @brief Reads a MessagePack document, replacing the previous content.
+       * Strings are referenced in place, so the buffer must outlive the tape.
+       * bin and ext values have no JSON equivalent and are refused.
+       *
+       * @return false on malformed input, see getError()
+       */
+      bool parseMessagePack(const char *begin, const char *end);
+
+      /**
+       * @brief Reads a CBOR document the same way. Tags are ignored, byte
+       * strings and undefined are refused.
+       */
+      bool parseCbor(const char *begin, const char *end);
+
+      const std::string &getError() const {return m_error;}
+
+      JsonTapeValue root() const;
+
+      void clear();
+
+      /**
+       * @brief Bytes held by the tape and its string buffer
+       */
+      size_t memoryUsage() const;
+
+      // builder interface, used by the parsers of the various input formats
+      void appendNull();
+      void appendBool(bool value);
+      void appendInt(int64_t value);
+      void appendUInt(uint64_t value);
+      void appendDouble(double value);
+      void appendString(const char *begin, const char *end);
+
+      /**
+       * @brief Appends a string that stays in the source buffer given to
+       * setSource(), no copy is made
+       */
+      void appendSourceString(const char *begin, const char *end);
+
+      /**
+       * @brief Appends a value kept as its JSON text in the source buffer
+       */
+      void appendRaw(const char *begin, const char *end);
+
+      size_t openContainer(char tag);
+      void closeContainer(size_t open, uint64_t count);
+
+      /**
+       * @brief Buffer that 'S' strings point into. It must outlive the tape.
+       */
+      void setSource(const char *source) {m_source = source;}
+
+      const std::vector<uint64_t> &words() const {return m_tape;}
+
+      const char *stringData(char tag, uint64_t offset) const;
+
+   private:
+      friend class JsonTapeParser;
+      friend class JsonBinaryParser;
+
+      std::vector<uint64_t>   m_tape;
+      std::vector<char>       m_strings;
+      const char              *m_source;
+      std::string             m_error;
+};
+
+#endif
@@ -23,39 +23,157 @@
 #include <string>
 #include <fstream>
 #include <streambuf>
-#include <iostream>
 #include <sstream>
 #include <vector>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <atomic>
 #include <algorithm>
 #include <regex>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
 #include <json.h>
+#include <tape.h>
+#include <number.h>
+#include <format.h>
+#include <json_pointer.h>
+#include <memo.h>
+#include <budget.h>
+#include <parallel.h>
+#include <memory_usage.h>
 #include <primitive_base.h>
+#include <schema_cache.h>
 #include <keyword_validator.h>
+#include <skip_plan.h>
+#include <projection.h>
 #include <primitive.h>
+#include <policy_primitive.h>
 #include <validator.h>
 
+// pointer sets whose projection a validator keeps
+#define JVAL_PROJECTION_CACHE_SIZE 64
+
+// bytes of the compiled schemas of the live validators
+static std::atomic<size_t> totalSchemaBytes(0);
+
+// A validation cut short by the thread's budget failed, whatever the keyword
+// which noticed reported
+static int budgetResult(int ret)
+{
+   JsonBudget *budget = JsonBudget::current();
+   if (NULL != budget && budget->exceeded()) {
+      return JVAL_ERR_BUDGET_EXCEEDED;
+   }
+
+   return ret;
+}
+
 JsonValidator::JsonValidator()
 {
    m_primitive = NULL;
+   m_memoCapacity = 0;
+   m_memoryUsage = 0;
+   m_parallel = NULL;
+   m_skipPlan = NULL;
+   m_projections.reset(new JsonProjectionCache(JVAL_PROJECTION_CACHE_SIZE));
 }
 
 JsonValidator::JsonValidator(std::string &schema)
 {
    m_primitive = NULL;
+   m_memoCapacity = 0;
+   m_memoryUsage = 0;
+   m_parallel = NULL;
+   m_skipPlan = NULL;
+   m_projections.reset(new JsonProjectionCache(JVAL_PROJECTION_CACHE_SIZE));
    parseSchema(schema);
 }
 
 JsonValidator::JsonValidator(Json::Value *schema)
 {
    m_primitive = NULL;
-   m_primitive = JsonPrimitive::createPrimitive(schema);
+   m_memoCapacity = 0;
+   m_memoryUsage = 0;
+   m_parallel = NULL;
+   m_skipPlan = NULL;
+   m_projections.reset(new JsonProjectionCache(JVAL_PROJECTION_CACHE_SIZE));
+
+   JsonSchemaCache cache;
+   JsonSchemaCache::Scope scope(cache);
+   setCompiled(JsonPrimitive::createPrimitive(schema), cache, *schema);
 }
 
 JsonValidator::~JsonValidator()
 {
-   delete m_primitive;
+   setPrimitive(NULL);
+   delete m_parallel;
+   delete m_skipPlan;
+}
+
+void JsonValidator::setParallel(JsonWorkerPool *pool, size_t threshold)
+{
+   delete m_parallel;
+   m_parallel = NULL;
+
+   if (NULL != pool) {
+      m_parallel = new JsonParallel(pool, threshold);
+   }
+}
+
+void JsonValidator::setPrimitive(JsonPrimitive *primitive)
+{
+   // the projections refer to the primitives of the previous schema
+   m_projections->clear();
+
+   JsonPrimitive::release(m_primitive);
+   m_primitive = primitive;
+   totalSchemaBytes -= m_memoryUsage;
+   m_memoryUsage = 0;
+
+   if (NULL != m_primitive) {
+      JsonMemoryUsage usage;
+      m_primitive->memoryUsage(usage, "");
+      m_memoryUsage = usage.total();
+      totalSchemaBytes += m_memoryUsage;
+   }
+}
+
+/**
+ * @brief Takes the primitive compiled from schema in the scope of cache,
+ * unless the schema had errors
+ */
+void JsonValidator::setCompiled(JsonPrimitive *primitive,
+      const JsonSchemaCache &cache, const Json::Value &schema)
+{
+   m_error = cache.error();
+   if (cache.failed()) {
+      JsonPrimitive::release(primitive);
+      primitive = NULL;
+   }
+
+   setPrimitive(primitive);
+
+   delete m_skipPlan;
+   m_skipPlan = NULL;
+   if (NULL != primitive) {
+      m_skipPlan = new JsonSkipPlan(schema);
+   }
+}
+
+void JsonValidator::memoryUsage(JsonMemoryUsage &usage) const
+{
+   if (NULL != m_primitive && usage.visit(m_primitive)) {
+      m_primitive->memoryUsage(usage, "");
+   }
+}
+
+size_t JsonValidator::totalMemoryUsage()
+{
+   return totalSchemaBytes;
 }
 
 void JsonValidator::readSchema(const char *schema_file)
@@ -77,45 +195,127 @@ void JsonValidator::readSchema(const char *schema_file)
 
 void JsonValidator::parseSchema(std::string &str)
 {
+   JsonSchemaCache cache;
+   JsonSchemaCache::Scope scope(cache);
+   JsonPrimitive *primitive = NULL;
+
    Json::Reader   reader;
    Json::Value    schema;
    bool parsingSuccessful = reader.parse(str.c_str(), schema);
-   if (!parsingSuccessful) {
-      throw Exception(reader.getFormattedErrorMessages());
+   if (parsingSuccessful) {
+      primitive = JsonPrimitive::createPrimitive(&schema);
+   } else {
+      JVAL_SCHEMA_ERROR(reader.getFormattedErrorMessages());
    }
 
-   m_primitive = JsonPrimitive::createPrimitive(&schema);
+   setCompiled(primitive, cache, schema);
 }
 
 int JsonValidator::validate(const Json::Value *value)
 {
-   int ret = JVAL_ROK;
+   if (NULL == m_primitive) {
+      return JVAL_ERR_INVALID_SCHEMA;
+   }
 
-   try {
+   if (NULL != m_parallel && NULL == JsonParallel::current()) {
+      JsonParallel::Scope scope(*m_parallel);
+      return validate(value);
+   }
+
+   int ret = JVAL_ROK;
+   if (m_memoCapacity > 0 && NULL == JsonMemo::current()) {
+      JsonMemo memo(m_memoCapacity, false);
+      JsonMemo::Scope scope(memo);
+      ret = m_primitive->validate(value);
+   } else {
       ret = m_primitive->validate(value);
-   } catch (Exception &e) {
-      std::cout << e.what() << std::endl;
    }
 
-   return ret;
+   return budgetResult(ret);
+}
+
+int JsonValidator::validate(const JsonTape *document)
+{
+   if (NULL == m_primitive) {
+      return JVAL_ERR_INVALID_SCHEMA;
+   }
+
+   if (NULL != m_parallel && NULL == JsonParallel::current()) {
+      JsonParallel::Scope scope(*m_parallel);
+      return validate(document);
+   }
+
+   return budgetResult(m_primitive->validate(document->root()));
+}
+
+int JsonValidator::validate(const Json::Value *value, JsonBudget &budget)
+{
+   JsonBudget::Scope scope(budget);
+   return validate(value);
+}
+
+int JsonValidator::validate(const JsonTape *document, JsonBudget &budget)
+{
+   JsonBudget::Scope scope(budget);
+   return validate(document);
+}
+
+int JsonValidator::revalidate(const Json::Value *value,
+      const std::vector<std::string> &pointers)
+{
+   if (NULL == m_primitive) {
+      return JVAL_ERR_INVALID_SCHEMA;
+   }
+
+   if (pointers.empty()) {
+      return JVAL_ROK;
+   }
+
+   JsonPointerNode paths;
+   for (size_t i = 0; i < pointers.size(); i++) {
+      if (!paths.add(pointers[i])) {
+         // cannot tell what changed
+         return validate(value);
+      }
+   }
+
+   return budgetResult(m_primitive->validatePaths(value, &paths));
+}
+
+int JsonValidator::validateProjection(const Json::Value *value,
+      const std::vector<std::string> &pointers)
+{
+   if (NULL == m_primitive) {
+      return JVAL_ERR_INVALID_SCHEMA;
+   }
+
+   if (pointers.empty()) {
+      return JVAL_ROK;
+   }
+
+   std::shared_ptr<const JsonProjection> projection = \
+      m_projections->find(m_primitive, pointers);
+   if (!projection->isValid()) {
+      // cannot tell what to select
+      return validate(value);
+   }
+
+   return budgetResult(projection->validate(value));
 }
 
 /**
- * @brief Creates the primitive type based on the schema
- *
- * @param schema contains schema of the form
- *    {
- *       "type" : "integer"
- *       ...
- *       ...
- *    }
- *
- * @return 
+ * @brief Builds the primitive of a subschema not compiled yet
  */
-JsonPrimitive *JsonPrimitive::createPrimitive(Json::Value *schema)
+static JsonPrimitive *compilePrimitive(Json::Value *schema)
 {
    JsonPrimitiveType type = JsonPrimitive::getPrimitveType(schema);
 
+   // common shapes get a primitive without keyword validator objects
+   JsonPrimitive *primitive = createPolicyPrimitive(schema, type);
+   if (NULL != primitive) {
+      return primitive;
+   }
+
    switch (type) {
       case JSON_TYPE_INTEGER:
          return new JsonInteger(schema);
@@ -132,8 +332,48 @@ JsonPrimitive *JsonPrimitive::createPrimitive(Json::Value *schema)
       case JSON_TYPE_NULL:
          return new JsonNull(schema);
       default:
-         throw Exception("Invalid Schema");
+         JVAL_SCHEMA_ERROR("Invalid Schema");
+         return NULL;
+   }
+}
+
+/**
+ * @brief Creates the primitive type based on the schema, or takes a reference
+ * to the one compiled for an identical subschema earlier
+ *
+ * @param schema contains schema of the form
+ *    {
+ *       "type" : "integer"
+ *       ...
+ *       ...
+ *    }
+ *
+ * @return 
+ */
+JsonPrimitive *JsonPrimitive::createPrimitive(Json::Value *schema)
+{
+   JsonSchemaCache *cache = JsonSchemaCache::current();
+   if (NULL == cache) {
+      JsonSchemaCache compiled;
+      JsonSchemaCache::Scope scope(compiled);
+      JsonPrimitive *primitive = createPrimitive(schema);
+      if (compiled.failed()) {
+         release(primitive);
+         primitive = NULL;
+      }
+      return primitive;
    }
+
+   Json::Value canonical = JsonSchemaCache::canonical(*schema);
+   size_t hash = JsonMemo::hash(canonical);
+
+   JsonPrimitive *primitive = cache->find(canonical, hash);
+   if (NULL == primitive) {
+      primitive = compilePrimitive(schema);
+      cache->insert(canonical, hash, primitive);
+   }
+
+   return primitive;
 }
 
 /**
@@ -150,10 +390,17 @@ JsonPrimitive *JsonPrimitive::createPrimitive(Json::Value *schema)
  */
 JsonPrimitiveType JsonPrimitive::getPrimitveType(Json::Value *schema)
 {
+   if (!schema->isObject()) {
+      JVAL_SCHEMA_ERROR("Schema is not an object");
+      return JSON_TYPE_INVALID;
+   }
+
    if (schema->isMember("type")) {
       Json::Value typeValue = schema->get("type", typeValue);
 
-      if (typeValue.asString() == "integer") {
+      if (!typeValue.isString()) {
+         JVAL_SCHEMA_ERROR("\"type\" is not a string");
+      } else if (typeValue.asString() == "integer") {
          return JSON_TYPE_INTEGER;
       } else if (typeValue.asString() == "number") {
          return JSON_TYPE_NUMBER;
@@ -170,11 +417,13 @@ JsonPrimitiveType JsonPrimitive::getPrimitveType(Json::Value *schema)
       } else {
          std::string err = "Unknown type keyword \"" + \
                             typeValue.asString() + "\"";
-         throw Exception(err);
+         JVAL_SCHEMA_ERROR(err);
       }
    } else {
-      throw Exception("\"type\" keyword is undefined");
+      JVAL_SCHEMA_ERROR("\"type\" keyword is undefined");
    }
+
+   return JSON_TYPE_INVALID;
 }
 
 
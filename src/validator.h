@@ -23,8 +23,18 @@
 #ifndef __VALIDATOR_H__
 #define __VALIDATOR_H__
 
+#include <memory>
 #include <primitive_base.h>
 
+class JsonTape;
+class JsonSkipPlan;
+class JsonProjectionCache;
+class JsonMemoryUsage;
+class JsonBudget;
+class JsonSchemaCache;
+class JsonParallel;
+class JsonWorkerPool;
+
 class JsonValidator
 {
    public:
@@ -41,15 +51,136 @@ class JsonValidator
        */
       void readSchema(const char *schema_file);
 
+      /**
+       * @brief Error of the last schema given, empty if it compiled. Only
+       * builds without exceptions keep one; the others throw Exception.
+       */
+      const std::string &getError() const {return m_error;}
+
+      /**
+       * @brief Never throws nor prints
+       *
+       * @return JVAL_ROK, a JVAL_ERR_* code of the failure, or
+       * JVAL_ERR_INVALID_SCHEMA if there is no valid schema
+       */
       int validate(const Json::Value *value);
 
+      /**
+       * @brief Remembers, for the duration of each validate(const
+       * Json::Value *) call, the results of up to entries distinct
+       * subobjects and subarrays found in items and properties, so repeated
+       * ones are validated once. Off (0) by default; ignored while the
+       * thread already has a JsonMemo::Scope, which then spans the calls.
+       *
+       * @param entries
+       */
+      void setMemoCapacity(size_t entries) {m_memoCapacity = entries;}
+
+      /**
+       * @brief Splits arrays and objects of at least threshold items or
+       * members into chunks validated by the workers of pool alongside the
+       * calling thread; see JsonParallel. The result is the same as without.
+       * Off (NULL) by default; ignored while the thread already has a
+       * JsonParallel::Scope, or a JsonBudget::Scope.
+       *
+       * @param pool outlives the validations, may be shared
+       * @param threshold
+       */
+      void setParallel(JsonWorkerPool *pool, size_t threshold);
+
+      /**
+       * @brief Validates a document parsed into a JsonTape, without building
+       * a Json::Value tree
+       *
+       * @param document
+       *
+       * @return same codes as validate(const Json::Value *)
+       */
+      int validate(const JsonTape *document);
+
+      /**
+       * @brief Validates within a budget of steps, time and cancellation.
+       * Every validate() and revalidate() also spends the budget of the
+       * thread's JsonBudget::Scope, if any.
+       *
+       * @return JVAL_ERR_BUDGET_EXCEEDED once the budget is exceeded, else
+       * same codes as validate(const Json::Value *)
+       */
+      int validate(const Json::Value *value, JsonBudget &budget);
+
+      int validate(const JsonTape *document, JsonBudget &budget);
+
+      /**
+       * @brief Instance locations the schema never looks into, for
+       * JsonTape::parse() to leave them unparsed. The result of validate()
+       * stays the same.
+       *
+       * @return NULL if there is no valid schema
+       */
+      const JsonSkipPlan *skipPlan() const {return m_skipPlan;}
+
+      /**
+       * @brief Re-validates a document which was valid before some edits,
+       * running only the subschemas whose instance locations changed along
+       * with the keywords of their ancestor objects and arrays. The result is
+       * the one validate(const Json::Value *) gives.
+       *
+       * For a JSON Patch pass the "path" of every operation and also the
+       * "from" of a move. Pointers to removed locations are fine.
+       *
+       * @param value the edited document
+       * @param pointers JSON Pointers (RFC 6901) of the changed locations
+       *
+       * @return same codes as validate(const Json::Value *)
+       */
+      int revalidate(const Json::Value *value,
+            const std::vector<std::string> &pointers);
+
+      /**
+       * @brief Validates the locations of a document given as JSON Pointers
+       * only, along with the types of their ancestors; see JsonProjection.
+       * Every other member and item is skipped, and so are the locations the
+       * document does not have. The schema pruned to each set of pointers is
+       * kept for the next calls with the same set.
+       *
+       * @param value
+       * @param pointers JSON Pointers (RFC 6901), "" for the whole document
+       *
+       * @return same codes as validate(const Json::Value *)
+       */
+      int validateProjection(const Json::Value *value,
+            const std::vector<std::string> &pointers);
+
+      /**
+       * @brief Adds the estimated bytes held by the compiled schema, by kind
+       * of node and by schema location
+       */
+      void memoryUsage(JsonMemoryUsage &usage) const;
+
+      /**
+       * @brief Bytes held by the compiled schemas of all the JsonValidator
+       * alive in the process
+       */
+      static size_t totalMemoryUsage();
+
       ~JsonValidator();
 
    private:
 
       void parseSchema(std::string &str);
 
+      void setPrimitive(JsonPrimitive *primitive);
+
+      void setCompiled(JsonPrimitive *primitive, const JsonSchemaCache &cache,
+            const Json::Value &schema);
+
       JsonPrimitive *m_primitive;
+      size_t         m_memoCapacity;
+      size_t         m_memoryUsage;
+      JsonParallel   *m_parallel;
+      JsonSkipPlan   *m_skipPlan;
+      std::unique_ptr<JsonProjectionCache> m_projections;
+      std::string    m_error;
 };
 
 #endif
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <worker_pool.h>
+
+static inline uint64_t elapsedNs(std::chrono::steady_clock::time_point from,
+      std::chrono::steady_clock::time_point to)
+{
+   return static_cast<uint64_t>(
+         std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+JsonWorkerPool::JsonWorkerPool(unsigned int threads, size_t queueDepth)
+{
+   m_queueDepth = queueDepth;
+   m_stopping = false;
+   m_metrics.submitted = 0;
+   m_metrics.rejected = 0;
+   m_metrics.completed = 0;
+   m_metrics.queued = 0;
+   m_metrics.running = 0;
+   m_metrics.queueWaitNs = 0;
+   m_metrics.maxQueueWaitNs = 0;
+   m_metrics.executionNs = 0;
+   m_metrics.maxExecutionNs = 0;
+
+   if (threads == 0) {
+      threads = 1;
+   }
+
+   if (m_queueDepth == 0) {
+      m_queueDepth = 1;
+   }
+
+   for (unsigned int i = 0; i < threads; i++) {
+      m_threads.push_back(std::thread(&JsonWorkerPool::run, this));
+   }
+}
+
+JsonWorkerPool::~JsonWorkerPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+   }
+   m_ready.notify_all();
+
+   for (size_t i = 0; i < m_threads.size(); i++) {
+      m_threads[i].join();
+   }
+}
+
+bool JsonWorkerPool::trySubmit(const Task &task)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_stopping || m_queue.size() >= m_queueDepth) {
+         m_metrics.rejected++;
+         return false;
+      }
+
+      Entry entry;
+      entry.task = task;
+      entry.submitted = Clock::now();
+      m_queue.push_back(entry);
+      m_metrics.submitted++;
+   }
+   m_ready.notify_one();
+
+   return true;
+}
+
+void JsonWorkerPool::submit(const Task &task)
+{
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (m_queue.size() >= m_queueDepth && !m_stopping) {
+         m_room.wait(lock);
+      }
+
+      Entry entry;
+      entry.task = task;
+      entry.submitted = Clock::now();
+      m_queue.push_back(entry);
+      m_metrics.submitted++;
+   }
+   m_ready.notify_one();
+}
+
+void JsonWorkerPool::drain()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   while (!m_queue.empty() || m_metrics.running > 0) {
+      m_idle.wait(lock);
+   }
+}
+
+JsonWorkerPool::Metrics JsonWorkerPool::metrics() const
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   Metrics metrics = m_metrics;
+   metrics.queued = m_queue.size();
+   return metrics;
+}
+
+void JsonWorkerPool::run()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   for (;;) {
+      while (m_queue.empty() && !m_stopping) {
+         m_ready.wait(lock);
+      }
+
+      // queued tasks still run when the pool is being destroyed
+      if (m_queue.empty()) {
+         return;
+      }
+
+      Task task;
+      task.swap(m_queue.front().task);
+      Clock::time_point submitted = m_queue.front().submitted;
+      m_queue.pop_front();
+      m_metrics.running++;
+      lock.unlock();
+      m_room.notify_one();
+
+      Clock::time_point start = Clock::now();
+      task();
+      Clock::time_point end = Clock::now();
+
+      uint64_t wait = elapsedNs(submitted, start);
+      uint64_t execution = elapsedNs(start, end);
+
+      lock.lock();
+      m_metrics.running--;
+      m_metrics.completed++;
+      m_metrics.queueWaitNs += wait;
+      m_metrics.executionNs += execution;
+      if (wait > m_metrics.maxQueueWaitNs) {
+         m_metrics.maxQueueWaitNs = wait;
+      }
+      if (execution > m_metrics.maxExecutionNs) {
+         m_metrics.maxExecutionNs = execution;
+      }
+
+      if (m_queue.empty() && m_metrics.running == 0) {
+         m_idle.notify_all();
+      }
+   }
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads fed from a bounded FIFO queue. A task
+ * submitted while the queue is full is rejected instead of queued, so the
+ * caller sees the backpressure right away and never blocks.
+ */
+class JsonWorkerPool
+{
+   public:
+      typedef std::function<void()> Task;
+
+      /**
+       * @brief Counters since the pool was created. Times are in
+       * nanoseconds; queue wait runs from submission to the start of the
+       * task, execution from its start to its end.
+       */
+      struct Metrics
+      {
+         uint64_t submitted;
+         uint64_t rejected;
+         uint64_t completed;
+         size_t   queued;
+         size_t   running;
+         uint64_t queueWaitNs;
+         uint64_t maxQueueWaitNs;
+         uint64_t executionNs;
+         uint64_t maxExecutionNs;
+      };
+
+      /**
+       * @param threads number of workers, at least one
+       * @param queueDepth maximum number of tasks waiting for a worker, at
+       * least one
+       */
+      JsonWorkerPool(unsigned int threads, size_t queueDepth);
+
+      /**
+       * @brief Runs the tasks still queued, then stops the workers
+       */
+      ~JsonWorkerPool();
+
+      /**
+       * @brief Queues a task for a worker. The task must not throw.
+       *
+       * @return false if the queue is full
+       */
+      bool trySubmit(const Task &task);
+
+      /**
+       * @brief Queues a task, waiting for room in the queue if it is full
+       */
+      void submit(const Task &task);
+
+      /**
+       * @brief Waits until the queue is empty and no task is running
+       */
+      void drain();
+
+      Metrics metrics() const;
+
+      unsigned int threads() const {
+         return static_cast<unsigned int>(m_threads.size());
+      }
+
+      size_t queueDepth() const {return m_queueDepth;}
+
+   private:
+      JsonWorkerPool(const JsonWorkerPool &);
+      JsonWorkerPool &operator=(const JsonWorkerPool &);
+
+      typedef std::chrono::steady_clock Clock;
+
+      struct Entry
+      {
+         Task              task;
+         Clock::time_point submitted;
+      };
+
+      void run();
+
+      std::vector<std::thread>   m_threads;
+      std::deque<Entry>          m_queue;
+      size_t                     m_queueDepth;
+      bool                       m_stopping;
+      mutable std::mutex         m_mutex;
+      std::condition_variable    m_ready;
+      std::condition_variable    m_room;
+      std::condition_variable    m_idle;
+      Metrics                    m_metrics;
+};
+
+#endif
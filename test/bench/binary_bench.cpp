@@ -0,0 +1,285 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * Binary input benchmark: validates MessagePack and CBOR encodings of the
+ * codegen_bench document, once converted to a Json::Value and once read
+ * directly into a JsonTape. The conversion reuses the tape reader and then
+ * builds the Json::Value, so it is a lower bound of what a standalone
+ * converter costs.
+ *
+ *    ./binary_bench [records] [rounds]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <list>
+#include <regex>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <tape.h>
+#include <primitive_base.h>
+#include <validator.h>
+
+static void appendBigEndian(std::string &out, uint64_t value, size_t bytes)
+{
+   for (size_t i = bytes; i > 0; i--) {
+      out += static_cast<char>((value >> (8 * (i - 1))) & 0xFF);
+   }
+}
+
+static void appendHead(std::string &out, unsigned char small, unsigned char base,
+      uint64_t n)
+{
+   if (n < 16) {
+      out += static_cast<char>(small | n);
+   } else {
+      out += static_cast<char>(base);
+      appendBigEndian(out, n, 4);
+   }
+}
+
+/**
+ * @brief Encodes the benchmark document, which holds no negative number
+ */
+static void encodeMessagePack(const Json::Value &value, std::string &out)
+{
+   uint64_t bits;
+   double d;
+   switch (value.type()) {
+      case Json::nullValue:
+         out += '\xC0';
+         break;
+      case Json::booleanValue:
+         out += value.asBool() ? '\xC3' : '\xC2';
+         break;
+      case Json::intValue:
+      case Json::uintValue:
+         out += '\xCF';
+         appendBigEndian(out, value.asUInt64(), 8);
+         break;
+      case Json::realValue:
+         d = value.asDouble();
+         memcpy(&bits, &d, sizeof(bits));
+         out += '\xCB';
+         appendBigEndian(out, bits, 8);
+         break;
+      case Json::stringValue:
+         out += '\xDB';
+         appendBigEndian(out, value.asString().size(), 4);
+         out += value.asString();
+         break;
+      case Json::arrayValue:
+         appendHead(out, 0x90, 0xDD, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeMessagePack(*itr, out);
+         }
+         break;
+      case Json::objectValue:
+         appendHead(out, 0x80, 0xDF, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeMessagePack(Json::Value(itr.name()), out);
+            encodeMessagePack(*itr, out);
+         }
+         break;
+   }
+}
+
+static void appendCborHead(std::string &out, unsigned int major, uint64_t n)
+{
+   if (n < 24) {
+      out += static_cast<char>((major << 5) | n);
+   } else {
+      out += static_cast<char>((major << 5) | 27);
+      appendBigEndian(out, n, 8);
+   }
+}
+
+static void encodeCbor(const Json::Value &value, std::string &out)
+{
+   uint64_t bits;
+   double d;
+   switch (value.type()) {
+      case Json::nullValue:
+         out += '\xF6';
+         break;
+      case Json::booleanValue:
+         out += value.asBool() ? '\xF5' : '\xF4';
+         break;
+      case Json::intValue:
+      case Json::uintValue:
+         appendCborHead(out, 0, value.asUInt64());
+         break;
+      case Json::realValue:
+         d = value.asDouble();
+         memcpy(&bits, &d, sizeof(bits));
+         out += '\xFB';
+         appendBigEndian(out, bits, 8);
+         break;
+      case Json::stringValue:
+         appendCborHead(out, 3, value.asString().size());
+         out += value.asString();
+         break;
+      case Json::arrayValue:
+         appendCborHead(out, 4, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeCbor(*itr, out);
+         }
+         break;
+      case Json::objectValue:
+         appendCborHead(out, 5, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeCbor(Json::Value(itr.name()), out);
+            encodeCbor(*itr, out);
+         }
+         break;
+   }
+}
+
+/**
+ * @brief The conversion step of the current pipeline
+ */
+static void toValue(const JsonTapeValue &tape, Json::Value &out)
+{
+   switch (tape.type()) {
+      case Json::nullValue:
+         out = Json::Value();
+         break;
+      case Json::booleanValue:
+         out = tape.asBool();
+         break;
+      case Json::intValue:
+         out = static_cast<Json::Int64>(tape.asInt64());
+         break;
+      case Json::uintValue:
+         out = static_cast<Json::UInt64>(tape.asUInt64());
+         break;
+      case Json::realValue:
+         out = tape.asDouble();
+         break;
+      case Json::stringValue:
+         out = tape.asString();
+         break;
+      case Json::arrayValue:
+         out = Json::Value(Json::arrayValue);
+         for (JsonTapeValue::const_iterator itr = tape.begin();
+               itr != tape.end(); ++itr) {
+            toValue(*itr, out.append(Json::Value()));
+         }
+         break;
+      case Json::objectValue:
+         out = Json::Value(Json::objectValue);
+         for (JsonTapeValue::const_iterator itr = tape.begin();
+               itr != tape.end(); ++itr) {
+            const char *end = NULL;
+            const char *name = itr.memberName(&end);
+            toValue(*itr, out[std::string(name, end)]);
+         }
+         break;
+   }
+}
+
+typedef bool (JsonTape::*TapeReader)(const char *begin, const char *end);
+
+static int run(JsonValidator &validator, const std::string &buffer,
+      TapeReader reader, const char *format, int rounds)
+{
+   typedef std::chrono::steady_clock clock;
+   double converted = 0;
+   double direct = 0;
+   const char *begin = buffer.data();
+   const char *end = begin + buffer.size();
+
+   for (int i = 0; i < rounds; i++) {
+      clock::time_point t0 = clock::now();
+      JsonTape scratch;
+      (scratch.*reader)(begin, end);
+      Json::Value value;
+      toValue(scratch.root(), value);
+      int a = validator.validate(&value);
+      clock::time_point t1 = clock::now();
+      JsonTape tape;
+      (tape.*reader)(begin, end);
+      int b = validator.validate(&tape);
+      clock::time_point t2 = clock::now();
+
+      if (a != b) {
+         std::cerr << "result mismatch " << a << " != " << b << std::endl;
+         return 1;
+      }
+
+      converted += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      direct += std::chrono::duration<double, std::milli>(t2 - t1).count();
+   }
+
+   std::cout << format << ": " << buffer.size() << " bytes" << std::endl;
+   std::cout << "   convert + validate:  " << converted / rounds << " ms"
+      << std::endl;
+   std::cout << "   direct validation:   " << direct / rounds << " ms"
+      << std::endl;
+   return 0;
+}
+
+int main(int argc, char *argv[])
+{
+   int records = argc > 1 ? atoi(argv[1]) : 20000;
+   int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+   JsonValidator validator;
+   validator.readSchema("codegen_schema.json");
+
+   Json::Value doc(Json::arrayValue);
+   for (int i = 0; i < records; i++) {
+      Json::Value r(Json::objectValue);
+      r["id"] = i;
+      r["sku"] = "SKU-" + std::to_string(i);
+      r["price"] = (i % 1000) * 1.25;
+      r["stock"] = i % 500;
+      r["active"] = (i % 2) == 0;
+      for (int t = 0; t < 3; t++) {
+         r["tags"].append("tag" + std::to_string(t));
+      }
+      r["dimensions"]["w"] = 1.5;
+      r["dimensions"]["h"] = 2;
+      doc.append(r);
+   }
+
+   std::string msgpack;
+   encodeMessagePack(doc, msgpack);
+   std::string cbor;
+   encodeCbor(doc, cbor);
+
+   std::cout << "document: " << records << " records" << std::endl;
+   if (run(validator, msgpack, &JsonTape::parseMessagePack, "MessagePack",
+            rounds) != 0) {
+      return 1;
+   }
+   return run(validator, cbor, &JsonTape::parseCbor, "CBOR", rounds);
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * Code generator benchmark: validates the same document with JsonValidator
+ * and with the function jval-codegen generated from codegen_schema.json.
+ *
+ *    ./codegen_bench [records] [rounds]
+ */
+
+#include <stdlib.h>
+#include <fstream>
+#include <list>
+#include <regex>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <primitive_base.h>
+#include <validator.h>
+
+int codegen_bench_validate(const Json::Value *value);
+
+int main(int argc, char *argv[])
+{
+   int records = argc > 1 ? atoi(argv[1]) : 20000;
+   int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+   JsonValidator validator;
+   validator.readSchema("codegen_schema.json");
+
+   Json::Value doc(Json::arrayValue);
+   for (int i = 0; i < records; i++) {
+      Json::Value r(Json::objectValue);
+      r["id"] = i;
+      r["sku"] = "SKU-" + std::to_string(i);
+      r["price"] = (i % 1000) * 1.25;
+      r["stock"] = i % 500;
+      r["active"] = (i % 2) == 0;
+      for (int t = 0; t < 3; t++) {
+         r["tags"].append("tag" + std::to_string(t));
+      }
+      r["dimensions"]["w"] = 1.5;
+      r["dimensions"]["h"] = 2;
+      doc.append(r);
+   }
+
+   typedef std::chrono::steady_clock clock;
+   double interpreted = 0;
+   double generated = 0;
+
+   for (int i = 0; i < rounds; i++) {
+      clock::time_point t0 = clock::now();
+      int a = validator.validate(&doc);
+      clock::time_point t1 = clock::now();
+      int b = codegen_bench_validate(&doc);
+      clock::time_point t2 = clock::now();
+
+      if (a != b) {
+         std::cerr << "result mismatch " << a << " != " << b << std::endl;
+         return 1;
+      }
+
+      interpreted += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      generated += std::chrono::duration<double, std::milli>(t2 - t1).count();
+   }
+
+   std::cout << "document: " << records << " records" << std::endl;
+   std::cout << "JsonValidator:  " << interpreted / rounds << " ms" << std::endl;
+   std::cout << "jval-codegen:   " << generated / rounds << " ms" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * Edit latency benchmark: applies single JSON Patch style edits to a large
+ * document and compares full validation with JsonValidator::revalidate.
+ *
+ *    ./edit_latency [records] [edits]
+ */
+
+#include <stdlib.h>
+#include <list>
+#include <regex>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <primitive_base.h>
+#include <validator.h>
+
+static const char *schema = "{\"type\": \"object\", "
+   "\"required\": [\"name\", \"records\"], \"properties\": {"
+   "\"name\": {\"type\": \"string\"}, "
+   "\"records\": {\"type\": \"array\", \"items\": {\"type\": \"object\", "
+   "\"required\": [\"id\", \"score\", \"tags\"], "
+   "\"properties\": {"
+   "\"id\": {\"type\": \"integer\", \"minimum\": 0}, "
+   "\"score\": {\"type\": \"number\", \"maximum\": 100}, "
+   "\"label\": {\"type\": \"string\", \"pattern\": \"^[a-z]+$\", "
+   "\"maxLength\": 16}, "
+   "\"tags\": {\"type\": \"array\", \"maxItems\": 8, "
+   "\"items\": {\"type\": \"string\", \"minLength\": 1}}}}}}}";
+
+static Json::Value record(int id)
+{
+   Json::Value r(Json::objectValue);
+   r["id"] = id;
+   r["score"] = (id % 200) * 0.5;
+   r["label"] = "record";
+   for (int i = 0; i < 4; i++) {
+      r["tags"].append("tag" + std::to_string(i));
+   }
+   return r;
+}
+
+int main(int argc, char *argv[])
+{
+   int records = argc > 1 ? atoi(argv[1]) : 20000;
+   int edits = argc > 2 ? atoi(argv[2]) : 200;
+
+   std::string str(schema);
+   JsonValidator validator(str);
+
+   Json::Value doc(Json::objectValue);
+   doc["name"] = "bench";
+   for (int i = 0; i < records; i++) {
+      doc["records"].append(record(i));
+   }
+
+   Json::FastWriter writer;
+   size_t bytes = writer.write(doc).size();
+
+   typedef std::chrono::steady_clock clock;
+   double full = 0;
+   double incremental = 0;
+
+   srand(1);
+   for (int i = 0; i < edits; i++) {
+      int index = rand() % records;
+      std::vector<std::string> pointers;
+      pointers.push_back("/records/" + std::to_string(index) + "/score");
+      doc["records"][index]["score"] = (rand() % 200) * 0.5;
+
+      clock::time_point t0 = clock::now();
+      int a = validator.validate(&doc);
+      clock::time_point t1 = clock::now();
+      int b = validator.revalidate(&doc, pointers);
+      clock::time_point t2 = clock::now();
+
+      if (a != b) {
+         std::cerr << "result mismatch " << a << " != " << b << std::endl;
+         return 1;
+      }
+
+      full += std::chrono::duration<double, std::micro>(t1 - t0).count();
+      incremental += std::chrono::duration<double, std::micro>(t2 - t1).count();
+   }
+
+   std::cout << "document: " << records << " records, " << bytes << " bytes"
+      << std::endl;
+   std::cout << "full validate:  " << full / edits << " us/edit" << std::endl;
+   std::cout << "revalidate:     " << incremental / edits << " us/edit"
+      << std::endl;
+
+   return 0;
+}
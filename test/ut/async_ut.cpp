@@ -0,0 +1,239 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <atomic>
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "tape.h"
+#include "primitive_base.h"
+#include "validator.h"
+#include "worker_pool.h"
+#include "async_validator.h"
+
+// worker task waiting until the test releases it
+class BlockingTask
+{
+   public:
+      BlockingTask(std::shared_future<void> gate, std::atomic<int> *started) :
+         m_gate(gate), m_started(started) {}
+
+      void operator()() {
+         (*m_started)++;
+         m_gate.wait();
+      }
+
+      void operator()(const JsonAsyncResult &) {
+         (*this)();
+      }
+
+   private:
+      std::shared_future<void>   m_gate;
+      std::atomic<int>           *m_started;
+};
+
+class CountingCallback
+{
+   public:
+      CountingCallback(std::atomic<int> *valid, std::atomic<int> *invalid) :
+         m_valid(valid), m_invalid(invalid) {}
+
+      void operator()(const JsonAsyncResult &result) {
+         if (result.result == JVAL_ROK) {
+            (*m_valid)++;
+         } else {
+            (*m_invalid)++;
+         }
+      }
+
+   private:
+      std::atomic<int> *m_valid;
+      std::atomic<int> *m_invalid;
+};
+
+static void waitStarted(const std::atomic<int> &started, int count)
+{
+   while (started < count) {
+      std::this_thread::yield();
+   }
+}
+
+TEST(JsonWorkerPool, RejectsWhenFull)
+{
+   std::promise<void> release;
+   std::shared_future<void> gate = release.get_future().share();
+   std::atomic<int> started(0);
+
+   JsonWorkerPool pool(1, 2);
+   ASSERT_TRUE(pool.trySubmit(BlockingTask(gate, &started)));
+   waitStarted(started, 1);
+
+   ASSERT_TRUE(pool.trySubmit(BlockingTask(gate, &started)));
+   ASSERT_TRUE(pool.trySubmit(BlockingTask(gate, &started)));
+   ASSERT_FALSE(pool.trySubmit(BlockingTask(gate, &started)));
+
+   JsonWorkerPool::Metrics metrics = pool.metrics();
+   ASSERT_EQ(metrics.submitted, 3U);
+   ASSERT_EQ(metrics.rejected, 1U);
+   ASSERT_EQ(metrics.queued, 2U);
+   ASSERT_EQ(metrics.running, 1U);
+
+   release.set_value();
+   pool.drain();
+
+   metrics = pool.metrics();
+   ASSERT_EQ(metrics.completed, 3U);
+   ASSERT_EQ(metrics.queued, 0U);
+   ASSERT_EQ(metrics.running, 0U);
+   ASSERT_GE(metrics.executionNs, metrics.maxExecutionNs);
+   ASSERT_GE(metrics.queueWaitNs, metrics.maxQueueWaitNs);
+   ASSERT_GT(metrics.maxQueueWaitNs, 0U);
+}
+
+TEST(JsonWorkerPool, SubmitWaitsForRoom)
+{
+   std::promise<void> release;
+   std::shared_future<void> gate = release.get_future().share();
+   std::atomic<int> started(0);
+
+   JsonWorkerPool pool(1, 1);
+   pool.submit(BlockingTask(gate, &started));
+   waitStarted(started, 1);
+   pool.submit(BlockingTask(gate, &started));
+
+   // the queue is full, the third submission waits for the worker
+   std::thread producer(&JsonWorkerPool::submit, &pool,
+         JsonWorkerPool::Task(BlockingTask(gate, &started)));
+   ASSERT_EQ(pool.metrics().submitted, 2U);
+
+   release.set_value();
+   producer.join();
+   pool.drain();
+   ASSERT_EQ(pool.metrics().completed, 3U);
+   ASSERT_EQ(pool.metrics().rejected, 0U);
+}
+
+TEST(JsonWorkerPool, DestructorRunsQueuedTasks)
+{
+   std::promise<void> release;
+   std::shared_future<void> gate = release.get_future().share();
+   std::atomic<int> started(0);
+
+   {
+      JsonWorkerPool pool(2, 8);
+      for (int i = 0; i < 6; i++) {
+         ASSERT_TRUE(pool.trySubmit(BlockingTask(gate, &started)));
+      }
+      release.set_value();
+   }
+
+   ASSERT_EQ(started, 6);
+}
+
+TEST(JsonAsyncValidator, SameResultAsValidate)
+{
+   Json::Value schemaValue = parse(recordSchema);
+   JsonValidator validator(&schemaValue);
+
+   const char *documents[] = {"{\"id\": 1}", "{\"id\": -1}", "{\"tags\": []}",
+      "{\"id\": 2, \"tags\": [\"a\", 3]}", "{\"id\": 3, \"tags\": [\"a\"]}"};
+   std::vector<Json::Value> values;
+   std::vector<JsonTape> tapes(5);
+   for (int i = 0; i < 5; i++) {
+      values.push_back(parse(documents[i]));
+      ASSERT_TRUE(tapes[i].parse(documents[i]));
+   }
+
+   JsonAsyncValidator async(&validator, 4, 1000);
+   std::vector<std::future<JsonAsyncResult> > results;
+   for (int i = 0; i < 500; i++) {
+      results.push_back(async.submit(&values[i % 5]));
+      results.push_back(async.submit(&tapes[i % 5]));
+   }
+
+   for (size_t i = 0; i < results.size(); i++) {
+      ASSERT_TRUE(results[i].valid());
+      JsonAsyncResult result = results[i].get();
+      ASSERT_EQ(result.result, validator.validate(&values[(i / 2) % 5]));
+   }
+
+   JsonWorkerPool::Metrics metrics = async.metrics();
+   ASSERT_EQ(metrics.submitted, 1000U);
+   ASSERT_EQ(metrics.rejected, 0U);
+}
+
+TEST(JsonAsyncValidator, Callbacks)
+{
+   Json::Value schemaValue = parse(recordSchema);
+   JsonValidator validator(&schemaValue);
+   Json::Value valid = parse("{\"id\": 7}");
+   Json::Value invalid = parse("{\"id\": \"7\"}");
+
+   std::atomic<int> validCount(0);
+   std::atomic<int> invalidCount(0);
+   CountingCallback done(&validCount, &invalidCount);
+
+   JsonAsyncValidator async(&validator, 3, 64);
+   int accepted = 0;
+   for (int i = 0; i < 3000; i++) {
+      // retry until the workers make room in the queue
+      while (!async.submit(i % 3 == 0 ? &invalid : &valid, done)) {
+         std::this_thread::yield();
+      }
+      accepted++;
+   }
+   async.drain();
+
+   ASSERT_EQ(validCount, 2000);
+   ASSERT_EQ(invalidCount, 1000);
+   ASSERT_EQ(async.metrics().completed, static_cast<uint64_t>(accepted));
+}
+
+TEST(JsonAsyncValidator, Backpressure)
+{
+   Json::Value schemaValue = parse(recordSchema);
+   JsonValidator validator(&schemaValue);
+   Json::Value document = parse("{\"id\": 1}");
+
+   std::promise<void> release;
+   std::shared_future<void> gate = release.get_future().share();
+   std::atomic<int> started(0);
+
+   // the callback of the first document holds the only worker
+   JsonAsyncValidator async(&validator, 1, 1);
+   ASSERT_TRUE(async.submit(&document, BlockingTask(gate, &started)));
+   waitStarted(started, 1);
+
+   std::future<JsonAsyncResult> queued = async.submit(&document);
+   ASSERT_TRUE(queued.valid());
+   std::future<JsonAsyncResult> refused = async.submit(&document);
+   ASSERT_FALSE(refused.valid());
+
+   release.set_value();
+   ASSERT_EQ(queued.get().result, JVAL_ROK);
+   async.drain();
+   ASSERT_EQ(async.metrics().rejected, 1U);
+}
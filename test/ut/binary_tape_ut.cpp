@@ -0,0 +1,394 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "tape.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+static void appendBigEndian(std::string &out, uint64_t value, size_t bytes)
+{
+   for (size_t i = bytes; i > 0; i--) {
+      out += static_cast<char>((value >> (8 * (i - 1))) & 0xFF);
+   }
+}
+
+static void appendDoubleBits(std::string &out, double d)
+{
+   uint64_t bits;
+   memcpy(&bits, &d, sizeof(bits));
+   appendBigEndian(out, bits, 8);
+}
+
+/**
+ * @brief MessagePack encoder using the smallest forms, so that decoding
+ * covers every size class
+ */
+static void encodeMessagePack(const Json::Value &value, std::string &out)
+{
+   switch (value.type()) {
+      case Json::nullValue:
+         out += '\xC0';
+         break;
+      case Json::booleanValue:
+         out += value.asBool() ? '\xC3' : '\xC2';
+         break;
+      case Json::intValue:
+      case Json::uintValue:
+         if (value.isInt64() && value.asInt64() < 0) {
+            int64_t i = value.asInt64();
+            if (i >= -32) {
+               out += static_cast<char>(i);
+            } else if (i >= INT8_MIN) {
+               out += '\xD0';
+               appendBigEndian(out, static_cast<uint64_t>(i), 1);
+            } else if (i >= INT16_MIN) {
+               out += '\xD1';
+               appendBigEndian(out, static_cast<uint64_t>(i), 2);
+            } else if (i >= INT32_MIN) {
+               out += '\xD2';
+               appendBigEndian(out, static_cast<uint64_t>(i), 4);
+            } else {
+               out += '\xD3';
+               appendBigEndian(out, static_cast<uint64_t>(i), 8);
+            }
+         } else {
+            uint64_t u = value.asUInt64();
+            if (u < 128) {
+               out += static_cast<char>(u);
+            } else if (u <= 0xFF) {
+               out += '\xCC';
+               appendBigEndian(out, u, 1);
+            } else if (u <= 0xFFFF) {
+               out += '\xCD';
+               appendBigEndian(out, u, 2);
+            } else if (u <= 0xFFFFFFFFULL) {
+               out += '\xCE';
+               appendBigEndian(out, u, 4);
+            } else {
+               out += '\xCF';
+               appendBigEndian(out, u, 8);
+            }
+         }
+         break;
+      case Json::realValue:
+         out += '\xCB';
+         appendDoubleBits(out, value.asDouble());
+         break;
+      case Json::stringValue: {
+         std::string s = value.asString();
+         if (s.size() < 32) {
+            out += static_cast<char>(0xA0 | s.size());
+         } else if (s.size() <= 0xFF) {
+            out += '\xD9';
+            appendBigEndian(out, s.size(), 1);
+         } else {
+            out += '\xDA';
+            appendBigEndian(out, s.size(), 2);
+         }
+         out += s;
+         break;
+      }
+      case Json::arrayValue:
+         if (value.size() < 16) {
+            out += static_cast<char>(0x90 | value.size());
+         } else {
+            out += '\xDC';
+            appendBigEndian(out, value.size(), 2);
+         }
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeMessagePack(*itr, out);
+         }
+         break;
+      case Json::objectValue:
+         if (value.size() < 16) {
+            out += static_cast<char>(0x80 | value.size());
+         } else {
+            out += '\xDE';
+            appendBigEndian(out, value.size(), 2);
+         }
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeMessagePack(Json::Value(itr.name()), out);
+            encodeMessagePack(*itr, out);
+         }
+         break;
+   }
+}
+
+static void appendCborHead(std::string &out, unsigned int major, uint64_t n)
+{
+   char type = static_cast<char>(major << 5);
+   if (n < 24) {
+      out += static_cast<char>(type | n);
+   } else if (n <= 0xFF) {
+      out += static_cast<char>(type | 24);
+      appendBigEndian(out, n, 1);
+   } else if (n <= 0xFFFF) {
+      out += static_cast<char>(type | 25);
+      appendBigEndian(out, n, 2);
+   } else if (n <= 0xFFFFFFFFULL) {
+      out += static_cast<char>(type | 26);
+      appendBigEndian(out, n, 4);
+   } else {
+      out += static_cast<char>(type | 27);
+      appendBigEndian(out, n, 8);
+   }
+}
+
+static void encodeCbor(const Json::Value &value, std::string &out)
+{
+   switch (value.type()) {
+      case Json::nullValue:
+         out += '\xF6';
+         break;
+      case Json::booleanValue:
+         out += value.asBool() ? '\xF5' : '\xF4';
+         break;
+      case Json::intValue:
+      case Json::uintValue:
+         if (value.isInt64() && value.asInt64() < 0) {
+            appendCborHead(out, 1, ~static_cast<uint64_t>(value.asInt64()));
+         } else {
+            appendCborHead(out, 0, value.asUInt64());
+         }
+         break;
+      case Json::realValue:
+         out += '\xFB';
+         appendDoubleBits(out, value.asDouble());
+         break;
+      case Json::stringValue:
+         appendCborHead(out, 3, value.asString().size());
+         out += value.asString();
+         break;
+      case Json::arrayValue:
+         appendCborHead(out, 4, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeCbor(*itr, out);
+         }
+         break;
+      case Json::objectValue:
+         appendCborHead(out, 5, value.size());
+         for (Json::Value::const_iterator itr = value.begin();
+               itr != value.end(); itr++) {
+            encodeCbor(Json::Value(itr.name()), out);
+            encodeCbor(*itr, out);
+         }
+         break;
+   }
+}
+
+static bool parseMessagePack(JsonTape &tape, const std::string &buffer)
+{
+   return tape.parseMessagePack(buffer.data(), buffer.data() + buffer.size());
+}
+
+static bool parseCbor(JsonTape &tape, const std::string &buffer)
+{
+   return tape.parseCbor(buffer.data(), buffer.data() + buffer.size());
+}
+
+TEST(BinaryTape, SameTapeAsText)
+{
+   const char *documents[] = {
+      "null", "true", "[false, 0, 127, 128, 255, 256, 65535, 65536]",
+      "[-1, -32, -33, -128, -129, -32768, -32769, -2147483648, -2147483649]",
+      "[2147483647, 2147483648, 4294967296, 9223372036854775807, "
+      "18446744073709551615, -9223372036854775808]",
+      "[0.5, -1e300, 3.0]",
+      "{\"\": \"\", \"a\": {\"b\": [1, {\"c\": null}]}, \"e\\u00e9\": []}",
+      "[\"0123456789012345678901234567890123456789\", "
+      "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17]]",
+      "{\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, "
+      "\"k6\": 6, \"k7\": 7, \"k8\": 8, \"k9\": 9, \"ka\": 10, \"kb\": 11, "
+      "\"kc\": 12, \"kd\": 13, \"ke\": 14, \"kf\": 15, \"kg\": 16}"
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      Json::Reader reader;
+      Json::Value value;
+      ASSERT_TRUE(reader.parse(documents[i], value)) << documents[i];
+
+      JsonTape text;
+      ASSERT_TRUE(text.parse(documents[i]));
+
+      std::string msgpack;
+      encodeMessagePack(value, msgpack);
+      JsonTape fromMessagePack;
+      ASSERT_TRUE(parseMessagePack(fromMessagePack, msgpack))
+         << fromMessagePack.getError();
+      // operator== tells int, uint and double apart
+      ASSERT_TRUE(fromMessagePack.root() == text.root()) << documents[i];
+
+      std::string cbor;
+      encodeCbor(value, cbor);
+      JsonTape fromCbor;
+      ASSERT_TRUE(parseCbor(fromCbor, cbor)) << fromCbor.getError();
+      ASSERT_TRUE(fromCbor.root() == text.root()) << documents[i];
+   }
+}
+
+TEST(BinaryTape, StringsInPlace)
+{
+   std::string msgpack("\x91\xA3" "abc", 5);
+   JsonTape tape;
+   ASSERT_TRUE(parseMessagePack(tape, msgpack));
+
+   const char *begin = NULL;
+   const char *end = NULL;
+   ASSERT_TRUE((*tape.root().begin()).getString(&begin, &end));
+   ASSERT_EQ(begin, msgpack.data() + 2);
+   ASSERT_EQ(end, msgpack.data() + 5);
+}
+
+TEST(BinaryTape, CborEncodings)
+{
+   // half, single and double precision floats
+   std::string floats("\x83\xF9\x3E\x00\xFA\x3F\xC0\x00\x00"
+         "\xFB\x3F\xF8\x00\x00\x00\x00\x00\x00", 18);
+   JsonTape tape;
+   ASSERT_TRUE(parseCbor(tape, floats)) << tape.getError();
+   JsonTapeValue root = tape.root();
+   ASSERT_EQ(root.size(), 3U);
+   for (JsonTapeValue::const_iterator itr = root.begin(); itr != root.end();
+         ++itr) {
+      ASSERT_TRUE((*itr).isDouble());
+      ASSERT_EQ((*itr).asDouble(), 1.5);
+   }
+
+   // indefinite array, indefinite map with a chunked key and value, and a
+   // tagged epoch time
+   std::string indefinite("\x9F\x01\xBF\x7F\x61k\x62\x65y\xFF\x7F\x61v\xFF"
+         "\x61t\xC1\x1A\x5A\x00\x00\x00\xFF\xFF", 24);
+   ASSERT_TRUE(parseCbor(tape, indefinite)) << tape.getError();
+   JsonTape expected;
+   ASSERT_TRUE(expected.parse("[1, {\"key\": \"v\", \"t\": 1509949440}]"));
+   ASSERT_TRUE(tape.root() == expected.root());
+
+   // -1 - (2^64 - 1) is out of the int64 range
+   std::string negative("\x3B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 9);
+   ASSERT_TRUE(parseCbor(tape, negative));
+   ASSERT_TRUE(tape.root().isDouble());
+   ASSERT_EQ(tape.root().asDouble(), -18446744073709551616.0);
+}
+
+TEST(BinaryTape, Errors)
+{
+   std::string deep(2000, '\x91');
+   deep += '\xC0';
+
+   const std::string msgpack[] = {
+      std::string(),
+      std::string("\x92\x01", 2),
+      std::string("\xA3" "ab", 3),
+      std::string("\xC4\x01\x00", 3),
+      std::string("\xD4\x01\x00", 3),
+      std::string("\xC1", 1),
+      std::string("\x81\x01\x02", 3),
+      std::string("\xDD\xFF\xFF\xFF\xFF\x01", 6),
+      std::string("\x01\x02", 2),
+      std::string("\xCB\x00", 2),
+      deep
+   };
+
+   for (size_t i = 0; i < sizeof(msgpack) / sizeof(msgpack[0]); i++) {
+      JsonTape tape;
+      ASSERT_FALSE(parseMessagePack(tape, msgpack[i])) << i;
+      ASSERT_FALSE(tape.getError().empty());
+      ASSERT_FALSE(tape.root().isValid());
+   }
+
+   std::string cborDeep(2000, '\x81');
+   cborDeep += '\xF6';
+
+   const std::string cbor[] = {
+      std::string(),
+      std::string("\x82\x01", 2),
+      std::string("\x41" "a", 2),
+      std::string("\xF7", 1),
+      std::string("\xFF", 1),
+      std::string("\x1C", 1),
+      std::string("\xA1\x01\x02", 3),
+      std::string("\x7F\x41" "a\xFF", 4),
+      std::string("\x9F\x01", 2),
+      std::string("\x9B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x01", 10),
+      std::string("\x01\x02", 2),
+      cborDeep
+   };
+
+   for (size_t i = 0; i < sizeof(cbor) / sizeof(cbor[0]); i++) {
+      JsonTape tape;
+      ASSERT_FALSE(parseCbor(tape, cbor[i])) << i;
+      ASSERT_FALSE(tape.getError().empty());
+   }
+}
+
+TEST(BinaryTapeValidation, SameResultAsValue)
+{
+   std::string schema("{\"type\": \"object\", \"required\": [\"id\"], "
+      "\"additionalProperties\": false, \"properties\": {"
+      "\"id\": {\"type\": \"integer\", \"minimum\": 1, \"maximum\": 100}, "
+      "\"name\": {\"type\": \"string\", \"minLength\": 2, \"pattern\": \"^[a-z]+$\"}, "
+      "\"tags\": {\"type\": \"array\", \"items\": {\"type\": \"number\", "
+      "\"multipleOf\": 0.5}, \"uniqueItems\": true}}}");
+   JsonValidator validator(schema);
+
+   const char *documents[] = {
+      "{\"id\": 1}",
+      "{\"id\": 0}",
+      "{\"id\": 1.5}",
+      "{\"name\": \"abc\"}",
+      "{\"id\": 2, \"name\": \"a\"}",
+      "{\"id\": 2, \"name\": \"ABC\"}",
+      "{\"id\": 2, \"tags\": [0.5, 1, 1.5]}",
+      "{\"id\": 2, \"tags\": [0.5, 0.5]}",
+      "{\"id\": 2, \"tags\": [0.5, 0.7]}",
+      "{\"id\": 2, \"other\": 1}",
+      "[]"
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      Json::Reader reader;
+      Json::Value value;
+      ASSERT_TRUE(reader.parse(documents[i], value));
+      int expected = validator.validate(&value);
+
+      std::string msgpack;
+      encodeMessagePack(value, msgpack);
+      JsonTape tape;
+      ASSERT_TRUE(parseMessagePack(tape, msgpack));
+      ASSERT_EQ(validator.validate(&tape), expected) << documents[i];
+
+      std::string cbor;
+      encodeCbor(value, cbor);
+      ASSERT_TRUE(parseCbor(tape, cbor));
+      ASSERT_EQ(validator.validate(&tape), expected) << documents[i];
+   }
+}
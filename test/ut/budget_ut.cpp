@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "tape.h"
+#include "memo.h"
+#include "budget.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+// [0, 1, ..., count - 1]
+static std::string integers(int count)
+{
+   std::ostringstream text;
+   text << "[";
+   for (int i = 0; i < count; i++) {
+      text << (i ? ", " : "") << i;
+   }
+   text << "]";
+   return text.str();
+}
+
+TEST(JsonBudget, Steps)
+{
+   std::string schema = "{\"type\": \"array\", "
+      "\"items\": {\"type\": \"integer\"}}";
+   JsonValidator validator(schema);
+   Json::Value value = parse(integers(1000));
+
+   JsonBudget unlimited;
+   ASSERT_EQ(validator.validate(&value, unlimited), JVAL_ROK);
+   ASSERT_EQ(unlimited.used(), 1000U);
+   ASSERT_FALSE(unlimited.exceeded());
+
+   JsonBudget enough;
+   enough.setSteps(1000);
+   ASSERT_EQ(validator.validate(&value, enough), JVAL_ROK);
+
+   JsonBudget small;
+   small.setSteps(10);
+   ASSERT_EQ(validator.validate(&value, small), JVAL_ERR_BUDGET_EXCEEDED);
+   ASSERT_EQ(small.used(), 10U);
+   ASSERT_TRUE(small.exceeded());
+
+   // an exceeded budget stays exceeded
+   ASSERT_EQ(validator.validate(&value, small), JVAL_ERR_BUDGET_EXCEEDED);
+
+   // no budget once the scope is gone
+   ASSERT_TRUE(NULL == JsonBudget::current());
+   ASSERT_EQ(validator.validate(&value), JVAL_ROK);
+}
+
+TEST(JsonBudget, Nested)
+{
+   std::string schema = "{\"type\": \"object\", "
+      "\"additionalProperties\": false, \"properties\": {"
+      "\"pairs\": {\"type\": \"array\", \"items\": {\"type\": \"array\", "
+      "\"items\": [{\"type\": \"string\"}, {\"type\": \"integer\"}]}}}}";
+   JsonValidator validator(schema);
+   Json::Value value = parse("{\"pairs\": [[\"a\", 1], [\"b\", 2], "
+         "[\"c\", 3]]}");
+
+   JsonBudget budget;
+   ASSERT_EQ(validator.validate(&value, budget), JVAL_ROK);
+   // a member, three items and two per tuple
+   ASSERT_EQ(budget.used(), 10U);
+
+   // the keyword which ran out is not the failure reported
+   JsonBudget small;
+   small.setSteps(5);
+   ASSERT_EQ(validator.validate(&value, small), JVAL_ERR_BUDGET_EXCEEDED);
+
+   // a scope of the caller works as well
+   JsonBudget scoped;
+   scoped.setSteps(5);
+   JsonBudget::Scope scope(scoped);
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_BUDGET_EXCEEDED);
+   std::vector<std::string> pointers(1, "/pairs/2/1");
+   ASSERT_EQ(validator.revalidate(&value, pointers),
+         JVAL_ERR_BUDGET_EXCEEDED);
+}
+
+TEST(JsonBudget, UniqueItems)
+{
+   std::string schema = "{\"type\": \"array\", \"uniqueItems\": true}";
+   JsonValidator validator(schema);
+   std::string text = integers(10000);
+   Json::Value value = parse(text);
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(text.c_str()));
+
+   JsonBudget budget;
+   budget.setSteps(100);
+   ASSERT_EQ(validator.validate(&value, budget), JVAL_ERR_BUDGET_EXCEEDED);
+
+   JsonBudget tapeBudget;
+   tapeBudget.setSteps(100);
+   ASSERT_EQ(validator.validate(&tape, tapeBudget), JVAL_ERR_BUDGET_EXCEEDED);
+
+   JsonBudget unlimited;
+   ASSERT_EQ(validator.validate(&tape, unlimited), JVAL_ROK);
+}
+
+TEST(JsonBudget, DeadlineAndCancel)
+{
+   std::string schema = "{\"type\": \"array\", "
+      "\"items\": {\"type\": \"integer\"}}";
+   JsonValidator validator(schema);
+   Json::Value value = parse(integers(1000));
+
+   JsonBudget late;
+   late.setDeadline(JsonBudget::Clock::now());
+   ASSERT_EQ(validator.validate(&value, late), JVAL_ERR_BUDGET_EXCEEDED);
+   ASSERT_EQ(late.used(), (size_t)JVAL_BUDGET_POLL_STEPS);
+
+   JsonBudget early;
+   early.setDeadline(JsonBudget::Clock::now() + std::chrono::hours(1));
+   ASSERT_EQ(validator.validate(&value, early), JVAL_ROK);
+
+   std::atomic<bool> cancel(false);
+   JsonBudget cancellable;
+   cancellable.setCancel(&cancel);
+   ASSERT_EQ(validator.validate(&value, cancellable), JVAL_ROK);
+
+   cancel = true;
+   JsonBudget cancelled;
+   cancelled.setCancel(&cancel);
+   ASSERT_EQ(validator.validate(&value, cancelled), JVAL_ERR_BUDGET_EXCEEDED);
+}
+
+TEST(JsonBudget, Memo)
+{
+   std::string schema = "{\"type\": \"array\", \"items\": {\"type\": "
+      "\"array\", \"items\": {\"type\": \"integer\"}}}";
+   JsonValidator validator(schema);
+   std::string row = integers(100);
+   Json::Value value = parse("[" + row + ", " + row + "]");
+
+   JsonMemo memo(16, true);
+   JsonMemo::Scope scope(memo);
+
+   JsonBudget budget;
+   budget.setSteps(50);
+   ASSERT_EQ(validator.validate(&value, budget), JVAL_ERR_BUDGET_EXCEEDED);
+
+   // the row cut short was not remembered
+   ASSERT_EQ(memo.size(), 0U);
+   ASSERT_EQ(validator.validate(&value), JVAL_ROK);
+   ASSERT_EQ(memo.hits(), 1U);
+}
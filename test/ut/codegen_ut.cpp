@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <fstream>
+#include <list>
+#include <regex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "primitive_base.h"
+#include "codegen.h"
+#include "validator.h"
+
+// built by the Makefile from codegen_schema.json with jval-codegen
+int codegen_validate(const Json::Value *value);
+
+static Json::Value readSchema()
+{
+   std::ifstream t("codegen_schema.json");
+   std::string str((std::istreambuf_iterator<char>(t)),
+         std::istreambuf_iterator<char>());
+
+   Json::Reader reader;
+   Json::Value schema;
+   EXPECT_TRUE(reader.parse(str.c_str(), schema));
+   return schema;
+}
+
+/**
+ * @brief Random instances which mostly follow the schema, so that both the
+ * valid documents and every kind of violation show up
+ */
+class RandomInstances
+{
+   public:
+      RandomInstances(unsigned int seed) : m_random(seed) {}
+
+      unsigned int next(unsigned int n) {
+         return std::uniform_int_distribution<unsigned int>(0, n - 1)(m_random);
+      }
+
+      Json::Value any() {
+         switch (next(7)) {
+            case 0: return Json::Value();
+            case 1: return Json::Value(next(2) == 1);
+            case 2: return Json::Value(static_cast<int>(next(50)) - 10);
+            case 3: return Json::Value(next(50) * 0.25 - 1);
+            case 4: return Json::Value(Json::arrayValue);
+            case 5: return Json::Value(Json::objectValue);
+            default: return string();
+         }
+      }
+
+      Json::Value string() {
+         const char *strings[] = {"", "a", "ab", "abc\"", "b?c", "abcabca",
+            "x", "ca", "a\\", "ab\"\""};
+         return Json::Value(strings[next(10)]);
+      }
+
+      Json::Value instance(const Json::Value &schema) {
+         if (next(8) == 0) {
+            return any();
+         }
+
+         std::string type = schema["type"].asString();
+         if (type == "integer") {
+            return Json::Value(static_cast<int>(next(50)) - 6);
+         } else if (type == "number") {
+            return next(3) == 0 ? Json::Value(static_cast<int>(next(12))) : \
+               Json::Value(next(48) * 0.125 + 1);
+         } else if (type == "string") {
+            return string();
+         } else if (type == "boolean") {
+            return Json::Value(next(2) == 1);
+         } else if (type == "null") {
+            return Json::Value();
+         } else if (type == "array") {
+            Json::Value array(Json::arrayValue);
+            const Json::Value &items = schema["items"];
+            for (unsigned int i = next(6); i > 0; i--) {
+               if (items.isArray()) {
+                  array.append(array.size() < items.size() ? \
+                        instance(items[array.size()]) : any());
+               } else {
+                  array.append(instance(items));
+               }
+            }
+            return array;
+         }
+
+         Json::Value object(Json::objectValue);
+         const Json::Value &properties = schema["properties"];
+         std::vector<std::string> names = properties.getMemberNames();
+         for (size_t i = 0; i < names.size(); i++) {
+            if (next(4) > 0) {
+               object[names[i]] = instance(properties[names[i]]);
+            }
+         }
+         if (schema.isMember("patternProperties") || \
+               schema["additionalProperties"].isObject()) {
+            const char *matching[] = {"x-a", "x-1", "ab2", "b", "q"};
+            for (size_t i = 0; i < 5; i++) {
+               if (next(3) == 0) {
+                  object[matching[i]] = next(2) == 0 ? string() : \
+                     Json::Value(static_cast<int>(next(4)));
+               }
+            }
+         }
+         if (next(6) == 0) {
+            object["extra"] = any();
+         }
+         return object;
+      }
+
+   private:
+      std::mt19937 m_random;
+};
+
+TEST(JsonCodeGenerator, SameResultAsValidator)
+{
+   Json::Value schema = readSchema();
+   JsonValidator validator(&schema);
+
+   RandomInstances random(31);
+   std::vector<int> results(JVAL_ERR_ADDITIONAL_ITEMS + 1, 0);
+
+   for (int i = 0; i < 50000; i++) {
+      Json::Value doc = random.instance(schema);
+      int ret = validator.validate(&doc);
+      ASSERT_EQ(codegen_validate(&doc), ret) << doc.toStyledString();
+      results[ret]++;
+   }
+
+   // every code the schema can produce has been compared
+   int codes[] = {
+      JVAL_ROK, JVAL_ERR_NOT_AN_OBJECT, JVAL_ERR_INVALID_MIN_PROPERTIES,
+      JVAL_ERR_INVALID_MAX_PROPERTIES, JVAL_ERR_REQUIRED_ITEM_MISSING,
+      JVAL_ERR_UNKNOWN_PROPERTY, JVAL_ERR_INVALID_PROPERTY
+   };
+   for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+      EXPECT_GT(results[codes[i]], 0) << codes[i];
+   }
+}
+
+TEST(JsonCodeGenerator, InvalidSchema)
+{
+   JsonCodeGenerator generator;
+   std::ostringstream out;
+
+   Json::Value schema;
+   schema["type"] = "tuple";
+   ASSERT_THROW(generator.generate(&schema, "f", out), Exception);
+
+   schema["type"] = "object";
+   schema["properties"]["a"]["minimum"] = 1;
+   ASSERT_THROW(generator.generate(&schema, "f", out), Exception);
+}
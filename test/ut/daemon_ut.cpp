@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <list>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "primitive_base.h"
+#include "daemon.h"
+
+static std::string temporaryDirectory()
+{
+   char path[] = "/tmp/jvalut.XXXXXX";
+   EXPECT_TRUE(NULL != mkdtemp(path));
+   return path;
+}
+
+static void writeFile(const std::string &path, const char *text)
+{
+   std::ofstream out(path.c_str());
+   out << text;
+}
+
+TEST(JsonDaemon, LoadSchemas)
+{
+   std::string directory = temporaryDirectory();
+   writeFile(directory + "/person.json", recordSchema);
+   writeFile(directory + "/notes.txt", "not a schema");
+
+   JsonDaemon daemon;
+   ASSERT_EQ(daemon.loadSchemas(directory.c_str()), 1U);
+
+   writeFile(directory + "/broken.json", "{\"type\": \"unknown\"}");
+   ASSERT_THROW(daemon.loadSchemas(directory.c_str()), Exception);
+
+   writeFile(directory + "/broken.json",
+         "{\"type\": \"string\", \"pattern\": \"(\"}");
+   ASSERT_THROW(daemon.loadSchemas(directory.c_str()), Exception);
+   ASSERT_THROW(daemon.loadSchemas("/nonexistent/jvalut"), Exception);
+
+   unlink((directory + "/person.json").c_str());
+   unlink((directory + "/notes.txt").c_str());
+   unlink((directory + "/broken.json").c_str());
+   rmdir(directory.c_str());
+}
+
+TEST(JsonDaemon, Requests)
+{
+   std::string directory = temporaryDirectory();
+   std::string socketPath = directory + "/jvald.sock";
+
+   Json::Reader reader;
+   Json::Value schemaValue;
+   ASSERT_TRUE(reader.parse(recordSchema, schemaValue));
+
+   JsonDaemon daemon;
+   daemon.addSchema("person", &schemaValue);
+   daemon.listen(socketPath.c_str());
+   std::thread server(&JsonDaemon::run, &daemon);
+
+   JsonDaemonClient client;
+   ASSERT_TRUE(client.connect(socketPath.c_str())) << client.getError();
+   ASSERT_EQ(client.validate("person", "{\"id\": 4}"), JVAL_ROK);
+   ASSERT_EQ(client.validate("person", "{\"id\": -4}"),
+         JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(client.validate("person", "{}"), JVAL_ERR_REQUIRED_ITEM_MISSING);
+   ASSERT_EQ(client.validate("nobody", "{\"id\": 4}"),
+         JVALD_ERR_UNKNOWN_SCHEMA);
+   ASSERT_EQ(client.validate("person", "{\"id\": "),
+         JVALD_ERR_INVALID_JSON);
+
+   // pipelined, the answers come back in order
+   const std::string valid = "{\"id\": 1}";
+   const std::string invalid = "{\"id\": \"1\"}";
+   for (int round = 0; round < 10; round++) {
+      for (int i = 0; i < 500; i++) {
+         const std::string &document = i % 3 == 0 ? invalid : valid;
+         ASSERT_TRUE(client.send("person", document.data(),
+                  document.data() + document.size()));
+      }
+      for (int i = 0; i < 500; i++) {
+         int result;
+         ASSERT_TRUE(client.receive(result)) << client.getError();
+         ASSERT_EQ(result, i % 3 == 0 ? JVAL_ERR_INVALID_PROPERTY : JVAL_ROK);
+      }
+   }
+
+   // a frame many times the size of a read, the buffer grows as it comes
+   std::string large = "{\"id\": 1, \"tags\": [";
+   for (int i = 0; i < 100000; i++) {
+      large += i ? ", \"555-0100\"" : "\"555-0100\"";
+   }
+   ASSERT_EQ(client.validate("person", large + "]}"), JVAL_ROK);
+   ASSERT_EQ(client.validate("person", large + ", \"x\"]}"),
+         JVAL_ERR_INVALID_PROPERTY);
+
+   // several connections at once
+   JsonDaemonClient other;
+   ASSERT_TRUE(other.connect(socketPath.c_str()));
+   ASSERT_EQ(other.validate("person", valid), JVAL_ROK);
+   ASSERT_EQ(client.validate("person", valid), JVAL_ROK);
+
+   // stopping closes the connections still open
+   daemon.stop();
+   server.join();
+   int result;
+   ASSERT_FALSE(other.receive(result));
+   ASSERT_EQ(client.validate("person", valid), JVALD_ERR_IO);
+
+   unlink(socketPath.c_str());
+   rmdir(directory.c_str());
+}
@@ -0,0 +1,231 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "tape.h"
+#include "format.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+static bool check(JsonFormat::Checker checker, const std::string &text)
+{
+   return checker(text.data(), text.data() + text.size());
+}
+
+// validates a string against schema, as a Json::Value and from a tape, which
+// must agree
+static int validateString(JsonValidator &validator, const std::string &text)
+{
+   Json::Value value(text);
+   std::string document = "\"" + text + "\"";
+   JsonTape tape;
+   EXPECT_TRUE(tape.parse(document.data(), document.data() + document.size()));
+   int ret = validator.validate(&value);
+   EXPECT_EQ(validator.validate(&tape), ret) << text;
+   return ret;
+}
+
+// accepts the strings of two or more 'x'
+static bool xx(const char *begin, const char *end)
+{
+   if (end - begin < 2) {
+      return false;
+   }
+   for (const char *p = begin; p < end; p++) {
+      if (*p != 'x') {
+         return false;
+      }
+   }
+   return true;
+}
+
+TEST(JsonFormat, DateTime)
+{
+   const char *valid[] = {"1985-04-12T23:20:50.52Z", "1996-12-19T16:39:57-08:00",
+      "1990-12-31T23:59:60Z", "2000-02-29t00:00:00z", "1937-01-01T12:00:27.87+00:20"};
+   const char *invalid[] = {"", "1985-04-12", "1985-04-12T23:20:50", "1985-4-12T23:20:50Z",
+      "1985-13-12T23:20:50Z", "1900-02-29T00:00:00Z", "1985-04-31T00:00:00Z",
+      "1985-04-12T24:00:00Z", "1985-04-12T23:20:50.Z", "1985-04-12 23:20:50Z",
+      "1985-04-12T23:20:50+0800", "1985-04-12T23:20:50Z ", "1985-04-12T23:20:50+24:00"};
+
+   for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      EXPECT_TRUE(check(&JsonFormat::dateTime, valid[i])) << valid[i];
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      EXPECT_FALSE(check(&JsonFormat::dateTime, invalid[i])) << invalid[i];
+   }
+}
+
+TEST(JsonFormat, Email)
+{
+   const char *valid[] = {"joe.bloggs@example.com", "te~st@example.com",
+      "a+b=c@x.io", "x@localhost"};
+   const char *invalid[] = {"", "2962", "@example.com", "joe@", ".joe@example.com",
+      "joe.@example.com", "jo..e@example.com", "joe@exa mple.com", "joe@-a.com",
+      "j@e@example.com", "jo(e@example.com"};
+
+   for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      EXPECT_TRUE(check(&JsonFormat::email, valid[i])) << valid[i];
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      EXPECT_FALSE(check(&JsonFormat::email, invalid[i])) << invalid[i];
+   }
+}
+
+TEST(JsonFormat, Hostname)
+{
+   std::string label63(63, 'a');
+   EXPECT_TRUE(check(&JsonFormat::hostname, "www.example.com"));
+   EXPECT_TRUE(check(&JsonFormat::hostname, "xn--4gbwdl.xn--wgbh1c"));
+   EXPECT_TRUE(check(&JsonFormat::hostname, "a-b.c1"));
+   EXPECT_TRUE(check(&JsonFormat::hostname, label63 + ".com"));
+
+   EXPECT_FALSE(check(&JsonFormat::hostname, ""));
+   EXPECT_FALSE(check(&JsonFormat::hostname, label63 + "a.com"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, "-a-host-name-that-starts-with--"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, "ends-with-.com"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, "not_a_valid_host_name"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, "a..b"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, "example.com."));
+
+   std::string name;
+   for (int i = 0; i < 50; i++) {
+      name += "abcd.";
+   }
+   EXPECT_TRUE(check(&JsonFormat::hostname, name + "abc"));
+   EXPECT_FALSE(check(&JsonFormat::hostname, name + "abcd"));
+}
+
+TEST(JsonFormat, Ipv4)
+{
+   const char *valid[] = {"192.168.0.1", "0.0.0.0", "255.255.255.255", "10.0.20.3"};
+   const char *invalid[] = {"", "127.0.0.0.1", "256.256.256.256", "127.0",
+      "0x7f000001", "087.10.0.1", "1.2.3.", ".1.2.3", "1.2.3.4 ", "1..2.3",
+      "1234.1.1.1"};
+
+   for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      EXPECT_TRUE(check(&JsonFormat::ipv4, valid[i])) << valid[i];
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      EXPECT_FALSE(check(&JsonFormat::ipv4, invalid[i])) << invalid[i];
+   }
+}
+
+TEST(JsonFormat, Ipv6)
+{
+   const char *valid[] = {"::1", "::", "1::", "fe80::1:2", "2001:db8:0:0:0:0:2:1",
+      "2001:DB8::8:800:200C:417A", "::ffff:192.168.0.1", "1:2:3:4:5:6:1.2.3.4",
+      "1:2:3:4:5:6:7::"};
+   const char *invalid[] = {"", ":", ":1", "1:", "12345::", "1::2::3", "::ffff:1.2.3",
+      "1:2:3:4:5:6:7:8:9", "1:2:3:4:5:6:7", "1:2:3:4:5:6:7:8::", "::g",
+      "1.2.3.4", "::1.2.3.4:1", "fe80::1%eth0", ":::1"};
+
+   for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      EXPECT_TRUE(check(&JsonFormat::ipv6, valid[i])) << valid[i];
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      EXPECT_FALSE(check(&JsonFormat::ipv6, invalid[i])) << invalid[i];
+   }
+}
+
+TEST(JsonFormat, Uri)
+{
+   const char *valid[] = {"http://foo.bar/?baz=qux#quux", "urn:isbn:0451450523",
+      "mailto:John.Doe@example.com", "http://[2001:db8::7]/c=GB?one=two",
+      "file:///etc/hosts", "http://example.com/a%20b", "tel:+1-816-555-1212"};
+   const char *invalid[] = {"", "//foo.bar/?baz=qux#quux", "/abc", "abc",
+      "http:// shouldfail.com", "http://a/%2", "http://a/%zz", "1http://a",
+      "http://a/#b#c", "http://a/\\b", "http://a/<b>"};
+
+   for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      EXPECT_TRUE(check(&JsonFormat::uri, valid[i])) << valid[i];
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      EXPECT_FALSE(check(&JsonFormat::uri, invalid[i])) << invalid[i];
+   }
+}
+
+TEST(JsonFormat, Keyword)
+{
+   // the format alone and along with other keywords, which compile apart
+   std::string alone = "{\"type\": \"string\", \"format\": \"ipv4\"}";
+   std::string along = "{\"type\": \"string\", \"format\": \"ipv4\", "
+      "\"maxLength\": 11}";
+   JsonValidator formatOnly(alone);
+   JsonValidator formatAndLength(along);
+
+   EXPECT_EQ(validateString(formatOnly, "10.0.0.1"), JVAL_ROK);
+   EXPECT_EQ(validateString(formatOnly, "10.0.0.256"), JVAL_ERR_INVALID_FORMAT);
+   EXPECT_EQ(validateString(formatAndLength, "10.0.0.1"), JVAL_ROK);
+   EXPECT_EQ(validateString(formatAndLength, "10.0.0.256"),
+         JVAL_ERR_INVALID_FORMAT);
+   EXPECT_EQ(validateString(formatAndLength, "100.100.10.1"),
+         JVAL_ERR_INVALID_MAX_LENGTH);
+
+   Json::Value number(1);
+   EXPECT_EQ(formatOnly.validate(&number), JVAL_ERR_NOT_A_STRING);
+
+   // unknown formats are ignored
+   std::string unknown = "{\"type\": \"string\", \"format\": \"color\"}";
+   JsonValidator unknownFormat(unknown);
+   EXPECT_EQ(validateString(unknownFormat, "anything"), JVAL_ROK);
+}
+
+TEST(JsonFormat, InvalidSchema)
+{
+   std::string schema = "{\"type\": \"string\", \"format\": 4}";
+#ifdef JVAL_NO_EXCEPTIONS
+   JsonValidator validator(schema);
+   EXPECT_FALSE(validator.getError().empty());
+#else
+   EXPECT_THROW(JsonValidator validator(schema), Exception);
+#endif
+}
+
+TEST(JsonFormat, Define)
+{
+   std::string schema = "{\"type\": \"string\", \"format\": \"xx\"}";
+   JsonValidator before(schema);
+
+   JsonFormat::define("xx", &xx);
+   ASSERT_TRUE(JsonFormat::find("xx") == &xx);
+   JsonValidator validator(schema);
+   EXPECT_EQ(validateString(validator, "xxx"), JVAL_ROK);
+   EXPECT_EQ(validateString(validator, "xy"), JVAL_ERR_INVALID_FORMAT);
+
+   // compiled schemas keep the checker they were compiled with
+   EXPECT_EQ(validateString(before, "xy"), JVAL_ROK);
+   JsonFormat::define("xx", NULL);
+   EXPECT_TRUE(JsonFormat::find("xx") == NULL);
+   EXPECT_EQ(validateString(validator, "xy"), JVAL_ERR_INVALID_FORMAT);
+
+   // built-in formats can be replaced too
+   JsonFormat::Checker ipv4 = JsonFormat::find("ipv4");
+   JsonFormat::define("ipv4", &xx);
+   std::string address = "{\"type\": \"string\", \"format\": \"ipv4\"}";
+   JsonValidator replaced(address);
+   EXPECT_EQ(validateString(replaced, "xx"), JVAL_ROK);
+   JsonFormat::define("ipv4", ipv4);
+}
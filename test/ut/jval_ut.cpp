@@ -22,6 +22,8 @@
 
 #include <iostream>
 #include <list>
+#include <string>
+#include <vector>
 #include <regex>
 #include <json.h>
 #include <validator.h>
@@ -43,3 +45,92 @@ TEST(Validator, Basic)
    validator.readSchema("schema1.json");
    ASSERT_EQ(validator.validate(&v), 0);
 }
+
+TEST(Validator, NoSchema)
+{
+   Json::Value v(1);
+   std::vector<std::string> pointers(1, "");
+
+   JsonValidator validator;
+   ASSERT_EQ(validator.validate(&v), JVAL_ERR_INVALID_SCHEMA);
+   ASSERT_EQ(validator.revalidate(&v, pointers), JVAL_ERR_INVALID_SCHEMA);
+
+   std::string schema = "{\"type\": \"integer\"}";
+   JsonValidator integer(schema);
+   ASSERT_TRUE(integer.getError().empty());
+   ASSERT_EQ(integer.validate(&v), JVAL_ROK);
+
+   std::string notAnObject = "[{\"type\": \"integer\"}]";
+#ifdef JVAL_NO_EXCEPTIONS
+   JsonValidator invalid(notAnObject);
+   ASSERT_FALSE(invalid.getError().empty());
+   ASSERT_EQ(invalid.validate(&v), JVAL_ERR_INVALID_SCHEMA);
+#else
+   ASSERT_THROW(JsonValidator invalid(notAnObject), Exception);
+#endif
+}
+
+TEST(Validator, InvalidSchema)
+{
+   // the pattern keyword, a policy primitive and a nested subschema
+   const char *schemas[] = {
+      "{\"type\": \"string\", \"pattern\": \"(\"}",
+      "{\"type\": \"string\", \"minLength\": 1, \"maxLength\": 5, "
+         "\"pattern\": \"[a-\"}",
+      "{\"type\": \"object\", \"properties\": {\"a\": "
+         "{\"type\": \"string\", \"pattern\": \"a{2,1}\"}}}",
+   };
+
+   for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++) {
+      std::string schema(schemas[i]);
+#ifdef JVAL_NO_EXCEPTIONS
+      JsonValidator validator(schema);
+      EXPECT_FALSE(validator.getError().empty()) << schema;
+      Json::Value v("a");
+      EXPECT_EQ(validator.validate(&v), JVAL_ERR_INVALID_SCHEMA) << schema;
+#else
+      EXPECT_THROW(JsonValidator validator(schema), Exception) << schema;
+#endif
+   }
+}
+
+TEST(Validator, MistypedKeywords)
+{
+   // keywords of the wrong type or out of range, never converted
+   const char *schemas[] = {
+      "{\"type\": \"string\", \"maxLength\": \"10\"}",
+      "{\"type\": \"string\", \"maxLength\": -1}",
+      "{\"type\": \"string\", \"minLength\": 1.5}",
+      "{\"type\": \"string\", \"minLength\": 1, \"maxLength\": 5, "
+         "\"pattern\": 4}",
+      "{\"type\": \"array\", \"minItems\": \"x\"}",
+      "{\"type\": \"array\", \"maxItems\": 4294967296}",
+      "{\"type\": \"array\", \"uniqueItems\": 1}",
+      "{\"type\": \"object\", \"maxProperties\": [1]}",
+      "{\"type\": \"object\", \"required\": \"a\"}",
+      "{\"type\": \"object\", \"required\": [1]}",
+      "{\"type\": \"object\", \"properties\": [{}]}",
+      "{\"type\": \"integer\", \"minimum\": 0, "
+         "\"exclusiveMinimum\": \"yes\"}",
+      "{\"type\": [\"string\", \"null\"]}",
+   };
+
+   for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++) {
+      std::string schema(schemas[i]);
+#ifdef JVAL_NO_EXCEPTIONS
+      JsonValidator validator(schema);
+      EXPECT_FALSE(validator.getError().empty()) << schema;
+      Json::Value v("a");
+      EXPECT_EQ(validator.validate(&v), JVAL_ERR_INVALID_SCHEMA) << schema;
+#else
+      EXPECT_THROW(JsonValidator validator(schema), Exception) << schema;
+#endif
+   }
+
+   // a whole number written with a fraction is still a count
+   std::string whole = "{\"type\": \"string\", \"maxLength\": 2.0}";
+   JsonValidator validator(whole);
+   ASSERT_TRUE(validator.getError().empty());
+   Json::Value v("abc");
+   ASSERT_EQ(validator.validate(&v), JVAL_ERR_INVALID_MAX_LENGTH);
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "memo.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+static const char *schema = "{\"type\": \"array\", \"items\": {"
+   "\"type\": \"object\", \"required\": [\"street\"], "
+   "\"additionalProperties\": false, \"properties\": {"
+   "\"street\": {\"type\": \"string\", \"pattern\": \"^[A-Za-z ]+$\"}, "
+   "\"zip\": {\"type\": \"object\", \"additionalProperties\": false, "
+   "\"properties\": {\"code\": {\"type\": \"integer\", \"maximum\": 99999}}}}}}";
+
+TEST(JsonMemo, Hash)
+{
+   ASSERT_EQ(JsonMemo::hash(parse("{\"a\": [1, \"x\"], \"b\": null}")),
+         JsonMemo::hash(parse("{\"b\": null, \"a\": [1, \"x\"]}")));
+   ASSERT_EQ(JsonMemo::hash(parse("[0.0]")), JsonMemo::hash(parse("[-0.0]")));
+   ASSERT_NE(JsonMemo::hash(parse("[1, 2]")), JsonMemo::hash(parse("[2, 1]")));
+   ASSERT_NE(JsonMemo::hash(parse("{\"a\": 1}")),
+         JsonMemo::hash(parse("{\"b\": 1}")));
+   ASSERT_NE(JsonMemo::hash(parse("[1]")), JsonMemo::hash(parse("[1.0]")));
+}
+
+TEST(JsonMemo, SameResultPerCall)
+{
+   std::string str(schema);
+   JsonValidator plain(str);
+   JsonValidator memoized(str);
+   memoized.setMemoCapacity(16);
+
+   const char *documents[] = {
+      "[{\"street\": \"Main St\", \"zip\": {\"code\": 1}}, "
+      "{\"street\": \"Main St\", \"zip\": {\"code\": 1}}]",
+      "[{\"street\": \"Main St\"}, {\"street\": \"Main St\"}, "
+      "{\"street\": \"Main St 1\"}]",
+      "[{\"zip\": {\"code\": 1}}, {\"street\": \"A\", \"zip\": {\"code\": 1}}]",
+      "[{\"street\": \"A\", \"zip\": {\"code\": 100000}}, "
+      "{\"street\": \"A\", \"zip\": {\"code\": 100000}}]",
+      "[{\"street\": \"A\"}, {\"street\": \"A\", \"x\": 1}]",
+      "[{\"street\": \"A\", \"zip\": {\"code\": 5}}, "
+      "{\"street\": \"B\", \"zip\": {\"code\": 5}}, "
+      "{\"street\": \"B\", \"zip\": {\"code\": 5.0}}]",
+      "[]"
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      Json::Value doc = parse(documents[i]);
+      ASSERT_EQ(memoized.validate(&doc), plain.validate(&doc)) << documents[i];
+   }
+}
+
+TEST(JsonMemo, ThreadScope)
+{
+   std::string str(schema);
+   JsonValidator validator(str);
+
+   JsonMemo memo(4, true);
+   {
+      JsonMemo::Scope scope(memo);
+
+      for (int i = 0; i < 3; i++) {
+         // every document is gone before the next one is validated
+         Json::Value doc = parse("[{\"street\": \"Main St\"}, "
+               "{\"street\": \"Main St\"}, {\"street\": \"1\"}]");
+         ASSERT_EQ(validator.validate(&doc), JVAL_ERR_INVALID_ARRAY_ITEM);
+      }
+
+      ASSERT_EQ(memo.misses(), 2U);
+      ASSERT_EQ(memo.hits(), 7U);
+      ASSERT_EQ(memo.size(), 2U);
+
+      Json::Value doc = parse("[{\"street\": \"A\"}, {\"street\": \"B\"}, "
+            "{\"street\": \"C\"}, {\"street\": \"D\"}, {\"street\": \"E\"}]");
+      ASSERT_EQ(validator.validate(&doc), JVAL_ROK);
+      ASSERT_LE(memo.size(), 4U);
+   }
+
+   ASSERT_TRUE(NULL == JsonMemo::current());
+
+   // the memo does not copy into an arena which may be reset under it
+   Json::Arena arena;
+   {
+      Json::Arena::Scope arenaScope(arena);
+      JsonMemo::Scope scope(memo);
+      memo.clear();
+
+      Json::Value doc = parse("[{\"street\": \"A\"}, {\"street\": \"A\"}]");
+      ASSERT_EQ(validator.validate(&doc), JVAL_ROK);
+      ASSERT_EQ(memo.size(), 0U);
+   }
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "memory_usage.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+static size_t sum(const std::map<std::string, size_t> &bytes)
+{
+   size_t total = 0;
+   for (std::map<std::string, size_t>::const_iterator itr = bytes.begin(); \
+         itr != bytes.end(); itr++) {
+      total += itr->second;
+   }
+   return total;
+}
+
+TEST(JsonMemoryUsage, Helpers)
+{
+   ASSERT_EQ(JsonMemoryUsage::valueBytes(Json::Value(5)), 0U);
+   ASSERT_EQ(JsonMemoryUsage::valueBytes(Json::Value("abc")),
+         sizeof(unsigned) + 4);
+   ASSERT_GT(JsonMemoryUsage::valueBytes(parse("{\"a\": [1, 2]}")),
+         JsonMemoryUsage::valueBytes(parse("{\"a\": [1]}")));
+   ASSERT_GT(JsonMemoryUsage::valueBytes(parse("{\"abcdef\": 1}")),
+         JsonMemoryUsage::valueBytes(parse("{\"a\": 1}")));
+
+   ASSERT_EQ(JsonMemoryUsage::stringBytes(""), 0U);
+   ASSERT_GT(JsonMemoryUsage::stringBytes(std::string(100, 'x')), 100U);
+   ASSERT_GT(JsonMemoryUsage::regexBytes(20), JsonMemoryUsage::regexBytes(2));
+
+   ASSERT_EQ(JsonMemoryUsage::pointerToken("a/b~"), "a~1b~0");
+}
+
+TEST(JsonMemoryUsage, Breakdown)
+{
+   Json::Value schemaValue = parse(recordSchema);
+   JsonValidator validator(&schemaValue);
+
+   JsonMemoryUsage usage;
+   validator.memoryUsage(usage);
+   ASSERT_GT(usage.total(), 0U);
+   ASSERT_EQ(sum(usage.byKind()), usage.total());
+   ASSERT_EQ(sum(usage.byPath()), usage.total());
+
+   const std::map<std::string, size_t> &kinds = usage.byKind();
+   ASSERT_TRUE(kinds.count("JsonObject"));
+   ASSERT_TRUE(kinds.count("Properties"));
+   ASSERT_TRUE(kinds.count("Required"));
+   ASSERT_TRUE(kinds.count("ItemsList"));
+   ASSERT_TRUE(kinds.count("ItemsTuple"));
+   ASSERT_TRUE(kinds.count("Json::Value"));
+   ASSERT_TRUE(kinds.count("std::regex"));
+
+   const std::map<std::string, size_t> &paths = usage.byPath();
+   ASSERT_TRUE(paths.count(""));
+   ASSERT_TRUE(paths.count("/properties/id"));
+   ASSERT_TRUE(paths.count("/properties/a~1b~0"));
+   ASSERT_TRUE(paths.count("/properties/tags/items"));
+   ASSERT_TRUE(paths.count("/properties/pair/items/0"));
+   ASSERT_TRUE(paths.count("/properties/pair/items/1"));
+
+   // the pattern dominates its subschema
+   ASSERT_GT(paths.find("/properties/a~1b~0")->second,
+         paths.find("/properties/id")->second);
+
+   // calls add up
+   validator.memoryUsage(usage);
+   ASSERT_EQ(sum(usage.byKind()), usage.total());
+   usage.clear();
+   ASSERT_EQ(usage.total(), 0U);
+   ASSERT_TRUE(usage.byKind().empty());
+}
+
+TEST(JsonMemoryUsage, Total)
+{
+   size_t before = JsonValidator::totalMemoryUsage();
+
+   Json::Value schemaValue = parse(recordSchema);
+   JsonValidator *validator = new JsonValidator(&schemaValue);
+   JsonMemoryUsage usage;
+   validator->memoryUsage(usage);
+   ASSERT_EQ(JsonValidator::totalMemoryUsage(), before + usage.total());
+
+   std::string text = "{\"type\": \"string\"}";
+   JsonValidator small(text);
+   JsonMemoryUsage smallUsage;
+   small.memoryUsage(smallUsage);
+   ASSERT_LT(smallUsage.total(), usage.total());
+   ASSERT_EQ(JsonValidator::totalMemoryUsage(),
+         before + usage.total() + smallUsage.total());
+
+   delete validator;
+   ASSERT_EQ(JsonValidator::totalMemoryUsage(), before + smallUsage.total());
+}
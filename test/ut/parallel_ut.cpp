@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "tape.h"
+#include "budget.h"
+#include "primitive_base.h"
+#include "worker_pool.h"
+#include "parallel.h"
+#include "validator.h"
+
+// [0, 1, ..., count - 1] with the item at bad, if any, a string
+static std::string integers(int count, int bad)
+{
+   std::ostringstream text;
+   text << "[";
+   for (int i = 0; i < count; i++) {
+      text << (i ? ", " : "");
+      if (i == bad) {
+         text << "\"bad\"";
+      } else {
+         text << i;
+      }
+   }
+   text << "]";
+   return text.str();
+}
+
+// {"p0000": 0, ...} with count members
+static std::string members(int count)
+{
+   std::ostringstream text;
+   text << "{";
+   for (int i = 0; i < count; i++) {
+      text << (i ? ", " : "") << "\"p";
+      text.width(4);
+      text.fill('0');
+      text << i << "\": " << i;
+   }
+   text << "}";
+   return text.str();
+}
+
+// schema of the objects made by members(count), no other member allowed
+static std::string membersSchema(int count)
+{
+   Json::Value schema = parse("{\"type\": \"object\", "
+         "\"additionalProperties\": false}");
+   Json::Value value = parse(members(count));
+   for (Json::ValueIterator itr = value.begin(); itr != value.end(); itr++) {
+      schema["properties"][itr.name()]["type"] = "integer";
+   }
+
+   Json::FastWriter writer;
+   return writer.write(schema);
+}
+
+// Validates a document on a worker of the pool the validator splits with
+class NestedValidation
+{
+   public:
+      NestedValidation(JsonValidator *validator, const Json::Value *value,
+            std::atomic<int> *result) :
+         m_validator(validator), m_value(value), m_result(result) {}
+
+      void operator()() {
+         *m_result = m_validator->validate(m_value);
+      }
+
+   private:
+      JsonValidator        *m_validator;
+      const Json::Value    *m_value;
+      std::atomic<int>     *m_result;
+};
+
+TEST(JsonParallel, Chunks)
+{
+   JsonWorkerPool pool(3, 16);
+   JsonParallel parallel(&pool, 1000);
+
+   ASSERT_EQ(parallel.chunks(999), 0U);
+   ASSERT_EQ(parallel.chunks(1000), 4U);
+   ASSERT_EQ(parallel.chunks(1000000), 16U);
+
+   // never split while a budget is spent
+   JsonBudget budget;
+   JsonBudget::Scope scope(budget);
+   ASSERT_EQ(parallel.chunks(1000000), 0U);
+}
+
+TEST(JsonParallel, Items)
+{
+   std::string schema = "{\"type\": \"array\", "
+      "\"items\": {\"type\": \"integer\"}}";
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(4, 16);
+   validator.setParallel(&pool, 1000);
+
+   const int bad[] = {-1, 0, 1, 2499, 2500, 4999};
+   for (unsigned int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+      std::string text = integers(5000, bad[i]);
+      Json::Value value = parse(text);
+      JsonTape tape;
+      ASSERT_TRUE(tape.parse(text.data(), text.data() + text.size()));
+
+      int expected = bad[i] < 0 ? JVAL_ROK : JVAL_ERR_INVALID_ARRAY_ITEM;
+      ASSERT_EQ(validator.validate(&value), expected);
+      ASSERT_EQ(validator.validate(&tape), expected);
+   }
+
+   ASSERT_GT(pool.metrics().completed, 0U);
+
+   // smaller arrays stay on the calling thread
+   uint64_t submitted = pool.metrics().submitted;
+   Json::Value small = parse(integers(999, -1));
+   ASSERT_EQ(validator.validate(&small), JVAL_ROK);
+   ASSERT_EQ(pool.metrics().submitted, submitted);
+}
+
+TEST(JsonParallel, Properties)
+{
+   std::string schema = membersSchema(3000);
+   JsonValidator sequential(schema);
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(4, 16);
+   validator.setParallel(&pool, 1000);
+
+   Json::Value value = parse(members(3000));
+   ASSERT_EQ(validator.validate(&value), JVAL_ROK);
+
+   // the first failure in member order wins, whatever chunk ends first
+   value["p2999"] = "bad";
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_INVALID_PROPERTY);
+   value["zzz"] = 1;
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_INVALID_PROPERTY);
+   value["p2999"] = 2999;
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_UNKNOWN_PROPERTY);
+   value["p0001"] = "bad";
+   for (int i = 0; i < 20; i++) {
+      ASSERT_EQ(validator.validate(&value), JVAL_ERR_INVALID_PROPERTY);
+   }
+
+   Json::FastWriter writer;
+   std::string text = writer.write(value);
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(text.data(), text.data() + text.size()));
+   ASSERT_EQ(validator.validate(&tape), sequential.validate(&tape));
+}
+
+TEST(JsonParallel, Nested)
+{
+   std::string schema = "{\"type\": \"array\", \"items\": "
+      "{\"type\": \"array\", \"items\": {\"type\": \"integer\"}}}";
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(2, 4);
+   validator.setParallel(&pool, 1000);
+
+   Json::Value value(Json::arrayValue);
+   Json::Value inner = parse(integers(1000, -1));
+   for (int i = 0; i < 1200; i++) {
+      value.append(inner);
+   }
+   ASSERT_EQ(validator.validate(&value), JVAL_ROK);
+
+   value[1100] = parse(integers(1000, 999));
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_INVALID_ARRAY_ITEM);
+}
+
+TEST(JsonParallel, Budget)
+{
+   std::string schema = "{\"type\": \"array\", "
+      "\"items\": {\"type\": \"integer\"}}";
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(2, 4);
+   validator.setParallel(&pool, 1000);
+   Json::Value value = parse(integers(5000, -1));
+
+   JsonBudget budget;
+   ASSERT_EQ(validator.validate(&value, budget), JVAL_ROK);
+   ASSERT_EQ(budget.used(), 5000U);
+
+   JsonBudget small;
+   small.setSteps(10);
+   ASSERT_EQ(validator.validate(&value, small), JVAL_ERR_BUDGET_EXCEEDED);
+   ASSERT_EQ(pool.metrics().submitted, 0U);
+}
+
+TEST(JsonParallel, FromWorker)
+{
+   std::string schema = "{\"type\": \"array\", "
+      "\"items\": {\"type\": \"integer\"}}";
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(1, 4);
+   validator.setParallel(&pool, 1000);
+   Json::Value value = parse(integers(5000, 4000));
+
+   // the only worker is busy with the validation, which takes its chunks
+   std::atomic<int> result(-1);
+   pool.submit(NestedValidation(&validator, &value, &result));
+   pool.drain();
+   ASSERT_EQ(result, JVAL_ERR_INVALID_ARRAY_ITEM);
+
+   validator.setParallel(NULL, 0);
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_INVALID_ARRAY_ITEM);
+}
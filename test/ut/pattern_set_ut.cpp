@@ -0,0 +1,318 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "tape.h"
+#include "pattern_set.h"
+#include "primitive_base.h"
+#include "worker_pool.h"
+#include "validator.h"
+
+// the patterns of set found in text, as a string of '0' and '1'
+static std::string found(const JsonPatternSet &set, const std::string &text)
+{
+   std::vector<uint64_t> matches(set.words());
+   set.match(text.data(), text.data() + text.size(), matches.data());
+
+   std::string bits;
+   for (size_t i = 0; i < set.size(); i++) {
+      bits += (matches[i / 64] >> (i % 64)) & 1 ? '1' : '0';
+   }
+   return bits;
+}
+
+// validates a document as a Json::Value and from a tape, which must agree
+static int validateDocument(JsonValidator &validator, const std::string &text)
+{
+   Json::Value value = parse(text);
+   JsonTape tape;
+   EXPECT_TRUE(tape.parse(text.data(), text.data() + text.size()));
+   int ret = validator.validate(&value);
+   EXPECT_EQ(validator.validate(&tape), ret) << text;
+   return ret;
+}
+
+/**
+ * @brief Random patterns made of the constructs the automaton compiles, and
+ * random strings over a small alphabet to search them in
+ */
+class RandomPatterns
+{
+   public:
+      RandomPatterns(unsigned int seed) : m_random(seed) {}
+
+      unsigned int next(unsigned int n) {
+         return std::uniform_int_distribution<unsigned int>(0, n - 1)(m_random);
+      }
+
+      std::string alternation(int depth) {
+         std::string pattern = atom(depth);
+         for (unsigned int i = next(3); i > 0; i--) {
+            pattern += atom(depth);
+         }
+         if (next(5) == 0) {
+            pattern += "|" + alternation(depth + 1);
+         }
+         return pattern;
+      }
+
+      std::string text() {
+         const char alphabet[] = "abcx_-.A1 9\n\xc3\xa9";
+         std::string str;
+         for (unsigned int i = next(8); i > 0; i--) {
+            str += alphabet[next(sizeof(alphabet) - 1)];
+         }
+         return str;
+      }
+
+   private:
+      std::string atom(int depth) {
+         const char *literals[] = {"a", "b", "c", "_", "-", "\\.", "\\d",
+            "\\w", "\\s", "\\D", "[a-c]", "[^ab]", "[\\d_]", "x", "\\x41",
+            "A", "\\-", "\xc3\xa9", "[a\\-z]", "\\n"};
+         const char *quantifiers[] = {"*", "+", "?", "{2}", "{1,3}", "{2,}?"};
+
+         unsigned int kind = next(12);
+         if (kind == 9 && depth < 3) {
+            // groups are not quantified, std::regex backtracks too much
+            return "(" + alternation(depth + 1) + ")";
+         } else if (kind == 10 && depth < 3) {
+            return "(?:" + alternation(depth + 1) + ")";
+         } else if (kind >= 9) {
+            return next(2) ? "^" : "$";
+         }
+
+         std::string atom = kind == 8 ? "." : literals[next(20)];
+         unsigned int quantifier = next(8);
+         if (quantifier < 6) {
+            atom += quantifiers[quantifier];
+         }
+         return atom;
+      }
+
+      std::mt19937 m_random;
+};
+
+TEST(JsonPatternSet, Match)
+{
+   JsonPatternSet set;
+   set.add("^x-");
+   set.add("[0-9]$");
+   set.add("a+b");
+   set.add("^$");
+   set.add("\xc3\xa9");
+   set.add("^(?:foo|bar)\\.[a-z]{2,3}$");
+   set.compile();
+
+   ASSERT_EQ(set.size(), 6U);
+   ASSERT_EQ(set.words(), 1U);
+   ASSERT_EQ(set.fallbacks(), 0U);
+
+   EXPECT_EQ(found(set, ""), "000100");
+   EXPECT_EQ(found(set, "x-"), "100000");
+   EXPECT_EQ(found(set, "y-x-1"), "010000");
+   EXPECT_EQ(found(set, "x-caab9"), "111000");
+   EXPECT_EQ(found(set, "caf\xc3\xa9"), "000010");
+   EXPECT_EQ(found(set, "bar.io"), "000001");
+   EXPECT_EQ(found(set, "bar.i"), "000000");
+   EXPECT_EQ(found(set, "foo.json"), "000000");
+}
+
+TEST(JsonPatternSet, SameAsRegexSearch)
+{
+   RandomPatterns random(7);
+
+   for (int round = 0; round < 300; round++) {
+      JsonPatternSet set;
+      std::vector<std::regex> regexes;
+      std::vector<std::string> patterns;
+      for (unsigned int i = random.next(6) + 1; i > 0; i--) {
+         std::string pattern = random.alternation(0);
+         try {
+            regexes.push_back(std::regex(pattern));
+         } catch (std::regex_error &e) {
+            continue;
+         }
+         patterns.push_back(pattern);
+         set.add(pattern);
+      }
+      set.compile();
+
+      for (int t = 0; t < 50; t++) {
+         std::string text = random.text();
+         std::string bits = found(set, text);
+         for (size_t i = 0; i < patterns.size(); i++) {
+            ASSERT_EQ(bits[i] == '1', std::regex_search(text, regexes[i])) << \
+               "/" << patterns[i] << "/ on \"" << text << "\"";
+         }
+      }
+   }
+}
+
+TEST(JsonPatternSet, Fallbacks)
+{
+   JsonPatternSet set;
+   set.add("(a)\\1");
+   set.add("^id");
+   set.add("\\bid\\b");
+   set.add("x(?=y)");
+   set.compile();
+
+   ASSERT_EQ(set.fallbacks(), 3U);
+   EXPECT_EQ(found(set, "aa"), "1000");
+   EXPECT_EQ(found(set, "id"), "0110");
+   EXPECT_EQ(found(set, "my id"), "0010");
+   EXPECT_EQ(found(set, "idle"), "0100");
+   EXPECT_EQ(found(set, "xy"), "0001");
+   EXPECT_EQ(found(set, "xx"), "0000");
+}
+
+TEST(JsonPatternSet, ManyPatterns)
+{
+   JsonPatternSet set;
+   for (int i = 0; i < 100; i++) {
+      set.add("^p" + std::to_string(i) + "_");
+   }
+   set.add("_[a-z]+[0-9]");
+   set.compile();
+
+   ASSERT_EQ(set.words(), 2U);
+   ASSERT_EQ(set.fallbacks(), 0U);
+
+   std::string bits = found(set, "p77_x1");
+   for (int i = 0; i < 100; i++) {
+      EXPECT_EQ(bits[i], i == 77 ? '1' : '0') << i;
+   }
+   EXPECT_EQ(bits[100], '1');
+   EXPECT_EQ(found(set, "p7_").find('1'), 7U);
+   EXPECT_EQ(found(set, "q7_"), std::string(101, '0'));
+}
+
+TEST(JsonPatternSet, PatternProperties)
+{
+   std::string schema = "{\"type\": \"object\", "
+      "\"properties\": {\"x-id\": {\"type\": \"integer\"}}, "
+      "\"patternProperties\": {"
+      "\"^x-\": {\"type\": \"string\", \"maxLength\": 2}, "
+      "\"[0-9]$\": {\"type\": \"integer\"}}, "
+      "\"additionalProperties\": false}";
+   JsonValidator validator(schema);
+
+   EXPECT_EQ(validateDocument(validator, "{}"), JVAL_ROK);
+   EXPECT_EQ(validateDocument(validator, "{\"x-a\": \"ok\", \"n1\": 3}"),
+         JVAL_ROK);
+   EXPECT_EQ(validateDocument(validator, "{\"x-a\": \"long\"}"),
+         JVAL_ERR_INVALID_PROPERTY);
+   EXPECT_EQ(validateDocument(validator, "{\"n\": 3}"),
+         JVAL_ERR_UNKNOWN_PROPERTY);
+
+   // a member is checked against its property and every pattern found
+   EXPECT_EQ(validateDocument(validator, "{\"x-id\": 4}"),
+         JVAL_ERR_INVALID_PROPERTY);
+   EXPECT_EQ(validateDocument(validator, "{\"x-1\": 4}"),
+         JVAL_ERR_INVALID_PROPERTY);
+   EXPECT_EQ(validateDocument(validator, "{\"x-1\": \"4\"}"),
+         JVAL_ERR_INVALID_PROPERTY);
+
+   // the other members are allowed when additionalProperties is missing
+   std::string openSchema = "{\"type\": \"object\", "
+      "\"patternProperties\": {\"^x-\": {\"type\": \"string\"}}}";
+   JsonValidator open(openSchema);
+   EXPECT_EQ(validateDocument(open, "{\"n\": 3, \"x-a\": \"b\"}"), JVAL_ROK);
+   EXPECT_EQ(validateDocument(open, "{\"n\": 3, \"x-a\": 1}"),
+         JVAL_ERR_INVALID_PROPERTY);
+}
+
+TEST(JsonPatternSet, Revalidate)
+{
+   std::string schema = "{\"type\": \"object\", "
+      "\"patternProperties\": {\"^n\": {\"type\": \"integer\"}}, "
+      "\"additionalProperties\": false}";
+   JsonValidator validator(schema);
+
+   Json::Value doc = parse("{\"n1\": 1, \"n2\": 2}");
+   std::vector<std::string> pointers(1, "/n2");
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ROK);
+
+   doc["n2"] = "two";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+
+   doc["n2"] = 2;
+   doc["m"] = 3;
+   pointers[0] = "/m";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_UNKNOWN_PROPERTY);
+
+   // allowed when additionalProperties is missing
+   std::string openSchema = "{\"type\": \"object\", "
+      "\"patternProperties\": {\"^n\": {\"type\": \"integer\"}}}";
+   JsonValidator open(openSchema);
+   ASSERT_EQ(open.revalidate(&doc, pointers), JVAL_ROK);
+}
+
+TEST(JsonPatternSet, Parallel)
+{
+   std::string schema = "{\"type\": \"object\", "
+      "\"patternProperties\": {\"^p[0-9]+$\": {\"type\": \"integer\"}}, "
+      "\"additionalProperties\": false}";
+   JsonValidator sequential(schema);
+   JsonValidator validator(schema);
+   JsonWorkerPool pool(4, 16);
+   validator.setParallel(&pool, 1000);
+
+   Json::Value value(Json::objectValue);
+   for (int i = 0; i < 3000; i++) {
+      value["p" + std::to_string(i)] = i;
+   }
+   ASSERT_EQ(validator.validate(&value), JVAL_ROK);
+
+   value["p2999"] = "bad";
+   value["q"] = 1;
+   ASSERT_EQ(validator.validate(&value), sequential.validate(&value));
+   value["p2999"] = 2999;
+   ASSERT_EQ(validator.validate(&value), JVAL_ERR_UNKNOWN_PROPERTY);
+}
+
+TEST(JsonPatternSet, InvalidSchema)
+{
+   std::string schema = "{\"type\": \"object\", \"patternProperties\": 4}";
+   std::string pattern = "{\"type\": \"object\", "
+      "\"patternProperties\": {\"(\": {}, \"^a\": {}}}";
+#ifdef JVAL_NO_EXCEPTIONS
+   JsonValidator validator(schema);
+   EXPECT_FALSE(validator.getError().empty());
+
+   JsonValidator invalidPattern(pattern);
+   EXPECT_FALSE(invalidPattern.getError().empty());
+   Json::Value value = parse("{\"a\": 1}");
+   EXPECT_EQ(invalidPattern.validate(&value), JVAL_ERR_INVALID_SCHEMA);
+#else
+   EXPECT_THROW(JsonValidator validator(schema), Exception);
+   EXPECT_THROW(JsonValidator validator(pattern), Exception);
+#endif
+}
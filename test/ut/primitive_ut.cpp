@@ -24,25 +24,61 @@
 #include <list>
 #include <iostream>
 #include <regex>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include "gtest/gtest.h"
 #include "json.h"
+#include "tape.h"
+#include "number.h"
+#include "format.h"
+#include "memory_usage.h"
 #include "primitive_base.h"
+#include "schema_cache.h"
 #include "keyword_validator.h"
 #include "primitive.h"
+#include "policy_primitive.h"
 #include "validator.h"
 
-TEST(getPrimitveType, Negative)
+/**
+ * @brief Expects schema not to compile: createPrimitive throws Exception, or
+ * without exceptions returns NULL, and JsonValidator reports the error and
+ * fails every document with JVAL_ERR_INVALID_SCHEMA
+ */
+static void expectSchemaError(Json::Value schema)
 {
-   Json::Value a;
-   ASSERT_THROW(JsonPrimitive::getPrimitveType(&a), Exception);
-   
-   Json::Value b;
-   b["id"] = 1;
-   ASSERT_THROW(JsonPrimitive::getPrimitveType(&b), Exception);
+   std::string text = schema.toStyledString();
+#ifdef JVAL_NO_EXCEPTIONS
+   EXPECT_TRUE(NULL == JsonPrimitive::createPrimitive(&schema)) << text;
+
+   JsonValidator validator(&schema);
+   EXPECT_FALSE(validator.getError().empty()) << text;
+   Json::Value value;
+   EXPECT_EQ(validator.validate(&value), JVAL_ERR_INVALID_SCHEMA) << text;
+#else
+   EXPECT_THROW(JsonPrimitive::createPrimitive(&schema), Exception) << text;
+#endif
+}
 
-   Json::Value c;
-   c["type"] = "aaa";
-   ASSERT_THROW(JsonPrimitive::getPrimitveType(&c), Exception);
+TEST(getPrimitveType, Negative)
+{
+   Json::Value schemas[4];
+   schemas[1]["id"] = 1;
+   schemas[2]["type"] = "aaa";
+   schemas[3]["type"][0] = "string";
+
+   for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++) {
+#ifdef JVAL_NO_EXCEPTIONS
+      // the error is recorded by the cache of the thread
+      JsonSchemaCache cache;
+      JsonSchemaCache::Scope scope(cache);
+      ASSERT_EQ(JsonPrimitive::getPrimitveType(&schemas[i]),
+            JSON_TYPE_INVALID);
+      ASSERT_TRUE(cache.failed());
+#else
+      ASSERT_THROW(JsonPrimitive::getPrimitveType(&schemas[i]), Exception);
+#endif
+   }
 }
 
 TEST(getPrimitveType, Positive)
@@ -65,21 +101,16 @@ TEST(getPrimitveType, Positive)
 
 TEST(createPrimitive, Negative)
 {
-   JsonPrimitive *p = NULL;
-
    Json::Value a;
-   ASSERT_THROW(p = JsonPrimitive::createPrimitive(&a), Exception);
-   delete p;
-   
+   expectSchemaError(a);
+
    Json::Value b;
    b["id"] = 1;
-   ASSERT_THROW(p = JsonPrimitive::createPrimitive(&b), Exception);
-   delete p;
+   expectSchemaError(b);
 
    Json::Value c;
    c["type"] = "aaa";
-   ASSERT_THROW(p = JsonPrimitive::createPrimitive(&c), Exception);
-   delete p;
+   expectSchemaError(c);
 }
 
 TEST(createPrimitive, Positive)
@@ -142,8 +173,9 @@ TEST(IntegerPrimitive, InvalidInteger)
 
    Json::Value a = "a";
    ASSERT_EQ(jsonInt->validate(&a), JVAL_ERR_NOT_AN_INTEGER);
-   Json::Value b[0] = 1000000;
-   ASSERT_EQ(jsonInt->validate(b), JVAL_ERR_NOT_AN_INTEGER);
+   Json::Value b;
+   b[0] = 1000000;
+   ASSERT_EQ(jsonInt->validate(&b), JVAL_ERR_NOT_AN_INTEGER);
    Json::Value c = true;
    ASSERT_EQ(jsonInt->validate(&c), JVAL_ERR_NOT_AN_INTEGER);
    Json::Value d = 1.123;
@@ -934,5 +966,351 @@ TEST(ObjectPrimitive, ValidProperties)
    a["name"] = "abcd";
    a["present"] = true;
    ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+
+   // without additionalProperties the undeclared members are allowed
+   a["other"] = "x";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+   delete jsonObj;
+}
+
+TEST(ObjectPrimitive, AdditionalPropertiesTrue)
+{
+   Json::Value schema;
+   schema["type"] = "object";
+   schema["properties"]["id"]["type"] = "integer";
+   schema["additionalProperties"] = true;
+   JsonPrimitive *jsonObj = NULL;
+   ASSERT_NO_THROW((jsonObj = JsonPrimitive::createPrimitive(&schema)));
+   ASSERT_TRUE(jsonObj != NULL);
+
+   Json::Value a;
+   a["id"] = 1;
+   a["other"] = "x";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+
+   // the declared properties are validated all the same
+   a["id"] = "1";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_INVALID_PROPERTY);
+   delete jsonObj;
+}
+
+TEST(ObjectPrimitive, AdditionalPropertiesFalse)
+{
+   Json::Value schema;
+   schema["type"] = "object";
+   schema["additionalProperties"] = false;
+   JsonPrimitive *jsonObj = NULL;
+   ASSERT_NO_THROW((jsonObj = JsonPrimitive::createPrimitive(&schema)));
+   ASSERT_TRUE(jsonObj != NULL);
+
+   Json::Value a(Json::objectValue);
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+   a["id"] = 1;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_UNKNOWN_PROPERTY);
+   delete jsonObj;
+}
+
+TEST(ObjectPrimitive, AdditionalPropertiesSchema)
+{
+   Json::Value schema;
+   schema["type"] = "object";
+   schema["properties"]["id"]["type"] = "integer";
+   schema["patternProperties"]["^x-"]["type"] = "integer";
+   schema["additionalProperties"]["type"] = "string";
+   schema["additionalProperties"]["maxLength"] = 3;
+   JsonPrimitive *jsonObj = NULL;
+   ASSERT_NO_THROW((jsonObj = JsonPrimitive::createPrimitive(&schema)));
+   ASSERT_TRUE(jsonObj != NULL);
+
+   Json::Value a;
+   a["id"] = 1;
+   a["x-on"] = 1;
+   a["name"] = "abc";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+
+   // only the members no property nor pattern covers are additional
+   a["name"] = "abcd";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_INVALID_PROPERTY);
+   a["name"] = 1;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_INVALID_PROPERTY);
+   a.removeMember("name");
+   a["x-on"] = "abc";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_INVALID_PROPERTY);
+   delete jsonObj;
+
+   schema["additionalProperties"] = 1;
+   expectSchemaError(schema);
+}
+
+TEST(ObjectPrimitive, Dependencies)
+{
+   Json::Value schema;
+   schema["type"] = "object";
+   schema["dependencies"]["card"][0] = "billing";
+   schema["dependencies"]["card"][1] = "cvv";
+   schema["dependencies"]["gift"]["type"] = "object";
+   schema["dependencies"]["gift"]["required"][0] = "message";
+   JsonPrimitive *jsonObj = NULL;
+   ASSERT_NO_THROW((jsonObj = JsonPrimitive::createPrimitive(&schema)));
+   ASSERT_TRUE(jsonObj != NULL);
+
+   Json::Value a(Json::objectValue);
+   a["billing"] = 1;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+   a["card"] = 1;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_DEPENDENCY_MISSING);
+   a["cvv"] = 1;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+   a["gift"] = true;
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_INVALID_DEPENDENCY);
+   a["message"] = "x";
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+
+   Json::FastWriter writer;
+   std::string text = writer.write(a);
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(text.data(), text.data() + text.size()));
+   ASSERT_EQ(jsonObj->validate(tape.root()), JVAL_ROK);
+   delete jsonObj;
+
+   schema["dependencies"]["card"] = "billing";
+   expectSchemaError(schema);
+}
+
+TEST(ObjectPrimitive, ManyDependencies)
+{
+   // more names than the bits of one word
+   Json::Value schema;
+   schema["type"] = "object";
+   for (int i = 0; i < 100; i++) {
+      std::string name = "f" + std::to_string(i);
+      schema["dependencies"][name][0] = "f" + std::to_string((i + 1) % 100);
+   }
+   JsonPrimitive *jsonObj = NULL;
+   ASSERT_NO_THROW((jsonObj = JsonPrimitive::createPrimitive(&schema)));
+   ASSERT_TRUE(jsonObj != NULL);
+
+   Json::Value a(Json::objectValue);
+   for (int i = 0; i < 100; i++) {
+      a["f" + std::to_string(i)] = i;
+   }
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ROK);
+   a.removeMember("f70");
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_DEPENDENCY_MISSING);
+   a.removeMember("f69");
+   ASSERT_EQ(jsonObj->validate(&a), JVAL_ERR_DEPENDENCY_MISSING);
+
+   // names no rule mentions are ignored, every rule of a name present holds
+   Json::Value b(Json::objectValue);
+   b["x"] = 1;
+   ASSERT_EQ(jsonObj->validate(&b), JVAL_ROK);
+   b["f99"] = 1;
+   ASSERT_EQ(jsonObj->validate(&b), JVAL_ERR_DEPENDENCY_MISSING);
+   b["f0"] = 1;
+   ASSERT_EQ(jsonObj->validate(&b), JVAL_ERR_DEPENDENCY_MISSING);
    delete jsonObj;
 }
+
+static void expectSameAsGeneric(const char *schemaText, bool policy)
+{
+   Json::Reader reader;
+   Json::Value schema;
+   ASSERT_TRUE(reader.parse(schemaText, schema));
+
+   JsonPrimitive *selected = JsonPrimitive::createPrimitive(&schema);
+   JsonPrimitive *specialized = createPolicyPrimitive(&schema,
+         JsonPrimitive::getPrimitveType(&schema));
+   EXPECT_EQ(specialized != NULL, policy);
+
+   JsonPrimitive *generic = NULL;
+   if (schema["type"] == "integer") {
+      generic = new JsonInteger(&schema);
+   } else if (schema["type"] == "number") {
+      generic = new JsonNumber(&schema);
+   } else {
+      generic = new JsonString(&schema);
+   }
+
+   const char *instances = "[null, true, \"\", \"ab\", \"abc\", "
+      "\"abcdef\", \"xyz\", -6, -5, -4, 0, 1, 5, 9, 10, 11, -5.5, 4.5, "
+      "10.0, 10.5, 2147483647, 3000000000, -1e300]";
+   Json::Value values;
+   ASSERT_TRUE(reader.parse(instances, values));
+
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(instances));
+   JsonTapeValue::const_iterator item = tape.root().begin();
+
+   for (Json::ArrayIndex i = 0; i < values.size(); i++, ++item) {
+      EXPECT_EQ(selected->validate(&values[i]), generic->validate(&values[i]))
+         << schemaText << " " << values[i];
+      EXPECT_EQ(selected->validate(*item), generic->validate(*item))
+         << schemaText << " " << values[i];
+   }
+
+   JsonPrimitive::release(selected);
+   JsonPrimitive::release(specialized);
+   JsonPrimitive::release(generic);
+}
+
+TEST(PolicyPrimitive, SameResultAsGeneric)
+{
+   expectSameAsGeneric("{\"type\": \"integer\"}", true);
+   expectSameAsGeneric("{\"type\": \"integer\", \"minimum\": -5, "
+         "\"maximum\": 10}", true);
+   expectSameAsGeneric("{\"type\": \"integer\", \"minimum\": -5, "
+         "\"exclusiveMinimum\": true, \"maximum\": 10, "
+         "\"exclusiveMaximum\": true}", true);
+   expectSameAsGeneric("{\"type\": \"integer\", \"minimum\": 1, "
+         "\"maximum\": 9, \"multipleOf\": 2}", true);
+   expectSameAsGeneric("{\"type\": \"number\"}", true);
+   expectSameAsGeneric("{\"type\": \"number\", \"minimum\": -5.5, "
+         "\"maximum\": 9.5, \"exclusiveMaximum\": true}", true);
+   expectSameAsGeneric("{\"type\": \"number\", \"maximum\": 9.5}", true);
+   expectSameAsGeneric("{\"type\": \"string\"}", true);
+   expectSameAsGeneric("{\"type\": \"string\", \"maxLength\": 3}", true);
+   expectSameAsGeneric("{\"type\": \"string\", \"minLength\": 3, "
+         "\"maxLength\": 5, \"pattern\": \"[a-c]+\"}", true);
+   expectSameAsGeneric("{\"type\": \"string\", \"minLength\": 3}", false);
+}
+
+static int validateNumber(const char *schemaText, const char *instance)
+{
+   Json::Reader reader;
+   Json::Value schema;
+   Json::Value value;
+   EXPECT_TRUE(reader.parse(schemaText, schema));
+   EXPECT_TRUE(reader.parse(instance, value));
+
+   JsonPrimitive *primitive = JsonPrimitive::createPrimitive(&schema);
+   int ret = primitive->validate(&value);
+   delete primitive;
+   return ret;
+}
+
+TEST(NumberRange, ExactBounds)
+{
+   // bounds are no longer truncated to int
+   const char *number = "{\"type\": \"number\", \"minimum\": 1.9, "
+      "\"maximum\": 2.5}";
+   ASSERT_EQ(validateNumber(number, "1.5"), JVAL_ERR_INVALID_MINIMUM);
+   ASSERT_EQ(validateNumber(number, "1.9"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(number, "2.5"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(number, "2.7"), JVAL_ERR_INVALID_MAXIMUM);
+   ASSERT_EQ(validateNumber(number, "2"), JVAL_ROK);
+
+   // 64-bit integers compare exactly, instead of through a double
+   const char *big = "{\"type\": \"number\", "
+      "\"maximum\": 9007199254740993, \"exclusiveMaximum\": true}";
+   ASSERT_EQ(validateNumber(big, "9007199254740992"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(big, "9007199254740993"), JVAL_ERR_INVALID_MAXIMUM);
+   ASSERT_EQ(validateNumber(big, "9007199254740992.0"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(big, "18446744073709551615"),
+         JVAL_ERR_INVALID_MAXIMUM);
+   ASSERT_EQ(validateNumber(big, "1e300"), JVAL_ERR_INVALID_MAXIMUM);
+   ASSERT_EQ(validateNumber(big, "-1e300"), JVAL_ROK);
+
+   const char *unsignedMin = "{\"type\": \"number\", "
+      "\"minimum\": 18446744073709551615}";
+   ASSERT_EQ(validateNumber(unsignedMin, "18446744073709551614"),
+         JVAL_ERR_INVALID_MINIMUM);
+   ASSERT_EQ(validateNumber(unsignedMin, "-1"), JVAL_ERR_INVALID_MINIMUM);
+   ASSERT_EQ(validateNumber(unsignedMin, "18446744073709551615"), JVAL_ROK);
+
+   const char *negative = "{\"type\": \"integer\", \"minimum\": -2.5, "
+      "\"exclusiveMinimum\": true, \"maximum\": -1}";
+   ASSERT_EQ(validateNumber(negative, "-3"), JVAL_ERR_INVALID_MINIMUM);
+   ASSERT_EQ(validateNumber(negative, "-2"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(negative, "-1"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(negative, "0"), JVAL_ERR_INVALID_MAXIMUM);
+}
+
+TEST(NumberRange, MultipleOf)
+{
+   const char *integer = "{\"type\": \"integer\", \"multipleOf\": 2.5}";
+   ASSERT_EQ(validateNumber(integer, "5"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(integer, "4"), JVAL_ERR_NOT_A_MULTIPLE);
+
+   const char *big = "{\"type\": \"number\", \"multipleOf\": 3}";
+   ASSERT_EQ(validateNumber(big, "18446744073709551615"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(big, "-9223372036854775806"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(big, "-9223372036854775808"),
+         JVAL_ERR_NOT_A_MULTIPLE);
+
+   Json::Value schema;
+   schema["type"] = "number";
+   schema["multipleOf"] = 0;
+   expectSchemaError(schema);
+   schema["multipleOf"] = "2";
+   expectSchemaError(schema);
+}
+
+TEST(NumberRange, DecimalMultipleOf)
+{
+   // fmod(0.07, 0.01) is 0.00999..., far from both 0 and 0.01
+   const char *cents = "{\"type\": \"number\", \"multipleOf\": 0.01}";
+   ASSERT_EQ(validateNumber(cents, "0.07"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "19.99"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "-0.13"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "123456789.12"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "100"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "1e20"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(cents, "0.015"), JVAL_ERR_NOT_A_MULTIPLE);
+   ASSERT_EQ(validateNumber(cents, "1e-20"), JVAL_ERR_NOT_A_MULTIPLE);
+   ASSERT_EQ(validateNumber(cents, "0.30000000000000004"),
+         JVAL_ERR_NOT_A_MULTIPLE);
+
+   const char *tenths = "{\"type\": \"number\", \"multipleOf\": 0.1}";
+   ASSERT_EQ(validateNumber(tenths, "0.7"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(tenths, "2.3"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(tenths, "2.35"), JVAL_ERR_NOT_A_MULTIPLE);
+
+   const char *small = "{\"type\": \"number\", \"multipleOf\": 0.0001}";
+   ASSERT_EQ(validateNumber(small, "0.0075"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(small, "0.00751"), JVAL_ERR_NOT_A_MULTIPLE);
+
+   // 1.5 is 15 / 10, so an integer must be divisible by 3
+   const char *step = "{\"type\": \"number\", \"multipleOf\": 1.5}";
+   ASSERT_EQ(validateNumber(step, "4.5"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(step, "36"), JVAL_ROK);
+   ASSERT_EQ(validateNumber(step, "35"), JVAL_ERR_NOT_A_MULTIPLE);
+   ASSERT_EQ(validateNumber(step, "9007199254740997"), JVAL_ERR_NOT_A_MULTIPLE);
+
+   JsonNumberValue divisor = {JsonNumberValue::REAL, 0, 0, 0.25};
+   JsonMultipleOf quarter = JsonMultipleOf::of(divisor);
+   ASSERT_TRUE(quarter.decimal);
+   ASSERT_EQ(quarter.units, 25U);
+   ASSERT_EQ(quarter.scale, 2U);
+   ASSERT_EQ(quarter.step, 1U);
+
+   // the double nearest 1/3 reads back from 16 digits, the shortest form
+   divisor.d = 1.0 / 3;
+   JsonMultipleOf third = JsonMultipleOf::of(divisor);
+   ASSERT_TRUE(third.decimal);
+   ASSERT_EQ(third.scale, 16U);
+
+   // more than 18 fractional digits keeps the floating point test
+   divisor.d = 1e-19;
+   JsonMultipleOf tiny = JsonMultipleOf::of(divisor);
+   ASSERT_FALSE(tiny.decimal);
+   JsonNumberValue zero = {JsonNumberValue::INTEGER, 0, 0, 0};
+   ASSERT_TRUE(tiny.check(zero));
+}
+
+TEST(NumberRange, Compare)
+{
+   JsonNumberValue a = {JsonNumberValue::REAL, 0, 0, -0.5};
+   JsonNumberValue b = {JsonNumberValue::INTEGER, 0, 0, 0};
+   JsonNumberValue c = {JsonNumberValue::UNSIGNED, 0, 1ULL << 63, 0};
+   JsonNumberValue d = {JsonNumberValue::REAL, 0, 0, 9223372036854775808.0};
+   JsonNumberValue nan = {JsonNumberValue::REAL, 0, 0,
+      std::numeric_limits<double>::quiet_NaN()};
+
+   ASSERT_EQ(JsonNumberValue::compare(a, b), -1);
+   ASSERT_EQ(JsonNumberValue::compare(b, a), 1);
+   ASSERT_EQ(JsonNumberValue::compare(c, d), 0);
+   ASSERT_EQ(JsonNumberValue::compare(d, c), 0);
+   ASSERT_EQ(JsonNumberValue::compare(b, c), -1);
+   ASSERT_EQ(JsonNumberValue::compare(nan, b), JSON_NUMBER_UNORDERED);
+   ASSERT_EQ(JsonNumberValue::compare(b, nan), JSON_NUMBER_UNORDERED);
+}
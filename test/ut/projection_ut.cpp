@@ -0,0 +1,253 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "primitive_base.h"
+#include "projection.h"
+#include "validator.h"
+
+static const char *orderSchema = "{\"type\": \"object\", "
+   "\"required\": [\"id\"], \"additionalProperties\": false, "
+   "\"properties\": {"
+   "\"id\": {\"type\": \"integer\", \"minimum\": 1}, "
+   "\"name\": {\"type\": \"string\", \"maxLength\": 5}, "
+   "\"tags\": {\"type\": \"array\", "
+   "\"items\": {\"type\": \"string\", \"minLength\": 2}}, "
+   "\"point\": {\"type\": \"array\", \"additionalItems\": false, "
+   "\"items\": [{\"type\": \"number\"}, {\"type\": \"number\"}]}, "
+   "\"meta\": {\"type\": \"object\", "
+   "\"additionalProperties\": {\"type\": \"integer\"}}}, "
+   "\"patternProperties\": {\"^x-\": {\"type\": \"string\"}}}";
+
+static int project(JsonValidator &validator, const Json::Value &doc,
+      const char *pointer)
+{
+   std::vector<std::string> pointers(1, pointer);
+   return validator.validateProjection(&doc, pointers);
+}
+
+TEST(JsonProjection, SelectedLocations)
+{
+   std::string schema(orderSchema);
+   JsonValidator validator(schema);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse("{\"id\": 0, \"name\": \"toolong\", "
+            "\"tags\": [\"ok\"]}", doc));
+   ASSERT_EQ(validator.validate(&doc), JVAL_ERR_INVALID_PROPERTY);
+
+   // the invalid members are not selected
+   ASSERT_EQ(project(validator, doc, "/tags"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/tags/0"), JVAL_ROK);
+
+   ASSERT_EQ(project(validator, doc, "/name"), JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(project(validator, doc, "/id"), JVAL_ERR_INVALID_PROPERTY);
+
+   std::vector<std::string> pointers;
+   pointers.push_back("/tags");
+   pointers.push_back("/name");
+   ASSERT_EQ(validator.validateProjection(&doc, pointers),
+         JVAL_ERR_INVALID_PROPERTY);
+
+   // nor are the keywords of the root which look at other members
+   Json::Value partial;
+   ASSERT_TRUE(reader.parse("{\"name\": \"ok\"}", partial));
+   ASSERT_EQ(validator.validate(&partial), JVAL_ERR_REQUIRED_ITEM_MISSING);
+   ASSERT_EQ(project(validator, partial, "/name"), JVAL_ROK);
+
+   // nothing selected
+   ASSERT_EQ(validator.validateProjection(&doc, std::vector<std::string>()),
+         JVAL_ROK);
+}
+
+TEST(JsonProjection, NestedLocations)
+{
+   std::string schema(orderSchema);
+   JsonValidator validator(schema);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse("{\"id\": 1, \"tags\": [\"ok\", \"x\"], "
+            "\"point\": [1, \"a\", 3], \"meta\": {\"a\": 1, \"b\": \"s\"}, "
+            "\"x-a\": 1, \"x-b\": \"s\", \"zz\": 1}", doc));
+
+   // items
+   ASSERT_EQ(project(validator, doc, "/tags/0"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/tags/1"), JVAL_ERR_INVALID_PROPERTY);
+
+   // tuples and additionalItems
+   ASSERT_EQ(project(validator, doc, "/point/0"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/point/1"), JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(project(validator, doc, "/point/2"), JVAL_ERR_INVALID_PROPERTY);
+
+   // additionalProperties as a subschema, patternProperties and refused
+   // members
+   ASSERT_EQ(project(validator, doc, "/meta/a"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/meta/b"), JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(project(validator, doc, "/x-b"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/x-a"), JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(project(validator, doc, "/zz"), JVAL_ERR_UNKNOWN_PROPERTY);
+
+   // locations the document does not have
+   ASSERT_EQ(project(validator, doc, "/tags/-"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/tags/7"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/missing/a"), JVAL_ROK);
+   ASSERT_EQ(project(validator, doc, "/id/a"), JVAL_ROK);
+
+   std::string tuple("{\"type\": \"array\", \"additionalItems\": false, "
+         "\"items\": [{\"type\": \"number\"}, {\"type\": \"number\"}]}");
+   JsonValidator point(tuple);
+   Json::Value items;
+   ASSERT_TRUE(reader.parse("[1, 2, 3]", items));
+   ASSERT_EQ(project(point, items, "/1"), JVAL_ROK);
+   ASSERT_EQ(project(point, items, "/2"), JVAL_ERR_ADDITIONAL_ITEMS);
+   ASSERT_EQ(project(point, items, "/2"), point.validate(&items));
+}
+
+TEST(JsonProjection, AncestorTypes)
+{
+   std::string schema(orderSchema);
+   JsonValidator validator(schema);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse("{\"id\": 1, \"meta\": [1], \"name\": 5}", doc));
+   ASSERT_EQ(project(validator, doc, "/meta/a"), JVAL_ERR_INVALID_PROPERTY);
+   ASSERT_EQ(project(validator, doc, "/name/a"), JVAL_ERR_INVALID_PROPERTY);
+
+   Json::Value array;
+   ASSERT_TRUE(reader.parse("[{\"id\": 1}]", array));
+   ASSERT_EQ(project(validator, array, "/0/id"), JVAL_ERR_NOT_AN_OBJECT);
+   ASSERT_EQ(project(validator, array, "/0/id"), validator.validate(&array));
+}
+
+TEST(JsonProjection, WholeDocument)
+{
+   std::string schema(orderSchema);
+   JsonValidator validator(schema);
+
+   const char *documents[] = {
+      "{\"id\": 1, \"tags\": [\"ok\"], \"point\": [1, 2]}",
+      "{\"id\": 1, \"tags\": [\"o\"]}",
+      "{\"name\": \"ok\"}",
+      "{\"id\": 1, \"zz\": 1}",
+      "[]",
+   };
+
+   Json::Reader reader;
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      Json::Value doc;
+      ASSERT_TRUE(reader.parse(documents[i], doc));
+      ASSERT_EQ(project(validator, doc, ""), validator.validate(&doc))
+         << documents[i];
+
+      // malformed pointers select everything
+      ASSERT_EQ(project(validator, doc, "tags"), validator.validate(&doc))
+         << documents[i];
+   }
+
+   JsonValidator none;
+   Json::Value doc;
+   ASSERT_EQ(project(none, doc, ""), JVAL_ERR_INVALID_SCHEMA);
+}
+
+TEST(JsonProjection, Cache)
+{
+   Json::Reader reader;
+   Json::Value schema;
+   ASSERT_TRUE(reader.parse(orderSchema, schema));
+   JsonPrimitive *primitive = JsonPrimitive::createPrimitive(&schema);
+
+   JsonProjectionCache cache(2);
+   std::vector<std::string> tags(1, "/tags/0");
+   std::vector<std::string> name(1, "/name");
+
+   std::shared_ptr<const JsonProjection> first = cache.find(primitive, tags);
+   ASSERT_TRUE(first->isValid());
+   ASSERT_EQ(cache.find(primitive, tags).get(), first.get());
+   ASSERT_NE(cache.find(primitive, name).get(), first.get());
+   ASSERT_EQ(cache.size(), 2U);
+
+   // only the nodes along the pointers are kept
+   ASSERT_EQ(first->size(), 3U);
+
+   // starts over when full
+   std::vector<std::string> bad(1, "name");
+   ASSERT_FALSE(cache.find(primitive, bad)->isValid());
+   ASSERT_EQ(cache.size(), 1U);
+   ASSERT_NE(cache.find(primitive, tags).get(), first.get());
+
+   cache.clear();
+   ASSERT_EQ(cache.size(), 0U);
+
+   first.reset();
+   JsonPrimitive::release(primitive);
+}
+
+// Validates the same documents as the other threads, through the shared
+// projections of the validator
+static void projectMany(JsonValidator *validator, const Json::Value *doc,
+      int *failures)
+{
+   const char *pointers[] = {"/tags/1", "/meta/a", "/zz", "/point/0"};
+   const int expected[] = {JVAL_ERR_INVALID_PROPERTY, JVAL_ROK,
+      JVAL_ERR_UNKNOWN_PROPERTY, JVAL_ROK};
+
+   for (int i = 0; i < 400; i++) {
+      if (project(*validator, *doc, pointers[i % 4]) != expected[i % 4]) {
+         (*failures)++;
+      }
+   }
+}
+
+TEST(JsonProjection, Threads)
+{
+   std::string schema(orderSchema);
+   JsonValidator validator(schema);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse("{\"id\": 1, \"tags\": [\"ok\", \"x\"], "
+            "\"point\": [1, 2], \"meta\": {\"a\": 1}, \"zz\": 1}", doc));
+
+   std::vector<int> failures(4, 0);
+   std::vector<std::thread> threads;
+   for (size_t i = 0; i < failures.size(); i++) {
+      threads.push_back(std::thread(projectMany, &validator, &doc,
+               &failures[i]));
+   }
+
+   for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+      ASSERT_EQ(failures[i], 0);
+   }
+}
@@ -0,0 +1,240 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <json.h>
+#include "gtest/gtest.h"
+
+static double parseDouble(const char *text)
+{
+   Json::Reader reader;
+   Json::Value root;
+   std::string doc = std::string("[") + text + "]";
+   EXPECT_TRUE(reader.parse(doc, root));
+   return root[0].asDouble();
+}
+
+static double parseDoubleCharReader(const char *text)
+{
+   Json::CharReaderBuilder builder;
+   std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+   Json::Value root;
+   std::string errs;
+   std::string doc = std::string("[") + text + "]";
+   EXPECT_TRUE(reader->parse(doc.data(), doc.data() + doc.size(), &root, &errs));
+   return root[0].asDouble();
+}
+
+TEST(DecodeDouble, MatchesStrtod)
+{
+   const char *numbers[] = {
+      "0.0", "-0.0", "1.5", "0.1", "0.01", "3.14159", "-273.15",
+      "1e22", "1e23", "9007199254740993.0", "1.7976931348623157e308",
+      "2.2250738585072014e-308", "4.9406564584124654e-324",
+      "2.4703282292062327e-324", "0.30000000000000004",
+      "123456789012345678901234567890.5", "1.00000000000000011102230246251565e0",
+      "7.038531e-26", "8.98846567431158e307", "4.35679e-3"
+   };
+
+   for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+      double expected = strtod(numbers[i], NULL);
+      double a = parseDouble(numbers[i]);
+      double b = parseDoubleCharReader(numbers[i]);
+      ASSERT_EQ(0, memcmp(&a, &expected, sizeof(double))) << numbers[i];
+      ASSERT_EQ(0, memcmp(&b, &expected, sizeof(double))) << numbers[i];
+   }
+}
+
+TEST(DecodeDouble, Overflow)
+{
+   ASSERT_EQ(parseDouble("1e400"), std::numeric_limits<double>::infinity());
+   ASSERT_EQ(parseDouble("-1e400"), -std::numeric_limits<double>::infinity());
+   ASSERT_EQ(parseDouble("1e-400"), 0.0);
+}
+
+TEST(DecodeDouble, Malformed)
+{
+   Json::Reader reader;
+   Json::Value root;
+   ASSERT_FALSE(reader.parse("[1.]", root));
+   ASSERT_FALSE(reader.parse("[1e]", root));
+   ASSERT_FALSE(reader.parse("[-]", root));
+   ASSERT_FALSE(reader.parse("[1.5e+]", root));
+}
+
+TEST(DecodeDouble, LocaleIndependent)
+{
+   const char *locales[] = {"de_DE.UTF-8", "fr_FR.UTF-8", "de_DE", "fr_FR"};
+   const char *previous = setlocale(LC_NUMERIC, NULL);
+   std::string saved = previous ? previous : "C";
+
+   for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); i++) {
+      if (setlocale(LC_NUMERIC, locales[i]) != NULL) {
+         break;
+      }
+   }
+
+   double a = parseDouble("1.25");
+   double b = parseDoubleCharReader("1.25");
+   setlocale(LC_NUMERIC, saved.c_str());
+   ASSERT_EQ(a, 1.25);
+   ASSERT_EQ(b, 1.25);
+}
+
+TEST(DecodeNumber, Integers)
+{
+   Json::Reader reader;
+   Json::Value root;
+   ASSERT_TRUE(reader.parse("[0, -1, 2147483648, 9223372036854775807, "
+            "-9223372036854775808, 18446744073709551615, "
+            "18446744073709551616]", root));
+   ASSERT_TRUE(root[0].isInt());
+   ASSERT_EQ(root[1].asInt(), -1);
+   ASSERT_EQ(root[2].asInt64(), 2147483648LL);
+   ASSERT_EQ(root[3].asInt64(), std::numeric_limits<Json::Int64>::max());
+   ASSERT_EQ(root[4].asInt64(), std::numeric_limits<Json::Int64>::min());
+   ASSERT_EQ(root[5].asUInt64(), std::numeric_limits<Json::UInt64>::max());
+   ASSERT_TRUE(root[6].isDouble());
+   ASSERT_EQ(root[6].asDouble(), 18446744073709551616.0);
+}
+
+static Json::Value parseNumber(const char *text, bool charReader)
+{
+   Json::Value root;
+   std::string doc = std::string("[") + text + "]";
+   if (charReader) {
+      Json::CharReaderBuilder builder;
+      std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+      std::string errs;
+      EXPECT_TRUE(reader->parse(doc.data(), doc.data() + doc.size(), &root,
+               &errs));
+   } else {
+      Json::Reader reader;
+      EXPECT_TRUE(reader.parse(doc, root));
+   }
+   return root[0];
+}
+
+TEST(DecodeNumber, Limits)
+{
+   for (int i = 0; i < 2; i++) {
+      bool charReader = (1 == i);
+
+      Json::Value v = parseNumber("-9223372036854775807", charReader);
+      ASSERT_TRUE(v.isInt64());
+      ASSERT_EQ(v.asInt64(), std::numeric_limits<Json::Int64>::min() + 1);
+
+      v = parseNumber("-9223372036854775808", charReader);
+      ASSERT_TRUE(v.isInt64());
+      ASSERT_EQ(v.asInt64(), std::numeric_limits<Json::Int64>::min());
+
+      // one past -2^63, same digit count
+      v = parseNumber("-9223372036854775809", charReader);
+      ASSERT_EQ(v.type(), Json::realValue);
+      ASSERT_EQ(v.asDouble(), -9223372036854775809.0);
+
+      v = parseNumber("-9999999999999999999", charReader);
+      ASSERT_EQ(v.type(), Json::realValue);
+      ASSERT_EQ(v.asDouble(), -9999999999999999999.0);
+
+      // non-negative integers past Value::maxInt are kept unsigned
+      v = parseNumber("9223372036854775807", charReader);
+      ASSERT_EQ(v.type(), Json::uintValue);
+      ASSERT_EQ(v.asInt64(), std::numeric_limits<Json::Int64>::max());
+
+      v = parseNumber("9223372036854775808", charReader);
+      ASSERT_EQ(v.type(), Json::uintValue);
+      ASSERT_EQ(v.asUInt64(), 9223372036854775808ULL);
+
+      v = parseNumber("18446744073709551615", charReader);
+      ASSERT_EQ(v.type(), Json::uintValue);
+      ASSERT_EQ(v.asUInt64(), std::numeric_limits<Json::UInt64>::max());
+
+      v = parseNumber("18446744073709551616", charReader);
+      ASSERT_EQ(v.type(), Json::realValue);
+
+      v = parseNumber("-18446744073709551615", charReader);
+      ASSERT_EQ(v.type(), Json::realValue);
+      ASSERT_EQ(v.asDouble(), -18446744073709551615.0);
+   }
+}
+
+TEST(Arena, ParseInScope)
+{
+   std::string doc = "{\"name\": \"a fairly long string value\", "
+      "\"tags\": [\"x\", \"y\\n\"], \"nested\": {\"k\": 1.5}}";
+   Json::Arena arena(256);
+   Json::Value outside(Json::objectValue);
+   outside["kept"] = "allocated on the heap before the scope";
+   outside["removed0"] = "released inside the scope";
+   outside["removed1"] = "released inside the scope";
+   outside["removed2"] = "released inside the scope";
+
+   for (int i = 0; i < 3; i++) {
+      {
+         Json::Arena::Scope scope(arena);
+         ASSERT_EQ(Json::Arena::current(), &arena);
+
+         Json::Reader reader;
+         Json::Value root;
+         ASSERT_TRUE(reader.parse(doc, root));
+         ASSERT_EQ(root["name"].asString(), "a fairly long string value");
+         ASSERT_EQ(root["tags"][1].asString(), "y\n");
+         ASSERT_EQ(root["nested"]["k"].asDouble(), 1.5);
+         ASSERT_GT(arena.used(), 0U);
+
+         // heap values can still be released inside the scope
+         std::string name = "removed" + std::string(1, static_cast<char>('0' + i));
+         outside.removeMember(name);
+      }
+      ASSERT_TRUE(Json::Arena::current() == NULL);
+      arena.reset();
+      ASSERT_EQ(arena.used(), 0U);
+   }
+
+   ASSERT_EQ(outside.size(), 1U);
+   ASSERT_EQ(outside["kept"].asString(),
+         "allocated on the heap before the scope");
+}
+
+TEST(Arena, ResetMergesBlocks)
+{
+   Json::Arena arena(64);
+   for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(arena.allocate(48) != NULL);
+   }
+   size_t reserved = arena.reserved();
+   arena.reset();
+   ASSERT_EQ(arena.reserved(), reserved);
+
+   void *p = arena.allocate(reserved / 2);
+   ASSERT_TRUE(arena.owns(p));
+   ASSERT_EQ(arena.reserved(), reserved);
+
+   int local = 0;
+   ASSERT_FALSE(arena.owns(&local));
+}
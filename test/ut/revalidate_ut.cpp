@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <random>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "json_pointer.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+TEST(JsonPointer, Parse)
+{
+   std::vector<std::string> tokens;
+
+   ASSERT_TRUE(parseJsonPointer("", tokens));
+   ASSERT_TRUE(tokens.empty());
+
+   ASSERT_TRUE(parseJsonPointer("/a~1b/~0c/0/", tokens));
+   ASSERT_EQ(tokens.size(), 4U);
+   ASSERT_EQ(tokens[0], "a/b");
+   ASSERT_EQ(tokens[1], "~c");
+   ASSERT_EQ(tokens[2], "0");
+   ASSERT_EQ(tokens[3], "");
+
+   ASSERT_FALSE(parseJsonPointer("a", tokens));
+   ASSERT_FALSE(parseJsonPointer("/a~", tokens));
+   ASSERT_FALSE(parseJsonPointer("/a~2", tokens));
+
+   unsigned int index = 0;
+   ASSERT_TRUE(JsonPointerNode::toIndex("12", 3, index));
+   ASSERT_EQ(index, 12U);
+   ASSERT_TRUE(JsonPointerNode::toIndex("-", 3, index));
+   ASSERT_EQ(index, 2U);
+   ASSERT_FALSE(JsonPointerNode::toIndex("-", 0, index));
+   ASSERT_FALSE(JsonPointerNode::toIndex("01", 3, index));
+   ASSERT_FALSE(JsonPointerNode::toIndex("1a", 3, index));
+}
+
+TEST(JsonPointer, Tree)
+{
+   JsonPointerNode root;
+   ASSERT_TRUE(root.add("/a/b"));
+   ASSERT_TRUE(root.add("/a"));
+   ASSERT_TRUE(root.add("/a/c"));
+   ASSERT_TRUE(root.add("/d/3"));
+   ASSERT_TRUE(root.add("/d/1/x"));
+   ASSERT_FALSE(root.add("d"));
+
+   ASSERT_FALSE(root.isFull());
+   ASSERT_TRUE(root.find("a")->isFull());
+   ASSERT_TRUE(NULL == root.find("b"));
+
+   const JsonPointerNode *d = root.find("d");
+   ASSERT_FALSE(d->isFull());
+   unsigned int index = 0;
+   ASSERT_TRUE(d->minIndex(5, index));
+   ASSERT_EQ(index, 1U);
+   ASSERT_FALSE(root.minIndex(5, index));
+}
+
+static const char *schema = "{\"type\": \"object\", "
+   "\"required\": [\"id\", \"items\"], \"maxProperties\": 5, "
+   "\"additionalProperties\": false, \"properties\": {"
+   "\"id\": {\"type\": \"integer\", \"minimum\": 0, \"maximum\": 50}, "
+   "\"a/b\": {\"type\": \"string\", \"maxLength\": 3}, "
+   "\"t~\": {\"type\": \"array\", \"items\": [{\"type\": \"string\"}, "
+   "{\"type\": \"integer\"}, {\"type\": \"boolean\"}], "
+   "\"additionalItems\": false}, "
+   "\"items\": {\"type\": \"array\", \"maxItems\": 8, \"uniqueItems\": true, "
+   "\"items\": {\"type\": \"object\", \"required\": [\"n\"], "
+   "\"additionalProperties\": false, \"properties\": {"
+   "\"n\": {\"type\": \"number\", \"multipleOf\": 0.5}, "
+   "\"s\": {\"type\": \"string\", \"pattern\": \"^[a-c]*$\"}, "
+   "\"l\": {\"type\": \"array\", \"minItems\": 1, "
+   "\"items\": {\"type\": \"integer\", \"maximum\": 10}}}}}, "
+   "\"meta\": {\"type\": \"object\", \"additionalProperties\": true}}}";
+
+static const char *document = "{\"id\": 7, \"a/b\": \"ab\", "
+   "\"t~\": [\"x\", 1], \"items\": ["
+   "{\"n\": 1, \"s\": \"abc\", \"l\": [1, 2]}, {\"n\": 1.5}, "
+   "{\"n\": 2, \"l\": [3]}], \"meta\": {\"k\": [1, {}]}}";
+
+static const char *keys[] = {
+   "id", "a/b", "t~", "items", "meta", "n", "s", "l", "k", "other"
+};
+
+class RandomEdits
+{
+   public:
+      RandomEdits(unsigned int seed) : m_random(seed) {}
+
+      unsigned int next(unsigned int n) {
+         return std::uniform_int_distribution<unsigned int>(0, n - 1)(m_random);
+      }
+
+      Json::Value value(int depth) {
+         switch (next(depth > 0 ? 8 : 6)) {
+            case 0:
+               return Json::Value();
+            case 1:
+               return Json::Value(next(2) == 1);
+            case 2:
+               return Json::Value(static_cast<int>(next(60)) - 5);
+            case 3:
+               return Json::Value(next(24) * 0.25);
+            case 4:
+            case 5: {
+               const char *strings[] = {"", "a", "abc", "abcd", "xy", "ba"};
+               return Json::Value(strings[next(6)]);
+            }
+            case 6: {
+               Json::Value array(Json::arrayValue);
+               for (unsigned int i = next(4); i > 0; i--) {
+                  array.append(value(depth - 1));
+               }
+               return array;
+            }
+            default: {
+               Json::Value object(Json::objectValue);
+               for (unsigned int i = next(4); i > 0; i--) {
+                  object[keys[next(10)]] = value(depth - 1);
+               }
+               return object;
+            }
+         }
+      }
+
+      /**
+       * @brief Applies a random JSON Patch style operation to a random
+       * location of the document and records the pointers it touched
+       */
+      void edit(Json::Value &document, std::vector<std::string> &pointers) {
+         std::vector<Json::Value*> nodes;
+         std::vector<std::string> paths;
+         collect(document, "", nodes, paths);
+
+         unsigned int n = next(nodes.size());
+         Json::Value &node = *nodes[n];
+         const std::string &path = paths[n];
+
+         if (node.isObject() && next(3) > 0) {
+            std::string key = keys[next(10)];
+            if (next(2) == 0 && node.size() > 0) {
+               key = node.getMemberNames()[next(node.size())];
+               node.removeMember(key);
+            } else {
+               node[key] = value(2);
+            }
+            pointers.push_back(path + "/" + escape(key));
+         } else if (node.isArray() && next(3) > 0) {
+            unsigned int index = next(node.size() + 1);
+            if (next(2) == 0 && index < node.size()) {
+               Json::Value removed;
+               node.removeIndex(index, &removed);
+               pointers.push_back(path + "/" + std::to_string(index));
+            } else {
+               Json::Value array(Json::arrayValue);
+               for (Json::ArrayIndex i = 0; i <= node.size(); i++) {
+                  if (i == index) {
+                     array.append(value(2));
+                  }
+                  if (i < node.size()) {
+                     array.append(node[i]);
+                  }
+               }
+               node.swap(array);
+               pointers.push_back(path + "/" + (index == node.size() - 1 ? \
+                        std::string("-") : std::to_string(index)));
+            }
+         } else if (node.isNumeric() && next(2) == 0) {
+            node = node.asDouble() + 0.5;
+            pointers.push_back(path);
+         } else {
+            node = value(2);
+            pointers.push_back(path);
+         }
+      }
+
+   private:
+      static std::string escape(const std::string &key) {
+         std::string token;
+         for (size_t i = 0; i < key.size(); i++) {
+            if (key[i] == '~') {
+               token += "~0";
+            } else if (key[i] == '/') {
+               token += "~1";
+            } else {
+               token += key[i];
+            }
+         }
+         return token;
+      }
+
+      static void collect(Json::Value &node, const std::string &path,
+            std::vector<Json::Value*> &nodes,
+            std::vector<std::string> &paths) {
+         nodes.push_back(&node);
+         paths.push_back(path);
+
+         if (node.isArray()) {
+            for (Json::ArrayIndex i = 0; i < node.size(); i++) {
+               collect(node[i], path + "/" + std::to_string(i), nodes, paths);
+            }
+         } else if (node.isObject()) {
+            std::vector<std::string> names = node.getMemberNames();
+            for (size_t i = 0; i < names.size(); i++) {
+               collect(node[names[i]], path + "/" + escape(names[i]),
+                     nodes, paths);
+            }
+         }
+      }
+
+      std::mt19937 m_random;
+};
+
+TEST(JsonValidatorRevalidate, SameResultAsValidate)
+{
+   std::string str(schema);
+   JsonValidator validator(str);
+
+   Json::Reader reader;
+   Json::Value original;
+   ASSERT_TRUE(reader.parse(document, original));
+   ASSERT_EQ(validator.validate(&original), JVAL_ROK);
+
+   RandomEdits random(2016);
+   Json::Value doc = original;
+   unsigned int invalid = 0;
+
+   for (int i = 0; i < 20000; i++) {
+      Json::Value before = doc;
+      std::vector<std::string> pointers;
+      for (unsigned int n = random.next(3) + 1; n > 0; n--) {
+         random.edit(doc, pointers);
+      }
+
+      int ret = validator.validate(&doc);
+      ASSERT_EQ(validator.revalidate(&doc, pointers), ret) << \
+         "after " << pointers.back() << " in " << doc.toStyledString();
+
+      if (ret != JVAL_ROK) {
+         doc = before;
+         invalid++;
+      }
+   }
+
+   // both outcomes have to be exercised
+   ASSERT_GT(invalid, 1000U);
+   ASSERT_LT(invalid, 19000U);
+}
+
+TEST(JsonValidatorRevalidate, Fallbacks)
+{
+   std::string str(schema);
+   JsonValidator validator(str);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse(document, doc));
+
+   std::vector<std::string> pointers;
+   doc["id"] = 100;
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ROK);
+
+   pointers.push_back("id");
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+
+   pointers[0] = "/id";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+
+   doc["id"] = 1;
+   doc["items"][1]["x"] = 1;
+   pointers[0] = "/items/1/x";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+}
+
+TEST(JsonValidatorRevalidate, AdditionalProperties)
+{
+   std::string str = "{\"type\": \"object\", "
+      "\"properties\": {\"id\": {\"type\": \"integer\"}}, "
+      "\"additionalProperties\": {\"type\": \"array\", \"maxItems\": 1}}";
+   JsonValidator validator(str);
+
+   Json::Reader reader;
+   Json::Value doc;
+   ASSERT_TRUE(reader.parse("{\"id\": 1, \"a\": [1], \"b\": []}", doc));
+   ASSERT_EQ(validator.validate(&doc), JVAL_ROK);
+
+   std::vector<std::string> pointers(1, "/a/1");
+   doc["a"].append(2);
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+
+   doc["a"].resize(1);
+   doc["id"] = "1";
+   pointers[0] = "/id";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+
+   doc["id"] = 1;
+   doc["c"] = 3;
+   pointers[0] = "/c";
+   ASSERT_EQ(validator.revalidate(&doc, pointers), JVAL_ERR_INVALID_PROPERTY);
+}
@@ -0,0 +1,130 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "memo.h"
+#include "memory_usage.h"
+#include "primitive_base.h"
+#include "schema_cache.h"
+#include "validator.h"
+
+static const char *names = "{\"type\": \"object\", "
+   "\"additionalProperties\": false, \"properties\": {"
+   "\"first\": {\"type\": \"string\", \"maxLength\": 4, "
+   "\"pattern\": \"^[a-z]+$\", \"description\": \"first name\"}, "
+   "\"last\": {\"type\": \"string\", \"maxLength\": 4, "
+   "\"pattern\": \"^[a-z]+$\", \"description\": \"last name\"}, "
+   "\"aliases\": {\"type\": \"array\", \"items\": {\"type\": \"string\", "
+   "\"maxLength\": 4, \"pattern\": \"^[a-z]+$\"}}}}";
+
+TEST(JsonSchemaCache, Canonical)
+{
+   Json::Value schema = parse("{\"type\": \"object\", \"title\": \"t\", "
+         "\"properties\": {\"title\": {\"type\": \"string\", "
+         "\"description\": \"d\", \"default\": \"x\"}, "
+         "\"list\": {\"type\": \"array\", \"$comment\": \"c\", "
+         "\"items\": [{\"type\": \"null\", \"examples\": [null]}]}}}");
+
+   Json::Value expected = parse("{\"type\": \"object\", "
+         "\"properties\": {\"title\": {\"type\": \"string\"}, "
+         "\"list\": {\"type\": \"array\", "
+         "\"items\": [{\"type\": \"null\"}]}}}");
+
+   ASSERT_EQ(JsonSchemaCache::canonical(schema), expected);
+   ASSERT_EQ(JsonMemo::hash(JsonSchemaCache::canonical(schema)),
+         JsonMemo::hash(expected));
+}
+
+TEST(JsonSchemaCache, Shared)
+{
+   Json::Value schema = parse(names);
+
+   JsonSchemaCache cache;
+   JsonPrimitive *primitive = NULL;
+   {
+      JsonSchemaCache::Scope scope(cache);
+      primitive = JsonPrimitive::createPrimitive(&schema);
+   }
+   ASSERT_TRUE(NULL != primitive);
+   ASSERT_EQ(cache.hits(), 2U);
+   // the string subschema, the array and the root
+   ASSERT_EQ(cache.size(), 3U);
+   ASSERT_TRUE(NULL == JsonSchemaCache::current());
+
+   JsonPrimitive::release(primitive);
+}
+
+TEST(JsonSchemaCache, MemoryUsage)
+{
+   Json::Value schema = parse(names);
+   JsonValidator shared(&schema);
+
+   schema["properties"]["last"]["maxLength"] = 5;
+   schema["properties"]["aliases"]["items"]["maxLength"] = 6;
+   JsonValidator distinct(&schema);
+
+   JsonMemoryUsage sharedUsage;
+   shared.memoryUsage(sharedUsage);
+   JsonMemoryUsage distinctUsage;
+   distinct.memoryUsage(distinctUsage);
+
+   // two fewer compiled patterns
+   ASSERT_LT(sharedUsage.total() + 2 * JsonMemoryUsage::regexBytes(8),
+         distinctUsage.total());
+
+   // counted at the first location only, members go in name order
+   ASSERT_TRUE(sharedUsage.byPath().count("/properties/aliases/items"));
+   ASSERT_FALSE(sharedUsage.byPath().count("/properties/first"));
+   ASSERT_FALSE(sharedUsage.byPath().count("/properties/last"));
+   ASSERT_TRUE(distinctUsage.byPath().count("/properties/last"));
+}
+
+TEST(JsonSchemaCache, Validate)
+{
+   Json::Value schema = parse(names);
+   JsonValidator *validator = new JsonValidator(&schema);
+
+   Json::Value value = parse("{\"first\": \"ab\", \"last\": \"cd\", "
+         "\"aliases\": [\"ef\", \"gh\"]}");
+   ASSERT_EQ(validator->validate(&value), JVAL_ROK);
+
+   value["last"] = "toolong";
+   ASSERT_EQ(validator->validate(&value), JVAL_ERR_INVALID_PROPERTY);
+
+   value["last"] = "cd";
+   value["aliases"][1] = "X";
+   ASSERT_EQ(validator->validate(&value), JVAL_ERR_INVALID_PROPERTY);
+
+   std::vector<std::string> pointers(1, "/aliases/1");
+   ASSERT_EQ(validator->revalidate(&value, pointers),
+         JVAL_ERR_INVALID_PROPERTY);
+
+   // the shared primitive goes with its last reference
+   delete validator;
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "tape.h"
+#include "skip_plan.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+static const char *webhookSchema = "{\"type\": \"object\", "
+   "\"required\": [\"event\", \"vendor\"], \"properties\": {"
+   "\"event\": {\"type\": \"string\", \"minLength\": 2}, "
+   "\"vendor\": {\"type\": \"object\", \"maxProperties\": 3}, "
+   "\"items\": {\"type\": \"array\", \"maxItems\": 3, "
+   "\"items\": [{\"type\": \"integer\"}]}}}";
+
+TEST(JsonSkipPlan, SkippedValues)
+{
+   std::string schema(webhookSchema);
+   JsonValidator validator(schema);
+   ASSERT_TRUE(NULL != validator.skipPlan());
+
+   std::string document("{\"event\": \"push\", \"vendor\": {\"a\": [1, "
+         "{\"b\": \"\\u00e9\"}], \"c\": 1e5}, \"items\": [1, {\"x\": null}], "
+         "\"extra\" : \"\\\"\" }");
+
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(document.data(), document.data() + document.size(),
+            validator.skipPlan())) << tape.getError();
+
+   JsonTapeValue root = tape.root();
+   ASSERT_EQ(root.size(), 4U);
+   std::string event("event");
+   ASSERT_EQ(root.find(event.data(), event.data() + event.size()).asString(),
+         "push");
+
+   // the vendor object keeps its members, not their values
+   std::string vendor("vendor");
+   JsonTapeValue v = root.find(vendor.data(), vendor.data() + vendor.size());
+   ASSERT_TRUE(v.isObject());
+   ASSERT_EQ(v.size(), 2U);
+   JsonTapeValue::const_iterator itr = v.begin();
+   ASSERT_TRUE((*itr).isSkipped());
+   ASSERT_FALSE((*itr).isArray());
+   const char *begin = NULL;
+   const char *end = NULL;
+   ASSERT_TRUE((*itr).getRaw(&begin, &end));
+   ASSERT_EQ(std::string(begin, end), "[1, {\"b\": \"\\u00e9\"}]");
+
+   // tuple items are parsed, the others skipped
+   std::string items("items");
+   JsonTapeValue i = root.find(items.data(), items.data() + items.size());
+   ASSERT_TRUE((*i.begin()).isInt());
+   ASSERT_TRUE((*++i.begin()).isSkipped());
+
+   std::string extra("extra");
+   JsonTapeValue x = root.find(extra.data(), extra.data() + extra.size());
+   ASSERT_TRUE(x.getRaw(&begin, &end));
+   ASSERT_EQ(std::string(begin, end), "\"\\\"\"");
+
+   ASSERT_EQ(validator.validate(&tape), JVAL_ROK);
+}
+
+TEST(JsonSkipPlan, InspectedSubtrees)
+{
+   // every value can be looked at by some keyword
+   const char *schemas[] = {
+      "{\"type\": \"array\", \"uniqueItems\": true}",
+      "{\"type\": \"object\", \"patternProperties\": {\"^a\": "
+         "{\"type\": \"integer\"}}}",
+      "{\"type\": \"object\", \"dependencies\": {\"a\": "
+         "{\"type\": \"object\", \"required\": [\"b\"]}}}",
+      "{\"type\": \"object\", \"properties\": {\"a\": {\"type\": \"string\"}}, "
+         "\"additionalProperties\": {\"type\": \"integer\"}}",
+      "{\"type\": \"array\", \"items\": {\"type\": \"string\"}}",
+      "{\"type\": \"string\"}"
+   };
+
+   for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++) {
+      Json::Reader reader;
+      Json::Value schema;
+      ASSERT_TRUE(reader.parse(schemas[i], schema));
+      JsonSkipPlan plan(schema);
+      ASSERT_EQ(plan.root(), JsonSkipPlan::FULL) << schemas[i];
+   }
+
+   Json::Reader reader;
+   Json::Value schema;
+   ASSERT_TRUE(reader.parse("{\"type\": \"object\", \"dependencies\": "
+            "{\"a\": [\"b\"]}, \"properties\": {\"a\": {\"type\": \"array\"}}}",
+            schema));
+   JsonSkipPlan plan(schema);
+   ASSERT_NE(plan.root(), JsonSkipPlan::FULL);
+   std::string a("a");
+   int node = plan.member(plan.root(), a.data(), a.data() + a.size());
+   ASSERT_NE(node, JsonSkipPlan::FULL);
+   ASSERT_EQ(plan.item(node, 7), JsonSkipPlan::SKIPPED);
+}
+
+TEST(JsonSkipPlan, SyntaxErrors)
+{
+   std::string schema(webhookSchema);
+   JsonValidator validator(schema);
+
+   // the same errors as a full parse, deep inside a skipped value
+   const char *values[] = {
+      "[1,", "{\"a\" 1}", "[1 2]", "{\"a\":1,}", "tru", "\"abc",
+      "[1.]", "[-]", "[1e]", "[01.e5]", "\"\\x\"", "\"\\ud800\"",
+      "\"\\u12g4\"", "{1: 2}", "[[[[", "[1] 2"
+   };
+
+   for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+      std::string document = std::string("{\"vendor\": {\"v\": ") + \
+         values[i] + "}}";
+
+      JsonTape full;
+      ASSERT_FALSE(full.parse(document));
+
+      JsonTape tape;
+      ASSERT_FALSE(tape.parse(document.data(),
+               document.data() + document.size(), validator.skipPlan()))
+         << document;
+      ASSERT_EQ(tape.getError(), full.getError()) << document;
+   }
+}
+
+TEST(JsonSkipPlan, SameResultAsFullParse)
+{
+   std::string schema(webhookSchema);
+   JsonValidator validator(schema);
+
+   const char *documents[] = {
+      "{\"event\": \"push\", \"vendor\": {}}",
+      "{\"event\": \"p\", \"vendor\": {}}",
+      "{\"event\": \"push\"}",
+      "{\"event\": \"push\", \"vendor\": {\"a\": 1, \"b\": 2, \"c\": 3, "
+         "\"d\": [4]}}",
+      "{\"event\": \"push\", \"vendor\": []}",
+      "{\"event\": \"push\", \"vendor\": {}, \"items\": [\"1\"]}",
+      "{\"event\": \"push\", \"vendor\": {}, \"items\": [1, 2, 3, 4]}",
+      "{\"event\": \"push\", \"vendor\": {}, \"items\": {}}",
+      "{\"event\": 1, \"vendor\": {\"deep\": [[[{\"x\": -0.5e-3}]]]}}",
+      "[{\"event\": 1}]"
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      std::string document(documents[i]);
+      JsonTape full;
+      ASSERT_TRUE(full.parse(document));
+
+      JsonTape tape;
+      ASSERT_TRUE(tape.parse(document.data(),
+               document.data() + document.size(), validator.skipPlan()));
+      ASSERT_EQ(validator.validate(&tape), validator.validate(&full))
+         << document;
+   }
+}
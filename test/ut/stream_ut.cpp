@@ -0,0 +1,235 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <list>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "ut_helpers.h"
+#include "tape.h"
+#include "budget.h"
+#include "primitive_base.h"
+#include "validator.h"
+#include "stream_validator.h"
+
+// feeds document in pieces of chunk bytes
+static int stream(JsonStreamValidator &validator, const std::string &document,
+      size_t chunk)
+{
+   validator.reset();
+   for (size_t i = 0; i < document.size(); i += chunk) {
+      validator.feed(document.data() + i,
+            std::min(chunk, document.size() - i));
+   }
+   return validator.finish();
+}
+
+static const char *listSchema = "{\"type\": \"array\", \"minItems\": 2, "
+   "\"maxItems\": 4, \"uniqueItems\": true, \"items\": {\"type\": \"object\", "
+   "\"additionalProperties\": false, \"properties\": {"
+   "\"id\": {\"type\": \"integer\"}, \"name\": {\"type\": \"string\"}}}}";
+
+static const char *tupleSchema = "{\"type\": \"array\", \"items\": ["
+   "{\"type\": \"string\"}, {\"type\": \"number\"}], "
+   "\"additionalItems\": false}";
+
+TEST(JsonStreamValidator, SameAsValidator)
+{
+   const char *lists[] = {
+      "[]",
+      "[{\"id\": 1}]",
+      " [ {\"id\": 1} , {\"id\": 2, \"name\": \"a, ]\\\"}\"} ]\n",
+      "[{\"id\": 1}, {\"id\": 1}]",
+      "[{\"id\": 1}, {\"id\": \"x\"}]",
+      "[{\"id\": 1}, {\"id\": 2}, {\"id\": 3}, {\"id\": 4}, {\"id\": 5}]",
+      "[{\"id\": 1}, {\"id\": \"x\"}, {\"id\": 1}]",
+      "[{\"id\": 1}, 5, true, null, \"s\", [1, [2]]]",
+      "{\"id\": 1}",
+      "5"
+   };
+   const char *tuples[] = {
+      "[]",
+      "[\"a\", 1.5]",
+      "[\"a\"]",
+      "[\"a\", 1, 2]",
+      "[1, 1]",
+      "[\"a\", -1e10]"
+   };
+
+   Json::Value listValue = parse(listSchema);
+   JsonValidator listValidator(&listValue);
+   JsonStreamValidator listStream(&listValue);
+   for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+      Json::Value document = parse(lists[i]);
+      int expected = listValidator.validate(&document);
+      for (size_t chunk = 1; chunk <= strlen(lists[i]); chunk *= 2) {
+         ASSERT_EQ(stream(listStream, lists[i], chunk), expected) << \
+            lists[i] << " in chunks of " << chunk;
+      }
+   }
+
+   Json::Value tupleValue = parse(tupleSchema);
+   JsonValidator tupleValidator(&tupleValue);
+   JsonStreamValidator tupleStream(&tupleValue);
+   for (size_t i = 0; i < sizeof(tuples) / sizeof(tuples[0]); i++) {
+      Json::Value document = parse(tuples[i]);
+      int expected = tupleValidator.validate(&document);
+      for (size_t chunk = 1; chunk <= strlen(tuples[i]); chunk++) {
+         ASSERT_EQ(stream(tupleStream, tuples[i], chunk), expected) << \
+            tuples[i] << " in chunks of " << chunk;
+      }
+   }
+}
+
+TEST(JsonStreamValidator, SyntaxErrors)
+{
+   Json::Value schema = parse(tupleSchema);
+   JsonStreamValidator validator(&schema);
+
+   const char *errors[] = {
+      "",
+      "[",
+      "[\"a\"",
+      "[\"a\",]",
+      "[,]",
+      "[\"a\" 1]",
+      "[\"a\"] x",
+      "[{]",
+      "[\"a\", 1e]",
+      "[\"a\", 1"
+   };
+
+   for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+      ASSERT_EQ(stream(validator, errors[i], 1), JVAL_ERR_INVALID_JSON) << \
+         errors[i];
+      ASSERT_FALSE(validator.getError().empty());
+   }
+
+   validator.reset();
+   ASSERT_TRUE(validator.getError().empty());
+
+   Json::Value object = parse("{\"type\": \"object\"}");
+   Json::Value mistyped = parse("{\"type\": \"array\", \"minItems\": \"x\"}");
+#ifdef JVAL_NO_EXCEPTIONS
+   JsonStreamValidator notArray(&object);
+   ASSERT_FALSE(notArray.getError().empty());
+   ASSERT_EQ(stream(notArray, "[1]", 1), JVAL_ERR_INVALID_SCHEMA);
+   ASSERT_FALSE(notArray.getError().empty());
+
+   JsonStreamValidator minItems(&mistyped);
+   ASSERT_EQ(stream(minItems, "[1]", 1), JVAL_ERR_INVALID_SCHEMA);
+#else
+   ASSERT_THROW(JsonStreamValidator notArray(&object), Exception);
+   ASSERT_THROW(JsonStreamValidator minItems(&mistyped), Exception);
+#endif
+}
+
+TEST(JsonStreamValidator, BoundedMemory)
+{
+   std::string schema = "{\"type\": \"array\", \"uniqueItems\": true, "
+      "\"items\": {\"type\": \"object\", \"properties\": {"
+      "\"id\": {\"type\": \"integer\"}, \"name\": {\"type\": \"string\"}}}}";
+   Json::Value schemaValue = parse(schema);
+   JsonStreamValidator validator(&schemaValue);
+
+   std::ostringstream document;
+   document << "[";
+   for (int i = 0; i < 20000; i++) {
+      document << (i ? ",\n" : "\n") << "{\"id\": " << i << \
+         ", \"name\": \"record number " << i << "\"}";
+   }
+   document << "]";
+   std::string text = document.str();
+
+   std::istringstream in(text);
+   ASSERT_EQ(validator.validate(in), JVAL_ROK);
+   ASSERT_EQ(validator.items(), 20000U);
+   ASSERT_EQ(validator.failedItem(), 20000U);
+   ASSERT_LT(validator.bufferBytes(), 1024U);
+   ASSERT_GT(text.size(), 500000U);
+
+   // a duplicate at the end
+   text.replace(text.size() - 1, 1, ", {\"id\": 0, "
+         "\"name\": \"record number 0\"}]");
+   std::istringstream duplicate(text);
+   ASSERT_EQ(validator.validate(duplicate), JVAL_ERR_DUPLICATE_ITEMS);
+}
+
+TEST(JsonStreamValidator, StopsAtFirstInvalidItem)
+{
+   Json::Value schema = parse("{\"type\": \"array\", "
+         "\"items\": {\"type\": \"integer\"}}");
+   JsonStreamValidator validator(&schema);
+
+   validator.reset();
+   std::string head = "[1, 2, \"three\", 4";
+   validator.feed(head.data(), head.size());
+   ASSERT_TRUE(validator.done());
+   ASSERT_EQ(validator.items(), 3U);
+   ASSERT_EQ(validator.failedItem(), 2U);
+
+   // the rest is not looked at
+   std::string tail = ", oops";
+   validator.feed(tail.data(), tail.size());
+   ASSERT_EQ(validator.finish(), JVAL_ERR_INVALID_ARRAY_ITEM);
+
+   // not an array
+   ASSERT_EQ(stream(validator, "{\"a\": [1]}", 4), JVAL_ERR_NOT_AN_ARRAY);
+}
+
+TEST(JsonStreamValidator, Budget)
+{
+   Json::Value schema = parse("{\"type\": \"array\", "
+         "\"items\": {\"type\": \"array\", \"items\": {\"type\": \"integer\"}}}");
+   JsonStreamValidator validator(&schema);
+
+   JsonBudget budget;
+   budget.setSteps(5);
+   JsonBudget::Scope scope(budget);
+   ASSERT_EQ(stream(validator, "[[1, 2], [3, 4], [5, 6]]", 64),
+         JVAL_ERR_BUDGET_EXCEEDED);
+   ASSERT_TRUE(validator.done());
+}
+
+TEST(JsonStreamValidator, FileDescriptor)
+{
+   Json::Value schema = parse(tupleSchema);
+   JsonStreamValidator validator(&schema);
+
+   FILE *file = tmpfile();
+   ASSERT_TRUE(NULL != file);
+   fputs("[\"a\", 2]", file);
+   fflush(file);
+   rewind(file);
+   ASSERT_EQ(validator.validate(fileno(file)), JVAL_ROK);
+
+   rewind(file);
+   fputs("[\"a\", 2, 3]", file);
+   fflush(file);
+   rewind(file);
+   ASSERT_EQ(validator.validate(fileno(file)), JVAL_ERR_ADDITIONAL_ITEMS);
+   fclose(file);
+}
@@ -0,0 +1,210 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+#include <json.h>
+#include "gtest/gtest.h"
+#include "tape.h"
+#include "primitive_base.h"
+#include "validator.h"
+
+TEST(JsonTape, Scalars)
+{
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse("[null, true, false, -5, 3000000000, 1.5, \"abc\", "
+            "18446744073709551616]"));
+
+   JsonTapeValue root = tape.root();
+   ASSERT_TRUE(root.isArray());
+   ASSERT_EQ(root.size(), 8U);
+
+   JsonTapeValue::const_iterator itr = root.begin();
+   ASSERT_TRUE((*itr).isNull());
+   ++itr;
+   ASSERT_TRUE((*itr).isBool());
+   ASSERT_TRUE((*itr).asBool());
+   ++itr;
+   ASSERT_FALSE((*itr).asBool());
+   ++itr;
+   ASSERT_TRUE((*itr).isInt());
+   ASSERT_EQ((*itr).asInt(), -5);
+   ++itr;
+   ASSERT_FALSE((*itr).isInt());
+   ASSERT_TRUE((*itr).isUInt());
+   ASSERT_EQ((*itr).asUInt64(), 3000000000ULL);
+   ++itr;
+   ASSERT_FALSE((*itr).isIntegral());
+   ASSERT_TRUE((*itr).isNumeric());
+   ASSERT_EQ((*itr).asDouble(), 1.5);
+   ++itr;
+   ASSERT_TRUE((*itr).isString());
+   ASSERT_EQ((*itr).asString(), "abc");
+   ++itr;
+   ASSERT_FALSE((*itr).isUInt64());
+   ASSERT_EQ((*itr).asDouble(), 18446744073709551616.0);
+   ++itr;
+   ASSERT_TRUE(itr == root.end());
+}
+
+TEST(JsonTape, Objects)
+{
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse("{\"a\": {\"b\": [1, 2, {\"c\": null}]}, "
+            "\"esc\\n\": \"\\u00e9\\ud83d\\ude00\\\"\", \"z\": {}}"));
+
+   JsonTapeValue root = tape.root();
+   ASSERT_TRUE(root.isObject());
+   ASSERT_EQ(root.size(), 3U);
+   ASSERT_TRUE(root.isMember("z"));
+   ASSERT_FALSE(root.isMember("b"));
+
+   std::string esc = "esc\n";
+   JsonTapeValue e = root.find(esc.data(), esc.data() + esc.size());
+   ASSERT_TRUE(e.isValid());
+   ASSERT_EQ(e.asString(), "\xc3\xa9\xf0\x9f\x98\x80\"");
+
+   // skipping over the nested members lands on the next key
+   JsonTapeValue::const_iterator itr = root.begin();
+   ++itr;
+   const char *end = NULL;
+   const char *name = itr.memberName(&end);
+   ASSERT_EQ(std::string(name, end), esc);
+   ++itr;
+   ++itr;
+   ASSERT_TRUE(itr == root.end());
+}
+
+TEST(JsonTape, SyntaxErrors)
+{
+   const char *documents[] = {
+      "", "[1,", "{\"a\" 1}", "[1 2]", "{\"a\":1,}", "tru", "\"abc",
+      "[1.]", "[-]", "\"\\x\"", "[1] 2", "{1: 2}"
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      JsonTape tape;
+      ASSERT_FALSE(tape.parse(documents[i])) << documents[i];
+      ASSERT_FALSE(tape.getError().empty());
+   }
+}
+
+TEST(JsonTape, Equality)
+{
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse("[{\"a\": 1, \"b\": [true]}, {\"b\": [true], \"a\": 1}, "
+            "{\"a\": 1.0, \"b\": [true]}, 0.0, -0.0]"));
+
+   std::vector<JsonTapeValue> items;
+   JsonTapeValue root = tape.root();
+   for (JsonTapeValue::const_iterator itr = root.begin(); itr != root.end(); ++itr) {
+      items.push_back(*itr);
+   }
+
+   ASSERT_TRUE(items[0] == items[1]);
+   ASSERT_EQ(items[0].hash(), items[1].hash());
+   // an int and a double are different values, like for Json::Value
+   ASSERT_FALSE(items[0] == items[2]);
+   ASSERT_TRUE(items[3] == items[4]);
+   ASSERT_EQ(items[3].hash(), items[4].hash());
+}
+
+static void expectSameResult(const char *schemaText, const char *document)
+{
+   std::string schema(schemaText);
+   JsonValidator validator(schema);
+
+   Json::Reader reader;
+   Json::Value value;
+   ASSERT_TRUE(reader.parse(document, value)) << document;
+
+   JsonTape tape;
+   ASSERT_TRUE(tape.parse(document)) << document;
+
+   ASSERT_EQ(validator.validate(&value), validator.validate(&tape))
+      << schemaText << " / " << document;
+}
+
+TEST(JsonTapeValidation, SameResultAsValue)
+{
+   const char *object = "{\"type\": \"object\", \"required\": [\"id\"], "
+      "\"maxProperties\": 3, \"additionalProperties\": false, "
+      "\"properties\": {"
+      "\"id\": {\"type\": \"integer\", \"minimum\": 1, \"maximum\": 100}, "
+      "\"name\": {\"type\": \"string\", \"minLength\": 2, \"maxLength\": 5, "
+      "\"pattern\": \"[a-z]+\"}, "
+      "\"tags\": {\"type\": \"array\", \"items\": {\"type\": \"number\", "
+      "\"multipleOf\": 0.5}, \"uniqueItems\": true, \"maxItems\": 3}}}";
+
+   const char *documents[] = {
+      "{\"id\": 1}",
+      "{\"id\": 0}",
+      "{\"id\": 101}",
+      "{\"id\": 1.5}",
+      "{\"name\": \"abc\"}",
+      "{\"id\": 2, \"name\": \"a\"}",
+      "{\"id\": 2, \"name\": \"abcdef\"}",
+      "{\"id\": 2, \"name\": \"ABC\"}",
+      "{\"id\": 2, \"tags\": [0.5, 1, 1.5]}",
+      "{\"id\": 2, \"tags\": [0.5, 0.5]}",
+      "{\"id\": 2, \"tags\": [0.5, 0.7]}",
+      "{\"id\": 2, \"tags\": [1, 2, 3, 4]}",
+      "{\"id\": 2, \"other\": 1}",
+      "{\"id\": 2, \"name\": \"ab\", \"tags\": [], \"x\": 1}",
+      "[]",
+      "\"id\""
+   };
+
+   for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+      expectSameResult(object, documents[i]);
+   }
+
+   const char *tuple = "{\"type\": \"array\", \"items\": [{\"type\": \"string\"}, "
+      "{\"type\": \"integer\"}], \"additionalItems\": false, \"minItems\": 1, "
+      "\"uniqueItems\": true}";
+
+   const char *tuples[] = {
+      "[\"a\", 1]", "[\"a\"]", "[]", "[1, 1]", "[\"a\", 1, 2]",
+      "[\"a\", \"b\"]", "{}"
+   };
+
+   for (size_t i = 0; i < sizeof(tuples) / sizeof(tuples[0]); i++) {
+      expectSameResult(tuple, tuples[i]);
+   }
+
+   const char *unique = "{\"type\": \"array\", \"uniqueItems\": true}";
+   const char *arrays[] = {
+      "[{\"a\": 1, \"b\": 2}, {\"b\": 2, \"a\": 1}]",
+      "[{\"a\": 1}, {\"a\": 2}]",
+      "[[1, 2], [2, 1]]",
+      "[[1, 2], [1, 2]]",
+      "[1, 1.0]",
+      "[\"x\", \"x\"]",
+      "[null, false, 0]"
+   };
+
+   for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+      expectSameResult(unique, arrays[i]);
+   }
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#ifndef __UT_HELPERS_H__
+#define __UT_HELPERS_H__
+
+#include <string>
+
+/**
+ * @brief Helpers and fixtures shared by the unit tests
+ */
+
+// document parsed with Json::Reader, failing the test if it does not parse
+static inline Json::Value parse(const std::string &text)
+{
+   Json::Reader reader;
+   Json::Value value;
+   EXPECT_TRUE(reader.parse(text, value));
+   return value;
+}
+
+// object schema with an integer id, a member whose name needs escaping in a
+// JSON Pointer, a list and a tuple
+static const char * const recordSchema = "{\"type\": \"object\", "
+   "\"required\": [\"id\"], \"properties\": {"
+   "\"id\": {\"type\": \"integer\", \"minimum\": 0}, "
+   "\"a/b~\": {\"type\": \"string\", \"pattern\": \"^[a-z]+$\", "
+   "\"minLength\": 2}, "
+   "\"tags\": {\"type\": \"array\", \"items\": {\"type\": \"string\", "
+   "\"pattern\": \"^[0-9]{3}-[0-9]{4}$\"}}, "
+   "\"pair\": {\"type\": \"array\", \"items\": [{\"type\": \"null\"}, "
+   "{\"type\": \"boolean\"}]}}}";
+
+#endif
@@ -0,0 +1,467 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * jval: validates JSON files against a schema on all cores.
+ *
+ *    jval [-j threads] [-s items] [-l] [-q] schema.json
+ *          [file | directory | -] ...
+ *
+ * A directory is searched recursively for .json, .ndjson and .jsonl files,
+ * "-" or no path at all reads the standard input. Files ending in .ndjson or
+ * .jsonl, and every input with -l, hold one document per line. One result is
+ * printed per document, in input order (-q prints the invalid ones only),
+ * then a throughput and latency summary on stderr. With -s, arrays and objects
+ * of at least that many items or members are split across the workers too, so
+ * that a single large document does not keep one core busy alone.
+ *
+ * The exit status is 0 if every document is valid, 1 if one is not and 2 on
+ * errors.
+ */
+
+#include <dirent.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <tape.h>
+#include <primitive_base.h>
+#include <validator.h>
+#include <worker_pool.h>
+
+// lines of NDJSON handed to a worker at once
+#define JVAL_BATCH_LINES   4096
+#define JVAL_BATCH_BYTES   (1U << 20)
+
+typedef std::chrono::steady_clock Clock;
+
+struct Document
+{
+   std::string name;
+   bool        parsed;
+   int         result;
+   std::string error;
+   uint64_t    ns;
+};
+
+/**
+ * @brief Results handed in by the workers, printed in input order by the
+ * reading thread
+ */
+class Results
+{
+   public:
+      explicit Results(bool quiet) : m_quiet(quiet), m_next(0), m_valid(0),
+         m_invalid(0), m_bytes(0) {}
+
+      void add(size_t sequence, std::vector<Document> &documents,
+            size_t bytes) {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_done[sequence].swap(documents);
+         m_bytes += bytes;
+      }
+
+      void print() {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         std::map<size_t, std::vector<Document> >::iterator itr;
+         while ((itr = m_done.find(m_next)) != m_done.end()) {
+            for (size_t i = 0; i < itr->second.size(); i++) {
+               print(itr->second[i]);
+            }
+            m_done.erase(itr);
+            m_next++;
+         }
+      }
+
+      void summary(double seconds) {
+         size_t count = m_latencies.size();
+         std::sort(m_latencies.begin(), m_latencies.end());
+
+         std::cerr << count << " documents (" << m_valid << " valid, " << \
+            m_invalid << " invalid) in " << seconds << " s";
+         if (count > 0 && seconds > 0) {
+            std::cerr << ": " << count / seconds << " docs/s, " << \
+               m_bytes / seconds / 1e6 << " MB/s, latency p50 " << \
+               percentile(0.50) / 1e3 << " us, p99 " << \
+               percentile(0.99) / 1e3 << " us";
+         }
+         std::cerr << std::endl;
+      }
+
+      size_t invalid() const {return m_invalid;}
+
+   private:
+      void print(const Document &document) {
+         m_latencies.push_back(document.ns);
+         if (document.parsed && document.result == JVAL_ROK) {
+            m_valid++;
+            if (!m_quiet) {
+               std::cout << document.name << ": valid\n";
+            }
+            return;
+         }
+
+         m_invalid++;
+         if (!document.parsed) {
+            std::cout << document.name << ": invalid JSON, " << \
+               document.error << "\n";
+         } else {
+            std::cout << document.name << ": invalid, error " << \
+               document.result << "\n";
+         }
+      }
+
+      double percentile(double p) const {
+         size_t index = static_cast<size_t>(p * (m_latencies.size() - 1) + 0.5);
+         return static_cast<double>(m_latencies[index]);
+      }
+
+      bool                                      m_quiet;
+      std::mutex                                m_mutex;
+      std::map<size_t, std::vector<Document> >  m_done;
+      size_t                                    m_next;
+      std::vector<uint64_t>                     m_latencies;
+      size_t                                    m_valid;
+      size_t                                    m_invalid;
+      size_t                                    m_bytes;
+};
+
+/**
+ * @brief Worker task: a whole file, or a batch of NDJSON lines
+ */
+class Batch
+{
+   public:
+      Batch(JsonValidator *validator, Results *results, size_t sequence,
+            const std::string &name, const std::shared_ptr<std::string> &data,
+            bool lines, size_t firstLine) :
+         m_validator(validator), m_results(results), m_sequence(sequence),
+         m_name(name), m_data(data), m_lines(lines), m_firstLine(firstLine) {}
+
+      void operator()() {
+         JsonTape tape;
+         std::vector<Document> documents;
+         const char *begin = m_data->data();
+         const char *end = begin + m_data->size();
+
+         if (!m_lines) {
+            validate(tape, begin, end, m_name, documents);
+         } else {
+            size_t line = m_firstLine;
+            while (begin < end) {
+               const char *eol = static_cast<const char *>(
+                     memchr(begin, '\n', static_cast<size_t>(end - begin)));
+               if (NULL == eol) {
+                  eol = end;
+               }
+
+               if (!blank(begin, eol)) {
+                  std::ostringstream name;
+                  name << m_name << ":" << line;
+                  validate(tape, begin, eol, name.str(), documents);
+               }
+
+               begin = eol + 1;
+               line++;
+            }
+         }
+
+         m_results->add(m_sequence, documents, m_data->size());
+      }
+
+   private:
+      static bool blank(const char *begin, const char *end) {
+         for (; begin < end; begin++) {
+            if (*begin != ' ' && *begin != '\t' && *begin != '\r') {
+               return false;
+            }
+         }
+         return true;
+      }
+
+      void validate(JsonTape &tape, const char *begin, const char *end,
+            const std::string &name, std::vector<Document> &documents) {
+         Document document;
+         document.name = name;
+         document.result = JVAL_ROK;
+
+         Clock::time_point start = Clock::now();
+         document.parsed = tape.parse(begin, end, m_validator->skipPlan());
+         if (document.parsed) {
+            document.result = m_validator->validate(&tape);
+         } else {
+            document.error = tape.getError();
+         }
+         document.ns = static_cast<uint64_t>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  Clock::now() - start).count());
+
+         documents.push_back(document);
+      }
+
+      JsonValidator                 *m_validator;
+      Results                       *m_results;
+      size_t                        m_sequence;
+      std::string                   m_name;
+      std::shared_ptr<std::string>  m_data;
+      bool                          m_lines;
+      size_t                        m_firstLine;
+};
+
+/**
+ * @brief Reads the inputs and queues them for the workers
+ */
+class Reader
+{
+   public:
+      Reader(JsonValidator *validator, JsonWorkerPool *pool, Results *results,
+            bool lines) :
+         m_validator(validator), m_pool(pool), m_results(results),
+         m_lines(lines), m_sequence(0), m_errors(0) {}
+
+      void path(const std::string &path) {
+         if (path == "-") {
+            stream(std::cin, "-", m_lines);
+            return;
+         }
+
+         struct stat st;
+         if (stat(path.c_str(), &st) != 0) {
+            error(path, "cannot open");
+         } else if (S_ISDIR(st.st_mode)) {
+            directory(path);
+         } else {
+            std::ifstream in(path.c_str(), std::ios::binary);
+            if (!in) {
+               error(path, "cannot open");
+            } else {
+               stream(in, path, m_lines || lineFile(path));
+            }
+         }
+      }
+
+      size_t errors() const {return m_errors;}
+
+   private:
+      static bool endsWith(const std::string &s, const char *suffix) {
+         size_t n = strlen(suffix);
+         return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+      }
+
+      static bool lineFile(const std::string &path) {
+         return endsWith(path, ".ndjson") || endsWith(path, ".jsonl");
+      }
+
+      void error(const std::string &path, const char *what) {
+         std::cerr << path << ": " << what << std::endl;
+         m_errors++;
+      }
+
+      void directory(const std::string &path) {
+         DIR *dir = opendir(path.c_str());
+         if (NULL == dir) {
+            error(path, "cannot open");
+            return;
+         }
+
+         std::vector<std::string> entries;
+         struct dirent *entry;
+         while (NULL != (entry = readdir(dir))) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+               entries.push_back(name);
+            }
+         }
+         closedir(dir);
+
+         std::sort(entries.begin(), entries.end());
+         for (size_t i = 0; i < entries.size(); i++) {
+            std::string child = path + "/" + entries[i];
+            struct stat st;
+            if (stat(child.c_str(), &st) != 0) {
+               continue;
+            }
+
+            if (S_ISDIR(st.st_mode) || endsWith(child, ".json") || \
+                  lineFile(child)) {
+               this->path(child);
+            }
+         }
+      }
+
+      void stream(std::istream &in, const std::string &name, bool lines) {
+         if (!lines) {
+            std::shared_ptr<std::string> data(new std::string(
+                     (std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>()));
+            submit(name, data, false, 1);
+            return;
+         }
+
+         size_t line = 1;
+         std::string text;
+         while (in) {
+            std::shared_ptr<std::string> data(new std::string());
+            size_t first = line;
+            for (size_t i = 0; i < JVAL_BATCH_LINES && \
+                  data->size() < JVAL_BATCH_BYTES; i++) {
+               if (!std::getline(in, text)) {
+                  break;
+               }
+               data->append(text);
+               data->push_back('\n');
+               line++;
+            }
+
+            if (!data->empty()) {
+               submit(name, data, true, first);
+            }
+         }
+      }
+
+      void submit(const std::string &name,
+            const std::shared_ptr<std::string> &data, bool lines,
+            size_t firstLine) {
+         m_pool->submit(Batch(m_validator, m_results, m_sequence++, name,
+                  data, lines, firstLine));
+         m_results->print();
+      }
+
+      JsonValidator  *m_validator;
+      JsonWorkerPool *m_pool;
+      Results        *m_results;
+      bool           m_lines;
+      size_t         m_sequence;
+      size_t         m_errors;
+};
+
+static int usage(const char *program)
+{
+   std::cerr << "usage: " << program << \
+      " [-j threads] [-s items] [-l] [-q] schema.json" \
+      " [file | directory | -] ..." << \
+      std::endl;
+   return 2;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned int threads = std::thread::hardware_concurrency();
+   size_t split = 0;
+   bool lines = false;
+   bool quiet = false;
+   const char *schema = NULL;
+   std::vector<std::string> paths;
+
+   for (int i = 1; i < argc; i++) {
+      if (0 == strcmp(argv[i], "-j") && i + 1 < argc) {
+         threads = static_cast<unsigned int>(atoi(argv[++i]));
+      } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+         split = static_cast<size_t>(atol(argv[++i]));
+      } else if (0 == strcmp(argv[i], "-l")) {
+         lines = true;
+      } else if (0 == strcmp(argv[i], "-q")) {
+         quiet = true;
+      } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+         return usage(argv[0]);
+      } else if (NULL == schema) {
+         schema = argv[i];
+      } else {
+         paths.push_back(argv[i]);
+      }
+   }
+
+   if (NULL == schema) {
+      return usage(argv[0]);
+   }
+
+   if (paths.empty()) {
+      paths.push_back("-");
+   }
+
+   std::ifstream t(schema);
+   if (!t) {
+      std::cerr << schema << ": cannot open" << std::endl;
+      return 2;
+   }
+
+   std::string str((std::istreambuf_iterator<char>(t)),
+         std::istreambuf_iterator<char>());
+
+   JsonValidator *validator = NULL;
+   try {
+      validator = new JsonValidator(str);
+   } catch (Exception &e) {
+      std::cerr << schema << ": " << e.what() << std::endl;
+      return 2;
+   } catch (std::exception &e) {
+      // such as std::regex_error for a pattern
+      std::cerr << schema << ": " << e.what() << std::endl;
+      return 2;
+   }
+
+   if (!validator->getError().empty()) {
+      std::cerr << schema << ": " << validator->getError() << std::endl;
+      delete validator;
+      return 2;
+   }
+
+   Results results(quiet);
+   size_t errors = 0;
+   Clock::time_point start = Clock::now();
+   {
+      // a few batches per worker keep them busy while the reader is ahead
+      JsonWorkerPool pool(threads, 4 * (threads > 0 ? threads : 1));
+      if (split > 0) {
+         validator->setParallel(&pool, split);
+      }
+      Reader reader(validator, &pool, &results, lines);
+      for (size_t i = 0; i < paths.size(); i++) {
+         reader.path(paths[i]);
+      }
+      pool.drain();
+      errors = reader.errors();
+   }
+   results.print();
+   std::cout.flush();
+
+   results.summary(std::chrono::duration<double>(Clock::now() - start).count());
+   delete validator;
+
+   if (errors > 0) {
+      return 2;
+   }
+
+   return results.invalid() > 0 ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * jval-codegen: writes a C++ validator specialized for one schema.
+ *
+ *    jval-codegen [-n function] [-o output.cpp] schema.json
+ *
+ * The output defines int function(const Json::Value *value), returning the
+ * same codes as JsonValidator::validate(), and is built against jsoncpp and
+ * primitive_base.h only.
+ */
+
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <stdexcept>
+#include <json.h>
+#include <primitive_base.h>
+#include <codegen.h>
+
+static int usage(const char *program)
+{
+   std::cerr << "usage: " << program << \
+      " [-n function] [-o output.cpp] schema.json" << std::endl;
+   return 2;
+}
+
+int main(int argc, char *argv[])
+{
+   std::string function = "jval_validate";
+   const char *output = NULL;
+   const char *input = NULL;
+
+   for (int i = 1; i < argc; i++) {
+      if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+         function = argv[++i];
+      } else if (0 == strcmp(argv[i], "-o") && i + 1 < argc) {
+         output = argv[++i];
+      } else if (argv[i][0] != '-' && NULL == input) {
+         input = argv[i];
+      } else {
+         return usage(argv[0]);
+      }
+   }
+
+   if (NULL == input) {
+      return usage(argv[0]);
+   }
+
+   std::ifstream t(input);
+   if (!t) {
+      std::cerr << input << ": cannot open" << std::endl;
+      return 1;
+   }
+
+   std::string str((std::istreambuf_iterator<char>(t)),
+         std::istreambuf_iterator<char>());
+
+   Json::Reader reader;
+   Json::Value schema;
+   if (!reader.parse(str.c_str(), schema)) {
+      std::cerr << input << ": " << reader.getFormattedErrorMessages();
+      return 1;
+   }
+
+   JsonCodeGenerator generator;
+   std::ostringstream source;
+   try {
+      generator.generate(&schema, function, source);
+   } catch (Exception &e) {
+      std::cerr << input << ": " << e.what() << std::endl;
+      return 1;
+   } catch (std::exception &e) {
+      std::cerr << input << ": " << e.what() << std::endl;
+      return 1;
+   }
+
+   if (NULL == output) {
+      std::cout << source.str();
+      return 0;
+   }
+
+   std::ofstream out(output);
+   out << source.str();
+   if (!out) {
+      std::cerr << output << ": cannot write" << std::endl;
+      return 1;
+   }
+
+   return 0;
+}
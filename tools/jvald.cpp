@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * jvald: compiles the schemas of a directory once and validates documents
+ * sent over a Unix socket, see daemon.h for the protocol.
+ *
+ *    jvald -s socket -d schema_directory
+ *
+ * A schema is named after its file name without the .json extension. The
+ * daemon runs until SIGINT or SIGTERM.
+ */
+
+#include <signal.h>
+#include <string.h>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <json.h>
+#include <primitive_base.h>
+#include <daemon.h>
+
+static JsonDaemon *daemonInstance = NULL;
+
+static void onSignal(int)
+{
+   if (NULL != daemonInstance) {
+      daemonInstance->stop();
+   }
+}
+
+static int usage(const char *program)
+{
+   std::cerr << "usage: " << program << " -s socket -d schema_directory" << \
+      std::endl;
+   return 2;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *socketPath = NULL;
+   const char *directory = NULL;
+
+   for (int i = 1; i < argc; i++) {
+      if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+         socketPath = argv[++i];
+      } else if (0 == strcmp(argv[i], "-d") && i + 1 < argc) {
+         directory = argv[++i];
+      } else {
+         return usage(argv[0]);
+      }
+   }
+
+   if (NULL == socketPath || NULL == directory) {
+      return usage(argv[0]);
+   }
+
+   JsonDaemon daemon;
+   try {
+      size_t count = daemon.loadSchemas(directory);
+      daemon.listen(socketPath);
+      std::cerr << "jvald: " << count << " schemas, listening on " << \
+         socketPath << std::endl;
+   } catch (Exception &e) {
+      std::cerr << "jvald: " << e.what() << std::endl;
+      return 1;
+   } catch (std::exception &e) {
+      std::cerr << "jvald: " << e.what() << std::endl;
+      return 1;
+   }
+
+   daemonInstance = &daemon;
+
+   struct sigaction action;
+   memset(&action, 0, sizeof(action));
+   action.sa_handler = onSignal;
+   sigaction(SIGINT, &action, NULL);
+   sigaction(SIGTERM, &action, NULL);
+   signal(SIGPIPE, SIG_IGN);
+
+   daemon.run();
+   daemonInstance = NULL;
+
+   return 0;
+}
@@ -0,0 +1,186 @@
+/******************************************************************************
+ * Copyright (c) 2016, Nithin Nellikunnu (nithin.nn@gmail.com)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * jvald-bench: load test for jvald. Each connection sends the same document
+ * over and over, keeping up to depth requests in flight.
+ *
+ *    jvald-bench -s socket -n schema [-c connections] [-r requests]
+ *       [-p depth] document.json
+ *
+ * requests is the total over all connections.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json.h>
+#include <daemon.h>
+
+struct Load
+{
+   const char        *socketPath;
+   std::string       schema;
+   std::string       document;
+   unsigned long     requests;
+   unsigned int      depth;
+   unsigned long     valid;
+   unsigned long     invalid;
+   bool              failed;
+};
+
+static void runConnection(Load *load)
+{
+   JsonDaemonClient client;
+   if (!client.connect(load->socketPath)) {
+      std::cerr << client.getError() << std::endl;
+      load->failed = true;
+      return;
+   }
+
+   const char *begin = load->document.data();
+   const char *end = begin + load->document.size();
+   unsigned long sent = 0;
+   unsigned long received = 0;
+
+   while (received < load->requests) {
+      while (sent < load->requests && sent - received < load->depth) {
+         if (!client.send(load->schema, begin, end)) {
+            break;
+         }
+         sent++;
+      }
+
+      int result;
+      if (!client.receive(result)) {
+         std::cerr << client.getError() << std::endl;
+         load->failed = true;
+         return;
+      }
+      received++;
+
+      if (result == 0) {
+         load->valid++;
+      } else {
+         load->invalid++;
+      }
+   }
+}
+
+static int usage(const char *program)
+{
+   std::cerr << "usage: " << program << " -s socket -n schema " \
+      "[-c connections] [-r requests] [-p depth] document.json" << std::endl;
+   return 2;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *socketPath = NULL;
+   const char *schema = NULL;
+   const char *input = NULL;
+   unsigned int connections = 4;
+   unsigned long requests = 100000;
+   unsigned int depth = 64;
+
+   for (int i = 1; i < argc; i++) {
+      if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+         socketPath = argv[++i];
+      } else if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+         schema = argv[++i];
+      } else if (0 == strcmp(argv[i], "-c") && i + 1 < argc) {
+         connections = static_cast<unsigned int>(atoi(argv[++i]));
+      } else if (0 == strcmp(argv[i], "-r") && i + 1 < argc) {
+         requests = strtoul(argv[++i], NULL, 10);
+      } else if (0 == strcmp(argv[i], "-p") && i + 1 < argc) {
+         depth = static_cast<unsigned int>(atoi(argv[++i]));
+      } else if (argv[i][0] != '-' && NULL == input) {
+         input = argv[i];
+      } else {
+         return usage(argv[0]);
+      }
+   }
+
+   if (NULL == socketPath || NULL == schema || NULL == input || \
+         connections == 0 || depth == 0) {
+      return usage(argv[0]);
+   }
+
+   std::ifstream t(input);
+   if (!t) {
+      std::cerr << input << ": cannot open" << std::endl;
+      return 1;
+   }
+
+   std::string document((std::istreambuf_iterator<char>(t)),
+         std::istreambuf_iterator<char>());
+
+   std::vector<Load> loads(connections);
+   for (unsigned int i = 0; i < connections; i++) {
+      loads[i].socketPath = socketPath;
+      loads[i].schema = schema;
+      loads[i].document = document;
+      loads[i].requests = requests / connections + \
+         (i < requests % connections ? 1 : 0);
+      loads[i].depth = depth;
+      loads[i].valid = 0;
+      loads[i].invalid = 0;
+      loads[i].failed = false;
+   }
+
+   std::chrono::steady_clock::time_point start = \
+      std::chrono::steady_clock::now();
+
+   std::vector<std::thread> threads;
+   for (unsigned int i = 0; i < connections; i++) {
+      threads.push_back(std::thread(runConnection, &loads[i]));
+   }
+   for (unsigned int i = 0; i < connections; i++) {
+      threads[i].join();
+   }
+
+   double seconds = std::chrono::duration<double>(
+         std::chrono::steady_clock::now() - start).count();
+
+   unsigned long valid = 0;
+   unsigned long invalid = 0;
+   bool failed = false;
+   for (unsigned int i = 0; i < connections; i++) {
+      valid += loads[i].valid;
+      invalid += loads[i].invalid;
+      failed = failed || loads[i].failed;
+   }
+
+   unsigned long done = valid + invalid;
+   std::cout << done << " requests in " << seconds << " s: " << \
+      (seconds > 0 ? done / seconds : 0) << " requests/s, " << \
+      (seconds > 0 ? done * document.size() / seconds / 1e6 : 0) << \
+      " MB/s (" << valid << " valid, " << invalid << " invalid)" << std::endl;
+
+   return failed ? 1 : 0;
+}